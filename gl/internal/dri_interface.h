@@ -651,6 +651,42 @@ struct __DRIswrastLoaderExtensionRec {
                         int shmid, void *loaderPrivate);
 };
 
+/**
+ * Direct rendering loader extension for swrast.  A loader offering it
+ * can hand the driver a drawable's own pixel storage to render the front
+ * buffer into and to copy the back buffer into on swaps, so the driver
+ * only has to tell the loader what changed instead of reading pixels
+ * back or writing them out through putImage.
+ *
+ * \since 1
+ */
+#define __DRI_SWRAST_DIRECT "DRI_SWRastDirect"
+#define __DRI_SWRAST_DIRECT_VERSION 1
+typedef struct __DRIswrastDirectExtensionRec __DRIswrastDirectExtension;
+struct __DRIswrastDirectExtensionRec {
+    __DRIextension base;
+
+    /**
+     * Get the drawable's storage, top row first, if the driver may
+     * render a width x height image of the given bits per pixel straight
+     * into it.  Returns NULL otherwise.  The storage may move or go
+     * away whenever the loader runs, so the driver asks again before
+     * each use and never keeps pixels in it that are not meant to be
+     * seen.
+     */
+    void *(*getBuffer)(__DRIdrawable *drawable, int bpp,
+                       int width, int height, int *stride,
+                       void *loaderPrivate);
+
+    /**
+     * Report an area rendered into the storage from getBuffer, in the
+     * same coordinates as putImage.
+     */
+    void (*damage)(__DRIdrawable *drawable,
+                   int x, int y, int width, int height,
+                   void *loaderPrivate);
+};
+
 /**
  * Invalidate loader extension.  The presence of this extension
  * indicates to the DRI driver that the loader will call invalidate in
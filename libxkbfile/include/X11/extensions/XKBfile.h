@@ -416,6 +416,12 @@ extern	Bool	XkbWriteXKMFile(
     XkbFileInfo *	/* result */
 );
 
+extern	Bool	XkbWriteXKMBuffer(
+    XkbFileInfo *	/* result */,
+    char **		/* data_rtrn */,
+    size_t *		/* size_rtrn */
+);
+
 extern	Bool	XkbWriteToServer(
     XkbFileInfo *	/* result */
 );
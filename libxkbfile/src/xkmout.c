@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 #include <X11/Xfuncs.h>
 #include <X11/Xlib.h>
 #include <X11/XKBlib.h>
@@ -50,38 +51,86 @@ typedef struct _XkmInfo {
 
 /***====================================================================***/
 
-#define	xkmPutCARD8(f,v)	(putc(v,f),1)
+/*
+ * A compiled keymap goes either to a FILE or into a growing buffer, so
+ * that a caller compiling keymaps in memory never has to touch a file.
+ */
+typedef struct _XkmOutput {
+    FILE *		file;
+    char *		data;
+    size_t		size;
+    size_t		alloc;
+    Bool		failed;
+} XkmOutput;
+
+static size_t
+xkmWrite(const void *ptr,size_t size,size_t count,XkmOutput *out)
+{
+size_t	len= size*count;
+
+    if (out->file)
+	return fwrite(ptr,size,count,out->file);
+    if (out->failed)
+	return 0;
+    if (out->size+len>out->alloc) {
+	size_t	alloc= out->alloc?out->alloc:4096;
+	char *	data;
+
+	while (out->size+len>alloc)
+	    alloc*= 2;
+	data= realloc(out->data,alloc);
+	if (data==NULL) {
+	    out->failed= True;
+	    return 0;
+	}
+	out->data= data;
+	out->alloc= alloc;
+    }
+    memcpy(out->data+out->size,ptr,len);
+    out->size+= len;
+    return count;
+}
+
+static void
+xkmPutc(XkmOutput *out,int c)
+{
+unsigned char	ch= c;
+
+    xkmWrite(&ch,1,1,out);
+}
+
+#define	xkmPutCARD8(f,v)	(xkmPutc(f,v),1)
 
 static int
-xkmPutCARD16(FILE *file,unsigned val)
+xkmPutCARD16(XkmOutput *file,unsigned val)
 {
 CARD16	tmp= val;
 
-    fwrite(&tmp,2,1,file);
+    xkmWrite(&tmp,2,1,file);
     return 2;
 }
 
 static int
-xkmPutCARD32(FILE *file,unsigned long val)
+xkmPutCARD32(XkmOutput *file,unsigned long val)
 {
 CARD32 tmp= val;
 
-    fwrite(&tmp,4,1,file);
+    xkmWrite(&tmp,4,1,file);
     return 4;
 }
 
 static int
-xkmPutPadding(FILE *file,unsigned pad)
+xkmPutPadding(XkmOutput *file,unsigned pad)
 {
 int	i;
     for (i=0;i<pad;i++) {
-	putc('\0',file);
+	xkmPutc(file,'\0');
     }
     return pad;
 }
 
 static int
-xkmPutCountedBytes(FILE *file,char *ptr,unsigned count)
+xkmPutCountedBytes(XkmOutput *file,char *ptr,unsigned count)
 {
 register int nOut;
 register unsigned pad;
@@ -90,7 +139,7 @@ register unsigned pad;
 	return xkmPutCARD32(file,(unsigned long)0);
 
     xkmPutCARD16(file,count);
-    nOut= fwrite(ptr,1,count,file);
+    nOut= xkmWrite(ptr,1,count,file);
     if (nOut<0)
 	return 2;
     nOut= count+2;
@@ -109,7 +158,7 @@ xkmSizeCountedString(char *str)
 }
 
 static int
-xkmPutCountedString(FILE *file,char *str)
+xkmPutCountedString(XkmOutput *file,char *str)
 {
     if (str==NULL)
 	 return xkmPutCARD32(file,(unsigned long)0);
@@ -168,7 +217,7 @@ register unsigned	i,bit;
 }
 
 static unsigned
-WriteXKMVirtualMods(FILE *file,XkbFileInfo *result,XkmInfo *info)
+WriteXKMVirtualMods(XkmOutput *file,XkbFileInfo *result,XkmInfo *info)
 {
 register unsigned int i,bit;
 XkbDescPtr	xkb;
@@ -229,7 +278,7 @@ Display *	dpy;
 }
 
 static unsigned
-WriteXKMKeycodes(FILE *file,XkbFileInfo *result)
+WriteXKMKeycodes(XkmOutput *file,XkbFileInfo *result)
 {
 XkbDescPtr	xkb;
 Atom	 	kcName;
@@ -247,10 +296,10 @@ unsigned	tmp,size= 0;
     size+= xkmPutCARD8(file,xkb->max_key_code);
     size+= xkmPutCARD8(file,xkb->names->num_key_aliases);
     size+= xkmPutPadding(file,1);
-    tmp= fwrite(start,sizeof(XkbKeyNameRec),XkbNumKeys(xkb),file);
+    tmp= xkmWrite(start,sizeof(XkbKeyNameRec),XkbNumKeys(xkb),file);
     size+= tmp*sizeof(XkbKeyNameRec);
     if (xkb->names->num_key_aliases>0) {
-	tmp= fwrite((char *)xkb->names->key_aliases,
+	tmp= xkmWrite((char *)xkb->names->key_aliases,
 			sizeof(XkbKeyAliasRec),xkb->names->num_key_aliases,
 			file);
 	size+= tmp*sizeof(XkbKeyAliasRec);
@@ -306,7 +355,7 @@ char *			name;
 }
 
 static unsigned
-WriteXKMKeyTypes(FILE *file,XkbFileInfo *result)
+WriteXKMKeyTypes(XkmOutput *file,XkbFileInfo *result)
 {
 register unsigned	i,n;
 XkbDescPtr		xkb;
@@ -337,13 +386,13 @@ char *			name;
 	     wire.nLevelNames= type->num_levels;
 	else wire.nLevelNames= 0;
   wire.pad = 0;
-	tmp= fwrite(&wire,SIZEOF(xkmKeyTypeDesc),1,file);
+	tmp= xkmWrite(&wire,SIZEOF(xkmKeyTypeDesc),1,file);
 	size+= tmp*SIZEOF(xkmKeyTypeDesc);
 	for (n=0,entry= type->map;n<type->map_count;n++,entry++) {
 	    wire_entry.level= entry->level;
 	    wire_entry.realMods= entry->mods.real_mods;
 	    wire_entry.virtualMods= entry->mods.vmods;
-	    tmp= fwrite(&wire_entry,SIZEOF(xkmKTMapEntryDesc),1,file);
+	    tmp= xkmWrite(&wire_entry,SIZEOF(xkmKTMapEntryDesc),1,file);
 	    size+= tmp*SIZEOF(xkmKTMapEntryDesc);
 	}
 	size+= xkmPutCountedString(file,XkbAtomGetString(dpy,type->name));
@@ -354,7 +403,7 @@ char *			name;
 		p_entry.realMods= pre->real_mods;
 		p_entry.virtualMods= pre->vmods;
     p_entry.pad = 0;
-		tmp= fwrite(&p_entry,SIZEOF(xkmModsDesc),1,file);
+		tmp= xkmWrite(&p_entry,SIZEOF(xkmModsDesc),1,file);
 		size+= tmp*SIZEOF(xkmModsDesc);
 	    }
 	}
@@ -414,7 +463,7 @@ Display *	dpy;
 }
 
 static unsigned
-WriteXKMCompatMap(FILE *file,XkbFileInfo *result,XkmInfo *info)
+WriteXKMCompatMap(XkmOutput *file,XkbFileInfo *result,XkmInfo *info)
 {
 register unsigned	i;
 char *			name;
@@ -447,7 +496,7 @@ unsigned		tmp,size=0;
 	wire.actionData[4]= interp->act.data[4];
 	wire.actionData[5]= interp->act.data[5];
 	wire.actionData[6]= interp->act.data[6];
-	tmp= fwrite(&wire,SIZEOF(xkmSymInterpretDesc),1,file);
+	tmp= xkmWrite(&wire,SIZEOF(xkmSymInterpretDesc),1,file);
 	size+= tmp*SIZEOF(xkmSymInterpretDesc);
     }
     if (info->group_compat) {
@@ -458,7 +507,7 @@ unsigned		tmp,size=0;
 		modsWire.realMods= xkb->compat->groups[i].real_mods;
 		modsWire.virtualMods= xkb->compat->groups[i].vmods;
 		modsWire.pad = 0;
-		fwrite(&modsWire,SIZEOF(xkmModsDesc),1,file);
+		xkmWrite(&modsWire,SIZEOF(xkmModsDesc),1,file);
 		size+= SIZEOF(xkmModsDesc);
 	    }
 	}
@@ -531,7 +580,7 @@ char *		name;
 }
 
 static unsigned
-WriteXKMSymbols(FILE *file,XkbFileInfo *result,XkmInfo *info)
+WriteXKMSymbols(XkmOutput *file,XkbFileInfo *result,XkmInfo *info)
 {
 Display *		dpy;
 XkbDescPtr		xkb;
@@ -592,7 +641,7 @@ unsigned		tmp,size= 0;
 		else wireMap.flags|= XkmNonRepeatingKey;
 	    }
 	}
-	tmp= fwrite(&wireMap,SIZEOF(xkmKeySymMapDesc),1,file);
+	tmp= xkmWrite(&wireMap,SIZEOF(xkmKeySymMapDesc),1,file);
 	size+= tmp*SIZEOF(xkmKeySymMapDesc);
 	if (xkb->server->explicit[i]&XkbExplicitKeyTypesMask) {
 	    register int g;
@@ -611,7 +660,7 @@ unsigned		tmp,size= 0;
 		XkbAction *	act;
 		act= XkbKeyActionsPtr(xkb,i);
 		for (n=XkbKeyNumActions(xkb,i);n>0;n--,act++) {
-		    tmp= fwrite(act,SIZEOF(xkmActionDesc),1,file);
+		    tmp= xkmWrite(act,SIZEOF(xkmActionDesc),1,file);
 		    size+= tmp*SIZEOF(xkmActionDesc);
 		}
 	    }
@@ -620,7 +669,7 @@ unsigned		tmp,size= 0;
 	    xkmBehaviorDesc	b;
 	    b.type= xkb->server->behaviors[i].type;
 	    b.data= xkb->server->behaviors[i].data;
-	    tmp= fwrite(&b,SIZEOF(xkmBehaviorDesc),1,file);
+	    tmp= xkmWrite(&b,SIZEOF(xkmBehaviorDesc),1,file);
 	    size+= tmp*SIZEOF(xkmBehaviorDesc);
 	}
     }
@@ -630,7 +679,7 @@ unsigned		tmp,size= 0;
 	    if (xkb->server->vmodmap[i]!=0) {
 		v.key= i;
 		v.vmods= xkb->server->vmodmap[i];
-		tmp= fwrite(&v,SIZEOF(xkmVModMapDesc),1,file);
+		tmp= xkmWrite(&v,SIZEOF(xkmVModMapDesc),1,file);
 		size+= tmp*SIZEOF(xkmVModMapDesc);
 	    }
 	}
@@ -686,7 +735,7 @@ register unsigned	i,nLEDs;
 }
 
 static unsigned
-WriteXKMIndicators(FILE *file,XkbFileInfo *result,XkmInfo *info)
+WriteXKMIndicators(XkmOutput *file,XkbFileInfo *result,XkmInfo *info)
 {
 Display *		dpy;
 XkbDescPtr		xkb;
@@ -721,7 +770,7 @@ unsigned		tmp,size= 0;
 		wire.which_groups= map->which_groups;
 		wire.groups= map->groups;
 		wire.ctrls= map->ctrls;
-		tmp= fwrite(&wire,SIZEOF(xkmIndicatorMapDesc),1,file);
+		tmp= xkmWrite(&wire,SIZEOF(xkmIndicatorMapDesc),1,file);
 		size+= tmp*SIZEOF(xkmIndicatorMapDesc);
 	    }
 	}
@@ -852,7 +901,7 @@ unsigned	size;
 }
 
 static unsigned
-WriteXKMGeomDoodad(FILE *file,XkbFileInfo *result,XkbDoodadPtr doodad)
+WriteXKMGeomDoodad(XkmOutput *file,XkbFileInfo *result,XkbDoodadPtr doodad)
 {
 Display *	dpy;
 XkbDescPtr	xkb;
@@ -895,7 +944,7 @@ unsigned	tmp,size= 0;
 	    return 0;
     }
     size+= xkmPutCountedAtomString(dpy,file,doodad->any.name);
-    tmp= fwrite(&doodadWire,SIZEOF(xkmDoodadDesc),1,file);
+    tmp= xkmWrite(&doodadWire,SIZEOF(xkmDoodadDesc),1,file);
     size+= tmp*SIZEOF(xkmDoodadDesc);
     if (doodad->any.type==XkbTextDoodad) {
 	size+= xkmPutCountedString(file,doodad->text.text);
@@ -908,7 +957,7 @@ unsigned	tmp,size= 0;
 }
 
 static unsigned
-WriteXKMGeomOverlay(FILE *file,XkbFileInfo *result,XkbOverlayPtr ol)
+WriteXKMGeomOverlay(XkmOutput *file,XkbFileInfo *result,XkbOverlayPtr ol)
 {
 register int		r,k;
 Display *		dpy;
@@ -926,18 +975,18 @@ unsigned		tmp,size= 0;
     bzero((char *)&keyWire,sizeof(keyWire));
     size+= xkmPutCountedAtomString(dpy,file,ol->name);
     olWire.num_rows= ol->num_rows;
-    tmp= fwrite(&olWire,SIZEOF(xkmOverlayDesc),1,file);
+    tmp= xkmWrite(&olWire,SIZEOF(xkmOverlayDesc),1,file);
     size+= tmp*SIZEOF(xkmOverlayDesc);
     for (r=0,row=ol->rows;r<ol->num_rows;r++,row++) {
 	XkbOverlayKeyPtr	key;
 	rowWire.row_under= row->row_under;
 	rowWire.num_keys= row->num_keys;
-	tmp= fwrite(&rowWire,SIZEOF(xkmOverlayRowDesc),1,file);
+	tmp= xkmWrite(&rowWire,SIZEOF(xkmOverlayRowDesc),1,file);
 	size+= tmp*SIZEOF(xkmOverlayRowDesc);
 	for (k=0,key=row->keys;k<row->num_keys;k++,key++) {
 	    memcpy(keyWire.over,key->over.name,XkbKeyNameLength);
 	    memcpy(keyWire.under,key->under.name,XkbKeyNameLength);
-	    tmp= fwrite(&keyWire,SIZEOF(xkmOverlayKeyDesc),1,file);
+	    tmp= xkmWrite(&keyWire,SIZEOF(xkmOverlayKeyDesc),1,file);
 	    size+= tmp*SIZEOF(xkmOverlayKeyDesc);
 	}
     }
@@ -945,7 +994,7 @@ unsigned		tmp,size= 0;
 }
 
 static unsigned
-WriteXKMGeomSection(FILE *file,XkbFileInfo *result,XkbSectionPtr section)
+WriteXKMGeomSection(XkmOutput *file,XkbFileInfo *result,XkbSectionPtr section)
 {
 register int	i;
 Display *	dpy;
@@ -966,7 +1015,7 @@ unsigned	tmp,size= 0;
     sectionWire.num_doodads= section->num_doodads;
     sectionWire.num_overlays= section->num_overlays;
     sectionWire.pad2 = 0;
-    tmp= fwrite(&sectionWire,SIZEOF(xkmSectionDesc),1,file);
+    tmp= xkmWrite(&sectionWire,SIZEOF(xkmSectionDesc),1,file);
     size+= tmp*SIZEOF(xkmSectionDesc);
     if (section->rows) {
 	register unsigned k;
@@ -980,14 +1029,14 @@ unsigned	tmp,size= 0;
 	    rowWire.num_keys= row->num_keys;
 	    rowWire.vertical= row->vertical;
 			rowWire.pad = 0;
-	    tmp= fwrite(&rowWire,SIZEOF(xkmRowDesc),1,file);
+	    tmp= xkmWrite(&rowWire,SIZEOF(xkmRowDesc),1,file);
 	    size+= tmp*SIZEOF(xkmRowDesc);
 	    for (k=0,key=row->keys;k<row->num_keys;k++,key++) {
 		memcpy(keyWire.name,key->name.name,XkbKeyNameLength);
 		keyWire.gap= key->gap;
 		keyWire.shape_ndx= key->shape_ndx;
 		keyWire.color_ndx= key->color_ndx;
-		tmp= fwrite(&keyWire,SIZEOF(xkmKeyDesc),1,file);
+		tmp= xkmWrite(&keyWire,SIZEOF(xkmKeyDesc),1,file);
 		size+= tmp*SIZEOF(xkmKeyDesc);
 	    }
 	}
@@ -1008,7 +1057,7 @@ unsigned	tmp,size= 0;
 }
 
 static unsigned
-WriteXKMGeometry(FILE *file,XkbFileInfo *result)
+WriteXKMGeometry(XkmOutput *file,XkbFileInfo *result)
 {
 register int	i;
 Display *	dpy;
@@ -1034,7 +1083,7 @@ unsigned	tmp,size= 0;
     wire.num_key_aliases= geom->num_key_aliases;
     wire.pad1 = 0;
     size+= xkmPutCountedAtomString(dpy,file,geom->name);
-    tmp= fwrite(&wire,SIZEOF(xkmGeometryDesc),1,file);
+    tmp= xkmWrite(&wire,SIZEOF(xkmGeometryDesc),1,file);
     size+= tmp*SIZEOF(xkmGeometryDesc);
     size+= xkmPutCountedString(file,geom->label_font);
     if (geom->properties) {
@@ -1067,7 +1116,7 @@ unsigned	tmp,size= 0;
 	    if (shape->approx!=NULL)
 		 shapeWire.approx_ndx= XkbOutlineIndex(shape,shape->approx);
 	    else shapeWire.approx_ndx= XkbNoShape;
-	    tmp= fwrite(&shapeWire,SIZEOF(xkmShapeDesc),1,file);
+	    tmp= xkmWrite(&shapeWire,SIZEOF(xkmShapeDesc),1,file);
 	    size+= tmp*SIZEOF(xkmShapeDesc);
 	    for (n=0,ol=shape->outlines;n<shape->num_outlines;n++,ol++) {
 		register int	p;
@@ -1076,12 +1125,12 @@ unsigned	tmp,size= 0;
 		olWire.num_points= ol->num_points;
 		olWire.corner_radius= ol->corner_radius;
 		olWire.pad = 0;
-		tmp= fwrite(&olWire,SIZEOF(xkmOutlineDesc),1,file);
+		tmp= xkmWrite(&olWire,SIZEOF(xkmOutlineDesc),1,file);
 		size+= tmp*SIZEOF(xkmOutlineDesc);
 		for (p=0,pt=ol->points;p<ol->num_points;p++,pt++) {
 		    ptWire.x= pt->x;
 		    ptWire.y= pt->y;
-		    tmp= fwrite(&ptWire,SIZEOF(xkmPointDesc),1,file);
+		    tmp= xkmWrite(&ptWire,SIZEOF(xkmPointDesc),1,file);
 		    size+= tmp*SIZEOF(xkmPointDesc);
 		}
 	    }
@@ -1100,7 +1149,7 @@ unsigned	tmp,size= 0;
 	}
     }
     if (geom->key_aliases) {
-	tmp= fwrite(geom->key_aliases,2*XkbKeyNameLength,geom->num_key_aliases,
+	tmp= xkmWrite(geom->key_aliases,2*XkbKeyNameLength,geom->num_key_aliases,
 									file);
 	size+= tmp*(2*XkbKeyNameLength);
     }
@@ -1258,7 +1307,7 @@ int	total_size;
 }
 
 static Bool
-WriteXKMFile(	FILE *		file,
+WriteXKMFile(	XkmOutput *		file,
 		XkbFileInfo *	result,
 		int		num_toc,
 		xkmSectionInfo *toc,
@@ -1268,7 +1317,7 @@ register int 	i;
 unsigned	tmp,size,total= 0;
     
     for (i=0;i<num_toc;i++) {
-	tmp= fwrite(&toc[i],SIZEOF(xkmSectionInfo),1,file);
+	tmp= xkmWrite(&toc[i],SIZEOF(xkmSectionInfo),1,file);
 	total+= tmp*SIZEOF(xkmSectionInfo);
 	switch (toc[i].type) {
 	    case XkmTypesIndex:
@@ -1309,8 +1358,8 @@ unsigned	tmp,size,total= 0;
 
 #define	MAX_TOC	16
 
-Bool
-XkbWriteXKMFile(FILE *out,XkbFileInfo *result)
+static Bool
+XkbWriteXKMOutput(XkmOutput *out,XkbFileInfo *result)
 {
 Bool	 		ok;
 XkbDescPtr		xkb;
@@ -1362,10 +1411,6 @@ int			(*getTOC)(
 	_XkbLibError(_XkbErrEmptyFile,"XkbWriteXKMFile",0);
 	return False;
     }
-    if (out==NULL) {
-	_XkbLibError(_XkbErrFileCannotOpen,"XkbWriteXKMFile",0);
-	return False;
-    }
     for (i=present=0;i<size_toc;i++) {
 	toc[i].offset+= 4+SIZEOF(xkmFileInfo);
 	toc[i].offset+= (size_toc*SIZEOF(xkmSectionInfo));
@@ -1387,8 +1432,39 @@ int			(*getTOC)(
     fileInfo.num_toc= size_toc;
     fileInfo.present= present;
     fileInfo.pad= 0;
-    fwrite(&fileInfo,SIZEOF(xkmFileInfo),1,out);
-    fwrite(toc,SIZEOF(xkmSectionInfo),size_toc,out);
+    xkmWrite(&fileInfo,SIZEOF(xkmFileInfo),1,out);
+    xkmWrite(toc,SIZEOF(xkmSectionInfo),size_toc,out);
     ok= WriteXKMFile(out,result,size_toc,toc,&info);
     return ok;
 }
+
+Bool
+XkbWriteXKMFile(FILE *file,XkbFileInfo *result)
+{
+XkmOutput	out;
+
+    if (file==NULL) {
+	_XkbLibError(_XkbErrFileCannotOpen,"XkbWriteXKMFile",0);
+	return False;
+    }
+    bzero((char *)&out,sizeof(out));
+    out.file= file;
+    return XkbWriteXKMOutput(&out,result);
+}
+
+Bool
+XkbWriteXKMBuffer(XkbFileInfo *result,char **data_rtrn,size_t *size_rtrn)
+{
+XkmOutput	out;
+
+    bzero((char *)&out,sizeof(out));
+    if (!XkbWriteXKMOutput(&out,result) || out.failed) {
+	if (out.failed)
+	    _XkbLibError(_XkbErrBadAlloc,"XkbWriteXKMBuffer",0);
+	free(out.data);
+	return False;
+    }
+    *data_rtrn= out.data;
+    *size_rtrn= out.size;
+    return True;
+}
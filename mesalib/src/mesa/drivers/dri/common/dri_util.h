@@ -202,6 +202,7 @@ struct __DRIscreenRec {
     const __DRIextension **extensions;
 
     const __DRIswrastLoaderExtension *swrast_loader;
+    const __DRIswrastDirectExtension *swrast_direct;
 
     struct {
 	/* Flag to indicate that this is a DRI2 screen.  Many of the above
@@ -30,6 +30,11 @@
  * front-buffer rendering to avoid repeated calls to the loader.
  *
  * The back-buffer is allocated by the driver and is private.
+ *
+ * If the loader offers __DRI_SWRAST_DIRECT, the front-buffer is mapped
+ * straight from the drawable's storage whenever the loader allows it,
+ * instead of being read back and written out for each map.  Only the
+ * front-buffer is, since that storage is what the drawable shows.
  */
 
 #include <stdio.h>
@@ -500,6 +505,21 @@ swrast_map_renderbuffer(struct gl_context *ctx,
       xrb->map_w = w;
       xrb->map_h = h;
 
+      if (sPriv->swrast_direct) {
+         /* the storage may move between requests, so ask on every map */
+         map = sPriv->swrast_direct->getBuffer(dPriv, xrb->bpp,
+                                               rb->Width, rb->Height,
+                                               &stride,
+                                               dPriv->loaderPrivate);
+         if (map && stride >= bytes_per_line(rb->Width * xrb->bpp, 8)) {
+            xrb->direct = GL_TRUE;
+            xrb->Base.Buffer = map;
+            *out_map = map + (xrb->map_y + h - 1) * stride + x * cpp;
+            *out_stride = -stride;
+            return;
+         }
+      }
+
       stride = w * cpp;
       xrb->Base.Buffer = malloc(h * stride);
 
@@ -536,6 +556,16 @@ swrast_unmap_renderbuffer(struct gl_context *ctx,
       __DRIdrawable *dPriv = xrb->dPriv;
       __DRIscreen *sPriv = dPriv->driScreenPriv;
 
+      if (xrb->direct) {
+         if (xrb->map_mode & GL_MAP_WRITE_BIT)
+            sPriv->swrast_direct->damage(dPriv, xrb->map_x, xrb->map_y,
+                                         xrb->map_w, xrb->map_h,
+                                         dPriv->loaderPrivate);
+         xrb->direct = GL_FALSE;
+         xrb->Base.Buffer = NULL;
+         return;
+      }
+
       if (xrb->map_mode & GL_MAP_WRITE_BIT) {
 	 sPriv->swrast_loader->putImage(dPriv, __DRI_SWRAST_IMAGE_OP_DRAW,
 					xrb->map_x, xrb->map_y,
@@ -628,6 +658,39 @@ dri_destroy_buffer(__DRIdrawable * dPriv)
     }
 }
 
+/**
+ * Copy rows y to y + h - 1, top first, of the back buffer straight into
+ * the drawable's storage and report them damaged, if the loader lets us.
+ * Returns GL_FALSE if they have to go through putImage instead.
+ */
+static GLboolean
+dri_copy_direct(__DRIdrawable *dPriv, struct dri_swrast_renderbuffer *backrb,
+                int x, int y, int w, int h)
+{
+    __DRIscreen *sPriv = dPriv->driScreenPriv;
+    int cpp = (backrb->bpp + 7) / 8;
+    int width = backrb->Base.Base.Width;
+    char *src, *dst;
+    int stride, i;
+
+    if (!sPriv->swrast_direct)
+	return GL_FALSE;
+
+    dst = sPriv->swrast_direct->getBuffer(dPriv, backrb->bpp,
+					  width, backrb->Base.Base.Height,
+					  &stride, dPriv->loaderPrivate);
+    if (!dst || stride < bytes_per_line(width * backrb->bpp, 8))
+	return GL_FALSE;
+
+    src = (char *) backrb->Base.Buffer + y * backrb->pitch + x * cpp;
+    dst += y * stride + x * cpp;
+    for (i = 0; i < h; i++)
+	memcpy(dst + i * stride, src + i * backrb->pitch, w * cpp);
+
+    sPriv->swrast_direct->damage(dPriv, x, y, w, h, dPriv->loaderPrivate);
+    return GL_TRUE;
+}
+
 static void
 dri_swap_buffers(__DRIdrawable * dPriv)
 {
@@ -658,6 +721,10 @@ dri_swap_buffers(__DRIdrawable * dPriv)
 	_mesa_notifySwapBuffers(ctx);
     }
 
+    if (dri_copy_direct(dPriv, backrb, 0, 0,
+			frontrb->Base.Base.Width, frontrb->Base.Base.Height))
+	return;
+
     sPriv->swrast_loader->putImage(dPriv, __DRI_SWRAST_IMAGE_OP_SWAP,
 				   0, 0,
 				   frontrb->Base.Base.Width,
@@ -947,6 +1014,9 @@ dri_copy_sub_buffer(__DRIdrawable *dPriv, int x, int y,
        return;
 
     iy = frontrb->Base.Base.Height - y - h;
+    if (dri_copy_direct(dPriv, backrb, x, iy, w, h))
+       return;
+
     data = (char *)backrb->Base.Buffer + (iy * backrb->pitch) + (x * ((backrb->bpp + 7) / 8));
     sPriv->swrast_loader->putImage2(dPriv, __DRI_SWRAST_IMAGE_OP_SWAP,
                                     x, iy, w, h,
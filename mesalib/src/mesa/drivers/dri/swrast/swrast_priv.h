@@ -111,6 +111,8 @@ struct dri_swrast_renderbuffer {
 
     /* renderbuffer pitch (in bytes) */
     GLuint pitch;
+    /* mapped straight from the drawable's storage, from swrast_direct */
+    GLboolean direct;
    /* bits per pixel of storage */
     GLuint bpp;
 };
@@ -0,0 +1,661 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file prog_batch.c
+ * Execution of vertex/fragment programs on PROG_BATCH_LANES vertices or
+ * fragments at a time.
+ *
+ * _mesa_execute_program() decodes every instruction again for every
+ * vertex or fragment and works on one vec4 at a time.  Straight-line
+ * programs made of the common opcodes are instead decoded once, and run
+ * on a batch of lanes.  A register holds one row of lanes per component,
+ * so most instructions are one AVX or two SSE2 operations per row.  Texture
+ * instructions hand all the lanes that need a texel to the caller's
+ * sample function at once.  Anything else, like flow control or the
+ * rarer opcodes, is left to the interpreter.
+ *
+ * The results match the interpreter's: every opcode does the same float
+ * operations in the same order.
+ */
+
+
+#include <float.h>
+#include "c99_math.h"
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "prog_batch.h"
+#include "prog_cache.h"
+#include "prog_instruction.h"
+#include "prog_parameter.h"
+#include "util/u_cpu_detect.h"
+
+
+#define LANES PROG_BATCH_LANES
+
+#define FOR_EACH_VECTOR(i) for (i = 0; i < LANES; i += VF_WIDTH)
+#define FOR_EACH_ROW_VECTOR(k, i) for (k = 0; k < 4; k++) FOR_EACH_VECTOR(i)
+
+
+enum batch_file {
+   BATCH_TEMP,
+   BATCH_INPUT,
+   BATCH_OUTPUT,
+   BATCH_PARAM
+};
+
+struct batch_src
+{
+   GLubyte file;                /**< enum batch_file */
+   GLubyte swizzle[4];
+   GLboolean negate;
+   GLboolean relAddr;           /**< index plus the address register */
+   GLboolean direct;            /**< no swizzle or negation to apply */
+   GLint index;                 /**< into the file; inputs/outputs dense */
+};
+
+struct prog_batch_inst
+{
+   enum prog_opcode opcode;
+   GLuint numSrc;
+   GLboolean saturate;
+   GLubyte writeMask;
+   GLubyte dstFile;             /**< BATCH_TEMP or BATCH_OUTPUT */
+   GLuint dstIndex;
+   GLuint texSrcUnit;
+   GLint derivAttr;             /**< see prog_batch_sample_func */
+   struct batch_src src[3];
+};
+
+
+/** Cached for programs which can't be run in batches */
+static struct gl_program_batch unbatchable;
+
+static const GLfloat ZeroVec[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+
+
+/** Return the dense index of program register 'reg' in 'regs' */
+static GLint
+dense_index(GLuint *regs, GLuint *numRegs, GLuint maxRegs, GLuint reg)
+{
+   GLuint i;
+
+   for (i = 0; i < *numRegs; i++) {
+      if (regs[i] == reg)
+         return i;
+   }
+   if (i == maxRegs)
+      return -1;
+   regs[(*numRegs)++] = reg;
+   return i;
+}
+
+
+static GLboolean
+decode_src(struct gl_program_batch *batch, const struct gl_program *program,
+           const struct prog_src_register *reg, struct batch_src *src)
+{
+   const GLuint maxInputs = program->Target == GL_VERTEX_PROGRAM_ARB ?
+      VERT_ATTRIB_MAX : VARYING_SLOT_MAX;
+   const GLuint maxOutputs = program->Target == GL_VERTEX_PROGRAM_ARB ?
+      VARYING_SLOT_MAX : FRAG_RESULT_MAX;
+   GLuint i;
+
+   if (reg->Negate != NEGATE_NONE && reg->Negate != NEGATE_XYZW)
+      return GL_FALSE;
+
+   src->relAddr = reg->RelAddr;
+   src->index = reg->Index;
+
+   switch (reg->File) {
+   case PROGRAM_TEMPORARY:
+      if (reg->RelAddr || reg->Index < 0 || reg->Index >= PROG_BATCH_MAX_TEMPS)
+         return GL_FALSE;
+      src->file = BATCH_TEMP;
+      batch->NumTemps = MAX2(batch->NumTemps, (GLuint) reg->Index + 1);
+      break;
+   case PROGRAM_INPUT:
+      if (reg->RelAddr || reg->Index < 0 || reg->Index >= (GLint) maxInputs)
+         return GL_FALSE;
+      src->file = BATCH_INPUT;
+      src->index = dense_index(batch->Inputs, &batch->NumInputs,
+                               PROG_BATCH_MAX_INPUTS, reg->Index);
+      if (src->index < 0)
+         return GL_FALSE;
+      break;
+   case PROGRAM_OUTPUT:
+      if (reg->RelAddr || reg->Index < 0 || reg->Index >= (GLint) maxOutputs)
+         return GL_FALSE;
+      src->file = BATCH_OUTPUT;
+      src->index = dense_index(batch->Outputs, &batch->NumOutputs,
+                               PROG_BATCH_MAX_OUTPUTS, reg->Index);
+      if (src->index < 0)
+         return GL_FALSE;
+      break;
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+      /* the index is checked when the parameter is fetched */
+      src->file = BATCH_PARAM;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   for (i = 0; i < 4; i++) {
+      src->swizzle[i] = GET_SWZ(reg->Swizzle, i);
+      if (src->swizzle[i] > SWIZZLE_W)
+         return GL_FALSE;
+   }
+   src->negate = reg->Negate != NEGATE_NONE;
+   src->direct = reg->Swizzle == SWIZZLE_NOOP && !src->negate;
+   return GL_TRUE;
+}
+
+
+static GLboolean
+decode_inst(struct gl_program_batch *batch, const struct gl_program *program,
+            const struct prog_instruction *inst, struct prog_batch_inst *out)
+{
+   const struct prog_dst_register *dst = &inst->DstReg;
+   const GLboolean vertex = program->Target == GL_VERTEX_PROGRAM_ARB;
+   GLuint i;
+
+   switch (inst->Opcode) {
+   case OPCODE_ABS:
+   case OPCODE_ADD:
+   case OPCODE_ARL:
+   case OPCODE_CMP:
+   case OPCODE_DP2:
+   case OPCODE_DP3:
+   case OPCODE_DP4:
+   case OPCODE_DPH:
+   case OPCODE_DST:
+   case OPCODE_EX2:
+   case OPCODE_EXP:
+   case OPCODE_FLR:
+   case OPCODE_FRC:
+   case OPCODE_LG2:
+   case OPCODE_LIT:
+   case OPCODE_LOG:
+   case OPCODE_LRP:
+   case OPCODE_MAD:
+   case OPCODE_MAX:
+   case OPCODE_MIN:
+   case OPCODE_MOV:
+   case OPCODE_MUL:
+   case OPCODE_POW:
+   case OPCODE_RCP:
+   case OPCODE_RSQ:
+   case OPCODE_SGE:
+   case OPCODE_SLT:
+   case OPCODE_SSG:
+   case OPCODE_SUB:
+   case OPCODE_XPD:
+   case OPCODE_TEX:
+   case OPCODE_TXB:
+   case OPCODE_TXL:
+   case OPCODE_TXP:
+      break;
+   case OPCODE_KIL:
+      if (vertex)
+         return GL_FALSE;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   out->opcode = inst->Opcode;
+   out->numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+   out->saturate = inst->Saturate;
+   out->writeMask = dst->WriteMask;
+   out->texSrcUnit = inst->TexSrcUnit;
+   out->derivAttr = -1;
+
+   for (i = 0; i < out->numSrc; i++) {
+      if (!decode_src(batch, program, &inst->SrcReg[i], &out->src[i]))
+         return GL_FALSE;
+   }
+
+   if (inst->Opcode == OPCODE_KIL || inst->Opcode == OPCODE_ARL)
+      return GL_TRUE;
+
+   if (dst->RelAddr)
+      return GL_FALSE;
+   if (dst->File == PROGRAM_TEMPORARY &&
+       dst->Index < PROG_BATCH_MAX_TEMPS) {
+      out->dstFile = BATCH_TEMP;
+      out->dstIndex = dst->Index;
+      batch->NumTemps = MAX2(batch->NumTemps, dst->Index + 1);
+   }
+   else if (dst->File == PROGRAM_OUTPUT &&
+            dst->Index < (vertex ? VARYING_SLOT_MAX : FRAG_RESULT_MAX)) {
+      const GLint index = dense_index(batch->Outputs, &batch->NumOutputs,
+                                      PROG_BATCH_MAX_OUTPUTS, dst->Index);
+      if (index < 0)
+         return GL_FALSE;
+      out->dstFile = BATCH_OUTPUT;
+      out->dstIndex = index;
+   }
+   else {
+      return GL_FALSE;
+   }
+
+   if (out->opcode == OPCODE_TEX ||
+       out->opcode == OPCODE_TXB ||
+       out->opcode == OPCODE_TXL ||
+       out->opcode == OPCODE_TXP) {
+      if (inst->TexSrcUnit >= MAX_SAMPLERS)
+         return GL_FALSE;
+      /* the same test as fetch_texel() in prog_execute.c, which TXL
+       * doesn't go through
+       */
+      if (!vertex && out->opcode != OPCODE_TXL &&
+          inst->SrcReg[0].File == PROGRAM_INPUT &&
+          inst->SrcReg[0].Index == VARYING_SLOT_TEX0 + inst->TexSrcUnit)
+         out->derivAttr = inst->SrcReg[0].Index;
+   }
+   return GL_TRUE;
+}
+
+
+/**
+ * Decode 'program' for _mesa_execute_program_batch().
+ * \return  the decoded program, or NULL if it has to be interpreted
+ */
+struct gl_program_batch *
+_mesa_new_program_batch(const struct gl_program *program)
+{
+   struct gl_program_batch *batch;
+   GLuint pc;
+
+   if (program->arb.NumInstructions == 0)
+      return NULL;
+
+   /* for _mesa_execute_program_batch() */
+   util_cpu_detect();
+
+   batch = calloc(1, sizeof(*batch));
+   if (!batch)
+      return NULL;
+   batch->Insts = malloc(program->arb.NumInstructions *
+                         sizeof(*batch->Insts));
+   if (!batch->Insts) {
+      free(batch);
+      return NULL;
+   }
+
+   for (pc = 0; pc < program->arb.NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->arb.Instructions + pc;
+
+      if (inst->Opcode == OPCODE_END)
+         break;
+      if (inst->Opcode == OPCODE_NOP)
+         continue;
+      if (!decode_inst(batch, program, inst, &batch->Insts[batch->NumInsts])) {
+         _mesa_delete_program_batch(batch);
+         return NULL;
+      }
+      batch->NumInsts++;
+   }
+
+   return batch;
+}
+
+
+void
+_mesa_delete_program_batch(struct gl_program_batch *batch)
+{
+   if (batch && batch != &unbatchable) {
+      free(batch->Insts);
+      free(batch);
+   }
+}
+
+
+/**
+ * Return 'program' decoded, from 'cache' if a program with the same
+ * instructions was decoded before.  Programs of different targets must
+ * use different caches.
+ * \return  the decoded program, or NULL if it has to be interpreted
+ */
+struct gl_program_batch *
+_mesa_get_program_batch(struct gl_program_cache *cache,
+                        const struct gl_program *program)
+{
+   const GLuint keysize =
+      program->arb.NumInstructions * sizeof(struct prog_instruction);
+   struct gl_program_batch *batch;
+
+   if (keysize == 0)
+      return NULL;
+
+   batch = _mesa_search_batch_cache(cache, program->arb.Instructions,
+                                    keysize);
+   if (!batch) {
+      batch = _mesa_new_program_batch(program);
+      if (!batch)
+         batch = &unbatchable;
+      _mesa_batch_cache_insert(cache, program->arb.Instructions, keysize,
+                               batch);
+   }
+
+   return batch != &unbatchable ? batch : NULL;
+}
+
+
+/**
+ * Clear the registers a program may read before writing them.  The
+ * interpreter leaves whatever the previous vertex or fragment put there;
+ * here they start out as zero.
+ */
+void
+_mesa_clear_program_batch(const struct gl_program_batch *batch,
+                          struct gl_program_batch_machine *machine)
+{
+   memset(machine->Temps, 0, batch->NumTemps * sizeof(prog_batch_reg));
+   memset(machine->Outputs, 0, batch->NumOutputs * sizeof(prog_batch_reg));
+   memset(machine->AddressReg, 0, sizeof(machine->AddressReg));
+}
+
+
+/** The parameter 'reg', or zeros if there's none, as the interpreter does */
+static inline const GLfloat *
+param_value(const struct gl_program_parameter_list *params, GLint reg)
+{
+   if (reg < 0 || reg >= (GLint) params->NumParameters)
+      return ZeroVec;
+   return (const GLfloat *) params->ParameterValues +
+      params->ParameterValueOffset[reg];
+}
+
+
+
+/**
+ * TEX, TXB, TXL and TXP for the lanes in 'live'.  The coordinates are set up
+ * as the interpreter sets them up, then sampled with one call.
+ */
+static void
+sample_lanes(struct gl_context *ctx, struct gl_program_batch_machine *machine,
+             const struct prog_batch_inst *inst, prog_batch_row *coord,
+             GLbitfield live, prog_batch_reg result)
+{
+   GLfloat texcoords[LANES][4], lodBias[LANES], rgba[LANES][4];
+   GLuint lane[LANES];
+   GLuint i, j, k, n = 0;
+
+   for (i = 0; i < LANES; i++) {
+      GLfloat *tc = texcoords[n];
+
+      if (!(live & (1 << i)))
+         continue;
+
+      tc[0] = coord[0][i];
+      tc[1] = coord[1][i];
+      tc[2] = coord[2][i];
+      tc[3] = coord[3][i];
+      lodBias[n] = 0.0F;
+      if (inst->opcode == OPCODE_TEX) {
+         tc[3] = 1.0F;
+      }
+      else if (inst->opcode == OPCODE_TXB || inst->opcode == OPCODE_TXL) {
+         lodBias[n] = tc[3];
+      }
+      else if (tc[3] != 0.0F) {
+         tc[0] /= tc[3];
+         tc[1] /= tc[3];
+         tc[2] /= tc[3];
+      }
+      lane[n++] = i;
+   }
+
+   memset(result, 0, sizeof(prog_batch_reg));
+   if (n == 0)
+      return;
+
+   machine->Sample(ctx, machine->SampleData, inst->texSrcUnit,
+                   inst->derivAttr, n, (const GLfloat (*)[4]) texcoords,
+                   lodBias, rgba);
+
+   for (j = 0; j < n; j++) {
+      for (k = 0; k < 4; k++)
+         result[k][lane[j]] = rgba[j][k];
+   }
+}
+
+
+/** LIT, EXP and LOG of one lane, as the interpreter does them */
+static void
+scalar_vector_op(enum prog_opcode opcode, const GLfloat a[4],
+                 GLfloat result[4])
+{
+   fi_type fi;
+
+   switch (opcode) {
+   case OPCODE_LIT:
+      {
+         const GLfloat epsilon = 1.0F / 256.0F;      /* from NV VP spec */
+         const GLfloat x = MAX2(a[0], 0.0F);
+         const GLfloat y = MAX2(a[1], 0.0F);
+         const GLfloat w = CLAMP(a[3], -(128.0F - epsilon),
+                                 (128.0F - epsilon));
+         result[0] = 1.0F;
+         result[1] = x;
+         if (x > 0.0F) {
+            if (y == 0.0F && w == 0.0F)
+               result[2] = 1.0F;
+            else
+               result[2] = powf(y, w);
+         }
+         else {
+            result[2] = 0.0F;
+         }
+         result[3] = 1.0F;
+      }
+      break;
+   case OPCODE_EXP:
+      {
+         const GLfloat floor_t0 = floorf(a[0]);
+         if (floor_t0 > FLT_MAX_EXP) {
+            fi.i = 0x7F800000;
+            result[0] = result[2] = fi.f;
+         }
+         else if (floor_t0 < FLT_MIN_EXP) {
+            result[0] = result[2] = 0.0F;
+         }
+         else {
+            result[0] = ldexpf(1.0, (int) floor_t0);
+            result[2] = exp2f(a[0]);
+         }
+         result[1] = a[0] - floor_t0;
+         result[3] = 1.0F;
+      }
+      break;
+   default: /* OPCODE_LOG */
+      {
+         const GLfloat abs_t0 = fabsf(a[0]);
+         if (abs_t0 != 0.0F) {
+            if (IS_INF_OR_NAN(abs_t0)) {
+               fi.i = 0x7F800000;
+               result[0] = result[2] = fi.f;
+               result[1] = 1.0F;
+            }
+            else {
+               int exponent;
+               GLfloat mantissa = frexpf(a[0], &exponent);
+               result[0] = (GLfloat) (exponent - 1);
+               result[1] = 2.0F * mantissa;
+               result[2] = logf(a[0]) * 1.442695F;
+            }
+         }
+         else {
+            fi.i = 0xFF800000;
+            result[0] = result[2] = fi.f;
+            result[1] = 1.0F;
+         }
+         result[3] = 1.0F;
+      }
+      break;
+   }
+}
+
+
+
+
+/*
+ * The executor is built from prog_batch_tmp.h for SSE2, or plain C where
+ * there's no SSE2, and again with eight lanes a vector for AVX when the
+ * compiler can target it.  The AVX version is picked at run time.  Every
+ * operation the executor needs is in AVX already, AVX2 only adds integer
+ * ones, so there's no reason to leave out the CPUs which have just AVX.
+ * FMA is not enabled: fused multiply-adds would round differently from
+ * the interpreter.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+/** a < 0 ? b : c */
+static inline __m128
+sse2_cmp(__m128 a, __m128 b, __m128 c)
+{
+   const __m128 m = _mm_cmplt_ps(a, _mm_setzero_ps());
+   return _mm_or_ps(_mm_and_ps(m, b), _mm_andnot_ps(m, c));
+}
+
+#define VF_WIDTH 4
+#define vfloat __m128
+
+#define vf_load(p)       _mm_loadu_ps(p)
+#define vf_store(p, v)   _mm_storeu_ps(p, v)
+#define vf_set1(f)       _mm_set1_ps(f)
+#define vf_add(a, b)     _mm_add_ps(a, b)
+#define vf_sub(a, b)     _mm_sub_ps(a, b)
+#define vf_mul(a, b)     _mm_mul_ps(a, b)
+/* same operand order as MIN2/MAX2, so NaNs come out the same way */
+#define vf_min(a, b)     _mm_min_ps(a, b)
+#define vf_max(a, b)     _mm_max_ps(a, b)
+#define vf_neg(v)        _mm_xor_ps(v, _mm_set1_ps(-0.0F))
+#define vf_abs(v)        _mm_andnot_ps(_mm_set1_ps(-0.0F), v)
+#define vf_sge(a, b)     _mm_and_ps(_mm_cmpge_ps(a, b), _mm_set1_ps(1.0F))
+#define vf_slt(a, b)     _mm_and_ps(_mm_cmplt_ps(a, b), _mm_set1_ps(1.0F))
+/* CLAMP(v, 0, 1) */
+#define vf_sat(v)        _mm_min_ps(_mm_set1_ps(1.0F), \
+                                    _mm_max_ps(v, _mm_setzero_ps()))
+/* one bit per lane less than zero */
+#define vf_negbits(v)    _mm_movemask_ps(_mm_cmplt_ps(v, _mm_setzero_ps()))
+#define vf_cmp(a, b, c)  sse2_cmp(a, b, c)
+
+#else
+
+#define VF_WIDTH 1
+#define vfloat GLfloat
+
+#define vf_load(p)       (*(p))
+#define vf_store(p, v)   (*(p) = (v))
+#define vf_set1(f)       (f)
+#define vf_add(a, b)     ((a) + (b))
+#define vf_sub(a, b)     ((a) - (b))
+#define vf_mul(a, b)     ((a) * (b))
+#define vf_min(a, b)     MIN2(a, b)
+#define vf_max(a, b)     MAX2(a, b)
+#define vf_neg(v)        (-(v))
+#define vf_abs(v)        fabsf(v)
+#define vf_sge(a, b)     ((a) >= (b) ? 1.0F : 0.0F)
+#define vf_slt(a, b)     ((a) < (b) ? 1.0F : 0.0F)
+#define vf_sat(v)        CLAMP(v, 0.0F, 1.0F)
+#define vf_negbits(v)    ((v) < 0.0F)
+#define vf_cmp(a, b, c)  ((a) < 0.0F ? (b) : (c))
+
+#endif
+
+#define BATCH_FUNC(name) name
+#define BATCH_TARGET
+#include "prog_batch_tmp.h"
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PROG_BATCH_AVX
+#define PROG_BATCH_AVX_TARGET __attribute__((target("avx")))
+#elif defined(_MSC_VER) && defined(__AVX__)
+#define PROG_BATCH_AVX
+#define PROG_BATCH_AVX_TARGET
+#endif
+
+#ifdef PROG_BATCH_AVX
+#include <immintrin.h>
+
+#define VF_WIDTH 8
+#define vfloat __m256
+
+#define vf_load(p)       _mm256_loadu_ps(p)
+#define vf_store(p, v)   _mm256_storeu_ps(p, v)
+#define vf_set1(f)       _mm256_set1_ps(f)
+#define vf_add(a, b)     _mm256_add_ps(a, b)
+#define vf_sub(a, b)     _mm256_sub_ps(a, b)
+#define vf_mul(a, b)     _mm256_mul_ps(a, b)
+#define vf_min(a, b)     _mm256_min_ps(a, b)
+#define vf_max(a, b)     _mm256_max_ps(a, b)
+#define vf_neg(v)        _mm256_xor_ps(v, _mm256_set1_ps(-0.0F))
+#define vf_abs(v)        _mm256_andnot_ps(_mm256_set1_ps(-0.0F), v)
+#define vf_sge(a, b)     _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_GE_OS), \
+                                       _mm256_set1_ps(1.0F))
+#define vf_slt(a, b)     _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_LT_OS), \
+                                       _mm256_set1_ps(1.0F))
+#define vf_sat(v)        _mm256_min_ps(_mm256_set1_ps(1.0F), \
+                                       _mm256_max_ps(v, _mm256_setzero_ps()))
+#define vf_negbits(v)    _mm256_movemask_ps(_mm256_cmp_ps(v, \
+                                                          _mm256_setzero_ps(), \
+                                                          _CMP_LT_OS))
+#define vf_cmp(a, b, c)  _mm256_blendv_ps(c, b, \
+                                          _mm256_cmp_ps(a, _mm256_setzero_ps(), \
+                                                        _CMP_LT_OS))
+#define vf_floor(v)      _mm256_floor_ps(v)
+
+#define BATCH_FUNC(name) name##_avx
+#define BATCH_TARGET PROG_BATCH_AVX_TARGET
+#include "prog_batch_tmp.h"
+
+#endif /* PROG_BATCH_AVX */
+
+
+/**
+ * Run a decoded program on all the lanes of 'machine'.  Lanes not in
+ * 'live' are computed too, but never sampled.
+ * \return  bitmask of the lanes killed by KIL
+ */
+GLbitfield
+_mesa_execute_program_batch(struct gl_context *ctx,
+                            const struct gl_program *program,
+                            const struct gl_program_batch *batch,
+                            struct gl_program_batch_machine *machine,
+                            GLbitfield live)
+{
+#ifdef PROG_BATCH_AVX
+   /* util_cpu_detect() was called when the program was decoded */
+   if (util_cpu_caps.has_avx)
+      return execute_batch_avx(ctx, program, batch, machine, live);
+#endif
+   return execute_batch(ctx, program, batch, machine, live);
+}
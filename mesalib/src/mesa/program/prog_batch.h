@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file prog_batch.h
+ * Execution of vertex/fragment programs on several vertices or fragments
+ * at a time.
+ */
+
+#ifndef PROG_BATCH_H
+#define PROG_BATCH_H
+
+#include "main/glheader.h"
+#include "prog_instruction.h"
+
+struct gl_context;
+struct gl_program;
+struct gl_program_cache;
+struct prog_batch_inst;
+
+
+/** Vertices or fragments run together */
+#define PROG_BATCH_LANES 8
+
+#define PROG_BATCH_MAX_TEMPS 64
+#define PROG_BATCH_MAX_INPUTS 16
+#define PROG_BATCH_MAX_OUTPUTS 32
+
+/** One component of a register, for each lane */
+typedef GLfloat prog_batch_row[PROG_BATCH_LANES];
+/** A register for each lane */
+typedef prog_batch_row prog_batch_reg[4];
+
+
+/**
+ * Sample 'n' texture coordinates for the program's sampler 'texSrcUnit'.
+ * The coordinates are already divided for TXP.  'lodBias' is the bias of
+ * TXB or the lod of TXL, zero otherwise.  'derivAttr' is the fragment
+ * input the coordinates come from unchanged, so that its derivatives
+ * apply, or -1; it's always -1 for TXL.
+ */
+typedef void (*prog_batch_sample_func)(struct gl_context *ctx, void *data,
+                                       GLuint texSrcUnit, GLint derivAttr,
+                                       GLuint n, const GLfloat texcoords[][4],
+                                       const GLfloat lodBias[],
+                                       GLfloat rgba[][4]);
+
+
+/**
+ * A program decoded for _mesa_execute_program_batch().  Its inputs and
+ * outputs are numbered densely; Inputs[] and Outputs[] give the program
+ * register of each.
+ */
+struct gl_program_batch
+{
+   GLuint NumInputs;
+   GLuint Inputs[PROG_BATCH_MAX_INPUTS];
+   GLuint NumOutputs;
+   GLuint Outputs[PROG_BATCH_MAX_OUTPUTS];
+   GLuint NumTemps;
+
+   GLuint NumInsts;
+   struct prog_batch_inst *Insts;
+};
+
+
+/**
+ * Registers of the lanes being run.  The caller loads Inputs and reads
+ * Outputs; _mesa_clear_program_batch() clears the rest.
+ */
+struct gl_program_batch_machine
+{
+   prog_batch_reg Temps[PROG_BATCH_MAX_TEMPS];
+   prog_batch_reg Inputs[PROG_BATCH_MAX_INPUTS];
+   prog_batch_reg Outputs[PROG_BATCH_MAX_OUTPUTS];
+   GLint AddressReg[PROG_BATCH_LANES];
+
+   prog_batch_sample_func Sample;
+   void *SampleData;
+};
+
+
+extern struct gl_program_batch *
+_mesa_new_program_batch(const struct gl_program *program);
+
+extern void
+_mesa_delete_program_batch(struct gl_program_batch *batch);
+
+extern struct gl_program_batch *
+_mesa_get_program_batch(struct gl_program_cache *cache,
+                        const struct gl_program *program);
+
+extern void
+_mesa_clear_program_batch(const struct gl_program_batch *batch,
+                          struct gl_program_batch_machine *machine);
+
+extern GLbitfield
+_mesa_execute_program_batch(struct gl_context *ctx,
+                            const struct gl_program *program,
+                            const struct gl_program_batch *batch,
+                            struct gl_program_batch_machine *machine,
+                            GLbitfield live);
+
+
+#endif /* PROG_BATCH_H */
@@ -0,0 +1,491 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file prog_batch_test.c
+ * Run programs with _mesa_execute_program_batch() and, one lane at a
+ * time, with _mesa_execute_program(), and check that every register,
+ * the kill mask and the texel fetches come out the same.  Where the CPU
+ * has AVX the SSE2 executor is checked as well.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c99_math.h"
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "prog_batch.h"
+#include "prog_execute.h"
+#include "prog_instruction.h"
+#include "prog_parameter.h"
+#include "util/u_cpu_detect.h"
+
+#define LANES PROG_BATCH_LANES
+#define ROUNDS 256
+
+struct test_src
+{
+   gl_register_file file;
+   GLint index;
+   GLuint swizzle;
+   GLuint negate;
+   GLboolean relAddr;
+};
+
+struct test_inst
+{
+   enum prog_opcode opcode;
+   gl_register_file dstFile;
+   GLuint dstIndex;
+   GLuint writeMask;
+   GLboolean saturate;
+   GLuint texSrcUnit;
+   struct test_src src[3];
+};
+
+#define SRC(file, index, swizzle, negate) \
+   { file, index, swizzle, negate, GL_FALSE }
+#define TEMP(i)          SRC(PROGRAM_TEMPORARY, i, SWIZZLE_NOOP, NEGATE_NONE)
+#define TEMP_SWZ(i, s)   SRC(PROGRAM_TEMPORARY, i, s, NEGATE_NONE)
+#define TEMP_NEG(i)      SRC(PROGRAM_TEMPORARY, i, SWIZZLE_NOOP, NEGATE_XYZW)
+#define INPUT(i)         SRC(PROGRAM_INPUT, i, SWIZZLE_NOOP, NEGATE_NONE)
+#define INPUT_SWZ(i, s)  SRC(PROGRAM_INPUT, i, s, NEGATE_NONE)
+#define INPUT_NEG(i)     SRC(PROGRAM_INPUT, i, SWIZZLE_NOOP, NEGATE_XYZW)
+#define CONST(i)         SRC(PROGRAM_CONSTANT, i, SWIZZLE_NOOP, NEGATE_NONE)
+#define CONST_SWZ(i, s)  SRC(PROGRAM_CONSTANT, i, s, NEGATE_NONE)
+#define CONST_NEG(i)     SRC(PROGRAM_CONSTANT, i, SWIZZLE_NOOP, NEGATE_XYZW)
+#define CONST_REL(i) \
+   { PROGRAM_CONSTANT, i, SWIZZLE_NOOP, NEGATE_NONE, GL_TRUE }
+
+#define OP(opcode, file, index, mask, ...) \
+   { opcode, file, index, mask, GL_FALSE, 0, { __VA_ARGS__ } }
+#define OP_SAT(opcode, file, index, mask, ...) \
+   { opcode, file, index, mask, GL_TRUE, 0, { __VA_ARGS__ } }
+#define OP_TEX(opcode, file, index, unit, coord) \
+   { opcode, file, index, WRITEMASK_XYZW, GL_FALSE, unit, { coord } }
+
+#define T PROGRAM_TEMPORARY
+#define O PROGRAM_OUTPUT
+#define XYZW WRITEMASK_XYZW
+
+#define SWZ(x, y, z, w) \
+   MAKE_SWIZZLE4(SWIZZLE_##x, SWIZZLE_##y, SWIZZLE_##z, SWIZZLE_##w)
+
+
+/** Every opcode the batches run, with derivatives for some texel fetches */
+static const struct test_inst fragment_program[] = {
+   OP(OPCODE_MUL, T, 0, XYZW, INPUT(VARYING_SLOT_COL0), CONST(0)),
+   OP(OPCODE_MAD, T, 1, XYZW, INPUT_SWZ(VARYING_SLOT_TEX1, SWZ(Y, Z, W, X)),
+      CONST_NEG(1), TEMP(0)),
+   OP(OPCODE_CMP, T, 2, XYZW, TEMP(1), INPUT(VARYING_SLOT_COL0),
+      INPUT_NEG(VARYING_SLOT_TEX1)),
+   OP(OPCODE_DP4, T, 3, WRITEMASK_X, TEMP(2), CONST(2)),
+   OP(OPCODE_DP3, T, 3, WRITEMASK_Y, TEMP_SWZ(2, SWZ(Z, X, Y, W)), TEMP(1)),
+   OP(OPCODE_DPH, T, 3, WRITEMASK_Z, TEMP(1), CONST(2)),
+   OP(OPCODE_DP2, T, 3, WRITEMASK_W, TEMP(0), TEMP_NEG(2)),
+   OP_SAT(OPCODE_LRP, T, 4, XYZW, CONST_SWZ(3, SWIZZLE_XXXX), TEMP(2),
+          TEMP(1)),
+   OP(OPCODE_XPD, T, 5, WRITEMASK_XYZ, TEMP(0), TEMP(1)),
+   OP(OPCODE_ABS, T, 6, XYZW, TEMP_NEG(1)),
+   OP(OPCODE_MIN, T, 7, XYZW, TEMP(1), TEMP(2)),
+   OP(OPCODE_MAX, T, 7, WRITEMASK_ZW, TEMP(0), CONST(1)),
+   OP(OPCODE_SGE, T, 8, XYZW, TEMP(1), TEMP(2)),
+   OP(OPCODE_SLT, T, 8, WRITEMASK_YW, TEMP(0), CONST(3)),
+   OP(OPCODE_SUB, T, 9, XYZW, TEMP(3), TEMP(4)),
+   OP_SAT(OPCODE_ADD, T, 9, WRITEMASK_XY, TEMP(9), TEMP(5)),
+   OP(OPCODE_FLR, T, 10, XYZW, TEMP(1)),
+   OP(OPCODE_FRC, T, 11, XYZW, TEMP(2)),
+   OP(OPCODE_SSG, T, 12, XYZW, TEMP(1)),
+   OP(OPCODE_RCP, T, 13, WRITEMASK_X, TEMP_SWZ(3, SWIZZLE_XXXX)),
+   OP(OPCODE_RSQ, T, 13, WRITEMASK_Y, TEMP_SWZ(3, SWIZZLE_YYYY)),
+   OP(OPCODE_EX2, T, 13, WRITEMASK_Z, TEMP_SWZ(3, SWIZZLE_ZZZZ)),
+   OP(OPCODE_LG2, T, 13, WRITEMASK_W, TEMP_SWZ(3, SWIZZLE_WWWW)),
+   OP(OPCODE_POW, T, 14, XYZW, TEMP_SWZ(3, SWIZZLE_XXXX),
+      CONST_SWZ(3, SWIZZLE_YYYY)),
+   OP(OPCODE_LIT, T, 15, XYZW, TEMP(1)),
+   OP(OPCODE_EXP, T, 16, XYZW, TEMP_SWZ(2, SWIZZLE_XXXX)),
+   OP(OPCODE_LOG, T, 17, XYZW, TEMP_SWZ(3, SWIZZLE_YYYY)),
+   OP(OPCODE_DST, T, 18, XYZW, TEMP(1), TEMP(2)),
+   /* the coordinates of these two have derivatives */
+   OP_TEX(OPCODE_TEX, T, 19, 0, INPUT(VARYING_SLOT_TEX0)),
+   OP_TEX(OPCODE_TXB, T, 20, 1, INPUT(VARYING_SLOT_TEX1)),
+   /* these don't, TXL never uses them */
+   OP_TEX(OPCODE_TXP, T, 21, 2, TEMP(1)),
+   OP_TEX(OPCODE_TEX, T, 22, 1, INPUT(VARYING_SLOT_TEX0)),
+   OP_TEX(OPCODE_TXL, T, 25, 0, INPUT(VARYING_SLOT_TEX0)),
+   /* about half the fragments have a component below -2.5 */
+   OP(OPCODE_ADD, T, 24, XYZW, INPUT(VARYING_SLOT_TEX1), CONST(5)),
+   OP(OPCODE_KIL, T, 0, 0, TEMP(24)),
+   /* killed fragments mustn't be sampled */
+   OP_TEX(OPCODE_TXB, T, 23, 0, INPUT(VARYING_SLOT_TEX0)),
+   OP(OPCODE_MOV, O, FRAG_RESULT_COLOR, XYZW, TEMP(23)),
+   OP_SAT(OPCODE_MOV, O, FRAG_RESULT_DATA0 + 1, WRITEMASK_YW, TEMP(9)),
+   OP(OPCODE_ADD, O, FRAG_RESULT_DEPTH, WRITEMASK_Z,
+      SRC(PROGRAM_OUTPUT, FRAG_RESULT_COLOR, SWIZZLE_NOOP, NEGATE_XYZW),
+      TEMP(13)),
+};
+
+/** Address register relative parameters */
+static const struct test_inst vertex_program[] = {
+   OP(OPCODE_ARL, PROGRAM_ADDRESS, 0, WRITEMASK_X,
+      INPUT_SWZ(VERT_ATTRIB_GENERIC0, SWIZZLE_WWWW)),
+   OP(OPCODE_MOV, T, 0, XYZW, CONST_REL(1)),
+   OP(OPCODE_MAD, T, 1, XYZW, INPUT(VERT_ATTRIB_POS), TEMP(0), CONST(0)),
+   OP(OPCODE_DP4, O, VARYING_SLOT_POS, WRITEMASK_X, TEMP(1), CONST(1)),
+   OP(OPCODE_DP4, O, VARYING_SLOT_POS, WRITEMASK_Y, TEMP(1), CONST(2)),
+   OP(OPCODE_DP4, O, VARYING_SLOT_POS, WRITEMASK_Z, TEMP(1), CONST(3)),
+   OP(OPCODE_MOV, O, VARYING_SLOT_POS, WRITEMASK_W, TEMP(0)),
+   OP_TEX(OPCODE_TEX, T, 2, 0, INPUT(VERT_ATTRIB_TEX0)),
+   OP_TEX(OPCODE_TXB, T, 3, 1, INPUT(VERT_ATTRIB_TEX0)),
+   OP_TEX(OPCODE_TXL, T, 4, 2, INPUT_SWZ(VERT_ATTRIB_TEX0, SWZ(W, Z, Y, X))),
+   OP_SAT(OPCODE_ADD, O, VARYING_SLOT_COL0, XYZW, TEMP(2), TEMP(3)),
+   OP(OPCODE_MOV, O, VARYING_SLOT_FOGC, WRITEMASK_X,
+      INPUT_SWZ(VERT_ATTRIB_GENERIC0, SWIZZLE_YYYY)),
+};
+
+static const GLfloat constants[][4] = {
+   {  0.5F, -1.0F,  2.0F,  0.0F },
+   {  1.0F,  0.25F, -0.75F, 3.0F },
+   { -2.0F,  0.0F,  1.5F,  -0.5F },
+   {  0.3F,  2.5F,  -1.0F,  1.0F },
+   {  4.0F, -3.0F,  0.125F, -8.0F },
+   {  2.5F,  2.5F,  2.5F,  2.5F },
+};
+
+static const GLubyte samplers[MAX_SAMPLERS] = { 3, 0, 7 };
+
+static GLfloat deriv_x[VARYING_SLOT_MAX][4];
+static GLfloat deriv_y[VARYING_SLOT_MAX][4];
+
+static GLuint fetches;
+
+
+static GLuint
+rand_next(void)
+{
+   static GLuint seed = 1;
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+
+/** Mostly small values, and some that take the edge cases */
+static GLfloat
+rand_value(void)
+{
+   static const GLfloat special[] = {
+      0.0F, -0.0F, 1.0F, -1.0F, 0.5F, 1e20F, -1e20F, 1e-30F,
+   };
+   const GLuint r = rand_next();
+
+   if (r % 8 == 0)
+      return special[(r >> 3) % ARRAY_SIZE(special)];
+   return (GLfloat) ((GLint) ((r >> 3) % 8001) - 4000) / 1000.0F;
+}
+
+
+/** A texel that depends on everything the program passes */
+static void
+fake_texel(const GLfloat texcoord[4], GLfloat lambda, GLuint unit,
+           GLfloat color[4])
+{
+   GLuint k;
+
+   for (k = 0; k < 4; k++)
+      color[k] = texcoord[k] * (GLfloat) (k + 1) + lambda + (GLfloat) unit;
+   fetches++;
+}
+
+
+static void
+fetch_texel_lod(struct gl_context *ctx, const GLfloat texcoord[4],
+                GLfloat lambda, GLuint unit, GLfloat color[4])
+{
+   fake_texel(texcoord, lambda, unit, color);
+}
+
+
+static void
+fetch_texel_deriv(struct gl_context *ctx, const GLfloat texcoord[4],
+                  const GLfloat texdx[4], const GLfloat texdy[4],
+                  GLfloat lodBias, GLuint unit, GLfloat color[4])
+{
+   fake_texel(texcoord, texdx[0] + texdy[1] + lodBias, unit, color);
+}
+
+
+static void
+sample_texels(struct gl_context *ctx, void *data,
+              GLuint texSrcUnit, GLint derivAttr,
+              GLuint n, const GLfloat texcoords[][4],
+              const GLfloat lodBias[], GLfloat rgba[][4])
+{
+   GLuint i;
+
+   for (i = 0; i < n; i++) {
+      GLfloat lambda = lodBias[i];
+      if (derivAttr >= 0)
+         lambda = deriv_x[derivAttr][0] + deriv_y[derivAttr][1] + lodBias[i];
+      fake_texel(texcoords[i], lambda, samplers[texSrcUnit], rgba[i]);
+   }
+}
+
+
+static void
+init_program(struct gl_program *prog, GLenum target,
+             const struct test_inst *insts, GLuint n)
+{
+   GLuint i, j;
+
+   memset(prog, 0, sizeof(*prog));
+   prog->Target = target;
+   prog->arb.NumInstructions = n + 1;
+   prog->arb.Instructions = calloc(n + 1, sizeof(struct prog_instruction));
+   _mesa_init_instructions(prog->arb.Instructions, n + 1);
+
+   for (i = 0; i < n; i++) {
+      struct prog_instruction *inst = &prog->arb.Instructions[i];
+
+      inst->Opcode = insts[i].opcode;
+      inst->Saturate = insts[i].saturate;
+      inst->TexSrcUnit = insts[i].texSrcUnit;
+      inst->DstReg.File = insts[i].dstFile;
+      inst->DstReg.Index = insts[i].dstIndex;
+      inst->DstReg.WriteMask = insts[i].writeMask;
+      for (j = 0; j < _mesa_num_inst_src_regs(inst->Opcode); j++) {
+         inst->SrcReg[j].File = insts[i].src[j].file;
+         inst->SrcReg[j].Index = insts[i].src[j].index;
+         inst->SrcReg[j].Swizzle = insts[i].src[j].swizzle;
+         inst->SrcReg[j].Negate = insts[i].src[j].negate;
+         inst->SrcReg[j].RelAddr = insts[i].src[j].relAddr;
+      }
+   }
+   prog->arb.Instructions[n].Opcode = OPCODE_END;
+
+   prog->Parameters = _mesa_new_parameter_list();
+   for (i = 0; i < ARRAY_SIZE(constants); i++)
+      _mesa_add_parameter(prog->Parameters, PROGRAM_CONSTANT, NULL, 4,
+                          GL_NONE, (const gl_constant_value *) constants[i],
+                          NULL, true);
+}
+
+
+static bool
+same_value(GLfloat a, GLfloat b)
+{
+   return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+
+static bool
+check_reg(const char *name, GLuint round, GLuint lane, GLuint index,
+          const GLfloat expected[4], const prog_batch_reg reg)
+{
+   bool failed = false;
+   GLuint k;
+
+   for (k = 0; k < 4; k++) {
+      if (!same_value(expected[k], reg[k][lane])) {
+         fprintf(stderr, "round %u lane %u: %s[%u].%c expected %g (%a) "
+                         "but got %g (%a)\n",
+                 round, lane, name, index, "xyzw"[k],
+                 expected[k], expected[k], reg[k][lane], reg[k][lane]);
+         failed = true;
+      }
+   }
+   return failed;
+}
+
+
+/**
+ * Run 'prog' on random inputs both ways.
+ * \return  true if they differ
+ */
+static bool
+run_program(struct gl_context *ctx, const struct gl_program *prog,
+            struct gl_program_machine *machine,
+            struct gl_program_batch_machine *batch_machine)
+{
+   const GLboolean vertex = prog->Target == GL_VERTEX_PROGRAM_ARB;
+   struct gl_program_batch *batch = _mesa_new_program_batch(prog);
+   bool failed = false;
+   GLuint round, lane, j, k;
+
+   if (!batch) {
+      fprintf(stderr, "%s program not decoded for batches\n",
+              vertex ? "vertex" : "fragment");
+      return true;
+   }
+
+   batch_machine->Sample = sample_texels;
+   batch_machine->SampleData = NULL;
+   /* derivatives are only for fragment inputs */
+   machine->NumDeriv = vertex ? 0 : VARYING_SLOT_MAX;
+
+   for (round = 0; round < ROUNDS && !failed; round++) {
+      /* some rounds with lanes left out */
+      const GLbitfield live = round % 4 == 3 ?
+         rand_next() & BITFIELD_MASK(LANES) : BITFIELD_MASK(LANES);
+      GLbitfield killed = 0, batch_killed;
+      GLuint interp_fetches;
+
+      for (j = 0; j < VARYING_SLOT_MAX; j++) {
+         for (k = 0; k < 4; k++) {
+            deriv_x[j][k] = rand_value();
+            deriv_y[j][k] = rand_value();
+         }
+      }
+
+      _mesa_clear_program_batch(batch, batch_machine);
+      for (j = 0; j < batch->NumInputs; j++) {
+         const GLuint attr = batch->Inputs[j];
+
+         for (lane = 0; lane < LANES; lane++) {
+            for (k = 0; k < 4; k++) {
+               GLfloat v = rand_value();
+               /* address register values around the parameters */
+               if (vertex && attr == VERT_ATTRIB_GENERIC0 && k == 3)
+                  v = (GLfloat) ((GLint) (rand_next() % 10) - 3) + 0.5F;
+               batch_machine->Inputs[j][k][lane] = v;
+               if (vertex)
+                  machine[lane].VertAttribs[attr][k] = v;
+               else
+                  machine->Attribs[attr][lane][k] = v;
+            }
+         }
+      }
+
+      fetches = 0;
+      for (lane = 0; lane < LANES; lane++) {
+         struct gl_program_machine *m = &machine[vertex ? lane : 0];
+
+         if (!(live & (1 << lane)))
+            continue;
+
+         memset(m->Temporaries, 0, sizeof(m->Temporaries));
+         memset(m->Outputs, 0, sizeof(m->Outputs));
+         memset(m->AddressReg, 0, sizeof(m->AddressReg));
+         m->CurElement = lane;
+         if (!_mesa_execute_program(ctx, prog, m))
+            killed |= 1 << lane;
+
+         if (vertex)
+            continue;
+
+         /* only the fragment machine is shared by the lanes */
+         for (j = 0; j < batch->NumOutputs; j++)
+            COPY_4V(machine[1 + lane].Outputs[j],
+                    m->Outputs[batch->Outputs[j]]);
+         memcpy(machine[1 + lane].Temporaries, m->Temporaries,
+                batch->NumTemps * sizeof(m->Temporaries[0]));
+      }
+      interp_fetches = fetches;
+
+      fetches = 0;
+      batch_killed = _mesa_execute_program_batch(ctx, prog, batch,
+                                                 batch_machine, live);
+
+      if ((batch_killed & live) != killed) {
+         fprintf(stderr, "round %u: expected kill mask 0x%x but got 0x%x\n",
+                 round, killed, batch_killed & live);
+         failed = true;
+      }
+      if (fetches != interp_fetches) {
+         fprintf(stderr, "round %u: expected %u texel fetches but got %u\n",
+                 round, interp_fetches, fetches);
+         failed = true;
+      }
+
+      for (lane = 0; lane < LANES; lane++) {
+         const struct gl_program_machine *m = &machine[vertex ? lane : 1 + lane];
+
+         if (!(live & ~killed & (1 << lane)))
+            continue;
+
+         for (j = 0; j < batch->NumTemps; j++)
+            failed |= check_reg("temp", round, lane, j, m->Temporaries[j],
+                                batch_machine->Temps[j]);
+         for (j = 0; j < batch->NumOutputs; j++) {
+            const GLfloat *expected = vertex ?
+               m->Outputs[batch->Outputs[j]] : m->Outputs[j];
+            failed |= check_reg("output", round, lane, batch->Outputs[j],
+                                expected, batch_machine->Outputs[j]);
+         }
+      }
+   }
+
+   _mesa_delete_program_batch(batch);
+   return failed;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   struct gl_context *ctx = calloc(1, sizeof(*ctx));
+   /* one machine per vertex; fragments share machine[0] and their
+    * registers are kept in the others
+    */
+   struct gl_program_machine *machine =
+      calloc(1 + LANES, sizeof(*machine));
+   struct gl_program_batch_machine *batch_machine =
+      calloc(1, sizeof(*batch_machine));
+   struct gl_program fp, vp;
+   bool failed = false;
+   GLuint i;
+
+   if (!ctx || !machine || !batch_machine)
+      return 1;
+
+   machine->Attribs = calloc(VARYING_SLOT_MAX, sizeof(*machine->Attribs));
+   if (!machine->Attribs)
+      return 1;
+   for (i = 0; i < 1 + LANES; i++) {
+      machine[i].DerivX = deriv_x;
+      machine[i].DerivY = deriv_y;
+      machine[i].Samplers = samplers;
+      machine[i].FetchTexelLod = fetch_texel_lod;
+      machine[i].FetchTexelDeriv = fetch_texel_deriv;
+   }
+
+   init_program(&fp, GL_FRAGMENT_PROGRAM_ARB, fragment_program,
+                ARRAY_SIZE(fragment_program));
+   init_program(&vp, GL_VERTEX_PROGRAM_ARB, vertex_program,
+                ARRAY_SIZE(vertex_program));
+
+   for (;;) {
+      failed |= run_program(ctx, &fp, machine, batch_machine);
+      failed |= run_program(ctx, &vp, machine, batch_machine);
+
+      /* again without AVX, util_cpu_detect() has run by now */
+      if (!util_cpu_caps.has_avx)
+         break;
+      util_cpu_caps.has_avx = 0;
+   }
+
+   return failed;
+}
@@ -0,0 +1,372 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Program batch executor template
+ *
+ * This file is #include'd by prog_batch.c once for each instruction set
+ * the executor is built for.  Before including it, define:
+ *    VF_WIDTH           - the number of lanes in a vfloat
+ *    vfloat             - the vector type
+ *    vf_load(p), vf_store(p, v), vf_set1(f), vf_add(a, b), vf_sub(a, b),
+ *    vf_mul(a, b), vf_min(a, b), vf_max(a, b), vf_neg(v), vf_abs(v),
+ *    vf_sge(a, b), vf_slt(a, b), vf_sat(v), vf_negbits(v), vf_cmp(a, b, c)
+ *                       - the operations, see the SSE2 ones for what each
+ *                         has to do
+ *    BATCH_FUNC(name)   - the name of this version of function 'name'
+ *    BATCH_TARGET       - attributes for the instruction set, or nothing
+ *
+ * Optionally:
+ *    vf_floor(v)        - floorf() of each lane
+ *
+ * All of them are undefined at the end.
+ */
+
+/**
+ * Return the value of a source register, swizzled and negated into 'tmp'
+ * unless the register can be used as it is.
+ */
+static BATCH_TARGET prog_batch_row *
+BATCH_FUNC(fetch_src)(const struct gl_program *program,
+          struct gl_program_batch_machine *machine,
+          const struct batch_src *src, prog_batch_reg tmp)
+{
+   prog_batch_row *reg;
+   GLuint k, i;
+
+   if (src->file == BATCH_PARAM) {
+      if (!src->relAddr) {
+         const GLfloat *value = param_value(program->Parameters, src->index);
+
+         for (k = 0; k < 4; k++) {
+            const GLfloat f = value[src->swizzle[k]];
+            const vfloat v = vf_set1(src->negate ? -f : f);
+            FOR_EACH_VECTOR(i)
+               vf_store(&tmp[k][i], v);
+         }
+      }
+      else {
+         for (i = 0; i < LANES; i++) {
+            const GLfloat *value =
+               param_value(program->Parameters,
+                           src->index + machine->AddressReg[i]);
+
+            for (k = 0; k < 4; k++) {
+               const GLfloat f = value[src->swizzle[k]];
+               tmp[k][i] = src->negate ? -f : f;
+            }
+         }
+      }
+      return tmp;
+   }
+
+   if (src->file == BATCH_TEMP)
+      reg = machine->Temps[src->index];
+   else if (src->file == BATCH_INPUT)
+      reg = machine->Inputs[src->index];
+   else
+      reg = machine->Outputs[src->index];
+
+   if (src->direct)
+      return reg;
+
+   FOR_EACH_ROW_VECTOR(k, i) {
+      const vfloat v = vf_load(&reg[src->swizzle[k]][i]);
+      vf_store(&tmp[k][i], src->negate ? vf_neg(v) : v);
+   }
+   return tmp;
+}
+
+
+/**
+ * Store an instruction's result, observing saturation and the write mask.
+ */
+static BATCH_TARGET void
+BATCH_FUNC(store_dst)(struct gl_program_batch_machine *machine,
+          const struct prog_batch_inst *inst, prog_batch_reg value)
+{
+   prog_batch_row *dst = inst->dstFile == BATCH_TEMP ?
+      machine->Temps[inst->dstIndex] : machine->Outputs[inst->dstIndex];
+   GLuint k, i;
+
+   for (k = 0; k < 4; k++) {
+      if (!(inst->writeMask & (1 << k)))
+         continue;
+      if (inst->saturate) {
+         FOR_EACH_VECTOR(i)
+            vf_store(&dst[k][i], vf_sat(vf_load(&value[k][i])));
+      }
+      else {
+         memcpy(dst[k], value[k], sizeof(prog_batch_row));
+      }
+   }
+}
+
+
+/**
+ * _mesa_execute_program_batch() for this instruction set.
+ */
+static BATCH_TARGET GLbitfield
+BATCH_FUNC(execute_batch)(struct gl_context *ctx,
+                          const struct gl_program *program,
+                          const struct gl_program_batch *batch,
+                          struct gl_program_batch_machine *machine,
+                          GLbitfield live)
+{
+   GLbitfield killed = 0;
+   GLuint pc, k, i;
+
+   for (pc = 0; pc < batch->NumInsts; pc++) {
+      const struct prog_batch_inst *inst = &batch->Insts[pc];
+      prog_batch_reg tmp[3], result;
+      prog_batch_row *a = NULL, *b = NULL, *c = NULL;
+
+      if (inst->numSrc > 0)
+         a = BATCH_FUNC(fetch_src)(program, machine, &inst->src[0], tmp[0]);
+      if (inst->numSrc > 1)
+         b = BATCH_FUNC(fetch_src)(program, machine, &inst->src[1], tmp[1]);
+      if (inst->numSrc > 2)
+         c = BATCH_FUNC(fetch_src)(program, machine, &inst->src[2], tmp[2]);
+
+      switch (inst->opcode) {
+      case OPCODE_ABS:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_abs(vf_load(&a[k][i])));
+         break;
+      case OPCODE_ADD:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_add(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_SUB:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_sub(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_MUL:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_mul(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_MAD:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i],
+                     vf_add(vf_mul(vf_load(&a[k][i]), vf_load(&b[k][i])),
+                            vf_load(&c[k][i])));
+         break;
+      case OPCODE_LRP:
+         /* a * b + (1 - a) * c */
+         FOR_EACH_ROW_VECTOR(k, i) {
+            const vfloat va = vf_load(&a[k][i]);
+            vf_store(&result[k][i],
+                     vf_add(vf_mul(va, vf_load(&b[k][i])),
+                            vf_mul(vf_sub(vf_set1(1.0F), va),
+                                   vf_load(&c[k][i]))));
+         }
+         break;
+      case OPCODE_CMP:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_cmp(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i]),
+                                           vf_load(&c[k][i])));
+         break;
+      case OPCODE_MIN:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_min(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_MAX:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_max(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_SGE:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_sge(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_SLT:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_slt(vf_load(&a[k][i]),
+                                           vf_load(&b[k][i])));
+         break;
+      case OPCODE_MOV:
+         memcpy(result, a, sizeof(prog_batch_reg));
+         break;
+      case OPCODE_DP2:
+      case OPCODE_DP3:
+      case OPCODE_DP4:
+      case OPCODE_DPH:
+         FOR_EACH_VECTOR(i) {
+            vfloat dot = vf_add(vf_mul(vf_load(&a[0][i]), vf_load(&b[0][i])),
+                                vf_mul(vf_load(&a[1][i]), vf_load(&b[1][i])));
+            if (inst->opcode != OPCODE_DP2)
+               dot = vf_add(dot, vf_mul(vf_load(&a[2][i]),
+                                        vf_load(&b[2][i])));
+            if (inst->opcode == OPCODE_DP4)
+               dot = vf_add(dot, vf_mul(vf_load(&a[3][i]),
+                                        vf_load(&b[3][i])));
+            else if (inst->opcode == OPCODE_DPH)
+               dot = vf_add(dot, vf_load(&b[3][i]));
+            for (k = 0; k < 4; k++)
+               vf_store(&result[k][i], dot);
+         }
+         break;
+      case OPCODE_DST:
+         FOR_EACH_VECTOR(i) {
+            vf_store(&result[0][i], vf_set1(1.0F));
+            vf_store(&result[1][i], vf_mul(vf_load(&a[1][i]),
+                                           vf_load(&b[1][i])));
+            vf_store(&result[2][i], vf_load(&a[2][i]));
+            vf_store(&result[3][i], vf_load(&b[3][i]));
+         }
+         break;
+      case OPCODE_XPD:
+         FOR_EACH_VECTOR(i) {
+            const vfloat a0 = vf_load(&a[0][i]), b0 = vf_load(&b[0][i]);
+            const vfloat a1 = vf_load(&a[1][i]), b1 = vf_load(&b[1][i]);
+            const vfloat a2 = vf_load(&a[2][i]), b2 = vf_load(&b[2][i]);
+            vf_store(&result[0][i], vf_sub(vf_mul(a1, b2), vf_mul(a2, b1)));
+            vf_store(&result[1][i], vf_sub(vf_mul(a2, b0), vf_mul(a0, b2)));
+            vf_store(&result[2][i], vf_sub(vf_mul(a0, b1), vf_mul(a1, b0)));
+            vf_store(&result[3][i], vf_set1(1.0F));
+         }
+         break;
+#ifdef vf_floor
+      case OPCODE_FLR:
+         FOR_EACH_ROW_VECTOR(k, i)
+            vf_store(&result[k][i], vf_floor(vf_load(&a[k][i])));
+         break;
+      case OPCODE_FRC:
+         FOR_EACH_ROW_VECTOR(k, i) {
+            const vfloat va = vf_load(&a[k][i]);
+            vf_store(&result[k][i], vf_sub(va, vf_floor(va)));
+         }
+         break;
+#else
+      case OPCODE_FLR:
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < LANES; i++)
+               result[k][i] = floorf(a[k][i]);
+         break;
+      case OPCODE_FRC:
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < LANES; i++)
+               result[k][i] = a[k][i] - floorf(a[k][i]);
+         break;
+#endif
+      case OPCODE_SSG:
+         for (k = 0; k < 4; k++)
+            for (i = 0; i < LANES; i++)
+               result[k][i] = (GLfloat) ((a[k][i] > 0.0F) -
+                                         (a[k][i] < 0.0F));
+         break;
+      case OPCODE_EX2:
+      case OPCODE_LG2:
+      case OPCODE_POW:
+      case OPCODE_RCP:
+      case OPCODE_RSQ:
+         /* scalar functions of the x component */
+         for (i = 0; i < LANES; i++) {
+            const GLfloat x = a[0][i];
+            GLfloat val;
+
+            switch (inst->opcode) {
+            case OPCODE_EX2:
+               val = exp2f(x);
+               break;
+            case OPCODE_LG2:
+               val = x == 0.0F ? -FLT_MAX : logf(x) * 1.442695F;
+               break;
+            case OPCODE_POW:
+               val = powf(x, b[0][i]);
+               break;
+            case OPCODE_RCP:
+               val = 1.0F / x;
+               break;
+            default:
+               val = 1.0F / sqrtf(fabsf(x));
+               break;
+            }
+            result[0][i] = result[1][i] = result[2][i] = result[3][i] = val;
+         }
+         break;
+      case OPCODE_LIT:
+      case OPCODE_EXP:
+      case OPCODE_LOG:
+         for (i = 0; i < LANES; i++) {
+            GLfloat v[4], r[4];
+            for (k = 0; k < 4; k++)
+               v[k] = a[k][i];
+            scalar_vector_op(inst->opcode, v, r);
+            for (k = 0; k < 4; k++)
+               result[k][i] = r[k];
+         }
+         break;
+      case OPCODE_ARL:
+         for (i = 0; i < LANES; i++)
+            machine->AddressReg[i] = IFLOOR(a[0][i]);
+         continue;
+      case OPCODE_KIL:
+         FOR_EACH_VECTOR(i)
+            killed |= (vf_negbits(vf_load(&a[0][i])) |
+                       vf_negbits(vf_load(&a[1][i])) |
+                       vf_negbits(vf_load(&a[2][i])) |
+                       vf_negbits(vf_load(&a[3][i]))) << i;
+         continue;
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXL:
+      case OPCODE_TXP:
+         sample_lanes(ctx, machine, inst, a, live & ~killed, result);
+         break;
+      default:
+         unreachable("opcode not decoded for batches");
+      }
+
+      BATCH_FUNC(store_dst)(machine, inst, result);
+   }
+
+   return killed;
+}
+
+#undef VF_WIDTH
+#undef vfloat
+#undef vf_load
+#undef vf_store
+#undef vf_set1
+#undef vf_add
+#undef vf_sub
+#undef vf_mul
+#undef vf_min
+#undef vf_max
+#undef vf_neg
+#undef vf_abs
+#undef vf_sge
+#undef vf_slt
+#undef vf_sat
+#undef vf_negbits
+#undef vf_cmp
+#undef vf_floor
+#undef BATCH_FUNC
+#undef BATCH_TARGET
@@ -30,6 +30,7 @@
 #include "main/mtypes.h"
 #include "main/imports.h"
 #include "main/shaderobj.h"
+#include "program/prog_batch.h"
 #include "program/prog_cache.h"
 #include "program/program.h"
 
@@ -50,6 +51,14 @@ struct gl_program_cache
    GLuint size, n_items;
 };
 
+/** What the items of a cache hold */
+enum cache_kind
+{
+   CACHE_PROGRAMS,
+   CACHE_SHADERS,
+   CACHE_BATCHES        /**< struct gl_program_batch, see prog_batch.c */
+};
+
 
 
 /**
@@ -107,7 +116,7 @@ rehash(struct gl_program_cache *cache)
 
 static void
 clear_cache(struct gl_context *ctx, struct gl_program_cache *cache,
-	    GLboolean shader)
+	    enum cache_kind kind)
 {
    struct cache_item *c, *next;
    GLuint i;
@@ -118,12 +127,18 @@ clear_cache(struct gl_context *ctx, struct gl_program_cache *cache,
       for (c = cache->items[i]; c; c = next) {
 	 next = c->next;
 	 free(c->key);
-	 if (shader) {
+	 switch (kind) {
+	 case CACHE_SHADERS:
 	    _mesa_reference_shader_program(ctx,
 					   (struct gl_shader_program **)&c->program,
 					   NULL);
-	 } else {
+	    break;
+	 case CACHE_BATCHES:
+	    _mesa_delete_program_batch((struct gl_program_batch *)c->program);
+	    break;
+	 default:
 	    _mesa_reference_program(ctx, &c->program, NULL);
+	    break;
 	 }
 	 free(c);
       }
@@ -156,7 +171,7 @@ _mesa_new_program_cache(void)
 void
 _mesa_delete_program_cache(struct gl_context *ctx, struct gl_program_cache *cache)
 {
-   clear_cache(ctx, cache, GL_FALSE);
+   clear_cache(ctx, cache, CACHE_PROGRAMS);
    free(cache->items);
    free(cache);
 }
@@ -165,7 +180,15 @@ void
 _mesa_delete_shader_cache(struct gl_context *ctx,
 			  struct gl_program_cache *cache)
 {
-   clear_cache(ctx, cache, GL_TRUE);
+   clear_cache(ctx, cache, CACHE_SHADERS);
+   free(cache->items);
+   free(cache);
+}
+
+void
+_mesa_delete_batch_cache(struct gl_program_cache *cache)
+{
+   clear_cache(NULL, cache, CACHE_BATCHES);
    free(cache->items);
    free(cache);
 }
@@ -199,11 +222,10 @@ _mesa_search_program_cache(struct gl_program_cache *cache,
 }
 
 
-void
-_mesa_program_cache_insert(struct gl_context *ctx,
-                           struct gl_program_cache *cache,
-                           const void *key, GLuint keysize,
-                           struct gl_program *program)
+static void
+cache_insert(struct gl_context *ctx, struct gl_program_cache *cache,
+             const void *key, GLuint keysize, void *item,
+             enum cache_kind kind)
 {
    const GLuint hash = hash_key(key, keysize);
    struct cache_item *c = CALLOC_STRUCT(cache_item);
@@ -214,13 +236,13 @@ _mesa_program_cache_insert(struct gl_context *ctx,
    memcpy(c->key, key, keysize);
    c->keysize = keysize;
 
-   c->program = program;  /* no refcount change */
+   c->program = item;  /* no refcount change */
 
    if (cache->n_items > cache->size * 1.5) {
       if (cache->size < 1000)
 	 rehash(cache);
       else 
-	 clear_cache(ctx, cache, GL_FALSE);
+	 clear_cache(ctx, cache, kind);
    }
 
    cache->n_items++;
@@ -228,31 +250,43 @@ _mesa_program_cache_insert(struct gl_context *ctx,
    cache->items[hash % cache->size] = c;
 }
 
+
+void
+_mesa_program_cache_insert(struct gl_context *ctx,
+                           struct gl_program_cache *cache,
+                           const void *key, GLuint keysize,
+                           struct gl_program *program)
+{
+   cache_insert(ctx, cache, key, keysize, program, CACHE_PROGRAMS);
+}
+
 void
 _mesa_shader_cache_insert(struct gl_context *ctx,
 			  struct gl_program_cache *cache,
 			  const void *key, GLuint keysize,
 			  struct gl_shader_program *program)
 {
-   const GLuint hash = hash_key(key, keysize);
-   struct cache_item *c = CALLOC_STRUCT(cache_item);
+   cache_insert(ctx, cache, key, keysize, program, CACHE_SHADERS);
+}
 
-   c->hash = hash;
 
-   c->key = malloc(keysize);
-   memcpy(c->key, key, keysize);
-   c->keysize = keysize;
-
-   c->program = (struct gl_program *)program;  /* no refcount change */
+struct gl_program_batch *
+_mesa_search_batch_cache(struct gl_program_cache *cache,
+                         const void *key, GLuint keysize)
+{
+   return (struct gl_program_batch *)
+      _mesa_search_program_cache(cache, key, keysize);
+}
 
-   if (cache->n_items > cache->size * 1.5) {
-      if (cache->size < 1000)
-	 rehash(cache);
-      else
-	 clear_cache(ctx, cache, GL_TRUE);
-   }
 
-   cache->n_items++;
-   c->next = cache->items[hash % cache->size];
-   cache->items[hash % cache->size] = c;
+/**
+ * Add a decoded program to a cache created with _mesa_new_program_cache().
+ * The cache owns it from then on; see _mesa_delete_batch_cache().
+ */
+void
+_mesa_batch_cache_insert(struct gl_program_cache *cache,
+                         const void *key, GLuint keysize,
+                         struct gl_program_batch *batch)
+{
+   cache_insert(NULL, cache, key, keysize, batch, CACHE_BATCHES);
 }
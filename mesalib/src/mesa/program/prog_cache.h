@@ -39,6 +39,7 @@ extern "C" {
 
 
 struct gl_context;
+struct gl_program_batch;
 
 /** Opaque type */
 struct gl_program_cache;
@@ -70,6 +71,18 @@ _mesa_shader_cache_insert(struct gl_context *ctx,
 			  const void *key, GLuint keysize,
 			  struct gl_shader_program *program);
 
+extern void
+_mesa_delete_batch_cache(struct gl_program_cache *cache);
+
+extern struct gl_program_batch *
+_mesa_search_batch_cache(struct gl_program_cache *cache,
+                         const void *key, GLuint keysize);
+
+extern void
+_mesa_batch_cache_insert(struct gl_program_cache *cache,
+                         const void *key, GLuint keysize,
+                         struct gl_program_batch *batch);
+
 
 #ifdef __cplusplus
 }
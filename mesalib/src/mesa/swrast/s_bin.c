@@ -0,0 +1,383 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file swrast/s_bin.c
+ * \brief Draw triangles on several threads.
+ *
+ * Instead of being drawn right away, triangles are copied into a batch.
+ * When the batch is full, or before anything else is drawn, the rows the
+ * batch touches are cut into horizontal bands and each band is handed to
+ * a worker thread.  A worker draws every triangle of the batch that
+ * overlaps its band, in the order the triangles came in, but writes only
+ * the band's rows (see s_tritemp.h).  No two workers write the same
+ * pixel, and every pixel sees its triangles in GL order.
+ *
+ * Bands are whole rows rather than tiles because the scanline rasterizer
+ * can skip rows cheaply but has no way to clip a span in x.
+ *
+ * The per-span scratch buffers in SWcontext are replaced by per-thread
+ * ones while a band is drawn; see struct swrast_band_thread.
+ */
+
+
+#include "c11/threads.h"
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "util/debug.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_queue.h"
+
+#include "s_bin.h"
+#include "s_chan.h"
+#include "s_context.h"
+
+
+/** Most worker threads we start */
+#define SWRAST_MAX_THREADS 16
+
+/** A batch is cut into at most two bands per thread */
+#define SWRAST_MAX_BANDS (2 * SWRAST_MAX_THREADS)
+
+/** Fewest rows worth handing to a thread */
+#define SWRAST_MIN_BAND_ROWS 16
+
+/** Triangles recorded before the batch is drawn */
+#define SWRAST_BIN_TRIANGLES 512
+
+
+struct swrast_bin_triangle
+{
+   SWvertex v[3];
+   GLint y0, y1;              /**< rows it may touch, [y0, y1) */
+};
+
+struct swrast_band_job
+{
+   struct gl_context *ctx;
+   GLint y0, y1;
+   struct util_queue_fence fence;
+};
+
+struct swrast_bins
+{
+   GLuint count;
+   GLint y0, y1;              /**< rows touched by the batch */
+   struct swrast_band_job jobs[SWRAST_MAX_BANDS];
+   struct swrast_bin_triangle tris[SWRAST_BIN_TRIANGLES];
+};
+
+
+tss_t _swrast_band_key;
+
+static once_flag bin_once = ONCE_FLAG_INIT;
+static mtx_t bin_mutex;
+static struct util_queue bin_queue;
+static GLuint bin_threads;                    /**< 0 when binning is off */
+static struct swrast_band_thread *bin_band;   /**< one per queue thread */
+
+
+static void
+init_bins_once(void)
+{
+   unsigned threads;
+
+   tss_create(&_swrast_band_key, NULL);
+   mtx_init(&bin_mutex, mtx_plain);
+
+   util_cpu_detect();
+   threads = env_var_as_unsigned("SWRAST_THREADS", util_cpu_caps.nr_cpus);
+   threads = MIN2(threads, SWRAST_MAX_THREADS);
+   if (threads < 2)
+      return;
+
+   bin_band = calloc(threads, sizeof(*bin_band));
+   if (!bin_band)
+      return;
+   if (!util_queue_init(&bin_queue, "swrast", SWRAST_MAX_BANDS, threads, 0)) {
+      free(bin_band);
+      bin_band = NULL;
+      return;
+   }
+   bin_threads = threads;
+}
+
+
+/**
+ * Start the worker threads.  The thread count is the number of CPUs, or
+ * SWRAST_THREADS if set; below two, triangles are drawn as they come.
+ */
+void
+_swrast_init_bins(void)
+{
+   call_once(&bin_once, init_bins_once);
+}
+
+
+/**
+ * May triangles be binned with the current state?  Called when a new
+ * triangle function has been chosen.
+ */
+GLboolean
+_swrast_bin_triangles(struct gl_context *ctx)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   /* Antialiased triangles clip spans in x, occlusion queries count
+    * fragments in shared state, and the specular wrapper modifies the
+    * vertices it draws.
+    */
+   return bin_threads &&
+          ctx->RenderMode == GL_RENDER &&
+          !ctx->Polygon.SmoothFlag &&
+          !ctx->Query.CurrentOcclusionObject &&
+          !swrast->SpecularVertexAdd &&
+          ctx->DrawBuffer->Height >= 2 * SWRAST_MIN_BAND_ROWS;
+}
+
+
+/** Copy what the triangle functions read of a vertex */
+static void
+copy_vertex(const SWcontext *swrast, SWvertex *dst, const SWvertex *src)
+{
+   COPY_4V(dst->attrib[VARYING_SLOT_POS], src->attrib[VARYING_SLOT_POS]);
+   ATTRIB_LOOP_BEGIN
+      COPY_4V(dst->attrib[attr], src->attrib[attr]);
+   ATTRIB_LOOP_END
+   COPY_CHAN4(dst->color, src->color);
+   dst->pointSize = src->pointSize;
+}
+
+
+/**
+ * Called via swrast->Triangle in place of swrast->BinTriangle.
+ */
+void
+_swrast_bin_triangle(struct gl_context *ctx, const SWvertex *v0,
+                     const SWvertex *v1, const SWvertex *v2)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_bins *bins = swrast->Bins;
+   struct swrast_bin_triangle *tri;
+   const GLint height = ctx->DrawBuffer->Height;
+   GLfloat ymin, ymax;
+   GLuint i;
+
+   if (!bins) {
+      bins = calloc(1, sizeof(*bins));
+      if (!bins) {
+         swrast->BinTriangle(ctx, v0, v1, v2);
+         return;
+      }
+      for (i = 0; i < SWRAST_MAX_BANDS; i++)
+         util_queue_fence_init(&bins->jobs[i].fence);
+      swrast->Bins = bins;
+   }
+   else if (bins->count == SWRAST_BIN_TRIANGLES) {
+      _swrast_flush_bins(ctx);
+   }
+
+   ymin = MIN3(v0->attrib[VARYING_SLOT_POS][1],
+               v1->attrib[VARYING_SLOT_POS][1],
+               v2->attrib[VARYING_SLOT_POS][1]);
+   ymax = MAX3(v0->attrib[VARYING_SLOT_POS][1],
+               v1->attrib[VARYING_SLOT_POS][1],
+               v2->attrib[VARYING_SLOT_POS][1]);
+   /* nothing to draw, which also catches NaN */
+   if (!(ymax >= 0.0F && ymin < (GLfloat) height))
+      return;
+
+   tri = &bins->tris[bins->count];
+   /* a row or so of slack for the rasterizer's rounding */
+   tri->y0 = MAX2(IFLOOR(ymin) - 1, 0);
+   tri->y1 = MIN2(IFLOOR(ymax) + 2, height);
+   copy_vertex(swrast, &tri->v[0], v0);
+   copy_vertex(swrast, &tri->v[1], v1);
+   copy_vertex(swrast, &tri->v[2], v2);
+
+   if (bins->count == 0) {
+      bins->y0 = tri->y0;
+      bins->y1 = tri->y1;
+   }
+   else {
+      bins->y0 = MIN2(bins->y0, tri->y0);
+      bins->y1 = MAX2(bins->y1, tri->y1);
+   }
+   bins->count++;
+}
+
+
+/** Allocate whatever scratch a band thread is missing */
+static GLboolean
+alloc_band_thread(struct swrast_band_thread *band, GLuint texUnits)
+{
+   struct swrast_stencil_temp *temp = &band->stencil_temp;
+
+   if (!band->SpanArrays) {
+      band->SpanArrays = malloc(sizeof(SWspanarrays));
+      if (!band->SpanArrays)
+         return GL_FALSE;
+      band->SpanArrays->ChanType = CHAN_TYPE;
+#if CHAN_TYPE == GL_UNSIGNED_BYTE
+      band->SpanArrays->rgba = band->SpanArrays->rgba8;
+#elif CHAN_TYPE == GL_UNSIGNED_SHORT
+      band->SpanArrays->rgba = band->SpanArrays->rgba16;
+#else
+      band->SpanArrays->rgba = band->SpanArrays->attribs[VARYING_SLOT_COL0];
+#endif
+   }
+
+   if (!temp->buf1)
+      temp->buf1 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+   if (!temp->buf2)
+      temp->buf2 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+   if (!temp->buf3)
+      temp->buf3 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+   if (!temp->buf4)
+      temp->buf4 = malloc(SWRAST_MAX_WIDTH * sizeof(GLubyte));
+   if (!temp->buf1 || !temp->buf2 || !temp->buf3 || !temp->buf4)
+      return GL_FALSE;
+
+   if (band->TexelUnits < texUnits) {
+      free(band->TexelBuffer);
+      band->TexelBuffer = malloc(texUnits * SWRAST_MAX_WIDTH * 4 *
+                                 sizeof(GLfloat));
+      band->TexelUnits = band->TexelBuffer ? texUnits : 0;
+      if (!band->TexelBuffer)
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/** util_queue job: draw the batch's triangles into one band */
+static void
+draw_band(void *data, int thread_index)
+{
+   struct swrast_band_job *job = data;
+   struct gl_context *ctx = job->ctx;
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct swrast_bins *bins = swrast->Bins;
+   struct swrast_band_thread *band = &bin_band[thread_index];
+   GLuint i;
+
+   band->y0 = job->y0;
+   band->y1 = job->y1;
+   tss_set(_swrast_band_key, band);
+
+   for (i = 0; i < bins->count; i++) {
+      const struct swrast_bin_triangle *tri = &bins->tris[i];
+
+      if (tri->y0 < job->y1 && tri->y1 > job->y0)
+         swrast->BinTriangle(ctx, &tri->v[0], &tri->v[1], &tri->v[2]);
+   }
+
+   tss_set(_swrast_band_key, NULL);
+}
+
+
+/**
+ * Draw the triangles recorded so far.  Returns once they are all in the
+ * framebuffer.
+ */
+void
+_swrast_flush_bins(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_bins *bins = swrast->Bins;
+   const GLuint texUnits = ctx->Texture._EnabledCoordUnits ?
+      ctx->Const.Program[MESA_SHADER_FRAGMENT].MaxTextureImageUnits : 0;
+   const GLuint texEnableSave = ctx->Texture._EnabledCoordUnits;
+   GLboolean threaded;
+   GLint rows, y;
+   GLuint i, n;
+
+   if (!bins || !bins->count)
+      return;
+
+   rows = (bins->y1 - bins->y0 + 2 * bin_threads - 1) / (2 * bin_threads);
+   rows = MAX2(rows, SWRAST_MIN_BAND_ROWS);
+
+   /* The blend function is picked on first use, which must not happen on
+    * several threads at once; the first batch after a blend state change
+    * is drawn here.
+    */
+   threaded = bins->y1 - bins->y0 > rows &&
+              !(ctx->Color.BlendEnabled &&
+                swrast->BlendFunc == _swrast_validate_blend_func);
+
+   mtx_lock(&bin_mutex);
+   for (i = 0; threaded && i < bin_threads; i++)
+      threaded = alloc_band_thread(&bin_band[i], texUnits);
+
+   if (threaded) {
+      /* see affine_span() */
+      if (swrast->_TriangleTextures)
+         ctx->Texture._EnabledCoordUnits = 0x0;
+
+      for (y = bins->y0, n = 0; y < bins->y1; y += rows, n++) {
+         struct swrast_band_job *job = &bins->jobs[n];
+
+         job->ctx = ctx;
+         job->y0 = y;
+         job->y1 = MIN2(y + rows, bins->y1);
+         util_queue_add_job(&bin_queue, job, &job->fence, draw_band, NULL);
+      }
+      for (i = 0; i < n; i++)
+         util_queue_fence_wait(&bins->jobs[i].fence);
+
+      ctx->Texture._EnabledCoordUnits = texEnableSave;
+   }
+   mtx_unlock(&bin_mutex);
+
+   if (!threaded) {
+      for (i = 0; i < bins->count; i++) {
+         struct swrast_bin_triangle *tri = &bins->tris[i];
+
+         swrast->BinTriangle(ctx, &tri->v[0], &tri->v[1], &tri->v[2]);
+      }
+   }
+
+   bins->count = 0;
+}
+
+
+void
+_swrast_destroy_bins(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_bins *bins = swrast->Bins;
+   GLuint i;
+
+   if (!bins)
+      return;
+
+   for (i = 0; i < SWRAST_MAX_BANDS; i++)
+      util_queue_fence_destroy(&bins->jobs[i].fence);
+   free(bins);
+   swrast->Bins = NULL;
+}
@@ -33,10 +33,13 @@
 #include "main/state.h"
 #include "main/stencil.h"
 #include "main/teximage.h"
+#include "program/prog_cache.h"
 #include "program/prog_parameter.h"
 #include "program/prog_statevars.h"
 #include "swrast.h"
+#include "s_bin.h"
 #include "s_blend.h"
+#include "s_fragprog.h"
 #include "s_context.h"
 #include "s_lines.h"
 #include "s_points.h"
@@ -267,6 +270,9 @@ _swrast_update_fragment_program(struct gl_context *ctx, GLbitfield newState)
 
    _mesa_load_state_parameters(ctx,
                                ctx->FragmentProgram._Current->Parameters);
+
+   if (newState & _NEW_PROGRAM)
+      _swrast_update_fragment_batch(ctx);
 }
 
 
@@ -355,6 +361,11 @@ _swrast_validate_triangle( struct gl_context *ctx,
       swrast->SpecTriangle = swrast->Triangle;
       swrast->Triangle = _swrast_add_spec_terms_triangle;
    }
+   else if (_swrast_bin_triangles(ctx)) {
+      /* draw on the band threads */
+      swrast->BinTriangle = swrast->Triangle;
+      swrast->Triangle = _swrast_bin_triangle;
+   }
 
    swrast->Triangle( ctx, v0, v1, v2 );
 }
@@ -405,7 +416,7 @@ _swrast_validate_point( struct gl_context *ctx, const SWvertex *v0 )
  * Called via swrast->BlendFunc.  Examine GL state to choose a blending
  * function, then call it.
  */
-static void
+void
 _swrast_validate_blend_func(struct gl_context *ctx, GLuint n, const GLubyte mask[],
                             GLvoid *src, const GLvoid *dst,
                             GLenum chanType )
@@ -635,6 +646,7 @@ _swrast_Line( struct gl_context *ctx, const SWvertex *v0, const SWvertex *v1 )
       _swrast_print_vertex( ctx, v0 );
       _swrast_print_vertex( ctx, v1 );
    }
+   _swrast_flush_bins( ctx );
    SWRAST_CONTEXT(ctx)->Line( ctx, v0, v1 );
 }
 
@@ -645,6 +657,7 @@ _swrast_Point( struct gl_context *ctx, const SWvertex *v0 )
       _mesa_debug(ctx, "_swrast_Point\n");
       _swrast_print_vertex( ctx, v0 );
    }
+   _swrast_flush_bins( ctx );
    SWRAST_CONTEXT(ctx)->Point( ctx, v0 );
 }
 
@@ -763,6 +776,11 @@ _swrast_CreateContext( struct gl_context *ctx )
    swrast->Driver.SpanRenderStart = _swrast_span_render_start;
    swrast->Driver.SpanRenderFinish = _swrast_span_render_finish;
 
+   _swrast_init_bins();
+
+   /* running without it only means interpreting every fragment program */
+   swrast->FragProgBatches = _mesa_new_program_cache();
+
    for (i = 0; i < ARRAY_SIZE(swrast->TextureSample); i++)
       swrast->TextureSample[i] = NULL;
 
@@ -823,6 +841,10 @@ _swrast_DestroyContext( struct gl_context *ctx )
       _mesa_debug(ctx, "_swrast_DestroyContext\n");
    }
 
+   _swrast_destroy_bins(ctx);
+   if (swrast->FragProgBatches)
+      _mesa_delete_batch_cache(swrast->FragProgBatches);
+
    free( swrast->SpanArrays );
    free( swrast->ZoomedArrays );
    free( swrast->TexelBuffer );
@@ -854,6 +876,8 @@ _swrast_flush( struct gl_context *ctx )
       _swrast_write_rgba_span(ctx, &(swrast->PointSpan));
       swrast->PointSpan.end = 0;
    }
+   /* and any binned triangles */
+   _swrast_flush_bins(ctx);
 }
 
 void
@@ -43,6 +43,7 @@
 #ifndef S_CONTEXT_H
 #define S_CONTEXT_H
 
+#include "c11/threads.h"
 #include "main/mtypes.h"
 #include "main/texcompress.h"
 #include "program/prog_execute.h"
@@ -122,6 +123,15 @@ typedef void (*FetchTexelFunc)(const struct swrast_texture_image *texImage,
                                GLfloat *texelOut);
 
 
+/**
+ * Bilinear sampling of a span of coordinates in a 2D texture image.
+ */
+typedef void (*LinearSpanFunc)(const struct gl_sampler_object *samp,
+                               const struct swrast_texture_image *texImage,
+                               GLuint n, const GLfloat texcoords[][4],
+                               GLfloat rgba[][4]);
+
+
 /**
  * Subclass of gl_texture_image.
  * We need extra fields/info to keep tracking of mapped texture buffers,
@@ -160,6 +170,9 @@ struct swrast_texture_image
 
    FetchTexelFunc FetchTexel;
 
+   /** For GL_LINEAR sampling of 2D images in common formats, or NULL */
+   LinearSpanFunc SampleLinearSpan;
+
    /** For fetching texels from compressed textures */
    compressed_fetch_func FetchCompressedTexel;
 };
@@ -208,6 +221,31 @@ swrast_renderbuffer(struct gl_renderbuffer *img)
 
 
 
+/** Temporary arrays for stencil operations */
+struct swrast_stencil_temp
+{
+   GLubyte *buf1, *buf2, *buf3, *buf4;
+};
+
+
+/**
+ * Scratch state of a thread rasterizing one band of rows for the
+ * triangle binner, see s_bin.c.  While a band is being drawn, these take
+ * the place of the context's own buffers of the same names.
+ */
+struct swrast_band_thread
+{
+   GLint y0, y1;              /**< rows this thread may write, [y0, y1) */
+   SWspanarrays *SpanArrays;
+   GLfloat *TexelBuffer;
+   GLuint TexelUnits;         /**< units TexelBuffer has room for */
+   struct gl_program_machine FragProgMachine;
+   struct swrast_stencil_temp stencil_temp;
+};
+
+struct swrast_bins;
+
+
 /**
  * \struct SWcontext
  * \brief  Per-context state that's private to the software rasterizer module.
@@ -294,6 +332,18 @@ typedef struct
    swrast_tri_func SpecTriangle;
    /*@}*/
 
+   /** Triangle function that binned triangles are drawn with */
+   swrast_tri_func BinTriangle;
+
+   /** Triangles recorded for the band threads, see s_bin.c */
+   struct swrast_bins *Bins;
+
+   /**
+    * Set when the triangle function textures its spans itself and clears
+    * ctx->Texture._EnabledCoordUnits around _swrast_write_rgba_span().
+    */
+   GLboolean _TriangleTextures;
+
    /**
     * Typically, we'll allocate a sw_span structure as a local variable
     * and set its 'array' pointer to point to this object.  The reason is
@@ -323,12 +373,24 @@ typedef struct
    /** State used during execution of fragment programs */
    struct gl_program_machine FragProgMachine;
 
+   /** Decoded fragment programs, see prog_batch.c */
+   struct gl_program_cache *FragProgBatches;
+
+   /** The current fragment program decoded for running several fragments
+    * at a time, and what it was decoded from.  Batch is NULL if the
+    * program needs the interpreter.  See s_fragprog.c.
+    */
+   struct {
+      const struct gl_program *Program;
+      const struct prog_instruction *Instructions;
+      GLuint NumInstructions;
+      struct gl_program_batch *Batch;
+   } FragProgBatch;
+
    /** Temporary arrays for stencil operations.  To avoid large stack
     * allocations.
     */
-   struct {
-      GLubyte *buf1, *buf2, *buf3, *buf4;
-   } stencil_temp;
+   struct swrast_stencil_temp stencil_temp;
 
 } SWcontext;
 
@@ -336,6 +398,11 @@ typedef struct
 extern void
 _swrast_validate_derived( struct gl_context *ctx );
 
+extern void
+_swrast_validate_blend_func(struct gl_context *ctx, GLuint n,
+                            const GLubyte mask[], GLvoid *src,
+                            const GLvoid *dst, GLenum chanType);
+
 extern void
 _swrast_update_texture_samplers(struct gl_context *ctx);
 
@@ -355,6 +422,45 @@ CONST_SWRAST_CONTEXT(const struct gl_context *ctx)
 }
 
 
+/** Thread-local key for the current swrast_band_thread, see s_bin.c */
+extern tss_t _swrast_band_key;
+
+/**
+ * Return the band the calling thread is drawing, or NULL when it is the
+ * thread that owns the context.
+ */
+static inline struct swrast_band_thread *
+_swrast_band_thread(void)
+{
+   return (struct swrast_band_thread *) tss_get(_swrast_band_key);
+}
+
+/** Span arrays for the calling thread */
+static inline SWspanarrays *
+_swrast_span_arrays(struct gl_context *ctx)
+{
+   struct swrast_band_thread *band = _swrast_band_thread();
+   return band ? band->SpanArrays : SWRAST_CONTEXT(ctx)->SpanArrays;
+}
+
+/** Stencil scratch arrays for the calling thread */
+static inline struct swrast_stencil_temp *
+_swrast_stencil_temp(struct gl_context *ctx)
+{
+   struct swrast_band_thread *band = _swrast_band_thread();
+   return band ? &band->stencil_temp : &SWRAST_CONTEXT(ctx)->stencil_temp;
+}
+
+/** Fragment program machine for the calling thread */
+static inline struct gl_program_machine *
+_swrast_fragprog_machine(struct gl_context *ctx)
+{
+   struct swrast_band_thread *band = _swrast_band_thread();
+   return band ? &band->FragProgMachine
+               : &SWRAST_CONTEXT(ctx)->FragProgMachine;
+}
+
+
 /**
  * Called prior to framebuffer reading/writing.
  * For drivers that rely on swrast for fallback rendering, this is the
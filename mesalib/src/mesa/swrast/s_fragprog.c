@@ -26,6 +26,7 @@
 #include "main/macros.h"
 #include "main/samplerobj.h"
 #include "main/teximage.h"
+#include "program/prog_batch.h"
 #include "program/prog_instruction.h"
 
 #include "s_context.h"
@@ -149,17 +150,12 @@ fetch_texel_deriv( struct gl_context *ctx, const GLfloat texcoord[4],
 
 
 /**
- * Initialize the virtual fragment program machine state prior to running
- * fragment program on a fragment.  This involves initializing the input
- * registers, condition codes, etc.
- * \param machine  the virtual machine state to init
- * \param program  the fragment program we're about to run
- * \param span  the span of pixels we'll operate on
- * \param col  which element (column) of the span we'll operate on
+ * Finish the inputs of fragment 'col' of the span which are not simply
+ * interpolated: the window position conventions and the facing value.
  */
 static void
-init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
-             const struct gl_program *program, const SWspan *span, GLuint col)
+init_fragment_inputs(struct gl_context *ctx, const struct gl_program *program,
+                     const SWspan *span, GLuint col)
 {
    GLfloat *wpos = span->array->attribs[VARYING_SLOT_POS][col];
 
@@ -171,6 +167,70 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
       wpos[1] += 0.5F;
    }
 
+   /* if running a GLSL program (not ARB_fragment_program) */
+   if (ctx->_Shader->CurrentProgram[MESA_SHADER_FRAGMENT]) {
+      /* Store front/back facing value */
+      span->array->attribs[VARYING_SLOT_FACE][col][0] = 1.0F - span->facing;
+   }
+}
+
+
+/**
+ * Store the results of fragment 'col' of the span.
+ */
+static void
+store_fragment_outputs(struct gl_context *ctx, SWspan *span, GLuint col,
+                       GLbitfield64 outputsWritten,
+                       const GLfloat outputs[][4])
+{
+   /* Store result color */
+   if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
+      COPY_4V(span->array->attribs[VARYING_SLOT_COL0][col],
+              outputs[FRAG_RESULT_COLOR]);
+   }
+   else {
+      /* Multiple drawbuffers / render targets
+       * Note that colors beyond 0 and 1 will overwrite other
+       * attributes, such as FOGC, TEX0, TEX1, etc.  That's OK.
+       */
+      GLuint buf;
+      for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
+         if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
+            COPY_4V(span->array->attribs[VARYING_SLOT_COL0 + buf][col],
+                    outputs[FRAG_RESULT_DATA0 + buf]);
+         }
+      }
+   }
+
+   /* Store result depth/z */
+   if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
+      const GLfloat depth = outputs[FRAG_RESULT_DEPTH][2];
+      if (depth <= 0.0F)
+         span->array->z[col] = 0;
+      else if (depth >= 1.0F)
+         span->array->z[col] = ctx->DrawBuffer->_DepthMax;
+      else
+         span->array->z[col] =
+            (GLuint) (depth * ctx->DrawBuffer->_DepthMaxF + 0.5F);
+   }
+}
+
+
+/**
+ * Initialize the virtual fragment program machine state prior to running
+ * fragment program on a fragment.  This involves initializing the input
+ * registers, condition codes, etc.
+ * \param machine  the virtual machine state to init
+ * \param program  the fragment program we're about to run
+ * \param span  the span of pixels we'll operate on
+ * \param col  which element (column) of the span we'll operate on
+ */
+static void
+init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
+             const struct gl_program *program, const SWspan *span, GLuint col)
+{
+   init_fragment_inputs(ctx, program, span, col);
+
    /* Setup pointer to input attributes */
    machine->Attribs = span->array->attribs;
 
@@ -180,12 +240,6 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
 
    machine->Samplers = program->SamplerUnits;
 
-   /* if running a GLSL program (not ARB_fragment_program) */
-   if (ctx->_Shader->CurrentProgram[MESA_SHADER_FRAGMENT]) {
-      /* Store front/back facing value */
-      machine->Attribs[VARYING_SLOT_FACE][col][0] = 1.0F - span->facing;
-   }
-
    machine->CurElement = col;
 
    /* init call stack */
@@ -202,10 +256,9 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
 static void
 run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
 {
-   SWcontext *swrast = SWRAST_CONTEXT(ctx);
    const struct gl_program *program = ctx->FragmentProgram._Current;
    const GLbitfield64 outputsWritten = program->info.outputs_written;
-   struct gl_program_machine *machine = &swrast->FragProgMachine;
+   struct gl_program_machine *machine = _swrast_fragprog_machine(ctx);
    GLuint i;
 
    for (i = start; i < end; i++) {
@@ -213,37 +266,8 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
          init_machine(ctx, machine, program, span, i);
 
          if (_mesa_execute_program(ctx, program, machine)) {
-
-            /* Store result color */
-	    if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
-               COPY_4V(span->array->attribs[VARYING_SLOT_COL0][i],
-                       machine->Outputs[FRAG_RESULT_COLOR]);
-            }
-            else {
-               /* Multiple drawbuffers / render targets
-                * Note that colors beyond 0 and 1 will overwrite other
-                * attributes, such as FOGC, TEX0, TEX1, etc.  That's OK.
-                */
-               GLuint buf;
-               for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
-                  if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
-                     COPY_4V(span->array->attribs[VARYING_SLOT_COL0 + buf][i],
-                             machine->Outputs[FRAG_RESULT_DATA0 + buf]);
-                  }
-               }
-            }
-
-            /* Store result depth/z */
-            if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
-               const GLfloat depth = machine->Outputs[FRAG_RESULT_DEPTH][2];
-               if (depth <= 0.0F)
-                  span->array->z[i] = 0;
-               else if (depth >= 1.0F)
-                  span->array->z[i] = ctx->DrawBuffer->_DepthMax;
-               else
-                  span->array->z[i] =
-                     (GLuint) (depth * ctx->DrawBuffer->_DepthMaxF + 0.5F);
-            }
+            store_fragment_outputs(ctx, span, i, outputsWritten,
+                                   (const GLfloat (*)[4]) machine->Outputs);
          }
          else {
             /* killed fragment */
@@ -255,6 +279,174 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
 }
 
 
+/**
+ * Decode the current fragment program for run_program_batches(), or find
+ * it decoded in the cache.  Called at state validation, so that the
+ * threads of the triangle binner only ever read the result.
+ */
+void
+_swrast_update_fragment_batch(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_program *program = ctx->FragmentProgram._Current;
+
+   swrast->FragProgBatch.Batch = NULL;
+   if (!program || !swrast->FragProgBatches)
+      return;
+
+   swrast->FragProgBatch.Program = program;
+   swrast->FragProgBatch.Instructions = program->arb.Instructions;
+   swrast->FragProgBatch.NumInstructions = program->arb.NumInstructions;
+   swrast->FragProgBatch.Batch =
+      _mesa_get_program_batch(swrast->FragProgBatches, program);
+}
+
+
+/**
+ * Sample texels for run_program_batches(), finding the lod just as
+ * fetch_texel_deriv() and fetch_texel_lod() find it.
+ */
+static void
+sample_fragments(struct gl_context *ctx, void *data,
+                 GLuint texSrcUnit, GLint derivAttr,
+                 GLuint n, const GLfloat texcoords[][4],
+                 const GLfloat lodBias[], GLfloat rgba[][4])
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const SWspan *span = (const SWspan *) data;
+   const GLuint unit =
+      ctx->FragmentProgram._Current->SamplerUnits[texSrcUnit];
+   const struct gl_texture_unit *texUnit = &ctx->Texture.Unit[unit];
+   const struct gl_texture_object *texObj = texUnit->_Current;
+   const struct gl_sampler_object *samp;
+   GLfloat lambda[PROG_BATCH_LANES];
+   GLuint i;
+
+   if (!texObj) {
+      for (i = 0; i < n; i++)
+         ASSIGN_4V(rgba[i], 0.0F, 0.0F, 0.0F, 1.0F);
+      return;
+   }
+
+   samp = _mesa_get_samplerobj(ctx, unit);
+
+   if (derivAttr >= 0) {
+      const struct swrast_texture_image *swImg =
+         swrast_texture_image_const(_mesa_base_tex_image(texObj));
+      const GLfloat texW = (GLfloat) swImg->WidthScale;
+      const GLfloat texH = (GLfloat) swImg->HeightScale;
+      const GLfloat *dx = span->attrStepX[derivAttr];
+      const GLfloat *dy = span->attrStepY[derivAttr];
+
+      for (i = 0; i < n; i++) {
+         const GLfloat *tc = texcoords[i];
+         lambda[i] = _swrast_compute_lambda(dx[0], dy[0], dx[1], dy[1],
+                                            dx[3], dy[3], texW, texH,
+                                            tc[0], tc[1], tc[3],
+                                            1.0F / tc[3]);
+         lambda[i] += lodBias[i] + texUnit->LodBias + samp->LodBias;
+      }
+   }
+   else {
+      for (i = 0; i < n; i++)
+         lambda[i] = lodBias[i];
+   }
+
+   for (i = 0; i < n; i++)
+      lambda[i] = CLAMP(lambda[i], samp->MinLod, samp->MaxLod);
+
+   swrast->TextureSample[unit](ctx, samp, texObj, n, texcoords, lambda, rgba);
+
+   if (texObj->_Swizzle != SWIZZLE_NOOP) {
+      for (i = 0; i < n; i++) {
+         GLfloat texel[4];
+         COPY_4V(texel, rgba[i]);
+         swizzle_texel(texel, rgba[i], texObj->_Swizzle);
+      }
+   }
+}
+
+
+/**
+ * Run the current fragment program on the span PROG_BATCH_LANES
+ * fragments at a time, see prog_batch.c.
+ * \return  GL_FALSE if the program can't be run that way
+ */
+static GLboolean
+run_program_batches(struct gl_context *ctx, SWspan *span)
+{
+   const SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_program *program = ctx->FragmentProgram._Current;
+   const struct gl_program_batch *batch = swrast->FragProgBatch.Batch;
+   const GLbitfield64 outputsWritten = program->info.outputs_written;
+   SWspanarrays *array = span->array;
+   struct gl_program_batch_machine machine;
+   GLuint base;
+
+   /* the program may have changed under the same state */
+   if (!batch ||
+       swrast->FragProgBatch.Program != program ||
+       swrast->FragProgBatch.Instructions != program->arb.Instructions ||
+       swrast->FragProgBatch.NumInstructions != program->arb.NumInstructions)
+      return GL_FALSE;
+
+   _mesa_clear_program_batch(batch, &machine);
+   machine.Sample = sample_fragments;
+   machine.SampleData = span;
+
+   for (base = 0; base < span->end; base += PROG_BATCH_LANES) {
+      const GLuint n = MIN2(span->end - base, PROG_BATCH_LANES);
+      GLbitfield live = 0, killed;
+      GLuint i, j, k;
+
+      for (i = 0; i < n; i++) {
+         if (array->mask[base + i]) {
+            init_fragment_inputs(ctx, program, span, base + i);
+            live |= 1 << i;
+         }
+      }
+      if (!live)
+         continue;
+
+      for (j = 0; j < batch->NumInputs; j++) {
+         const GLfloat (*attr)[4] =
+            (const GLfloat (*)[4]) array->attribs[batch->Inputs[j]] + base;
+         for (k = 0; k < 4; k++) {
+            for (i = 0; i < n; i++)
+               machine.Inputs[j][k][i] = attr[i][k];
+            for (; i < PROG_BATCH_LANES; i++)
+               machine.Inputs[j][k][i] = 0.0F;
+         }
+      }
+
+      killed = _mesa_execute_program_batch(ctx, program, batch, &machine,
+                                           live);
+
+      for (i = 0; i < n; i++) {
+         GLfloat outputs[FRAG_RESULT_MAX][4];
+
+         if (!(live & (1 << i)))
+            continue;
+
+         if (killed & (1 << i)) {
+            array->mask[base + i] = GL_FALSE;
+            span->writeAll = GL_FALSE;
+            continue;
+         }
+
+         for (j = 0; j < batch->NumOutputs; j++) {
+            for (k = 0; k < 4; k++)
+               outputs[batch->Outputs[j]][k] = machine.Outputs[j][k][i];
+         }
+         store_fragment_outputs(ctx, span, base + i, outputsWritten,
+                                (const GLfloat (*)[4]) outputs);
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
 /**
  * Execute the current fragment program for all the fragments
  * in the given span.
@@ -269,7 +461,8 @@ _swrast_exec_fragment_program( struct gl_context *ctx, SWspan *span )
       assert(span->array->ChanType == GL_FLOAT);
    }
 
-   run_program(ctx, span, 0, span->end);
+   if (!run_program_batches(ctx, span))
+      run_program(ctx, span, 0, span->end);
 
    if (program->info.outputs_written & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
       span->interpMask &= ~SPAN_RGBA;
@@ -37,6 +37,9 @@ _swrast_use_fragment_program(struct gl_context *ctx);
 extern void
 _swrast_exec_fragment_program(struct gl_context *ctx, SWspan *span);
 
+extern void
+_swrast_update_fragment_batch(struct gl_context *ctx);
+
 
 #endif /* S_FRAGPROG_H */
 
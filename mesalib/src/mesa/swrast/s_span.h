@@ -179,7 +179,7 @@ do {						\
    (S).end = 0;					\
    (S).leftClip = 0;				\
    (S).facing = 0;				\
-   (S).array = SWRAST_CONTEXT(ctx)->SpanArrays;	\
+   (S).array = _swrast_span_arrays(ctx);		\
 } while (0)
 
 
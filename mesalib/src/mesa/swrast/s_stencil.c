@@ -211,8 +211,7 @@ static GLboolean
 do_stencil_test(struct gl_context *ctx, GLuint face, GLuint n,
                 GLubyte stencil[], GLubyte mask[], GLint stride)
 {
-   SWcontext *swrast = SWRAST_CONTEXT(ctx);
-   GLubyte *fail = swrast->stencil_temp.buf2;
+   GLubyte *fail = _swrast_stencil_temp(ctx)->buf2;
    GLboolean allfail = GL_FALSE;
    GLuint i, j;
    const GLuint valueMask = ctx->Stencil.ValueMask[face];
@@ -349,7 +348,7 @@ put_s8_values(struct gl_context *ctx, struct gl_renderbuffer *rb,
 GLboolean
 _swrast_stencil_and_ztest_span(struct gl_context *ctx, SWspan *span)
 {
-   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_stencil_temp *temp = _swrast_stencil_temp(ctx);
    struct gl_framebuffer *fb = ctx->DrawBuffer;
    struct gl_renderbuffer *rb = fb->Attachment[BUFFER_STENCIL].Renderbuffer;
    const GLint stencilOffset = get_stencil_offset(rb->Format);
@@ -357,7 +356,7 @@ _swrast_stencil_and_ztest_span(struct gl_context *ctx, SWspan *span)
    const GLuint face = (span->facing == 0) ? 0 : ctx->Stencil._BackFace;
    const GLuint count = span->end;
    GLubyte *mask = span->array->mask;
-   GLubyte *stencilTemp = swrast->stencil_temp.buf1;
+   GLubyte *stencilTemp = temp->buf1;
    GLubyte *stencilBuf;
 
    if (span->arrayMask & SPAN_XY) {
@@ -405,10 +404,9 @@ _swrast_stencil_and_ztest_span(struct gl_context *ctx, SWspan *span)
       /*
        * Perform depth buffering, then apply zpass or zfail stencil function.
        */
-      SWcontext *swrast = SWRAST_CONTEXT(ctx);
-      GLubyte *passMask = swrast->stencil_temp.buf2;
-      GLubyte *failMask = swrast->stencil_temp.buf3;
-      GLubyte *origMask = swrast->stencil_temp.buf4;
+      GLubyte *passMask = temp->buf2;
+      GLubyte *failMask = temp->buf3;
+      GLubyte *origMask = temp->buf4;
 
       /* save the current mask bits */
       memcpy(origMask, mask, count * sizeof(GLubyte));
@@ -494,7 +492,7 @@ void
 _swrast_write_stencil_span(struct gl_context *ctx, GLint n, GLint x, GLint y,
                            const GLubyte stencil[] )
 {
-   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   struct swrast_stencil_temp *temp = _swrast_stencil_temp(ctx);
    struct gl_framebuffer *fb = ctx->DrawBuffer;
    struct gl_renderbuffer *rb = fb->Attachment[BUFFER_STENCIL].Renderbuffer;
    const GLuint stencilMax = (1 << fb->Visual.stencilBits) - 1;
@@ -524,8 +522,8 @@ _swrast_write_stencil_span(struct gl_context *ctx, GLint n, GLint x, GLint y,
 
    if ((stencilMask & stencilMax) != stencilMax) {
       /* need to apply writemask */
-      GLubyte *destVals = swrast->stencil_temp.buf1;
-      GLubyte *newVals = swrast->stencil_temp.buf2;
+      GLubyte *destVals = temp->buf1;
+      GLubyte *newVals = temp->buf2;
       GLint i;
 
       _mesa_unpack_ubyte_stencil_row(rb->Format, n, stencilBuf, destVals);
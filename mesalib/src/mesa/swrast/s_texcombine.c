@@ -52,7 +52,10 @@ get_texel_array(SWcontext *swrast, GLuint unit)
 #ifdef _OPENMP
    return (float4_array) (swrast->TexelBuffer + unit * SWRAST_MAX_WIDTH * 4 * omp_get_num_threads() + (SWRAST_MAX_WIDTH * 4 * omp_get_thread_num()));
 #else
-   return (float4_array) (swrast->TexelBuffer + unit * SWRAST_MAX_WIDTH * 4);
+   const struct swrast_band_thread *band = _swrast_band_thread();
+   GLfloat *texels = band ? band->TexelBuffer : swrast->TexelBuffer;
+
+   return (float4_array) (texels + unit * SWRAST_MAX_WIDTH * 4);
 #endif
 }
 
@@ -590,7 +593,8 @@ _swrast_texture_span( struct gl_context *ctx, SWspan *span )
    float4_array primary_rgba;
    GLuint unit;
 
-   if (!swrast->TexelBuffer) {
+   /* band threads get theirs from _swrast_flush_bins() */
+   if (!swrast->TexelBuffer && !_swrast_band_thread()) {
 #ifdef _OPENMP
       const GLint maxThreads = omp_get_max_threads();
 
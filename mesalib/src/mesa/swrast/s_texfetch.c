@@ -44,6 +44,7 @@
 #include "main/samplerobj.h"
 #include "s_context.h"
 #include "s_texfetch.h"
+#include "s_texfilter.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
 #include "util/format_srgb.h"
@@ -509,6 +510,8 @@ set_fetch_functions(const struct gl_sampler_object *samp,
    }
 
    texImage->FetchCompressedTexel = _mesa_get_compressed_fetch_func(format);
+   texImage->SampleLinearSpan =
+      dims == 2 ? _swrast_choose_linear_span_func(format) : NULL;
 
    assert(texImage->FetchTexel);
 }
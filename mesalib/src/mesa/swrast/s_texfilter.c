@@ -31,6 +31,7 @@
 #include "main/samplerobj.h"
 #include "main/teximage.h"
 #include "main/texobj.h"
+#include "util/u_cpu_detect.h"
 
 #include "s_context.h"
 #include "s_texfilter.h"
@@ -1244,6 +1245,540 @@ sample_2d_linear_repeat(struct gl_context *ctx,
 }
 
 
+/*
+ * Span-wide GL_LINEAR sampling of 2D images in a few common formats, with
+ * GL_REPEAT (power of two sizes) or GL_CLAMP_TO_EDGE wrapping and no
+ * border.  Texel locations and weights are computed for four coordinates
+ * at a time, texels are unpacked straight from the image instead of
+ * through FetchTexel, and the blends work on all four channels at once.
+ * The float operations are the same as sample_2d_linear()'s and the
+ * unpacked texels the same as FetchTexel's, so are the results.
+ *
+ * The kernel for an image's format is chosen along with its FetchTexel
+ * function, see set_fetch_functions(), and is the AVX2 one below where
+ * the CPU has it.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+#define LINEAR_SPAN_KERNELS
+
+
+/**
+ * linear_texel_locations() for four coordinates.
+ * \return the weights
+ */
+static inline __m128
+linear_span_locations(GLenum wrapMode, GLint size, __m128 s,
+                      __m128i *i0, __m128i *i1)
+{
+   const __m128 one = _mm_set1_ps(1.0F);
+   __m128 u, fl, less;
+   __m128i i;
+
+   if (wrapMode == GL_CLAMP_TO_EDGE) {
+      /* s <= 0 maps to 0 and s >= 1 to size */
+      s = _mm_min_ps(_mm_max_ps(s, _mm_setzero_ps()), one);
+   }
+   u = _mm_sub_ps(_mm_mul_ps(s, _mm_set1_ps((GLfloat) size)),
+                  _mm_set1_ps(0.5F));
+
+   /* IFLOOR(u): truncate, then step down where that rounded up */
+   i = _mm_cvttps_epi32(u);
+   fl = _mm_cvtepi32_ps(i);
+   less = _mm_cmplt_ps(u, fl);
+   i = _mm_add_epi32(i, _mm_castps_si128(less));
+   fl = _mm_sub_ps(fl, _mm_and_ps(less, one));
+
+   if (wrapMode == GL_REPEAT) {
+      const __m128i mask = _mm_set1_epi32(size - 1);
+      *i0 = _mm_and_si128(i, mask);
+      *i1 = _mm_and_si128(_mm_add_epi32(*i0, _mm_set1_epi32(1)), mask);
+   }
+   else {
+      const __m128i max = _mm_set1_epi32(size - 1);
+      __m128i over;
+      /* u >= -0.5, so only i0 = -1 needs clamping to 0 */
+      *i0 = _mm_andnot_si128(_mm_srai_epi32(i, 31), i);
+      *i1 = _mm_add_epi32(i, _mm_set1_epi32(1));
+      over = _mm_cmpgt_epi32(*i1, max);
+      *i1 = _mm_or_si128(_mm_and_si128(over, max),
+                         _mm_andnot_si128(over, *i1));
+   }
+
+   return _mm_sub_ps(u, fl);   /* FRAC(u) */
+}
+
+
+/**
+ * Convert four 8-bit values, from least significant, to floats as
+ * _mesa_unorm_to_float() does.
+ */
+static inline __m128
+unorm8x4_to_float(GLuint bytes)
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i v = _mm_cvtsi32_si128(bytes);
+
+   v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+   return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0F / 255.0F));
+}
+
+
+/**
+ * Unpack texel i of a row to RGBA floats, as FetchTexel would.
+ */
+static ALWAYS_INLINE __m128
+linear_span_texel(mesa_format format, const GLubyte *row, GLint i)
+{
+   GLuint texel;
+
+   switch (format) {
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+      memcpy(&texel, row + 4 * i, 4);
+      return _mm_shuffle_ps(unorm8x4_to_float(texel),
+                            unorm8x4_to_float(texel),
+                            _MM_SHUFFLE(0, 1, 2, 3));
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+      memcpy(&texel, row + 4 * i, 4);
+      return unorm8x4_to_float(texel);
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+   case MESA_FORMAT_B8G8R8X8_UNORM:
+      memcpy(&texel, row + 4 * i, 4);
+      if (format == MESA_FORMAT_B8G8R8X8_UNORM)
+         texel |= 0xff000000;
+      return _mm_shuffle_ps(unorm8x4_to_float(texel),
+                            unorm8x4_to_float(texel),
+                            _MM_SHUFFLE(3, 0, 1, 2));
+   case MESA_FORMAT_B5G6R5_UNORM:
+      {
+         GLushort p;
+         memcpy(&p, row + 2 * i, 2);
+         texel = p;
+         return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+                                         _mm_setr_epi32(texel >> 11,
+                                                        (texel >> 5) & 0x3f,
+                                                        texel & 0x1f, 0)),
+                                      _mm_setr_ps(1.0F / 31.0F,
+                                                  1.0F / 63.0F,
+                                                  1.0F / 31.0F, 0.0F)),
+                           _mm_setr_ps(0.0F, 0.0F, 0.0F, 1.0F));
+      }
+   case MESA_FORMAT_L_UNORM8:
+      texel = row[i] * 0x010101 + 0xff000000;
+      return unorm8x4_to_float(texel);
+   default:
+      unreachable("format without a linear span kernel");
+   }
+}
+
+
+static ALWAYS_INLINE void
+linear_span_2d(const struct gl_sampler_object *samp,
+               const struct swrast_texture_image *swImg,
+               GLuint n, const GLfloat texcoords[][4], GLfloat rgba[][4],
+               mesa_format format)
+{
+   const GLubyte *map = (const GLubyte *) swImg->ImageSlices[0];
+   const GLint stride = swImg->RowStride;
+   const GLint width = swImg->Base.Width2;
+   const GLint height = swImg->Base.Height2;
+   GLuint base, k;
+
+   for (base = 0; base < n; base += 4) {
+      const GLuint count = MIN2(n - base, 4);
+      GLfloat s[4] = { 0.0F }, t[4] = { 0.0F };
+      GLint i0[4], i1[4], j0[4], j1[4];
+      GLfloat a[4], b[4];
+      __m128i vi0, vi1, vj0, vj1;
+
+      for (k = 0; k < count; k++) {
+         s[k] = texcoords[base + k][0];
+         t[k] = texcoords[base + k][1];
+      }
+      _mm_storeu_ps(a, linear_span_locations(samp->WrapS, width,
+                                             _mm_loadu_ps(s), &vi0, &vi1));
+      _mm_storeu_ps(b, linear_span_locations(samp->WrapT, height,
+                                             _mm_loadu_ps(t), &vj0, &vj1));
+      _mm_storeu_si128((__m128i *) i0, vi0);
+      _mm_storeu_si128((__m128i *) i1, vi1);
+      _mm_storeu_si128((__m128i *) j0, vj0);
+      _mm_storeu_si128((__m128i *) j1, vj1);
+
+      for (k = 0; k < count; k++) {
+         const GLubyte *row0 = map + stride * j0[k];
+         const GLubyte *row1 = map + stride * j1[k];
+         const __m128 wa = _mm_set1_ps(a[k]), wb = _mm_set1_ps(b[k]);
+         const __m128 t00 = linear_span_texel(format, row0, i0[k]);
+         const __m128 t10 = linear_span_texel(format, row0, i1[k]);
+         const __m128 t01 = linear_span_texel(format, row1, i0[k]);
+         const __m128 t11 = linear_span_texel(format, row1, i1[k]);
+         /* lerp_rgba_2d() */
+         const __m128 temp0 = _mm_add_ps(t00,
+                                         _mm_mul_ps(wa, _mm_sub_ps(t10, t00)));
+         const __m128 temp1 = _mm_add_ps(t01,
+                                         _mm_mul_ps(wa, _mm_sub_ps(t11, t01)));
+         _mm_storeu_ps(rgba[base + k],
+                       _mm_add_ps(temp0,
+                                  _mm_mul_ps(wb, _mm_sub_ps(temp1, temp0))));
+      }
+   }
+}
+
+
+#define LINEAR_SPAN_FUNC(NAME)                                          \
+static void                                                             \
+linear_span_2d_##NAME(const struct gl_sampler_object *samp,             \
+                      const struct swrast_texture_image *swImg,         \
+                      GLuint n, const GLfloat texcoords[][4],           \
+                      GLfloat rgba[][4])                                \
+{                                                                       \
+   linear_span_2d(samp, swImg, n, texcoords, rgba, MESA_FORMAT_##NAME); \
+}
+
+LINEAR_SPAN_FUNC(A8B8G8R8_UNORM)
+LINEAR_SPAN_FUNC(R8G8B8A8_UNORM)
+LINEAR_SPAN_FUNC(B8G8R8A8_UNORM)
+LINEAR_SPAN_FUNC(B8G8R8X8_UNORM)
+LINEAR_SPAN_FUNC(B5G6R5_UNORM)
+LINEAR_SPAN_FUNC(L_UNORM8)
+
+#undef LINEAR_SPAN_FUNC
+
+
+/*
+ * The same kernels for eight coordinates at a time with AVX2.  AVX alone
+ * wouldn't do: the texel locations are integer vectors and the 32-bit
+ * texels are fetched with a gather.  Each channel is unpacked and
+ * blended for all eight coordinates, and the results are transposed to
+ * RGBA at the end.  Without FMA the float operations are still those of
+ * sample_2d_linear().
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINEAR_SPAN_AVX2
+#define LINEAR_SPAN_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#define LINEAR_SPAN_AVX2
+#define LINEAR_SPAN_AVX2_TARGET
+#endif
+
+#ifdef LINEAR_SPAN_AVX2
+#include <immintrin.h>
+
+
+/**
+ * linear_span_locations() for eight coordinates.
+ * \return the weights
+ */
+static inline LINEAR_SPAN_AVX2_TARGET __m256
+linear_span_locations_avx2(GLenum wrapMode, GLint size, __m256 s,
+                           __m256i *i0, __m256i *i1)
+{
+   const __m256 one = _mm256_set1_ps(1.0F);
+   __m256 u, fl, less;
+   __m256i i;
+
+   if (wrapMode == GL_CLAMP_TO_EDGE) {
+      /* s <= 0 maps to 0 and s >= 1 to size */
+      s = _mm256_min_ps(_mm256_max_ps(s, _mm256_setzero_ps()), one);
+   }
+   u = _mm256_sub_ps(_mm256_mul_ps(s, _mm256_set1_ps((GLfloat) size)),
+                     _mm256_set1_ps(0.5F));
+
+   /* IFLOOR(u): truncate, then step down where that rounded up */
+   i = _mm256_cvttps_epi32(u);
+   fl = _mm256_cvtepi32_ps(i);
+   less = _mm256_cmp_ps(u, fl, _CMP_LT_OS);
+   i = _mm256_add_epi32(i, _mm256_castps_si256(less));
+   fl = _mm256_sub_ps(fl, _mm256_and_ps(less, one));
+
+   if (wrapMode == GL_REPEAT) {
+      const __m256i mask = _mm256_set1_epi32(size - 1);
+      *i0 = _mm256_and_si256(i, mask);
+      *i1 = _mm256_and_si256(_mm256_add_epi32(*i0, _mm256_set1_epi32(1)),
+                             mask);
+   }
+   else {
+      *i0 = _mm256_max_epi32(i, _mm256_setzero_si256());
+      *i1 = _mm256_min_epi32(_mm256_add_epi32(i, _mm256_set1_epi32(1)),
+                             _mm256_set1_epi32(size - 1));
+   }
+
+   return _mm256_sub_ps(u, fl);   /* FRAC(u) */
+}
+
+
+/**
+ * The channel at bit 'shift' of eight 32-bit texels, converted as
+ * unorm8x4_to_float() does.
+ */
+static inline LINEAR_SPAN_AVX2_TARGET __m256
+unorm8x8_to_float(__m256i texels, int shift)
+{
+   const __m256i v = _mm256_and_si256(_mm256_srli_epi32(texels, shift),
+                                      _mm256_set1_epi32(0xff));
+
+   return _mm256_mul_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(1.0F / 255.0F));
+}
+
+
+/**
+ * Unpack the texels at (i, j) of eight coordinates as linear_span_texel()
+ * would, one vector per channel.
+ */
+static ALWAYS_INLINE LINEAR_SPAN_AVX2_TARGET void
+linear_span_texels_avx2(mesa_format format, const GLubyte *map,
+                        GLint stride, __m256i i, __m256i j, __m256 c[4])
+{
+   const GLint bpp = format == MESA_FORMAT_B5G6R5_UNORM ? 2 :
+                     format == MESA_FORMAT_L_UNORM8 ? 1 : 4;
+   const __m256i offsets =
+      _mm256_add_epi32(_mm256_mullo_epi32(j, _mm256_set1_epi32(stride)),
+                       _mm256_mullo_epi32(i, _mm256_set1_epi32(bpp)));
+   __m256i texels;
+
+   if (bpp == 4) {
+      texels = _mm256_i32gather_epi32((const int *) map, offsets, 1);
+   }
+   else {
+      /* a gather would read past the last texel */
+      GLint offset[8];
+      GLuint texel[8];
+      GLuint k;
+
+      _mm256_storeu_si256((__m256i *) offset, offsets);
+      for (k = 0; k < 8; k++) {
+         if (bpp == 2) {
+            GLushort p;
+            memcpy(&p, map + offset[k], 2);
+            texel[k] = p;
+         }
+         else {
+            texel[k] = map[offset[k]] * 0x010101 + 0xff000000;
+         }
+      }
+      texels = _mm256_loadu_si256((const __m256i *) texel);
+   }
+
+   switch (format) {
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+      c[0] = unorm8x8_to_float(texels, 24);
+      c[1] = unorm8x8_to_float(texels, 16);
+      c[2] = unorm8x8_to_float(texels, 8);
+      c[3] = unorm8x8_to_float(texels, 0);
+      break;
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+   case MESA_FORMAT_L_UNORM8:
+      c[0] = unorm8x8_to_float(texels, 0);
+      c[1] = unorm8x8_to_float(texels, 8);
+      c[2] = unorm8x8_to_float(texels, 16);
+      c[3] = unorm8x8_to_float(texels, 24);
+      break;
+   case MESA_FORMAT_B8G8R8X8_UNORM:
+      texels = _mm256_or_si256(texels, _mm256_set1_epi32((int) 0xff000000));
+      /* fall-through */
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+      c[0] = unorm8x8_to_float(texels, 16);
+      c[1] = unorm8x8_to_float(texels, 8);
+      c[2] = unorm8x8_to_float(texels, 0);
+      c[3] = unorm8x8_to_float(texels, 24);
+      break;
+   case MESA_FORMAT_B5G6R5_UNORM:
+      c[0] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(texels, 11)),
+                           _mm256_set1_ps(1.0F / 31.0F));
+      c[1] = _mm256_mul_ps(_mm256_cvtepi32_ps(
+                              _mm256_and_si256(_mm256_srli_epi32(texels, 5),
+                                               _mm256_set1_epi32(0x3f))),
+                           _mm256_set1_ps(1.0F / 63.0F));
+      c[2] = _mm256_mul_ps(_mm256_cvtepi32_ps(
+                              _mm256_and_si256(texels,
+                                               _mm256_set1_epi32(0x1f))),
+                           _mm256_set1_ps(1.0F / 31.0F));
+      c[3] = _mm256_set1_ps(1.0F);
+      break;
+   default:
+      unreachable("format without a linear span kernel");
+   }
+}
+
+
+static ALWAYS_INLINE LINEAR_SPAN_AVX2_TARGET void
+linear_span_2d_avx2(const struct gl_sampler_object *samp,
+                    const struct swrast_texture_image *swImg,
+                    GLuint n, const GLfloat texcoords[][4], GLfloat rgba[][4],
+                    mesa_format format)
+{
+   const GLubyte *map = (const GLubyte *) swImg->ImageSlices[0];
+   const GLint stride = swImg->RowStride;
+   const GLint width = swImg->Base.Width2;
+   const GLint height = swImg->Base.Height2;
+   GLuint base, k;
+
+   for (base = 0; base < n; base += 8) {
+      const GLuint count = MIN2(n - base, 8);
+      GLfloat s[8] = { 0.0F }, t[8] = { 0.0F };
+      GLfloat tail[8][4];
+      GLfloat (*dst)[4] = count == 8 ? rgba + base : tail;
+      __m256i i0, i1, j0, j1;
+      __m256 a, b, t00[4], t10[4], t01[4], t11[4], v[4];
+      __m256 rg0, rg1, ba0, ba1, p0, p1, p2, p3;
+
+      for (k = 0; k < count; k++) {
+         s[k] = texcoords[base + k][0];
+         t[k] = texcoords[base + k][1];
+      }
+      a = linear_span_locations_avx2(samp->WrapS, width, _mm256_loadu_ps(s),
+                                     &i0, &i1);
+      b = linear_span_locations_avx2(samp->WrapT, height, _mm256_loadu_ps(t),
+                                     &j0, &j1);
+
+      linear_span_texels_avx2(format, map, stride, i0, j0, t00);
+      linear_span_texels_avx2(format, map, stride, i1, j0, t10);
+      linear_span_texels_avx2(format, map, stride, i0, j1, t01);
+      linear_span_texels_avx2(format, map, stride, i1, j1, t11);
+
+      for (k = 0; k < 4; k++) {
+         /* lerp_rgba_2d() */
+         const __m256 temp0 =
+            _mm256_add_ps(t00[k], _mm256_mul_ps(a, _mm256_sub_ps(t10[k],
+                                                                 t00[k])));
+         const __m256 temp1 =
+            _mm256_add_ps(t01[k], _mm256_mul_ps(a, _mm256_sub_ps(t11[k],
+                                                                 t01[k])));
+         v[k] = _mm256_add_ps(temp0,
+                              _mm256_mul_ps(b, _mm256_sub_ps(temp1, temp0)));
+      }
+
+      /* RGBA of coordinates 0 and 4 in p0, 1 and 5 in p1 and so on */
+      rg0 = _mm256_unpacklo_ps(v[0], v[1]);
+      rg1 = _mm256_unpackhi_ps(v[0], v[1]);
+      ba0 = _mm256_unpacklo_ps(v[2], v[3]);
+      ba1 = _mm256_unpackhi_ps(v[2], v[3]);
+      p0 = _mm256_shuffle_ps(rg0, ba0, _MM_SHUFFLE(1, 0, 1, 0));
+      p1 = _mm256_shuffle_ps(rg0, ba0, _MM_SHUFFLE(3, 2, 3, 2));
+      p2 = _mm256_shuffle_ps(rg1, ba1, _MM_SHUFFLE(1, 0, 1, 0));
+      p3 = _mm256_shuffle_ps(rg1, ba1, _MM_SHUFFLE(3, 2, 3, 2));
+      _mm256_storeu_ps(dst[0], _mm256_permute2f128_ps(p0, p1, 0x20));
+      _mm256_storeu_ps(dst[2], _mm256_permute2f128_ps(p2, p3, 0x20));
+      _mm256_storeu_ps(dst[4], _mm256_permute2f128_ps(p0, p1, 0x31));
+      _mm256_storeu_ps(dst[6], _mm256_permute2f128_ps(p2, p3, 0x31));
+
+      if (count < 8)
+         memcpy(rgba + base, tail, count * sizeof(tail[0]));
+   }
+}
+
+
+#define LINEAR_SPAN_AVX2_FUNC(NAME)                                     \
+static LINEAR_SPAN_AVX2_TARGET void                                     \
+linear_span_2d_##NAME##_avx2(const struct gl_sampler_object *samp,      \
+                             const struct swrast_texture_image *swImg,  \
+                             GLuint n, const GLfloat texcoords[][4],    \
+                             GLfloat rgba[][4])                         \
+{                                                                       \
+   linear_span_2d_avx2(samp, swImg, n, texcoords, rgba,                 \
+                       MESA_FORMAT_##NAME);                             \
+}
+
+LINEAR_SPAN_AVX2_FUNC(A8B8G8R8_UNORM)
+LINEAR_SPAN_AVX2_FUNC(R8G8B8A8_UNORM)
+LINEAR_SPAN_AVX2_FUNC(B8G8R8A8_UNORM)
+LINEAR_SPAN_AVX2_FUNC(B8G8R8X8_UNORM)
+LINEAR_SPAN_AVX2_FUNC(B5G6R5_UNORM)
+LINEAR_SPAN_AVX2_FUNC(L_UNORM8)
+
+#undef LINEAR_SPAN_AVX2_FUNC
+
+/* util_cpu_detect() has to be called first */
+#define LINEAR_SPAN_KERNEL(NAME) \
+   (util_cpu_caps.has_avx2 ? linear_span_2d_##NAME##_avx2 \
+                           : linear_span_2d_##NAME)
+
+#else
+
+#define LINEAR_SPAN_KERNEL(NAME) linear_span_2d_##NAME
+
+#endif /* LINEAR_SPAN_AVX2 */
+
+#endif /* SSE2 */
+
+
+/**
+ * Return the span kernel for 2D images of the given format, or NULL.
+ */
+LinearSpanFunc
+_swrast_choose_linear_span_func(mesa_format format)
+{
+#ifdef LINEAR_SPAN_KERNELS
+   util_cpu_detect();
+
+   switch (format) {
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+      return LINEAR_SPAN_KERNEL(A8B8G8R8_UNORM);
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+      return LINEAR_SPAN_KERNEL(R8G8B8A8_UNORM);
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+      return LINEAR_SPAN_KERNEL(B8G8R8A8_UNORM);
+   case MESA_FORMAT_B8G8R8X8_UNORM:
+      return LINEAR_SPAN_KERNEL(B8G8R8X8_UNORM);
+   case MESA_FORMAT_B5G6R5_UNORM:
+      return LINEAR_SPAN_KERNEL(B5G6R5_UNORM);
+   case MESA_FORMAT_L_UNORM8:
+      return LINEAR_SPAN_KERNEL(L_UNORM8);
+   default:
+      break;
+   }
+#endif
+   (void) format;
+   return NULL;
+}
+
+
+static inline GLboolean
+linear_span_wrap(GLenum wrapMode, const struct swrast_texture_image *swImg)
+{
+   return wrapMode == GL_CLAMP_TO_EDGE ||
+          (wrapMode == GL_REPEAT && swImg->_IsPowerOfTwo);
+}
+
+
+/**
+ * Sample n coordinates of one image with GL_LINEAR filtering, with the
+ * image's span kernel when it has one that fits.
+ */
+static void
+sample_2d_linear_span(struct gl_context *ctx,
+                      const struct gl_sampler_object *samp,
+                      const struct gl_texture_image *img,
+                      GLuint n, const GLfloat texcoords[][4],
+                      GLfloat rgba[][4])
+{
+   const struct swrast_texture_image *swImg = swrast_texture_image_const(img);
+   GLuint i;
+
+   if (swImg->SampleLinearSpan &&
+       img->Border == 0 &&
+       linear_span_wrap(samp->WrapS, swImg) &&
+       linear_span_wrap(samp->WrapT, swImg)) {
+      swImg->SampleLinearSpan(samp, swImg, n, texcoords, rgba);
+   }
+   else if (samp->WrapS == GL_REPEAT &&
+            samp->WrapT == GL_REPEAT &&
+            swImg->_IsPowerOfTwo &&
+            img->Border == 0) {
+      for (i = 0; i < n; i++) {
+         sample_2d_linear_repeat(ctx, samp, img, texcoords[i], rgba[i]);
+      }
+   }
+   else {
+      for (i = 0; i < n; i++) {
+         sample_2d_linear(ctx, samp, img, texcoords[i], rgba[i]);
+      }
+   }
+}
+
+
 static void
 sample_2d_nearest_mipmap_nearest(struct gl_context *ctx,
                                  const struct gl_sampler_object *samp,
@@ -1266,11 +1801,17 @@ sample_2d_linear_mipmap_nearest(struct gl_context *ctx,
                                 GLuint n, const GLfloat texcoord[][4],
                                 const GLfloat lambda[], GLfloat rgba[][4])
 {
-   GLuint i;
+   GLuint i, j;
    assert(lambda != NULL);
-   for (i = 0; i < n; i++) {
-      GLint level = nearest_mipmap_level(tObj, lambda[i]);
-      sample_2d_linear(ctx, samp, tObj->Image[0][level], texcoord[i], rgba[i]);
+   for (i = 0; i < n; i = j) {
+      /* sample the run of texcoords at the same level together */
+      const GLint level = nearest_mipmap_level(tObj, lambda[i]);
+      for (j = i + 1; j < n; j++) {
+         if (nearest_mipmap_level(tObj, lambda[j]) != level)
+            break;
+      }
+      sample_2d_linear_span(ctx, samp, tObj->Image[0][level], j - i,
+                            texcoord + i, rgba + i);
    }
 }
 
@@ -1301,6 +1842,9 @@ sample_2d_nearest_mipmap_linear(struct gl_context *ctx,
 }
 
 
+/** Most texcoords sampled at once by sample_2d_linear_mipmap_linear() */
+#define LINEAR_MIPMAP_RUN 64
+
 static void
 sample_2d_linear_mipmap_linear( struct gl_context *ctx,
                                 const struct gl_sampler_object *samp,
@@ -1308,50 +1852,31 @@ sample_2d_linear_mipmap_linear( struct gl_context *ctx,
                                 GLuint n, const GLfloat texcoord[][4],
                                 const GLfloat lambda[], GLfloat rgba[][4] )
 {
-   GLuint i;
+   GLfloat t1[LINEAR_MIPMAP_RUN][4];  /* texels from level+1 */
+   GLuint i, j, k;
    assert(lambda != NULL);
-   for (i = 0; i < n; i++) {
-      GLint level = linear_mipmap_level(tObj, lambda[i]);
-      if (level >= tObj->_MaxLevel) {
-         sample_2d_linear(ctx, samp, tObj->Image[0][tObj->_MaxLevel],
-                          texcoord[i], rgba[i]);
-      }
-      else {
-         GLfloat t0[4], t1[4];  /* texels */
-         const GLfloat f = FRAC(lambda[i]);
-         sample_2d_linear(ctx, samp, tObj->Image[0][level  ], texcoord[i], t0);
-         sample_2d_linear(ctx, samp, tObj->Image[0][level+1], texcoord[i], t1);
-         lerp_rgba(rgba[i], f, t0, t1);
+   for (i = 0; i < n; i = j) {
+      /* sample the run of texcoords between the same levels together */
+      const GLint level = MIN2(linear_mipmap_level(tObj, lambda[i]),
+                               tObj->_MaxLevel);
+      for (j = i + 1; j < n && j - i < LINEAR_MIPMAP_RUN; j++) {
+         if (MIN2(linear_mipmap_level(tObj, lambda[j]),
+                  tObj->_MaxLevel) != level)
+            break;
       }
-   }
-}
-
-
-static void
-sample_2d_linear_mipmap_linear_repeat(struct gl_context *ctx,
-                                      const struct gl_sampler_object *samp,
-                                      const struct gl_texture_object *tObj,
-                                      GLuint n, const GLfloat texcoord[][4],
-                                      const GLfloat lambda[], GLfloat rgba[][4])
-{
-   GLuint i;
-   assert(lambda != NULL);
-   assert(samp->WrapS == GL_REPEAT);
-   assert(samp->WrapT == GL_REPEAT);
-   for (i = 0; i < n; i++) {
-      GLint level = linear_mipmap_level(tObj, lambda[i]);
       if (level >= tObj->_MaxLevel) {
-         sample_2d_linear_repeat(ctx, samp, tObj->Image[0][tObj->_MaxLevel],
-                                 texcoord[i], rgba[i]);
+         sample_2d_linear_span(ctx, samp, tObj->Image[0][tObj->_MaxLevel],
+                               j - i, texcoord + i, rgba + i);
       }
       else {
-         GLfloat t0[4], t1[4];  /* texels */
-         const GLfloat f = FRAC(lambda[i]);
-         sample_2d_linear_repeat(ctx, samp, tObj->Image[0][level  ],
-                                 texcoord[i], t0);
-         sample_2d_linear_repeat(ctx, samp, tObj->Image[0][level+1],
-                                 texcoord[i], t1);
-         lerp_rgba(rgba[i], f, t0, t1);
+         sample_2d_linear_span(ctx, samp, tObj->Image[0][level  ],
+                               j - i, texcoord + i, rgba + i);
+         sample_2d_linear_span(ctx, samp, tObj->Image[0][level+1],
+                               j - i, texcoord + i, t1);
+         for (k = i; k < j; k++) {
+            const GLfloat f = FRAC(lambda[k]);
+            lerp_rgba(rgba[k], f, rgba[k], t1[k - i]);
+         }
       }
    }
 }
@@ -1382,23 +1907,9 @@ sample_linear_2d(struct gl_context *ctx,
                  const GLfloat texcoords[][4],
                  const GLfloat lambda[], GLfloat rgba[][4])
 {
-   GLuint i;
-   const struct gl_texture_image *image = _mesa_base_tex_image(tObj);
-   const struct swrast_texture_image *swImg = swrast_texture_image_const(image);
    (void) lambda;
-   if (samp->WrapS == GL_REPEAT &&
-       samp->WrapT == GL_REPEAT &&
-       swImg->_IsPowerOfTwo &&
-       image->Border == 0) {
-      for (i = 0; i < n; i++) {
-         sample_2d_linear_repeat(ctx, samp, image, texcoords[i], rgba[i]);
-      }
-   }
-   else {
-      for (i = 0; i < n; i++) {
-         sample_2d_linear(ctx, samp, image, texcoords[i], rgba[i]);
-      }
-   }
+   sample_2d_linear_span(ctx, samp, _mesa_base_tex_image(tObj),
+                         n, texcoords, rgba);
 }
 
 
@@ -1559,11 +2070,7 @@ sample_lambda_2d(struct gl_context *ctx,
                                          lambda + minStart, rgba + minStart);
          break;
       case GL_LINEAR_MIPMAP_LINEAR:
-         if (repeatNoBorderPOT)
-            sample_2d_linear_mipmap_linear_repeat(ctx, samp, tObj, m,
-                  texcoords + minStart, lambda + minStart, rgba + minStart);
-         else
-            sample_2d_linear_mipmap_linear(ctx, samp, tObj, m, texcoords + minStart,
+         sample_2d_linear_mipmap_linear(ctx, samp, tObj, m, texcoords + minStart,
                                         lambda + minStart, rgba + minStart);
          break;
       default:
@@ -1613,7 +2120,8 @@ sample_lambda_2d(struct gl_context *ctx,
 /* For anisotropic filtering */
 #define WEIGHT_LUT_SIZE 1024
 
-static GLfloat *weightLut = NULL;
+static GLfloat weightLut[WEIGHT_LUT_SIZE];
+static once_flag weightLutOnce = ONCE_FLAG_INIT;
 
 /**
  * Creates the look-up table used to speed-up EWA sampling
@@ -1622,15 +2130,12 @@ static void
 create_filter_table(void)
 {
    GLuint i;
-   if (!weightLut) {
-      weightLut = malloc(WEIGHT_LUT_SIZE * sizeof(GLfloat));
 
-      for (i = 0; i < WEIGHT_LUT_SIZE; ++i) {
-         GLfloat alpha = 2;
-         GLfloat r2 = (GLfloat) i / (GLfloat) (WEIGHT_LUT_SIZE - 1);
-         GLfloat weight = (GLfloat) exp(-alpha * r2);
-         weightLut[i] = weight;
-      }
+   for (i = 0; i < WEIGHT_LUT_SIZE; ++i) {
+      GLfloat alpha = 2;
+      GLfloat r2 = (GLfloat) i / (GLfloat) (WEIGHT_LUT_SIZE - 1);
+      GLfloat weight = (GLfloat) exp(-alpha * r2);
+      weightLut[i] = weight;
    }
 }
 
@@ -1906,10 +2411,10 @@ sample_lambda_2d_aniso(struct gl_context *ctx,
 
    GLuint i;
    
-   /* on first access create the lookup table containing the filter weights. */
-   if (!weightLut) {
-      create_filter_table();
-   }
+   /* on first access create the lookup table containing the filter weights.
+    * Band threads can get here at the same time, hence call_once().
+    */
+   call_once(&weightLutOnce, create_filter_table);
 
    texW = swImg->WidthScale;
    texH = swImg->HeightScale;
@@ -38,5 +38,8 @@ _swrast_choose_texture_sample_func( struct gl_context *ctx,
 				    const struct gl_texture_object *tObj,
                                     const struct gl_sampler_object *sampler);
 
+extern LinearSpanFunc
+_swrast_choose_linear_span_func(mesa_format format);
+
 
 #endif
@@ -0,0 +1,266 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file s_texfilter_test.c
+ * Sample 2D images with GL_LINEAR filtering through their span kernel
+ * and, with the kernel taken away, through sample_2d_linear() or
+ * sample_2d_linear_repeat(), and check that the colors are the same.
+ * Where the CPU has AVX2 the SSE2 kernels are checked as well.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c99_math.h"
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+
+#include "s_context.h"
+#include "s_texfetch.h"
+#include "s_texfilter.h"
+
+/** Not a multiple of four or eight, so the last group is partial */
+#define NUM_COORDS 29
+#define ROUNDS 64
+
+static const struct {
+   mesa_format format;
+   GLenum baseFormat;
+   GLuint bytes;
+} formats[] = {
+   { MESA_FORMAT_A8B8G8R8_UNORM, GL_RGBA, 4 },
+   { MESA_FORMAT_R8G8B8A8_UNORM, GL_RGBA, 4 },
+   { MESA_FORMAT_B8G8R8A8_UNORM, GL_RGBA, 4 },
+   { MESA_FORMAT_B8G8R8X8_UNORM, GL_RGB, 4 },
+   { MESA_FORMAT_B5G6R5_UNORM, GL_RGB, 2 },
+   { MESA_FORMAT_L_UNORM8, GL_LUMINANCE, 1 },
+};
+
+/** Power of two sizes take GL_REPEAT, the others fall back for it */
+static const struct {
+   GLuint width, height;
+} sizes[] = {
+   { 16, 8 },
+   { 1, 4 },
+   { 2, 1 },
+   { 13, 7 },
+};
+
+static const GLenum wraps[][2] = {
+   { GL_REPEAT, GL_REPEAT },
+   { GL_REPEAT, GL_CLAMP_TO_EDGE },
+   { GL_CLAMP_TO_EDGE, GL_REPEAT },
+   { GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE },
+};
+
+
+static GLuint
+rand_next(void)
+{
+   static GLuint seed = 1;
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+
+/**
+ * A texture coordinate, mostly within [-3, 4] so that both wrap modes
+ * have work to do, sometimes on an edge or a texel center.
+ */
+static GLfloat
+rand_coord(GLuint size)
+{
+   static const GLfloat special[] = { 0.0F, -0.0F, 1.0F, -1.0F, 2.0F };
+   const GLuint r = rand_next();
+
+   switch (r % 8) {
+   case 0:
+      return special[(r >> 3) % ARRAY_SIZE(special)];
+   case 1:
+      return ((GLfloat) ((r >> 3) % (2 * size)) + 0.5F) / (GLfloat) size;
+   default:
+      return (GLfloat) ((GLint) ((r >> 3) % 7001) - 3000) / 1000.0F;
+   }
+}
+
+
+static bool
+same_value(GLfloat a, GLfloat b)
+{
+   return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+
+/**
+ * Sample the image of 'texObj' at random coordinates with and without
+ * its span kernel.
+ * \return  true if they differ
+ */
+static bool
+run_image(struct gl_context *ctx, struct gl_texture_object *texObj,
+          const char *name)
+{
+   struct swrast_texture_image *swImg =
+      swrast_texture_image(texObj->Image[0][0]);
+   const LinearSpanFunc span = swImg->SampleLinearSpan;
+   const texture_sample_func sample =
+      _swrast_choose_texture_sample_func(ctx, texObj, &texObj->Sampler);
+   static const GLfloat lambda[NUM_COORDS];
+   GLfloat texcoords[NUM_COORDS][4];
+   GLfloat expected[NUM_COORDS][4], rgba[NUM_COORDS][4];
+   bool failed = false;
+   GLuint round, w, i, k;
+
+   for (w = 0; w < ARRAY_SIZE(wraps); w++) {
+      texObj->Sampler.WrapS = wraps[w][0];
+      texObj->Sampler.WrapT = wraps[w][1];
+
+      for (round = 0; round < ROUNDS; round++) {
+         for (i = 0; i < NUM_COORDS; i++) {
+            texcoords[i][0] = rand_coord(swImg->Base.Width);
+            texcoords[i][1] = rand_coord(swImg->Base.Height);
+            texcoords[i][2] = 0.0F;
+            texcoords[i][3] = 1.0F;
+         }
+
+         swImg->SampleLinearSpan = NULL;
+         sample(ctx, &texObj->Sampler, texObj, NUM_COORDS,
+                (const GLfloat (*)[4]) texcoords, lambda, expected);
+         swImg->SampleLinearSpan = span;
+         sample(ctx, &texObj->Sampler, texObj, NUM_COORDS,
+                (const GLfloat (*)[4]) texcoords, lambda, rgba);
+
+         for (i = 0; i < NUM_COORDS; i++) {
+            for (k = 0; k < 4; k++) {
+               if (!same_value(expected[i][k], rgba[i][k])) {
+                  fprintf(stderr, "%s %ux%u wrap %#x/%#x at (%g, %g): "
+                                  "%c expected %g (%a) but got %g (%a)\n",
+                          name, swImg->Base.Width, swImg->Base.Height,
+                          wraps[w][0], wraps[w][1],
+                          texcoords[i][0], texcoords[i][1], "rgba"[k],
+                          expected[i][k], expected[i][k],
+                          rgba[i][k], rgba[i][k]);
+                  failed = true;
+               }
+            }
+         }
+      }
+   }
+
+   return failed;
+}
+
+
+/**
+ * Run every format and size with the kernels that
+ * _swrast_choose_linear_span_func() picks now.
+ */
+static bool
+run_kernels(struct gl_context *ctx, struct gl_texture_object *texObj)
+{
+   struct swrast_texture_image *swImg =
+      swrast_texture_image(texObj->Image[0][0]);
+   struct gl_texture_image *img = &swImg->Base;
+   bool failed = false;
+   GLuint f, z, i;
+
+   for (f = 0; f < ARRAY_SIZE(formats); f++) {
+      for (z = 0; z < ARRAY_SIZE(sizes); z++) {
+         const GLuint width = sizes[z].width, height = sizes[z].height;
+         /* rows that don't start on a texel boundary of the previous one */
+         const GLuint stride = width * formats[f].bytes + 3;
+         GLubyte *buffer = malloc(stride * height);
+
+         if (!buffer)
+            return true;
+         for (i = 0; i < stride * height; i++)
+            buffer[i] = (GLubyte) rand_next();
+
+         img->TexFormat = formats[f].format;
+         img->_BaseFormat = formats[f].baseFormat;
+         img->InternalFormat = formats[f].baseFormat;
+         img->Width = img->Width2 = width;
+         img->Height = img->Height2 = height;
+         img->Depth = img->Depth2 = 1;
+         img->WidthLog2 = util_logbase2(width);
+         img->HeightLog2 = util_logbase2(height);
+         swImg->_IsPowerOfTwo = util_is_power_of_two_nonzero(width) &&
+                                util_is_power_of_two_nonzero(height);
+         swImg->RowStride = stride;
+         swImg->ImageSlices[0] = buffer;
+
+         _mesa_update_fetch_functions(ctx, 0);
+         if (swImg->SampleLinearSpan) {
+            failed |= run_image(ctx, texObj,
+                                _mesa_get_format_name(formats[f].format));
+         }
+
+         free(buffer);
+      }
+   }
+
+   return failed;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   struct gl_context *ctx = calloc(1, sizeof(*ctx));
+   struct gl_texture_object *texObj = calloc(1, sizeof(*texObj));
+   struct swrast_texture_image *swImg = calloc(1, sizeof(*swImg));
+   void *slices[1];
+   bool failed = false;
+
+   if (!ctx || !texObj || !swImg)
+      return 1;
+
+   swImg->Base.TexObject = texObj;
+   swImg->ImageSlices = slices;
+   texObj->Target = GL_TEXTURE_2D;
+   texObj->Image[0][0] = &swImg->Base;
+   texObj->_BaseComplete = GL_TRUE;
+   texObj->Sampler.MinFilter = GL_LINEAR;
+   texObj->Sampler.MagFilter = GL_LINEAR;
+   ctx->Texture.Unit[0]._Current = texObj;
+
+   for (;;) {
+      failed |= run_kernels(ctx, texObj);
+
+      /* again without AVX2, util_cpu_detect() has run by now */
+      if (!util_cpu_caps.has_avx2)
+         break;
+      util_cpu_caps.has_avx2 = 0;
+   }
+
+   free(swImg);
+   free(texObj);
+   free(ctx);
+   return failed;
+}
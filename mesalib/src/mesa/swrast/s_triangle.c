@@ -144,7 +144,7 @@ _swrast_culltriangle( struct gl_context *ctx,
 
 #define RENDER_SPAN( span )						\
    GLuint i;								\
-   GLubyte (*rgba)[4] = swrast->SpanArrays->rgba8;			\
+   GLubyte (*rgba)[4] = span.array->rgba8;				\
    span.intTex[0] -= FIXED_HALF; /* off-by-one error? */		\
    span.intTex[1] -= FIXED_HALF;					\
    for (i = 0; i < span.end; i++) {					\
@@ -202,8 +202,8 @@ _swrast_culltriangle( struct gl_context *ctx,
 
 #define RENDER_SPAN( span )						\
    GLuint i;				    				\
-   GLubyte (*rgba)[4] = swrast->SpanArrays->rgba8;			\
-   GLubyte *mask = swrast->SpanArrays->mask;                            \
+   GLubyte (*rgba)[4] = span.array->rgba8;				\
+   GLubyte *mask = span.array->mask;                                    \
    span.intTex[0] -= FIXED_HALF; /* off-by-one error? */		\
    span.intTex[1] -= FIXED_HALF;					\
    for (i = 0; i < span.end; i++) {					\
@@ -410,8 +410,11 @@ affine_span(struct gl_context *ctx, SWspan *span,
    GLuint i;
    GLchan *dest = span->array->rgba[0];
 
-   /* Disable tex units so they're not re-applied in swrast_write_rgba_span */
-   ctx->Texture._EnabledCoordUnits = 0x0;
+   /* Disable tex units so they're not re-applied in swrast_write_rgba_span.
+    * Band threads find them disabled already, see _swrast_flush_bins().
+    */
+   if (texEnableSave)
+      ctx->Texture._EnabledCoordUnits = 0x0;
 
    span->intTex[0] -= FIXED_HALF;
    span->intTex[1] -= FIXED_HALF;
@@ -518,7 +521,8 @@ affine_span(struct gl_context *ctx, SWspan *span,
    _swrast_write_rgba_span(ctx, span);
 
    /* re-enable texture units */
-   ctx->Texture._EnabledCoordUnits = texEnableSave;
+   if (texEnableSave)
+      ctx->Texture._EnabledCoordUnits = texEnableSave;
 
 #undef SPAN_NEAREST
 #undef SPAN_LINEAR
@@ -676,8 +680,10 @@ fast_persp_span(struct gl_context *ctx, SWspan *span,
    GLfloat tex_coord[3], tex_step[3];
    GLchan *dest = span->array->rgba[0];
 
+   /* as in affine_span() */
    const GLuint texEnableSave = ctx->Texture._EnabledCoordUnits;
-   ctx->Texture._EnabledCoordUnits = 0;
+   if (texEnableSave)
+      ctx->Texture._EnabledCoordUnits = 0;
 
    tex_coord[0] = span->attrStart[VARYING_SLOT_TEX0][0]  * (info->smask + 1);
    tex_step[0] = span->attrStepX[VARYING_SLOT_TEX0][0] * (info->smask + 1);
@@ -790,7 +796,8 @@ fast_persp_span(struct gl_context *ctx, SWspan *span,
 #undef SPAN_LINEAR
 
    /* restore state */
-   ctx->Texture._EnabledCoordUnits = texEnableSave;
+   if (texEnableSave)
+      ctx->Texture._EnabledCoordUnits = texEnableSave;
 }
 
 
@@ -1003,6 +1010,8 @@ _swrast_choose_triangle( struct gl_context *ctx )
 {
    SWcontext *swrast = SWRAST_CONTEXT(ctx);
 
+   swrast->_TriangleTextures = GL_FALSE;
+
    if (ctx->Polygon.CullFlag &&
        ctx->Polygon.CullFaceMode == GL_FRONT_AND_BACK) {
       USE(nodraw_triangle);
@@ -1116,6 +1125,7 @@ _swrast_choose_triangle( struct gl_context *ctx )
                   }
                   else {
                      USE(affine_textured_triangle);
+                     swrast->_TriangleTextures = GL_TRUE;
                  }
 #endif
 	       }
@@ -1125,6 +1135,7 @@ _swrast_choose_triangle( struct gl_context *ctx )
                USE(general_triangle);
 #else
                USE(persp_textured_triangle);
+               swrast->_TriangleTextures = GL_TRUE;
 #endif
 	    }
 	 }
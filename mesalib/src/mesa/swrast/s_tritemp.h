@@ -143,6 +143,10 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
    GLfloat bf = SWRAST_CONTEXT(ctx)->_BackfaceSign;
    const GLint snapMask = ~((FIXED_ONE / (1 << SUB_PIXEL_BITS)) - 1); /* for x/y coord snapping */
    GLfixed vMin_fx, vMin_fy, vMid_fx, vMid_fy, vMax_fx, vMax_fy;
+   /* rows we may write; a band thread only owns some, see s_bin.c */
+   const struct swrast_band_thread *band = _swrast_band_thread();
+   const GLint bandY0 = band ? band->y0 : 0;
+   const GLint bandY1 = band ? band->y1 : SWRAST_MAX_WIDTH;
 
    SWspan span;
 
@@ -769,7 +773,8 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
             ATTRIB_LOOP_END
 #endif
 
-            while (lines > 0) {
+            /* rows only go up, so stop at the end of the band */
+            while (lines > 0 && span.y < bandY1) {
                /* initialize the span interpolants to the leftmost value */
                /* ff = fixed-pt fragment */
                const GLint right = FixedToInt(fxRightEdge);
@@ -808,8 +813,9 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
                /* This is where we actually generate fragments */
                /* XXX the test for span.y > 0 _shouldn't_ be needed but
                 * it fixes a problem on 64-bit Opterons (bug 4842).
+                * Rows below the band are stepped over without drawing.
                 */
-               if (span.end > 0 && span.y >= 0) {
+               if (span.end > 0 && span.y >= bandY0) {
                   const GLint len = span.end - 1;
                   (void) len;
 #ifdef INTERP_RGB
@@ -37,6 +37,8 @@
 #include "main/samplerobj.h"
 #include "main/state.h"
 #include "math/m_xform.h"
+#include "program/prog_batch.h"
+#include "program/prog_cache.h"
 #include "program/prog_instruction.h"
 #include "program/prog_statevars.h"
 #include "program/prog_execute.h"
@@ -73,6 +75,10 @@ struct vp_stage_data {
    GLboolean vertex_textures;
 
    struct gl_program_machine machine;
+
+   /** Decoded vertex programs and the registers to run them */
+   struct gl_program_cache *batches;
+   struct gl_program_batch_machine *batch_machine;
 };
 
 
@@ -215,8 +221,8 @@ GLboolean
 _tnl_program_string(struct gl_context *ctx, GLenum target, struct gl_program *program)
 {
    /* No-op.
-    * If we had derived anything from the program that was private to this
-    * stage we'd recompute/validate it here.
+    * The programs decoded by run_vp_batches() are cached by their
+    * instructions, so a new string simply misses the cache.
     */
    return GL_TRUE;
 }
@@ -285,6 +291,139 @@ unmap_textures(struct gl_context *ctx, const struct gl_program *vp)
 }
 
 
+/**
+ * Sample texels for run_vp_batches(), the same way as vp_fetch_texel().
+ */
+static void
+vp_sample_texels(struct gl_context *ctx, void *data,
+                 GLuint texSrcUnit, GLint derivAttr,
+                 GLuint n, const GLfloat texcoords[][4],
+                 const GLfloat lodBias[], GLfloat rgba[][4])
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLuint unit = ctx->VertexProgram._Current->SamplerUnits[texSrcUnit];
+
+   swrast->TextureSample[unit](ctx, _mesa_get_samplerobj(ctx, unit),
+                               ctx->Texture.Unit[unit]._Current,
+                               n, texcoords, lodBias, rgba);
+}
+
+
+/**
+ * Load the input register for vertex attribute 'attr' of 'n' vertices
+ * from 'start' on, with the values the interpreter would see.
+ */
+static void
+load_vp_input(struct gl_context *ctx, const struct gl_program *program,
+              GLuint attr, GLuint start, GLuint n, prog_batch_row *input)
+{
+   static const GLfloat zero[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   GLuint i, k;
+
+   if (program->info.inputs_read & BITFIELD64_BIT(attr)) {
+      const GLubyte *ptr = (const GLubyte*) VB->AttribPtr[attr]->data;
+      const GLuint size = VB->AttribPtr[attr]->size;
+      const GLuint stride = VB->AttribPtr[attr]->stride;
+
+      /* as COPY_CLEAN_4V() */
+      for (i = 0; i < n; i++) {
+         const GLfloat *data = (GLfloat *) (ptr + stride * (start + i));
+         for (k = 0; k < size; k++)
+            input[k][i] = data[k];
+         for (; k < 4; k++)
+            input[k][i] = k == 3 ? 1.0F : 0.0F;
+      }
+   }
+   else {
+      /* as init_machine() */
+      const GLfloat *value = attr < MAX_VERTEX_GENERIC_ATTRIBS ?
+         ctx->Current.Attrib[attr] : zero;
+      for (i = 0; i < n; i++) {
+         for (k = 0; k < 4; k++)
+            input[k][i] = value[k];
+      }
+   }
+
+   for (; i < PROG_BATCH_LANES; i++) {
+      for (k = 0; k < 4; k++)
+         input[k][i] = 0.0F;
+   }
+}
+
+
+/**
+ * Run the vertex program on PROG_BATCH_LANES vertices at a time, see
+ * prog_batch.c.
+ * \return  the number of vertices done: all of them, or none if the
+ *          program has to be interpreted
+ */
+static GLuint
+run_vp_batches(struct gl_context *ctx, struct vp_stage_data *store,
+               const struct gl_program *program)
+{
+   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   const GLbitfield64 outputsWritten = program->info.outputs_written;
+   const struct gl_program_batch *batch;
+   struct gl_program_batch_machine *machine;
+   GLuint base;
+
+   if (!store->batches)
+      return 0;
+   batch = _mesa_get_program_batch(store->batches, program);
+   if (!batch)
+      return 0;
+
+   if (!store->batch_machine) {
+      store->batch_machine = malloc(sizeof(*store->batch_machine));
+      if (!store->batch_machine)
+         return 0;
+   }
+   machine = store->batch_machine;
+
+   _mesa_clear_program_batch(batch, machine);
+   machine->Sample = vp_sample_texels;
+   machine->SampleData = NULL;
+
+   for (base = 0; base < VB->Count; base += PROG_BATCH_LANES) {
+      const GLuint n = MIN2(VB->Count - base, PROG_BATCH_LANES);
+      GLuint i, j, k;
+
+      for (j = 0; j < batch->NumInputs; j++)
+         load_vp_input(ctx, program, batch->Inputs[j], base, n,
+                       machine->Inputs[j]);
+
+      _mesa_execute_program_batch(ctx, program, batch, machine,
+                                  (1 << n) - 1);
+
+      /* copy the output registers into the VB->attribs arrays */
+      for (j = 0; j < batch->NumOutputs; j++) {
+         const GLuint attr = batch->Outputs[j];
+         GLfloat (*data)[4] = store->results[attr].data + base;
+
+         if (!(outputsWritten & BITFIELD64_BIT(attr)))
+            continue;
+         for (i = 0; i < n; i++) {
+            for (k = 0; k < 4; k++)
+               data[i][k] = machine->Outputs[j][k][i];
+         }
+      }
+
+      /* FOGC is a special case.  Fragment shader expects (f,0,0,1) */
+      if (outputsWritten & BITFIELD64_BIT(VARYING_SLOT_FOGC)) {
+         GLfloat (*fog)[4] = store->results[VARYING_SLOT_FOGC].data + base;
+         for (i = 0; i < n; i++) {
+            fog[i][1] = 0.0;
+            fog[i][2] = 0.0;
+            fog[i][3] = 1.0;
+         }
+      }
+   }
+
+   return VB->Count;
+}
+
+
 /**
  * This function executes vertex programs
  */
@@ -326,7 +465,7 @@ run_vp( struct gl_context *ctx, struct tnl_pipeline_stage *stage )
 
    map_textures(ctx, program);
 
-   for (i = 0; i < VB->Count; i++) {
+   for (i = run_vp_batches(ctx, store, program); i < VB->Count; i++) {
       GLuint attr;
 
       init_machine(ctx, machine, tnl->CurInstance);
@@ -483,6 +622,9 @@ init_vp(struct gl_context *ctx, struct tnl_pipeline_stage *stage)
    _mesa_vector4f_alloc( &store->ndcCoords, 0, size, 32 );
    store->clipmask = _mesa_align_malloc(sizeof(GLubyte)*size, 32 );
 
+   /* without it every vertex program is interpreted */
+   store->batches = _mesa_new_program_cache();
+
    return GL_TRUE;
 }
 
@@ -506,6 +648,10 @@ dtr(struct tnl_pipeline_stage *stage)
       _mesa_vector4f_free( &store->ndcCoords );
       _mesa_align_free( store->clipmask );
 
+      if (store->batches)
+         _mesa_delete_batch_cache( store->batches );
+      free( store->batch_machine );
+
       free( store );
       stage->privatePtr = NULL;
    }
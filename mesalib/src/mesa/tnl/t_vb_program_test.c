@@ -0,0 +1,444 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file t_vb_program_test.c
+ * Run a vertex program through the vertex program stage, where
+ * run_vp_batches() takes it, and a copy of it that has to be interpreted
+ * one vertex at a time, and check that the vertices come out the same.
+ * The program samples real swrast textures with TEX, TXB and TXL and
+ * writes FOGC, so vp_sample_texels() and the FOGC fixup are covered.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c99_math.h"
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/extensions.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "main/teximage.h"
+#include "main/texobj.h"
+#include "drivers/common/driverfuncs.h"
+#include "math/m_vector.h"
+#include "program/prog_batch.h"
+#include "program/prog_instruction.h"
+#include "program/prog_parameter.h"
+#include "swrast/swrast.h"
+#include "swrast/s_context.h"
+#include "tnl/tnl.h"
+#include "tnl/t_context.h"
+#include "tnl/t_pipeline.h"
+#include "util/u_cpu_detect.h"
+#include "vbo/vbo.h"
+
+/** Not a multiple of PROG_BATCH_LANES, so the last batch is partial */
+#define NUM_VERTICES 37
+#define ROUNDS 16
+
+struct test_inst
+{
+   enum prog_opcode opcode;
+   gl_register_file dstFile;
+   GLuint dstIndex;
+   GLuint writeMask;
+   GLuint texSrcUnit;
+   gl_register_file srcFile[2];
+   GLuint srcIndex[2];
+   GLuint srcSwizzle[2];
+};
+
+#define OP(opcode, output, mask, file0, index0, file1, index1) \
+   { opcode, PROGRAM_OUTPUT, output, mask, 0, { file0, file1 }, \
+     { index0, index1 }, { SWIZZLE_NOOP, SWIZZLE_NOOP } }
+#define OP_TEX(opcode, temp, unit, attr) \
+   { opcode, PROGRAM_TEMPORARY, temp, WRITEMASK_XYZW, unit, \
+     { PROGRAM_INPUT }, { attr }, { SWIZZLE_NOOP } }
+
+/**
+ * The last instruction is a MOV, which the batches run, or the same move
+ * as a SWZ, which they don't.
+ */
+static const struct test_inst vertex_program[] = {
+   OP(OPCODE_DP4, VARYING_SLOT_POS, WRITEMASK_X,
+      PROGRAM_INPUT, VERT_ATTRIB_POS, PROGRAM_CONSTANT, 0),
+   OP(OPCODE_DP4, VARYING_SLOT_POS, WRITEMASK_Y,
+      PROGRAM_INPUT, VERT_ATTRIB_POS, PROGRAM_CONSTANT, 1),
+   OP(OPCODE_DP4, VARYING_SLOT_POS, WRITEMASK_Z,
+      PROGRAM_INPUT, VERT_ATTRIB_POS, PROGRAM_CONSTANT, 2),
+   OP(OPCODE_DP4, VARYING_SLOT_POS, WRITEMASK_W,
+      PROGRAM_INPUT, VERT_ATTRIB_POS, PROGRAM_CONSTANT, 3),
+   OP_TEX(OPCODE_TEX, 0, 0, VERT_ATTRIB_TEX0),
+   /* the bias is TEX0.w */
+   OP_TEX(OPCODE_TXB, 1, 1, VERT_ATTRIB_TEX0),
+   /* the lod is TEX1.w */
+   OP_TEX(OPCODE_TXL, 2, 0, VERT_ATTRIB_TEX1),
+   OP(OPCODE_ADD, VARYING_SLOT_COL0, WRITEMASK_XYZW,
+      PROGRAM_TEMPORARY, 0, PROGRAM_TEMPORARY, 1),
+   OP(OPCODE_MOV, VARYING_SLOT_TEX0, WRITEMASK_XYZW,
+      PROGRAM_TEMPORARY, 2, 0, 0),
+   { OPCODE_MUL, PROGRAM_OUTPUT, VARYING_SLOT_FOGC, WRITEMASK_X, 0,
+     { PROGRAM_INPUT, PROGRAM_CONSTANT }, { VERT_ATTRIB_COLOR0, 4 },
+     { SWIZZLE_YYYY, SWIZZLE_XXXX } },
+   OP(OPCODE_MOV, VARYING_SLOT_TEX1, WRITEMASK_XYZW,
+      PROGRAM_INPUT, VERT_ATTRIB_COLOR0, 0, 0),
+};
+
+static const GLfloat constants[][4] = {
+   {  0.5F, -1.0F,  2.0F,  0.0F },
+   {  1.0F,  0.25F, -0.75F, 3.0F },
+   { -2.0F,  0.0F,  1.5F,  -0.5F },
+   {  0.3F,  2.5F,  -1.0F,  1.0F },
+   {  4.0F, -3.0F,  0.125F, -8.0F },
+};
+
+/** The program's inputs, COL0 has three components */
+static const struct {
+   GLuint attr;
+   GLuint size;
+} inputs[] = {
+   { VERT_ATTRIB_POS, 4 },
+   { VERT_ATTRIB_COLOR0, 3 },
+   { VERT_ATTRIB_TEX0, 4 },
+   { VERT_ATTRIB_TEX1, 4 },
+};
+
+/** The outputs that are compared, in the order run_stage() copies them */
+static const char *const output_names[] = {
+   "POS", "COL0", "FOGC", "TEX0", "TEX1",
+};
+
+#define NUM_OUTPUTS ARRAY_SIZE(output_names)
+
+
+static GLuint
+rand_next(void)
+{
+   static GLuint seed = 1;
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+
+/** A value in [lo, hi] */
+static GLfloat
+rand_range(GLfloat lo, GLfloat hi)
+{
+   return lo + (hi - lo) * (GLfloat) (rand_next() % 4097) / 4096.0F;
+}
+
+
+/**
+ * Make a complete mipmapped RGBA8 texture with random texels.
+ */
+static struct gl_texture_object *
+create_texture(struct gl_context *ctx, GLuint name, GLuint width,
+               GLuint height, GLenum minFilter, GLenum wrap)
+{
+   struct gl_texture_object *texObj =
+      ctx->Driver.NewTextureObject(ctx, name, GL_TEXTURE_2D);
+   GLuint level, x, y;
+
+   if (!texObj)
+      return NULL;
+
+   for (level = 0; ; level++) {
+      struct gl_texture_image *img =
+         _mesa_get_tex_image(ctx, texObj, GL_TEXTURE_2D, level);
+      struct swrast_texture_image *swImg;
+
+      if (!img)
+         return NULL;
+      _mesa_init_teximage_fields(ctx, img, width, height, 1, 0, GL_RGBA8,
+                                 MESA_FORMAT_R8G8B8A8_UNORM);
+      if (!ctx->Driver.AllocTextureImageBuffer(ctx, img))
+         return NULL;
+
+      swImg = swrast_texture_image(img);
+      for (y = 0; y < height; y++) {
+         for (x = 0; x < width * 4; x++)
+            swImg->Buffer[y * swImg->RowStride + x] = (GLubyte) rand_next();
+      }
+
+      if (width == 1 && height == 1)
+         break;
+      width = MAX2(width / 2, 1);
+      height = MAX2(height / 2, 1);
+   }
+
+   texObj->Sampler.MinFilter = minFilter;
+   texObj->Sampler.MagFilter = GL_LINEAR;
+   texObj->Sampler.WrapS = wrap;
+   texObj->Sampler.WrapT = wrap;
+   _mesa_test_texobj_completeness(ctx, texObj);
+   if (!_mesa_is_texture_complete(texObj, &texObj->Sampler))
+      return NULL;
+
+   return texObj;
+}
+
+
+/**
+ * Build vertex_program[], with the last MOV as a SWZ if 'interpreted'.
+ */
+static struct gl_program *
+create_program(struct gl_context *ctx, bool interpreted)
+{
+   const GLuint n = ARRAY_SIZE(vertex_program);
+   struct gl_program *prog =
+      ctx->Driver.NewProgram(ctx, GL_VERTEX_PROGRAM_ARB, 0, true);
+   GLuint i, j;
+
+   if (!prog)
+      return NULL;
+
+   prog->arb.NumInstructions = n + 1;
+   prog->arb.Instructions = calloc(n + 1, sizeof(struct prog_instruction));
+   if (!prog->arb.Instructions)
+      return NULL;
+   _mesa_init_instructions(prog->arb.Instructions, n + 1);
+
+   for (i = 0; i < n; i++) {
+      struct prog_instruction *inst = &prog->arb.Instructions[i];
+
+      inst->Opcode = vertex_program[i].opcode;
+      inst->TexSrcUnit = vertex_program[i].texSrcUnit;
+      inst->TexSrcTarget = TEXTURE_2D_INDEX;
+      inst->DstReg.File = vertex_program[i].dstFile;
+      inst->DstReg.Index = vertex_program[i].dstIndex;
+      inst->DstReg.WriteMask = vertex_program[i].writeMask;
+      for (j = 0; j < _mesa_num_inst_src_regs(inst->Opcode); j++) {
+         inst->SrcReg[j].File = vertex_program[i].srcFile[j];
+         inst->SrcReg[j].Index = vertex_program[i].srcIndex[j];
+         inst->SrcReg[j].Swizzle = vertex_program[i].srcSwizzle[j];
+      }
+
+      if (vertex_program[i].dstFile == PROGRAM_OUTPUT)
+         prog->info.outputs_written |=
+            BITFIELD64_BIT(vertex_program[i].dstIndex);
+   }
+   prog->arb.Instructions[n].Opcode = OPCODE_END;
+   if (interpreted)
+      prog->arb.Instructions[n - 1].Opcode = OPCODE_SWZ;
+
+   for (i = 0; i < ARRAY_SIZE(inputs); i++)
+      prog->info.inputs_read |= BITFIELD64_BIT(inputs[i].attr);
+
+   /* the program's sampler 0 is unit 1 and sampler 1 is unit 0 */
+   prog->SamplerUnits[0] = 1;
+   prog->SamplerUnits[1] = 0;
+   prog->TexturesUsed[0] = TEXTURE_2D_BIT;
+   prog->TexturesUsed[1] = TEXTURE_2D_BIT;
+
+   prog->Parameters = _mesa_new_parameter_list();
+   for (i = 0; i < ARRAY_SIZE(constants); i++)
+      _mesa_add_parameter(prog->Parameters, PROGRAM_CONSTANT, NULL, 4,
+                          GL_NONE, (const gl_constant_value *) constants[i],
+                          NULL, true);
+
+   return prog;
+}
+
+
+/**
+ * Run 'prog' through 'stage' and copy the outputs the next stages would
+ * see into 'results'.
+ */
+static void
+run_stage(struct gl_context *ctx, struct tnl_pipeline_stage *stage,
+          struct gl_program *prog, GLvector4f *input_vectors,
+          GLfloat results[NUM_OUTPUTS][NUM_VERTICES][4])
+{
+   struct vertex_buffer *VB = &TNL_CONTEXT(ctx)->vb;
+   const GLvector4f *outputs[NUM_OUTPUTS];
+   GLuint i, j;
+
+   /* run_vp() points these at its results */
+   for (i = 0; i < ARRAY_SIZE(inputs); i++)
+      VB->AttribPtr[inputs[i].attr] = &input_vectors[i];
+   VB->Count = NUM_VERTICES;
+
+   ctx->VertexProgram._Current = prog;
+   stage->validate(ctx, stage);
+   stage->run(ctx, stage);
+
+   outputs[0] = VB->ClipPtr;
+   outputs[1] = VB->AttribPtr[VERT_ATTRIB_COLOR0];
+   outputs[2] = VB->AttribPtr[VERT_ATTRIB_FOG];
+   outputs[3] = VB->AttribPtr[_TNL_ATTRIB_TEX0];
+   outputs[4] = VB->AttribPtr[_TNL_ATTRIB_TEX1];
+   for (i = 0; i < NUM_OUTPUTS; i++) {
+      for (j = 0; j < NUM_VERTICES; j++)
+         COPY_4V(results[i][j], outputs[i]->data[j]);
+   }
+}
+
+
+static bool
+same_value(GLfloat a, GLfloat b)
+{
+   return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+
+/**
+ * Run both programs on random vertices.
+ * \return  true if they differ
+ */
+static bool
+run_round(struct gl_context *ctx, struct tnl_pipeline_stage *stage,
+          struct gl_program *batched, struct gl_program *interpreted,
+          GLuint round)
+{
+   static GLfloat data[ARRAY_SIZE(inputs)][NUM_VERTICES][4];
+   static GLfloat expected[NUM_OUTPUTS][NUM_VERTICES][4];
+   static GLfloat results[NUM_OUTPUTS][NUM_VERTICES][4];
+   GLvector4f input_vectors[ARRAY_SIZE(inputs)];
+   bool failed = false;
+   GLuint i, j, k;
+
+   for (i = 0; i < ARRAY_SIZE(inputs); i++) {
+      for (j = 0; j < NUM_VERTICES; j++) {
+         for (k = 0; k < 4; k++)
+            data[i][j][k] = rand_range(-4.0F, 4.0F);
+      }
+      _mesa_vector4f_init(&input_vectors[i], 0, data[i]);
+      input_vectors[i].size = inputs[i].size;
+      input_vectors[i].count = NUM_VERTICES;
+   }
+
+   /* texcoords around [0, 1] and a bias or lod from below the base
+    * level to past the last one
+    */
+   for (j = 0; j < NUM_VERTICES; j++) {
+      for (i = 2; i < 4; i++) {
+         data[i][j][0] = rand_range(-0.5F, 1.5F);
+         data[i][j][1] = rand_range(-0.5F, 1.5F);
+         data[i][j][3] = rand_range(-1.0F, 5.0F);
+      }
+   }
+
+   run_stage(ctx, stage, interpreted, input_vectors, expected);
+   run_stage(ctx, stage, batched, input_vectors, results);
+
+   for (i = 0; i < NUM_OUTPUTS; i++) {
+      for (j = 0; j < NUM_VERTICES; j++) {
+         for (k = 0; k < 4; k++) {
+            if (!same_value(expected[i][j][k], results[i][j][k])) {
+               fprintf(stderr, "round %u vertex %u: %s.%c expected %g (%a) "
+                               "but got %g (%a)\n",
+                       round, j, output_names[i], "xyzw"[k],
+                       expected[i][j][k], expected[i][j][k],
+                       results[i][j][k], results[i][j][k]);
+               failed = true;
+            }
+         }
+      }
+   }
+
+   /* the fragment stages expect (f, 0, 0, 1) */
+   for (j = 0; j < NUM_VERTICES; j++) {
+      if (results[2][j][1] != 0.0F || results[2][j][2] != 0.0F ||
+          results[2][j][3] != 1.0F) {
+         fprintf(stderr, "round %u vertex %u: FOGC is (%g, %g, %g, %g)\n",
+                 round, j, results[2][j][0], results[2][j][1],
+                 results[2][j][2], results[2][j][3]);
+         failed = true;
+      }
+   }
+
+   return failed;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+   struct gl_context *ctx = calloc(1, sizeof(*ctx));
+   struct dd_function_table functions;
+   struct tnl_pipeline_stage stage = _tnl_vertex_program_stage;
+   struct gl_texture_object *texObj[2];
+   struct gl_program *batched, *interpreted;
+   struct gl_program_batch *batch;
+   bool failed = false;
+   GLuint i, u;
+
+   if (!ctx)
+      return 1;
+
+   _mesa_init_driver_functions(&functions);
+   if (!_mesa_initialize_context(ctx, API_OPENGL_COMPAT, NULL, NULL,
+                                 &functions))
+      return 1;
+   _mesa_enable_sw_extensions(ctx);
+   if (!_swrast_CreateContext(ctx) || !_vbo_CreateContext(ctx) ||
+       !_tnl_CreateContext(ctx))
+      return 1;
+   if (!stage.create(ctx, &stage))
+      return 1;
+
+   texObj[0] = create_texture(ctx, 1, 16, 8, GL_LINEAR_MIPMAP_LINEAR,
+                              GL_REPEAT);
+   texObj[1] = create_texture(ctx, 2, 8, 8, GL_NEAREST_MIPMAP_LINEAR,
+                              GL_CLAMP_TO_EDGE);
+   for (u = 0; u < 2; u++) {
+      if (!texObj[u])
+         return 1;
+      _mesa_reference_texobj(&ctx->Texture.Unit[u]._Current, texObj[u]);
+   }
+
+   batched = create_program(ctx, false);
+   interpreted = create_program(ctx, true);
+   if (!batched || !interpreted)
+      return 1;
+
+   /* otherwise both would run the same way */
+   batch = _mesa_new_program_batch(batched);
+   if (!batch) {
+      fprintf(stderr, "the program isn't batched\n");
+      return 1;
+   }
+   _mesa_delete_program_batch(batch);
+   batch = _mesa_new_program_batch(interpreted);
+   if (batch) {
+      fprintf(stderr, "the SWZ program is batched\n");
+      return 1;
+   }
+
+   for (;;) {
+      for (i = 0; i < ROUNDS; i++)
+         failed |= run_round(ctx, &stage, batched, interpreted, i);
+
+      /* again without AVX, util_cpu_detect() has run by now */
+      if (!util_cpu_caps.has_avx)
+         break;
+      util_cpu_caps.has_avx = 0;
+   }
+
+   stage.destroy(&stage);
+   return failed;
+}
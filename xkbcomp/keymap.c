@@ -84,7 +84,9 @@ CompileKeymap(XkbFile * file, XkbFileInfo * result, unsigned merge)
     /* Check for duplicate entries in the input file */
     while ((file) && (ok))
     {
-        file->topName = mainName;
+        if (file->topName)
+            uFree(file->topName);
+        file->topName = uStringDup(mainName);
         if ((have & (1 << file->type)) != 0)
         {
             ERROR2("More than one %s section in a %s file\n",
@@ -36,6 +36,9 @@
 
 /***====================================================================***/
 
+/* The include file being parsed, for CloseIncludeFile. */
+static FILE *includeFile;
+
 /**
  * Open the file given in the include statement and parse it's content.
  * If the statement defines a specific map to use, this map is returned in
@@ -77,14 +80,17 @@ ProcessIncludeFile(IncludeStmt * stmt,
         if (debugFlags & 2)
             INFO1("About to parse include file %s\n", stmt->file);
         /* parse the file */
+        includeFile = file;
         if ((XKBParseFile(file, &rtrn) == 0) || (rtrn == NULL))
         {
             setScanState(oldFile, oldLine);
             ERROR1("Error interpreting include file \"%s\"\n", stmt->file);
             ACTION("Exiting\n");
+            includeFile = NULL;
             fclose(file);
             return False;
         }
+        includeFile = NULL;
         fclose(file);
         XkbAddFileToCache(stmt->file, file_type, stmt->path, rtrn);
     }
@@ -149,6 +155,20 @@ ProcessIncludeFile(IncludeStmt * stmt,
     return True;
 }
 
+/**
+ * Close the include file ProcessIncludeFile was parsing when a fatal
+ * error longjmp'ed out of it, if any.
+ */
+void
+CloseIncludeFile(void)
+{
+    if (includeFile)
+    {
+        fclose(includeFile);
+        includeFile = NULL;
+    }
+}
+
 /***====================================================================***/
 
 int
@@ -92,6 +92,8 @@ extern Bool ProcessIncludeFile(IncludeStmt * /* stmt */ ,
                                unsigned *       /* merge_rtrn */
     );
 
+extern void CloseIncludeFile(void);
+
 extern Status ComputeKbdDefaults(XkbDescPtr     /* xkb */
     );
 
@@ -815,6 +815,22 @@ XKBParseFile(FILE * file, XkbFile ** pRtrn)
     return 1;
 }
 
+int
+XKBParseString(const char *str, size_t len, XkbFile ** pRtrn)
+{
+    scan_set_string(str, len);
+    rtrnValue = NULL;
+    if (yyparse() == 0)
+    {
+        *pRtrn = rtrnValue;
+        CheckDefaultMap(rtrnValue);
+        rtrnValue = NULL;
+        return 1;
+    }
+    *pRtrn = NULL;
+    return 0;
+}
+
 XkbFile *
 CreateXKBFile(int type, char *name, ParseCommon * defs, unsigned flags)
 {
@@ -837,6 +853,184 @@ CreateXKBFile(int type, char *name, ParseCommon * defs, unsigned flags)
     return file;
 }
 
+static void
+FreeInclude(IncludeStmt * incl)
+{
+    IncludeStmt *next;
+
+    while (incl)
+    {
+        next = incl->next;
+        if (incl->stmt)
+            uFree(incl->stmt);
+        if (incl->file)
+            uFree(incl->file);
+        if (incl->map)
+            uFree(incl->map);
+        if (incl->modifier)
+            uFree(incl->modifier);
+        if (incl->path)
+            uFree(incl->path);
+        uFree(incl);
+        incl = next;
+    }
+}
+
+static void FreeStmt(ParseCommon * stmt);
+
+static void
+FreeExpr(ExprDef * expr)
+{
+    int i;
+
+    switch (expr->op)
+    {
+    case ExprActionDecl:
+        FreeStmt((ParseCommon *) expr->value.action.args);
+        break;
+    case ExprArrayRef:
+        FreeStmt((ParseCommon *) expr->value.array.entry);
+        break;
+    case ExprKeysymList:
+        for (i = 0; i < expr->value.list.nSyms; i++)
+        {
+            if (expr->value.list.syms[i])
+                uFree(expr->value.list.syms[i]);
+        }
+        if (expr->value.list.syms)
+            uFree(expr->value.list.syms);
+        break;
+    case ExprActionList:
+    case OpNot:
+    case OpNegate:
+    case OpInvert:
+    case OpUnaryPlus:
+        FreeStmt((ParseCommon *) expr->value.child);
+        break;
+    case OpAdd:
+    case OpSubtract:
+    case OpMultiply:
+    case OpDivide:
+    case OpAssign:
+        FreeStmt((ParseCommon *) expr->value.binary.left);
+        FreeStmt((ParseCommon *) expr->value.binary.right);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Free a list of statements and everything they refer to.
+ */
+static void
+FreeStmt(ParseCommon * stmt)
+{
+    ParseCommon *next;
+
+    for (; stmt != NULL; stmt = next)
+    {
+        next = stmt->next;
+        switch (stmt->stmtType)
+        {
+        case StmtInclude:
+            /* the rest of the include comes along in its next list */
+            FreeInclude((IncludeStmt *) stmt);
+            continue;
+        case StmtExpr:
+            FreeExpr((ExprDef *) stmt);
+            break;
+        case StmtVarDef:
+            FreeStmt((ParseCommon *) ((VarDef *) stmt)->name);
+            FreeStmt((ParseCommon *) ((VarDef *) stmt)->value);
+            break;
+        case StmtKeycodeDef:
+            FreeStmt((ParseCommon *) ((KeycodeDef *) stmt)->value);
+            break;
+        case StmtKeyTypeDef:
+            FreeStmt((ParseCommon *) ((KeyTypeDef *) stmt)->body);
+            break;
+        case StmtInterpDef:
+            FreeStmt((ParseCommon *) ((InterpDef *) stmt)->match);
+            FreeStmt((ParseCommon *) ((InterpDef *) stmt)->def);
+            break;
+        case StmtVModDef:
+            FreeStmt((ParseCommon *) ((VModDef *) stmt)->value);
+            break;
+        case StmtSymbolsDef:
+            FreeStmt((ParseCommon *) ((SymbolsDef *) stmt)->symbols);
+            break;
+        case StmtModMapDef:
+            FreeStmt((ParseCommon *) ((ModMapDef *) stmt)->keys);
+            break;
+        case StmtGroupCompatDef:
+            FreeStmt((ParseCommon *) ((GroupCompatDef *) stmt)->def);
+            break;
+        case StmtIndicatorMapDef:
+        case StmtDoodadDef:
+            FreeStmt((ParseCommon *) ((DoodadDef *) stmt)->body);
+            break;
+        case StmtIndicatorNameDef:
+            FreeStmt((ParseCommon *) ((IndicatorNameDef *) stmt)->name);
+            break;
+        case StmtOutlineDef:
+            FreeStmt((ParseCommon *) ((OutlineDef *) stmt)->points);
+            break;
+        case StmtShapeDef:
+            FreeStmt((ParseCommon *) ((ShapeDef *) stmt)->outlines);
+            break;
+        case StmtKeyDef:
+            if (((KeyDef *) stmt)->name)
+                uFree(((KeyDef *) stmt)->name);
+            FreeStmt((ParseCommon *) ((KeyDef *) stmt)->expr);
+            break;
+        case StmtRowDef:
+            FreeStmt((ParseCommon *) ((RowDef *) stmt)->keys);
+            break;
+        case StmtSectionDef:
+            FreeStmt((ParseCommon *) ((SectionDef *) stmt)->rows);
+            break;
+        case StmtOverlayDef:
+            FreeStmt((ParseCommon *) ((OverlayDef *) stmt)->keys);
+            break;
+        default:
+            break;
+        }
+        uFree(stmt);
+    }
+}
+
+/**
+ * Free a list of parsed files, as returned by XKBParseFile or
+ * XKBParseString, with all their definitions.
+ */
+void
+FreeXKBFile(XkbFile * file)
+{
+    XkbFile *next;
+
+    for (; file != NULL; file = next)
+    {
+        next = (XkbFile *) file->common.next;
+        switch (file->type)
+        {
+        case XkmSemanticsFile:
+        case XkmLayoutFile:
+        case XkmKeymapFile:
+            FreeXKBFile((XkbFile *) file->defs);
+            break;
+        default:
+            FreeStmt(file->defs);
+            break;
+        }
+        if (file->topName)
+            uFree(file->topName);
+        if (file->name)
+            uFree(file->name);
+        uFree(file);
+    }
+}
+
 unsigned
 StmtSetMerge(ParseCommon * stmt, unsigned merge)
 {
@@ -185,12 +185,20 @@ extern int XKBParseFile(FILE * /* file */ ,
                         XkbFile **      /* pRtrn */
     );
 
+extern int XKBParseString(const char * /* str */ ,
+                          size_t /* len */ ,
+                          XkbFile **    /* pRtrn */
+    );
+
 extern XkbFile *CreateXKBFile(int /* type */ ,
                               char * /* name */ ,
                               ParseCommon * /* defs */ ,
                               unsigned  /* flags */
     );
 
+extern void FreeXKBFile(XkbFile * /* file */
+    );
+
 extern void yyerror(const char *        /* s */
     );
 
@@ -200,6 +208,8 @@ extern int yylex(void);
 extern int yyparse(void);
 extern void scan_set_file(FILE *file);
 
+extern void scan_set_string(const char *str, size_t len);
+
 extern int setScanState(char * /* file */ ,
                         int     /* line */
     );
@@ -149,6 +149,7 @@ static int outCount = 0;
 static char *preMsg = NULL;
 static char *postMsg = NULL;
 static char *prefix = NULL;
+static jmp_buf *fatalJump = NULL;
 
 Boolean
 uSetErrorFile(char *name)
@@ -250,9 +251,14 @@ uFatalError(const char *s, ...)
     va_start(args, s);
     vfprintf(errorFile, s, args);
     va_end(args);
+    outCount++;
+    if (fatalJump)
+    {
+        fflush(errorFile);
+        longjmp(*fatalJump, 1);
+    }
     fprintf(errorFile, "                  Exiting\n");
     fflush(errorFile);
-    outCount++;
     exit(1);
     /* NOTREACHED */
 }
@@ -298,11 +304,21 @@ uSetErrorPrefix(char *pre)
     return;
 }
 
+/* When compiling as a library, fatal errors return here instead of exiting. */
+void
+uSetFatalJump(jmp_buf *jump)
+{
+    fatalJump = jump;
+    return;
+}
+
 void
 uFinishUp(void)
 {
     if ((outCount > 0) && (postMsg != NULL))
         fprintf(errorFile, "%s\n", postMsg);
+    /* the library runs many compiles, each reports on its own */
+    outCount = 0;
     return;
 }
 
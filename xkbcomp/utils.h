@@ -30,6 +30,7 @@
 /***====================================================================***/
 
 #include 	<stdio.h>
+#include	<setjmp.h>
 #include	<X11/Xos.h>
 #include	<X11/Xfuncproto.h>
 #include	<X11/Xfuncs.h>
@@ -188,6 +189,9 @@ uInformation(const char * /* s */ , ...
      extern void uSetErrorPrefix(char * /* void */
     );
 
+     extern void uSetFatalJump(jmp_buf * /* jump */
+    );
+
      extern void uFinishUp(void);
 
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * The library entry points of xkbcomp.  They run the same steps as
+ * xkbcomp -xkm on a keymap, reading the source from memory and writing
+ * the result to memory.
+ *
+ * xkbcomp was written as a program and keeps its state in globals, so
+ * calls are not reentrant.  Everything a compile parses, the keymap and
+ * the include files it pulled in, is freed before it returns, and so is
+ * the include file being read if a fatal error jumps out of the parser.
+ */
+
+#include <stdlib.h>
+
+#define	DEBUG_VAR debugFlags
+#include "xkbcomp.h"
+#include "xkbpath.h"
+#include "parseutils.h"
+#include "misc.h"
+#include "xkbcomplib.h"
+
+unsigned int debugFlags;
+unsigned warningLevel = 5;
+unsigned optionalParts = 0;
+
+static Bool initialized = False;
+
+static XkbFile *
+FindMap(XkbFile *file)
+{
+    XkbFile *map;
+
+    for (map = file; map; map = (XkbFile *) map->common.next)
+    {
+        if (map->flags & XkbLC_Default)
+            return map;
+    }
+    return file;
+}
+
+static void
+FreeCachedFile(void *data)
+{
+    FreeXKBFile((XkbFile *) data);
+}
+
+/* Free what a compile left behind, whether it finished or not. */
+static void
+FinishCompile(XkbFileInfo *result, XkbFile *file)
+{
+    uSetFatalJump(NULL);
+    CloseIncludeFile();
+    if (result->xkb)
+        XkbFreeKeyboard(result->xkb, XkbAllComponentsMask, True);
+    FreeXKBFile(file);
+    XkbClearFileCache(FreeCachedFile);
+    rtrnValue = NULL;
+    uFinishUp();
+}
+
+int
+xkbcomp_compile(const char *src, size_t len, const char *root,
+                int warning_level, char **xkm_rtrn, size_t *xkm_len_rtrn)
+{
+    /* static, so they are still intact when a fatal error longjmps back */
+    static XkbFileInfo result;
+    static XkbFile *rtrn;
+    XkbFile *map;
+    jmp_buf fatal;
+    int ok;
+
+    *xkm_rtrn = NULL;
+    *xkm_len_rtrn = 0;
+
+    if (!initialized)
+    {
+        uSetDebugFile(NullString);
+        uSetErrorFile(NullString);
+        if (!XkbInitIncludePath())
+            return 0;
+        XkbInitAtoms(NULL);
+        initialized = True;
+    }
+    warningLevel = warning_level;
+    uSetPreErrorMessage("The XKEYBOARD keymap compiler (xkbcomp) reports:");
+    uSetErrorPrefix("> ");
+    uSetPostErrorMessage("Errors from xkbcomp are not fatal to the X server");
+
+    XkbClearIncludePath();
+    if ((root && !XkbAddDirectoryToPath(root)) ||
+        !XkbAddDirectoryToPath(DFLT_XKB_CONFIG_ROOT))
+        return 0;
+
+    bzero((char *) &result, sizeof(result));
+    rtrn = NULL;
+    if (setjmp(fatal))
+    {
+        FinishCompile(&result, rtrn);
+        return 0;
+    }
+    uSetFatalJump(&fatal);
+
+    setScanState("server", 1);
+    ok = XKBParseString(src, len, &rtrn) && rtrn != NULL;
+    if (ok)
+    {
+        map = FindMap(rtrn);
+        result.type = map->type;
+        switch (map->type)
+        {
+        case XkmSemanticsFile:
+        case XkmLayoutFile:
+        case XkmKeymapFile:
+            if ((result.xkb = XkbAllocKeyboard()) == NULL)
+            {
+                WSGO("Cannot allocate keyboard description\n");
+                ok = False;
+                break;
+            }
+            ok = CompileKeymap(map, &result, MergeReplace);
+            break;
+        default:
+            /* anything but a keymap is left to xkbcomp itself */
+            ok = False;
+            break;
+        }
+    }
+    if (ok)
+    {
+        result.xkb->device_spec = XkbUseCoreKbd;
+        ok = XkbWriteXKMBuffer(&result, xkm_rtrn, xkm_len_rtrn);
+        if (!ok)
+            ERROR2("%s in %s\n", _XkbErrMessages[_XkbErrCode],
+                   _XkbErrLocation ? _XkbErrLocation : "unknown");
+    }
+
+    FinishCompile(&result, rtrn);
+    return ok;
+}
+
+void
+xkbcomp_free(void *data)
+{
+    free(data);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef XKBCOMPLIB_H
+#define XKBCOMPLIB_H 1
+
+#include <stddef.h>
+
+/*
+ * xkbcomp as a loadable module.  The X server compiles keymaps with it
+ * in process instead of running xkbcomp; only source text and compiled
+ * XKM bytes cross the interface, as the server's own XKB structures and
+ * functions share names with the client-side ones xkbcomp is built on.
+ */
+
+#define XKBCOMP_LIB_NAME "libxkbcomp"
+
+/*
+ * Compile the keymap in src.  root is the XKB data directory, or NULL
+ * for the built-in default.  On success, returns 1 and a buffer holding
+ * the XKM file, to be released with xkbcomp_free.
+ */
+typedef int (*xkbcomp_compile_proc)(const char *src, size_t len,
+                                    const char *root, int warning_level,
+                                    char **xkm_rtrn, size_t *xkm_len_rtrn);
+typedef void (*xkbcomp_free_proc)(void *data);
+
+extern int xkbcomp_compile(const char *src, size_t len, const char *root,
+                           int warning_level,
+                           char **xkm_rtrn, size_t *xkm_len_rtrn);
+extern void xkbcomp_free(void *data);
+
+#endif /* XKBCOMPLIB_H */
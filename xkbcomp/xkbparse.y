@@ -378,9 +378,9 @@ InterpretDecl	:	INTERPRET InterpretMatch OBRACE
 		;
 
 InterpretMatch	:	KeySym PLUS Expr	
-			{ $$= InterpCreate($1, $3); }
+			{ $$= InterpCreate($1, $3); free($1); }
 		|	KeySym			
-			{ $$= InterpCreate($1, NULL); }
+			{ $$= InterpCreate($1, NULL); free($1); }
 		;
 
 VarDeclList	:	VarDeclList VarDecl
@@ -398,7 +398,7 @@ KeyTypeDecl	:	TYPE String OBRACE
 SymbolsDecl	:	KEY KeyName OBRACE
 			    SymbolsBody
 			CBRACE SEMI
-			{ $$= SymbolsCreate($2,(ExprDef *)$4); }
+			{ $$= SymbolsCreate($2,(ExprDef *)$4); free($2); }
 		;
 
 SymbolsBody	:	SymbolsBody COMMA SymbolsVarDecl
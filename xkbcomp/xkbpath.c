@@ -303,7 +303,8 @@ static FileCacheEntry *fileCache;
  * Add the file with the given name to the internal cache to avoid opening and
  * parsing the file multiple times. If a cache entry for the same name + type
  * is already present, the entry is overwritten and the data belonging to the
- * previous entry is returned.
+ * previous entry is returned.  The cache keeps its own copies of name and
+ * path.
  *
  * @parameter name The name of the file (e.g. evdev).
  * @parameter type Type of the file (XkbTypesIdx, ... or XkbSemanticsFile, ...)
@@ -323,7 +324,9 @@ XkbAddFileToCache(char *name, unsigned type, char *path, void *data)
         {
             void *old = entry->data;
             WSGO2("Replacing file cache entry (%s/%d)\n", name, type);
-            entry->path = path;
+            if (entry->path)
+                uFree(entry->path);
+            entry->path = uStringDup(path);
             entry->data = data;
             return old;
         }
@@ -331,9 +334,9 @@ XkbAddFileToCache(char *name, unsigned type, char *path, void *data)
     entry = uTypedAlloc(FileCacheEntry);
     if (entry != NULL)
     {
-        entry->name = name;
+        entry->name = uStringDup(name);
         entry->type = type;
-        entry->path = path;
+        entry->path = uStringDup(path);
         entry->data = data;
         entry->next = fileCache;
         fileCache = entry;
@@ -346,7 +349,7 @@ XkbAddFileToCache(char *name, unsigned type, char *path, void *data)
  *
  * @parameter name The name of the file (e.g. evdev).
  * @parameter type Type of the file (XkbTypesIdx, ... or XkbSemanticsFile, ...)
- * @parameter pathRtrn Set to the full path of the given entry.
+ * @parameter pathRtrn Set to a copy of the full path of the given entry.
  *
  * @return the data from the cache entry or NULL if no matching entry was found.
  */
@@ -359,13 +362,35 @@ XkbFindFileInCache(char *name, unsigned type, char **pathRtrn)
     {
         if ((type == entry->type) && (uStringEqual(name, entry->name)))
         {
-            *pathRtrn = entry->path;
+            *pathRtrn = uStringDup(entry->path);
             return entry->data;
         }
     }
     return NULL;
 }
 
+/**
+ * Remove all entries from the cache.
+ *
+ * @parameter freeData Called to free the data of each entry.
+ */
+void
+XkbClearFileCache(void (*freeData) (void *))
+{
+    FileCacheEntry *entry;
+
+    while ((entry = fileCache) != NULL)
+    {
+        fileCache = entry->next;
+        (*freeData) (entry->data);
+        if (entry->name)
+            uFree(entry->name);
+        if (entry->path)
+            uFree(entry->path);
+        uFree(entry);
+    }
+}
+
 /***====================================================================***/
 
 /**
@@ -55,6 +55,9 @@ extern void *XkbFindFileInCache(char * /* name */ ,
                                 char ** /* pathRtrn */
     );
 
+extern void XkbClearFileCache(void (*freeData) (void *)
+    );
+
 extern Bool XkbParseIncludeMap(char ** /* str_inout */ ,
                                char ** /* file_rtrn */ ,
                                char ** /* map_rtrn */ ,
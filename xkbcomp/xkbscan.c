@@ -39,6 +39,8 @@
 unsigned int scanDebug;
 
 static FILE *yyin;
+static const char *yyinString;
+static size_t yyinStringLen;
 
 static char scanFileBuf[1024] = {0};
 char *scanFile = scanFileBuf;
@@ -276,12 +278,33 @@ scan_set_file(FILE *file)
     readBufLen = 0;
     readBufPos = 0;
     yyin = file;
+    yyinString = NULL;
+}
+
+/* Scan text in memory instead; it must stay valid until parsed. */
+void
+scan_set_string(const char *str, size_t len)
+{
+    readBufLen = 0;
+    readBufPos = 0;
+    yyin = NULL;
+    yyinString = str;
+    yyinStringLen = len;
 }
 
 static int
 scanchar(void)
 {
-    if (readBufPos >= readBufLen) {
+    if (readBufPos >= readBufLen && yyin == NULL) {
+        readBufLen = yyinStringLen < BUFSIZE ? yyinStringLen : BUFSIZE;
+        readBufPos = 0;
+        if (!readBufLen)
+            return EOF;
+        memcpy(readBuf, yyinString, readBufLen);
+        yyinString += readBufLen;
+        yyinStringLen -= readBufLen;
+    }
+    else if (readBufPos >= readBufLen) {
         readBufLen = fread(readBuf, 1, BUFSIZE, yyin);
         readBufPos = 0;
         if (!readBufLen)
@@ -53,6 +53,7 @@ in this Software without prior written authorization from The Open Group.
 #include "extnsionst.h"
 #include "servermd.h"
 #include "shmint.h"
+#include "damage.h"
 #include "xace.h"
 #include <X11/extensions/shmproto.h>
 #include <X11/Xfuncproto.h>
@@ -146,6 +147,9 @@ static ShmFuncs fbFuncs = { fbShmCreatePixmap, NULL };
 	return BadAccess; \
 }
 
+/* all planes of the given depth, also for depth 32 */
+#define FullPlaneMask(depth) ((((Mask) 1 << ((depth) - 1)) << 1) - 1)
+
 #define VERIFY_SHMSIZE(shmdesc,offset,len,client) \
 { \
     if ((offset + len) > shmdesc->size) \
@@ -477,6 +481,52 @@ ProcShmDetach(ClientPtr client)
     return Success;
 }
 
+/*
+ * A shm pixmap made by fbShmCreatePixmap is a header over the segment
+ * itself.  Returns TRUE if pixel (x, y) of pDraw is stored at data, with
+ * rows stride bytes apart, in which case an image there is already in
+ * the pixmap and copying it would only move the bytes onto themselves.
+ */
+static Bool
+ShmIsAliased(DrawablePtr pDraw, ShmDescPtr shmdesc, int x, int y,
+             char *data, int stride)
+{
+    PixmapPtr pPixmap;
+    int bpp = BitsPerPixel(pDraw->depth);
+
+    if (pDraw->type != DRAWABLE_PIXMAP || (x * bpp) & 7)
+        return FALSE;
+    pPixmap = (PixmapPtr) pDraw;
+    if (dixLookupPrivate(&pPixmap->devPrivates, shmPixmapPrivateKey) !=
+        shmdesc || !pPixmap->devPrivate.ptr ||
+        pPixmap->drawable.bitsPerPixel != bpp || pPixmap->devKind != stride)
+        return FALSE;
+    return (char *) pPixmap->devPrivate.ptr + y * stride + x * bpp / 8 ==
+        data;
+}
+
+/*
+ * The client has already written the pixels of a put into an aliased
+ * pixmap; all that is left is to report them as drawn.
+ */
+static void
+ShmDamageAliased(DrawablePtr pDraw, GCPtr pGC, int x, int y, int w, int h)
+{
+    BoxRec box;
+    RegionRec region;
+
+    box.x1 = max(x, 0);
+    box.y1 = max(y, 0);
+    box.x2 = min(x + w, pDraw->width);
+    box.y2 = min(y + h, pDraw->height);
+    if (box.x1 >= box.x2 || box.y1 >= box.y2)
+        return;
+    RegionInit(&region, &box, 1);
+    RegionIntersect(&region, &region, pGC->pCompositeClip);
+    DamageDamageRegion(pDraw, &region);
+    RegionUninit(&region);
+}
+
 /*
  * If the given request doesn't exactly match PutImage's constraints,
  * wrap the image in a scratch pixmap header and let CopyArea sort it out.
@@ -591,7 +641,14 @@ ProcShmPutImage(ClientPtr client)
         return BadValue;
     }
 
-    if ((((stuff->format == ZPixmap) && (stuff->srcX == 0)) ||
+    if (stuff->format == ZPixmap &&
+        stuff->srcX == stuff->dstX && stuff->srcY == stuff->dstY &&
+        pGC->alu == GXcopy &&
+        ShmIsAliased(pDraw, shmdesc, 0, 0, shmdesc->addr + stuff->offset,
+                     length))
+        ShmDamageAliased(pDraw, pGC, stuff->dstX, stuff->dstY,
+                         stuff->srcWidth, stuff->srcHeight);
+    else if ((((stuff->format == ZPixmap) && (stuff->srcX == 0)) ||
          ((stuff->format != ZPixmap) &&
           (stuff->srcX < screenInfo.bitmapScanlinePad) &&
           ((stuff->format == XYBitmap) ||
@@ -700,6 +757,14 @@ ProcShmGetImage(ClientPtr client)
     if (length == 0) {
         /* nothing to do */
     }
+    else if (stuff->format == ZPixmap &&
+             (stuff->planeMask & FullPlaneMask(pDraw->depth)) ==
+             FullPlaneMask(pDraw->depth) &&
+             ShmIsAliased(pDraw, shmdesc, stuff->x, stuff->y,
+                          shmdesc->addr + stuff->offset,
+                          PixmapBytePad(stuff->width, pDraw->depth))) {
+        /* the image is already where the client asked for it */
+    }
     else if (stuff->format == ZPixmap) {
         (*pDraw->pScreen->GetImage) (pDraw, stuff->x, stuff->y,
                                      stuff->width, stuff->height,
@@ -1218,6 +1283,15 @@ shm_tmpfile(void)
     };
     int	fd;
 
+#ifdef HAVE_MEMFD_CREATE
+    /* anonymous, never on a disk, and can be sealed against truncation */
+    fd = memfd_create("xshm", MFD_CLOEXEC|MFD_ALLOW_SEALING);
+    if (fd >= 0) {
+        DebugF ("Using memfd\n");
+        return fd;
+    }
+#endif
+
 #ifdef O_TMPFILE
     for (int i = 0; i < ARRAY_SIZE(shmdirs); i++) {
         fd = open(shmdirs[i], O_TMPFILE|O_RDWR|O_CLOEXEC|O_EXCL, 0666);
@@ -1279,6 +1353,10 @@ ProcShmCreateSegment(ClientPtr client)
         close(fd);
         return BadAlloc;
     }
+#ifdef F_ADD_SEALS
+    /* A memfd can't then be cut short under us; other files just fail. */
+    (void) fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_SEAL);
+#endif
     shmdesc = malloc(sizeof(ShmDescRec));
     if (!shmdesc) {
         close(fd);
@@ -308,7 +308,7 @@ compFreeClientWindow(WindowPtr pWin, XID id)
 
     if (pPixmap) {
         compRestoreWindow(pWin, pPixmap);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compReleasePixmap(pScreen, pPixmap);
     }
 }
 
@@ -525,21 +525,18 @@ compUnredirectOneSubwindow(WindowPtr pParent, WindowPtr pWin)
     return Success;
 }
 
-static PixmapPtr
-compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
+/*
+ * Fill a w x h area of pPixmap at (dx, dy) with what the parent shows
+ * there.
+ */
+static void
+compCopyFromParent(WindowPtr pWin, PixmapPtr pPixmap,
+                   int dx, int dy, int w, int h)
 {
     ScreenPtr pScreen = pWin->drawable.pScreen;
     WindowPtr pParent = pWin->parent;
-    PixmapPtr pPixmap;
-
-    pPixmap = (*pScreen->CreatePixmap) (pScreen, w, h, pWin->drawable.depth,
-                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
-
-    if (!pPixmap)
-        return 0;
-
-    pPixmap->screen_x = x;
-    pPixmap->screen_y = y;
+    int x = pPixmap->screen_x + dx;
+    int y = pPixmap->screen_y + dy;
 
     if (pParent->drawable.depth == pWin->drawable.depth) {
         GCPtr pGC = GetScratchGC(pWin->drawable.depth, pScreen);
@@ -554,7 +551,7 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
                                    &pPixmap->drawable,
                                    pGC,
                                    x - pParent->drawable.x,
-                                   y - pParent->drawable.y, w, h, 0, 0);
+                                   y - pParent->drawable.y, w, h, dx, dy);
             FreeScratchGC(pGC);
         }
     }
@@ -583,13 +580,30 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
                              NULL,
                              pDstPicture,
                              x - pParent->drawable.x,
-                             y - pParent->drawable.y, 0, 0, 0, 0, w, h);
+                             y - pParent->drawable.y, 0, 0, dx, dy, w, h);
         }
         if (pSrcPicture)
             FreePicture(pSrcPicture, 0);
         if (pDstPicture)
             FreePicture(pDstPicture, 0);
     }
+}
+
+static PixmapPtr
+compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    PixmapPtr pPixmap;
+
+    pPixmap = compCreatePixmap(pScreen, w, h, pWin->drawable.depth);
+
+    if (!pPixmap)
+        return 0;
+
+    pPixmap->screen_x = x;
+    pPixmap->screen_y = y;
+
+    compCopyFromParent(pWin, pPixmap, 0, 0, w, h);
     return pPixmap;
 }
 
@@ -653,10 +667,35 @@ compSetParentPixmap(WindowPtr pWin)
     compSetPixmap(pWin, pParentPixmap, pWin->borderWidth);
 }
 
+/*
+ * Whether resizing pWin in place leaves every bit where it belongs: the
+ * bit gravity keeps the contents at the origin and no mapped child is
+ * moved by its window gravity.  Otherwise the areas gravity vacates
+ * would keep stale bits, where a new pixmap shows the parent.
+ */
+static Bool
+compResizeKeepsBits(WindowPtr pWin)
+{
+    WindowPtr pChild;
+
+    if (pWin->bitGravity != NorthWestGravity &&
+        pWin->bitGravity != StaticGravity)
+        return FALSE;
+    for (pChild = pWin->firstChild; pChild; pChild = pChild->nextSib) {
+        if (pChild->mapped && pChild->winGravity != NorthWestGravity &&
+            pChild->winGravity != StaticGravity)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 /*
  * Make sure the pixmap is the right size and offset.  Allocate a new
  * pixmap to change size, adjust origin to change offset, leaving the
- * old pixmap in cw->pOldPixmap so bits can be recovered
+ * old pixmap in cw->pOldPixmap so bits can be recovered.  A pooled
+ * pixmap with room to spare is resized in place when the window keeps
+ * its origin and nothing in it moves, so the bits are already where
+ * they belong.
  */
 Bool
 compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
@@ -668,6 +707,7 @@ compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
     CompWindowPtr cw = GetCompWindow(pWin);
     int pix_x, pix_y;
     int pix_w, pix_h;
+    int old_w, old_h;
 
     assert(cw && pWin->redirectDraw != RedirectDrawNone);
     cw->oldx = pOld->screen_x;
@@ -676,17 +716,30 @@ compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
     pix_y = draw_y - bw;
     pix_w = w + (bw << 1);
     pix_h = h + (bw << 1);
-    if (pix_w != pOld->drawable.width || pix_h != pOld->drawable.height) {
+    old_w = pOld->drawable.width;
+    old_h = pOld->drawable.height;
+    if (pix_w == old_w && pix_h == old_h) {
+        pNew = pOld;
+        cw->pOldPixmap = 0;
+    }
+    else if (pix_x == pOld->screen_x && pix_y == pOld->screen_y &&
+             bw == pWin->borderWidth && compResizeKeepsBits(pWin) &&
+             compResizePixmap(pOld, pix_w, pix_h)) {
+        if (pix_w > old_w)
+            compCopyFromParent(pWin, pOld, old_w, 0, pix_w - old_w, pix_h);
+        if (pix_h > old_h)
+            compCopyFromParent(pWin, pOld, 0, old_h,
+                               min(old_w, pix_w), pix_h - old_h);
+        pNew = pOld;
+        cw->pOldPixmap = 0;
+    }
+    else {
         pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h);
         if (!pNew)
             return FALSE;
         cw->pOldPixmap = pOld;
         compSetPixmap(pWin, pNew, bw);
     }
-    else {
-        pNew = pOld;
-        cw->pOldPixmap = 0;
-    }
     pNew->screen_x = pix_x;
     pNew->screen_y = pix_y;
     return TRUE;
@@ -257,6 +257,7 @@ ProcCompositeNameWindowPixmap(ClientPtr client)
         return rc;
 
     ++pPixmap->refcnt;
+    compForgetPixmap(pPixmap);
 
     if (!AddResource(stuff->pixmap, RT_PIXMAP, (void *) pPixmap))
         return BadAlloc;
@@ -753,6 +754,7 @@ PanoramiXCompositeNameWindowPixmap(ClientPtr client)
             return BadAlloc;
 
         ++pPixmap->refcnt;
+        compForgetPixmap(pPixmap);
     }
 
     if (!AddResource(stuff->pixmap, XRT_PIXMAP, (void *) newPix))
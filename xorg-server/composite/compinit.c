@@ -58,6 +58,7 @@ compCloseScreen(ScreenPtr pScreen)
     CompScreenPtr cs = GetCompScreen(pScreen);
     Bool ret;
 
+    compPoolFini(pScreen);
     free(cs->alternateVisuals);
 
     pScreen->CloseScreen = cs->CloseScreen;
@@ -394,6 +395,11 @@ compScreenInit(ScreenPtr pScreen)
     cs->numImplicitRedirectExceptions = 0;
     cs->implicitRedirectExceptions = NULL;
 
+    if (!compPoolInit(pScreen, cs)) {
+        free(cs);
+        return FALSE;
+    }
+
     if (!compAddAlternateVisuals(pScreen, cs)) {
         free(cs);
         return FALSE;
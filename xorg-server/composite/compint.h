@@ -124,6 +124,19 @@ typedef struct _CompImplicitRedirectException {
     XID winVisual;
 } CompImplicitRedirectException;
 
+#define COMP_POOL_SIZE 8
+
+typedef struct _CompPixmapPool {
+    Bool enabled;
+    int num;
+    PixmapPtr pixmaps[COMP_POOL_SIZE];  /* oldest first */
+    size_t bytes;
+    OsTimerPtr timer;
+    CARD32 hits;                /* backing pixmaps taken from the pool */
+    CARD32 misses;              /* and allocated instead */
+    CARD32 resizes;             /* resized without a new pixmap */
+} CompPixmapPoolRec, *CompPixmapPoolPtr;
+
 typedef struct _CompScreen {
     PositionWindowProcPtr PositionWindow;
     CopyWindowProcPtr CopyWindow;
@@ -171,6 +184,8 @@ typedef struct _CompScreen {
     GetImageProcPtr GetImage;
     GetSpansProcPtr GetSpans;
     SourceValidateProcPtr SourceValidate;
+
+    CompPixmapPoolRec pool;
 } CompScreenRec, *CompScreenPtr;
 
 extern DevPrivateKeyRec CompScreenPrivateKeyRec;
@@ -239,6 +254,28 @@ compReallocPixmap(WindowPtr pWin, int x, int y,
 
 void compMarkAncestors(WindowPtr pWin);
 
+/*
+ * comppool.c
+ */
+
+Bool
+ compPoolInit(ScreenPtr pScreen, CompScreenPtr cs);
+
+void
+ compPoolFini(ScreenPtr pScreen);
+
+PixmapPtr
+ compCreatePixmap(ScreenPtr pScreen, int w, int h, int depth);
+
+Bool
+ compResizePixmap(PixmapPtr pPixmap, int w, int h);
+
+void
+ compReleasePixmap(ScreenPtr pScreen, PixmapPtr pPixmap);
+
+void
+ compForgetPixmap(PixmapPtr pPixmap);
+
 /*
  * compinit.c
  */
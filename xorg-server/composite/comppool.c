@@ -0,0 +1,250 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Backing pixmap pool.
+ *
+ * Redirecting, resizing and remapping a window each allocate a new
+ * backing pixmap and free the old one, dozens of times a second during
+ * an interactive resize.  Backing pixmaps are instead allocated a little
+ * larger than asked for, rounded up to a size bucket, and the header is
+ * shrunk to the window size.  Freed ones wait in a small per-screen pool
+ * for a window of the same depth and bucket; a window resized within its
+ * bucket keeps its pixmap and only changes the header.
+ *
+ * That only works where a pixmap is plain memory whose header can be
+ * resized freely, as with fb.  The pool turns itself off the first time
+ * it sees a pixmap without CPU-visible storage, or a screen that has
+ * its own ModifyPixmapHeader.  A pixmap a client has named is never
+ * reused, as the client may still be watching it.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include "compint.h"
+
+#define COMP_POOL_BYTES		(32 << 20)
+#define COMP_POOL_LINGER	5000    /* ms after the last release */
+#define COMP_POOL_MAX_STEP	32      /* most slack per dimension, pixels */
+
+typedef struct _CompPixmap {
+    CARD16 width, height;       /* allocated size, or 0 if not pooled */
+} CompPixmapRec, *CompPixmapPtr;
+
+static DevPrivateKeyRec CompPixmapPrivateKeyRec;
+
+#define GetCompPixmap(p) ((CompPixmapPtr) \
+    dixGetPrivateAddr(&(p)->devPrivates, &CompPixmapPrivateKeyRec))
+
+/*
+ * Round up to a multiple of an eighth to a sixteenth of the size, but of
+ * no more than COMP_POOL_MAX_STEP pixels, so a large window wastes at
+ * most a few percent of its pixmap.
+ */
+static int
+compPoolRound(int v)
+{
+    int step = 8;
+
+    while (step * 16 <= v && step < COMP_POOL_MAX_STEP)
+        step <<= 1;
+    return (v + step - 1) & ~(step - 1);
+}
+
+static size_t
+compPoolBytes(PixmapPtr pPixmap)
+{
+    return (size_t) pPixmap->devKind * GetCompPixmap(pPixmap)->height;
+}
+
+static void
+compPoolRemove(CompPixmapPoolPtr pool, int i)
+{
+    pool->bytes -= compPoolBytes(pool->pixmaps[i]);
+    memmove(pool->pixmaps + i, pool->pixmaps + i + 1,
+            (pool->num - i - 1) * sizeof(pool->pixmaps[0]));
+    pool->num--;
+}
+
+static void
+compPoolFlush(ScreenPtr pScreen)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+
+    while (pool->num) {
+        PixmapPtr pPixmap = pool->pixmaps[0];
+
+        compPoolRemove(pool, 0);
+        (*pScreen->DestroyPixmap) (pPixmap);
+    }
+}
+
+static CARD32
+compPoolExpire(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    compPoolFlush(arg);
+    return 0;
+}
+
+static void
+compPoolDisable(ScreenPtr pScreen)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+
+    compPoolFlush(pScreen);
+    pool->enabled = FALSE;
+}
+
+/* Point an allocated pixmap's header at a w x h corner of it. */
+static void
+compPoolSetSize(PixmapPtr pPixmap, int w, int h)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
+    (*pScreen->ModifyPixmapHeader) (pPixmap, w, h, 0, 0, 0, NULL);
+}
+
+PixmapPtr
+compCreatePixmap(ScreenPtr pScreen, int w, int h, int depth)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+    int bw = compPoolRound(w), bh = compPoolRound(h);
+    PixmapPtr pPixmap;
+    CompPixmapPtr cp;
+    int i;
+
+    if (!pool->enabled || bw > MAXSHORT || bh > MAXSHORT)
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+
+    for (i = pool->num; i-- > 0;) {
+        pPixmap = pool->pixmaps[i];
+        cp = GetCompPixmap(pPixmap);
+        if (pPixmap->drawable.depth == depth &&
+            cp->width == bw && cp->height == bh) {
+            compPoolRemove(pool, i);
+            compPoolSetSize(pPixmap, w, h);
+            pool->hits++;
+            return pPixmap;
+        }
+    }
+
+    pool->misses++;
+    pPixmap = (*pScreen->CreatePixmap) (pScreen, bw, bh, depth,
+                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    if (!pPixmap)
+        return NULL;
+    if (!pPixmap->devPrivate.ptr || pPixmap->devKind <= 0 ||
+        pScreen->ModifyPixmapHeader != miModifyPixmapHeader) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        compPoolDisable(pScreen);
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    }
+    cp = GetCompPixmap(pPixmap);
+    cp->width = bw;
+    cp->height = bh;
+    compPoolSetSize(pPixmap, w, h);
+    return pPixmap;
+}
+
+Bool
+compResizePixmap(PixmapPtr pPixmap, int w, int h)
+{
+    CompPixmapPtr cp = GetCompPixmap(pPixmap);
+    CompPixmapPoolPtr pool = &GetCompScreen(pPixmap->drawable.pScreen)->pool;
+
+    if (!pool->enabled || !cp->width || pPixmap->refcnt != 1 ||
+        compPoolRound(w) != cp->width || compPoolRound(h) != cp->height)
+        return FALSE;
+    compPoolSetSize(pPixmap, w, h);
+    pool->resizes++;
+    return TRUE;
+}
+
+void
+compReleasePixmap(ScreenPtr pScreen, PixmapPtr pPixmap)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+    size_t bytes;
+
+    if (!pool->enabled || !GetCompPixmap(pPixmap)->width ||
+        pPixmap->refcnt != 1) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        return;
+    }
+
+    bytes = compPoolBytes(pPixmap);
+    if (bytes > COMP_POOL_BYTES) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        return;
+    }
+    /* make room, oldest first */
+    while (pool->num == COMP_POOL_SIZE ||
+           pool->bytes + bytes > COMP_POOL_BYTES) {
+        PixmapPtr pOld = pool->pixmaps[0];
+
+        compPoolRemove(pool, 0);
+        (*pScreen->DestroyPixmap) (pOld);
+    }
+    pool->pixmaps[pool->num++] = pPixmap;
+    pool->bytes += bytes;
+    pool->timer = TimerSet(pool->timer, 0, COMP_POOL_LINGER,
+                           compPoolExpire, pScreen);
+}
+
+void
+compForgetPixmap(PixmapPtr pPixmap)
+{
+    GetCompPixmap(pPixmap)->width = 0;
+}
+
+Bool
+compPoolInit(ScreenPtr pScreen, CompScreenPtr cs)
+{
+    CompPixmapPoolPtr pool = &cs->pool;
+
+    if (!dixRegisterPrivateKey(&CompPixmapPrivateKeyRec, PRIVATE_PIXMAP,
+                               sizeof(CompPixmapRec)))
+        return FALSE;
+    memset(pool, 0, sizeof(*pool));
+    pool->enabled = pScreen->ModifyPixmapHeader == miModifyPixmapHeader;
+    return TRUE;
+}
+
+void
+compPoolFini(ScreenPtr pScreen)
+{
+    CompPixmapPoolPtr pool = &GetCompScreen(pScreen)->pool;
+
+    if (pool->hits || pool->misses)
+        LogMessageVerb(X_INFO, 3, "Composite(%d): backing pixmap pool: "
+                       "%u hits, %u misses, %u resized in place\n",
+                       pScreen->myNum, (unsigned) pool->hits,
+                       (unsigned) pool->misses, (unsigned) pool->resizes);
+    TimerFree(pool->timer);
+    pool->timer = NULL;
+    compPoolFlush(pScreen);
+}
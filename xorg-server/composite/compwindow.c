@@ -171,7 +171,7 @@ compCheckRedirect(WindowPtr pWin)
 
             compSetParentPixmap(pWin);
             compRestoreWindow(pWin, pPixmap);
-            (*pScreen->DestroyPixmap) (pPixmap);
+            compReleasePixmap(pScreen, pPixmap);
         }
     }
     else if (should) {
@@ -375,7 +375,7 @@ compFreeOldPixmap(WindowPtr pWin)
         CompWindowPtr cw = GetCompWindow(pWin);
 
         if (cw->pOldPixmap) {
-            (*pScreen->DestroyPixmap) (cw->pOldPixmap);
+            compReleasePixmap(pScreen, cw->pOldPixmap);
             cw->pOldPixmap = NullPixmap;
         }
     }
@@ -608,7 +608,7 @@ compDestroyWindow(WindowPtr pWin)
         PixmapPtr pPixmap = (*pScreen->GetWindowPixmap) (pWin);
 
         compSetParentPixmap(pWin);
-        (*pScreen->DestroyPixmap) (pPixmap);
+        compReleasePixmap(pScreen, pPixmap);
     }
     ret = (*pScreen->DestroyWindow) (pWin);
     cs->DestroyWindow = pScreen->DestroyWindow;
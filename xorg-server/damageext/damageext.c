@@ -236,8 +236,11 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
-    pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
-                                       FALSE, pDrawable->pScreen, pDamageExt);
+    pDamageExt->pDamage = DamageCreateWithPolicy(DamageExtReport,
+                                                 DamageExtDestroy, level,
+                                                 FALSE, pDrawable->pScreen,
+                                                 pDamageExt,
+                                                 &DamageDefaultPolicy);
     if (!pDamageExt->pDamage) {
         free(pDamageExt);
         return NULL;
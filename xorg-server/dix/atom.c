@@ -57,87 +57,201 @@ SOFTWARE.
 #include "dix.h"
 
 #define InitialTableSize 256
+#define AtomChunkSize 4096
+
+/*
+ * Atoms are found through an open-addressed hash table of (hash, atom)
+ * pairs, and nodeTable maps an atom back to its name.  Names and both
+ * tables are carved out of a bump allocator that is only released as a
+ * whole by FreeAllAtoms.  A table that outgrows its space is copied into
+ * a fresh allocation and the old one is simply left behind, so a name
+ * returned by NameForAtom stays valid until FreeAllAtoms.  Like the rest
+ * of dix, the tables are only used from the main thread.
+ */
 
 typedef struct _Node {
-    struct _Node *left, *right;
-    Atom a;
-    unsigned int fingerPrint;
     const char *string;
+    unsigned int len;
+    unsigned int hash;
 } NodeRec, *NodePtr;
 
+typedef struct _AtomSlot {
+    unsigned int hash;
+    Atom a;
+} AtomSlotRec, *AtomSlotPtr;
+
+typedef struct _AtomChunk {
+    struct _AtomChunk *next;
+    size_t used;
+    size_t size;
+} AtomChunkRec, *AtomChunkPtr;
+
 static Atom lastAtom = None;
-static NodePtr atomRoot = NULL;
 static unsigned long tableLength;
-static NodePtr *nodeTable;
+static NodePtr nodeTable;
+static AtomSlotPtr atomHash;
+static unsigned int atomHashMask;
+static AtomChunkPtr atomChunks;
 
-Atom
-MakeAtom(const char *string, unsigned len, Bool makeit)
+static void *
+AtomAlloc(size_t size, size_t align)
 {
-    NodePtr *np;
-    unsigned i;
-    int comp;
-    unsigned int fp = 0;
+    AtomChunkPtr chunk = atomChunks;
+    size_t offset;
 
-    np = &atomRoot;
-    for (i = 0; i < (len + 1) / 2; i++) {
-        fp = fp * 27 + string[i];
-        fp = fp * 27 + string[len - 1 - i];
-    }
-    while (*np != NULL) {
-        if (fp < (*np)->fingerPrint)
-            np = &((*np)->left);
-        else if (fp > (*np)->fingerPrint)
-            np = &((*np)->right);
-        else {                  /* now start testing the strings */
-            comp = strncmp(string, (*np)->string, (int) len);
-            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
-                np = &((*np)->left);
-            else if (comp > 0)
-                np = &((*np)->right);
-            else
-                return (*np)->a;
+    if (chunk) {
+        offset = (chunk->used + align - 1) & ~(align - 1);
+        if (offset + size <= chunk->size) {
+            chunk->used = offset + size;
+            return (char *) (chunk + 1) + offset;
         }
     }
-    if (makeit) {
-        NodePtr nd;
 
-        nd = malloc(sizeof(NodeRec));
-        if (!nd)
-            return BAD_RESOURCE;
-        if (lastAtom < XA_LAST_PREDEFINED) {
-            nd->string = string;
+    /* tables get a chunk of their own, kept behind the current one */
+    if (size > AtomChunkSize / 4) {
+        chunk = malloc(sizeof(AtomChunkRec) + size);
+        if (!chunk)
+            return NULL;
+        chunk->used = chunk->size = size;
+        if (atomChunks) {
+            chunk->next = atomChunks->next;
+            atomChunks->next = chunk;
         }
         else {
-            nd->string = strndup(string, len);
-            if (!nd->string) {
-                free(nd);
-                return BAD_RESOURCE;
-            }
+            chunk->next = NULL;
+            atomChunks = chunk;
         }
-        if ((lastAtom + 1) >= tableLength) {
-            NodePtr *table;
-
-            table = reallocarray(nodeTable, tableLength, 2 * sizeof(NodePtr));
-            if (!table) {
-                if (nd->string != string) {
-                    /* nd->string has been strdup'ed */
-                    free((char *) nd->string);
-                }
-                free(nd);
-                return BAD_RESOURCE;
-            }
-            tableLength <<= 1;
-            nodeTable = table;
+        return chunk + 1;
+    }
+
+    chunk = malloc(sizeof(AtomChunkRec) + AtomChunkSize);
+    if (!chunk)
+        return NULL;
+    chunk->next = atomChunks;
+    chunk->used = size;
+    chunk->size = AtomChunkSize;
+    atomChunks = chunk;
+    return chunk + 1;
+}
+
+/*
+ * FNV-1a over the name.  Like the strncmp based comparison this used to
+ * be, the name ends at the first NUL, so len is trimmed to match.
+ */
+static unsigned int
+HashAtomName(const char *string, unsigned *len)
+{
+    unsigned int hash = 2166136261U;
+    unsigned i;
+
+    for (i = 0; i < *len && string[i]; i++) {
+        hash ^= (unsigned char) string[i];
+        hash *= 16777619U;
+    }
+    *len = i;
+    return hash;
+}
+
+static AtomSlotPtr
+FindAtomSlot(AtomSlotPtr table, unsigned int mask,
+             const char *string, unsigned len, unsigned int hash)
+{
+    unsigned int i;
+    AtomSlotPtr slot;
+    NodePtr nd;
+
+    for (i = hash & mask;; i = (i + 1) & mask) {
+        slot = &table[i];
+        if (slot->a == None)
+            return slot;
+        if (slot->hash == hash) {
+            nd = &nodeTable[slot->a];
+            if (nd->len == len && memcmp(nd->string, string, len) == 0)
+                return slot;
         }
-        *np = nd;
-        nd->left = nd->right = NULL;
-        nd->fingerPrint = fp;
-        nd->a = ++lastAtom;
-        nodeTable[lastAtom] = nd;
-        return nd->a;
     }
-    else
+}
+
+static Bool
+GrowNodeTable(void)
+{
+    NodePtr table;
+
+    table = AtomAlloc(2 * tableLength * sizeof(NodeRec), sizeof(void *));
+    if (!table)
+        return FALSE;
+    memcpy(table, nodeTable, (lastAtom + 1) * sizeof(NodeRec));
+    nodeTable = table;
+    tableLength <<= 1;
+    return TRUE;
+}
+
+static Bool
+GrowAtomHash(void)
+{
+    unsigned int mask = 2 * atomHashMask + 1;
+    AtomSlotPtr table;
+    NodePtr nd;
+    Atom a;
+
+    table = AtomAlloc((mask + 1) * sizeof(AtomSlotRec), sizeof(void *));
+    if (!table)
+        return FALSE;
+    memset(table, 0, (mask + 1) * sizeof(AtomSlotRec));
+    for (a = None + 1; a <= lastAtom; a++) {
+        AtomSlotPtr slot;
+
+        nd = &nodeTable[a];
+        slot = FindAtomSlot(table, mask, nd->string, nd->len, nd->hash);
+        slot->hash = nd->hash;
+        slot->a = a;
+    }
+    atomHash = table;
+    atomHashMask = mask;
+    return TRUE;
+}
+
+Atom
+MakeAtom(const char *string, unsigned len, Bool makeit)
+{
+    AtomSlotPtr slot;
+    NodePtr nd;
+    unsigned int hash;
+    char *name;
+
+    hash = HashAtomName(string, &len);
+    slot = FindAtomSlot(atomHash, atomHashMask, string, len, hash);
+    if (slot->a != None)
+        return slot->a;
+    if (!makeit)
         return None;
+
+    if ((lastAtom + 1) >= tableLength && !GrowNodeTable())
+        return BAD_RESOURCE;
+    /* keep the hash table at most half full */
+    if (2 * (lastAtom + 1) > atomHashMask) {
+        if (!GrowAtomHash())
+            return BAD_RESOURCE;
+        slot = FindAtomSlot(atomHash, atomHashMask, string, len, hash);
+    }
+
+    nd = &nodeTable[lastAtom + 1];
+    if (lastAtom < XA_LAST_PREDEFINED) {
+        nd->string = string;
+    }
+    else {
+        name = AtomAlloc(len + 1, 1);
+        if (!name)
+            return BAD_RESOURCE;
+        memcpy(name, string, len);
+        name[len] = '\0';
+        nd->string = name;
+    }
+    nd->len = len;
+    nd->hash = hash;
+    slot->hash = hash;
+    slot->a = ++lastAtom;
+    return lastAtom;
 }
 
 Bool
@@ -149,13 +263,9 @@ ValidAtom(Atom atom)
 const char *
 NameForAtom(Atom atom)
 {
-    NodePtr node;
-
     if (atom > lastAtom)
         return 0;
-    if ((node = nodeTable[atom]) == NULL)
-        return 0;
-    return node->string;
+    return nodeTable[atom].string;
 }
 
 void
@@ -164,32 +274,19 @@ AtomError(void)
     FatalError("initializing atoms");
 }
 
-static void
-FreeAtom(NodePtr patom)
-{
-    if (patom->left)
-        FreeAtom(patom->left);
-    if (patom->right)
-        FreeAtom(patom->right);
-    if (patom->a > XA_LAST_PREDEFINED) {
-        /*
-         * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
-         * cast here
-         */
-        free((char *) patom->string);
-    }
-    free(patom);
-}
-
 void
 FreeAllAtoms(void)
 {
-    if (atomRoot == NULL)
-        return;
-    FreeAtom(atomRoot);
-    atomRoot = NULL;
-    free(nodeTable);
+    AtomChunkPtr chunk, next;
+
+    for (chunk = atomChunks; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+    atomChunks = NULL;
     nodeTable = NULL;
+    atomHash = NULL;
+    atomHashMask = 0;
     lastAtom = None;
 }
 
@@ -198,10 +295,16 @@ InitAtoms(void)
 {
     FreeAllAtoms();
     tableLength = InitialTableSize;
-    nodeTable = xallocarray(InitialTableSize, sizeof(NodePtr));
-    if (!nodeTable)
+    nodeTable = AtomAlloc(InitialTableSize * sizeof(NodeRec), sizeof(void *));
+    atomHashMask = 2 * InitialTableSize - 1;
+    atomHash = AtomAlloc((atomHashMask + 1) * sizeof(AtomSlotRec),
+                         sizeof(void *));
+    if (!nodeTable || !atomHash)
         AtomError();
-    nodeTable[None] = NULL;
+    memset(atomHash, 0, (atomHashMask + 1) * sizeof(AtomSlotRec));
+    nodeTable[None].string = NULL;
+    nodeTable[None].len = 0;
+    nodeTable[None].hash = 0;
     MakePredeclaredAtoms();
     if (lastAtom != XA_LAST_PREDEFINED)
         AtomError();
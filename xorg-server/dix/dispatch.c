@@ -133,6 +133,7 @@ int ProcInitialConnection();
 #include "xkbsrv.h"
 #include "site.h"
 #include "client.h"
+#include "reqprof.h"
 
 #ifdef XSERVER_DTRACE
 #include "registry.h"
@@ -426,6 +427,8 @@ void DispatchQueuedEvents(Bool wait)
             ProcessInputEvents();
             FlushIfCriticalOutputPending();
         }
+        if (RequestProfileToggle)
+            ToggleRequestProfile();
 
         if (wait)
         {
@@ -463,6 +466,7 @@ void DispatchQueuedEvents(Bool wait)
             while (!isItTimeToYield)
             {
                 int result;
+                CARD64 profile_start;
 #ifdef XSERVER_DTRACE
                 CARD8 StartMajorOp;
 #endif
@@ -508,6 +512,7 @@ void DispatchQueuedEvents(Bool wait)
                                           client->requestBuffer);
                 }
 #endif
+                profile_start = RequestProfiling ? RequestProfileStart() : 0;
                 if (result > (maxBigRequestSize << 2))
                     result = BadLength;
                 else
@@ -516,6 +521,8 @@ void DispatchQueuedEvents(Bool wait)
                     if (result == Success)
                         result = (*client->requestVector[client->majorOp]) (client);
                 }
+                if (RequestProfiling && profile_start)
+                    RequestProfileDone(client, profile_start);
                 if (!SmartScheduleSignalEnable)
                     SmartScheduleTime = GetTimeInMillis();
 
@@ -573,6 +580,7 @@ Dispatch(void)
 
     SmartScheduleSlice = SmartScheduleInterval;
     init_client_ready();
+    InitRequestProfile();
 
     while (!dispatchException) {
         DispatchQueuedEvents(1);
@@ -584,6 +592,7 @@ Dispatch(void)
     KillAllClients();
     dispatchException &= ~DE_RESET;
     SmartScheduleLatencyLimited = 0;
+    FinishRequestProfile();
     ResetOsBuffers();
 }
 
@@ -2151,6 +2160,38 @@ ProcPutImage(ClientPtr client)
     return Success;
 }
 
+/*
+ * GetImage fills a fresh buffer per band and hands it to the output
+ * layer, which can then send it without copying even when the client
+ * is slow to read.  The preallocated scratch buffer is used, with a
+ * plain copy, should a band buffer not be available.
+ *
+ * GetImage writes the pixels of each scanline but not necessarily its
+ * padding, so only the padding, from the byte holding the last pixel
+ * bits on, is cleared.
+ */
+static char *
+GetImageBand(char *scratch, long length, long widthBytesLine, long usedBits)
+{
+    char *band = malloc(length);
+    long line, pad = usedBits >> 3;
+
+    if (!band)
+        return scratch;
+    for (line = 0; line < length; line += widthBytesLine)
+        memset(band + line + pad, 0, widthBytesLine - pad);
+    return band;
+}
+
+static void
+WriteImageBand(ClientPtr client, char *scratch, char *band, int length)
+{
+    if (band == scratch)
+        WriteToClient(client, length, band);
+    else
+        WriteToClientBuffer(client, length, band, free, band);
+}
+
 static int
 DoGetImage(ClientPtr client, int format, Drawable drawable,
            int x, int y, int width, int height,
@@ -2164,7 +2205,7 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
     int relx, rely;
     long widthBytesLine, length;
     Mask plane = 0;
-    char *pBuf;
+    char *pBuf, *pBand;
     xGetImageReply xgi;
     RegionPtr pVisibleRegion = NULL;
 
@@ -2291,23 +2332,26 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
         linesDone = 0;
         while (height - linesDone > 0) {
             nlines = min(linesPerBuf, height - linesDone);
+            pBand = GetImageBand(pBuf, length, widthBytesLine,
+                                 (long) width * BitsPerPixel(pDraw->depth));
             (*pDraw->pScreen->GetImage) (pDraw,
                                          x,
                                          y + linesDone,
                                          width,
                                          nlines,
-                                         format, planemask, (void *) pBuf);
+                                         format, planemask, (void *) pBand);
             if (pVisibleRegion)
                 XaceCensorImage(client, pVisibleRegion, widthBytesLine,
                                 pDraw, x, y + linesDone, width,
-                                nlines, format, pBuf);
+                                nlines, format, pBand);
 
             /* Note that this is NOT a call to WriteSwappedDataToClient,
                as we do NOT byte swap */
-            ReformatImage(pBuf, (int) (nlines * widthBytesLine),
+            ReformatImage(pBand, (int) (nlines * widthBytesLine),
                           BitsPerPixel(pDraw->depth), ClientOrder(client));
 
-            WriteToClient(client, (int) (nlines * widthBytesLine), pBuf);
+            WriteImageBand(client, pBuf, pBand,
+                           (int) (nlines * widthBytesLine));
             linesDone += nlines;
         }
     }
@@ -2318,24 +2362,26 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
                 linesDone = 0;
                 while (height - linesDone > 0) {
                     nlines = min(linesPerBuf, height - linesDone);
+                    pBand = GetImageBand(pBuf, length, widthBytesLine, width);
                     (*pDraw->pScreen->GetImage) (pDraw,
                                                  x,
                                                  y + linesDone,
                                                  width,
                                                  nlines,
-                                                 format, plane, (void *) pBuf);
+                                                 format, plane, (void *) pBand);
                     if (pVisibleRegion)
                         XaceCensorImage(client, pVisibleRegion,
                                         widthBytesLine,
                                         pDraw, x, y + linesDone, width,
-                                        nlines, format, pBuf);
+                                        nlines, format, pBand);
 
                     /* Note: NOT a call to WriteSwappedDataToClient,
                        as we do NOT byte swap */
-                    ReformatImage(pBuf, (int) (nlines * widthBytesLine),
+                    ReformatImage(pBand, (int) (nlines * widthBytesLine),
                                   1, ClientOrder(client));
 
-                    WriteToClient(client, (int)(nlines * widthBytesLine), pBuf);
+                    WriteImageBand(client, pBuf, pBand,
+                                   (int) (nlines * widthBytesLine));
                     linesDone += nlines;
                 }
             }
@@ -110,6 +110,7 @@ FontPtr defaultFont;            /* not declared in dix.h to avoid including font
 CursorPtr rootCursor;
 Bool party_like_its_1989 = FALSE;
 Bool whiteRoot = FALSE;
+Bool CoalesceMotion = TRUE;
 
 TimeStamp currentTime;
 
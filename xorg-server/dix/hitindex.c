@@ -0,0 +1,394 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Hit-test index for windows with many children.
+ *
+ * The inside of the parent is cut into a grid of at most
+ * HIT_GRID_MAX x HIT_GRID_MAX cells, and every cell lists the mapped
+ * children whose border box touches it, in stacking order.  A pointer
+ * position then only has to be tested against the children listed in
+ * its cell instead of against every sibling.
+ *
+ * The grid is kept in coordinates relative to the parent, so moving an
+ * ancestor does not touch it.  Moving, resizing, mapping or unmapping a
+ * child updates that child's cells in place; restacking or adding and
+ * removing children only marks the index stale, and it is rebuilt the
+ * next time it is asked for a position.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "misc.h"
+#include "windowstr.h"
+#include "window.h"
+
+#define HIT_GRID_MAX        16          /* cells per side */
+#define HIT_CELL_MIN        32          /* smallest cell, in pixels */
+#define HIT_INDEX_MIN       32          /* children before indexing pays */
+
+typedef struct _WindowHitEntry {
+    WindowPtr pWin;
+    unsigned rank;              /* position in the stack, 0 is the top */
+    short x1, y1, x2, y2;       /* cells covered, inclusive; empty if x1 > x2 */
+} WindowHitEntryRec, *WindowHitEntryPtr;
+
+typedef struct _WindowHitCell {
+    WindowHitEntryPtr *entries; /* sorted by rank */
+    WindowPtr *windows;         /* same order, handed to the caller */
+    int count;
+    int size;
+} WindowHitCellRec, *WindowHitCellPtr;
+
+typedef struct _WindowHitIndex {
+    Bool stale;
+    unsigned short width, height;       /* parent size the grid was cut for */
+    int cols, rows;
+    int cellWidth, cellHeight;
+    int count;                  /* children indexed */
+    int hashSize;               /* power of two, at least twice count */
+    WindowHitEntryPtr hash;     /* open addressing on the window pointer */
+    WindowHitCellRec cells[HIT_GRID_MAX * HIT_GRID_MAX];
+} WindowHitIndexRec, *WindowHitIndexPtr;
+
+static unsigned
+HitHash(WindowPtr pWin, int size)
+{
+    uintptr_t v = (uintptr_t) pWin >> 4;
+
+    return (unsigned) ((v * 2654435761u) ^ (v >> 16)) & (size - 1);
+}
+
+static WindowHitEntryPtr
+HitLookup(WindowHitIndexPtr index, WindowPtr pWin)
+{
+    unsigned i = HitHash(pWin, index->hashSize);
+
+    while (index->hash[i].pWin) {
+        if (index->hash[i].pWin == pWin)
+            return &index->hash[i];
+        i = (i + 1) & (index->hashSize - 1);
+    }
+    return NULL;
+}
+
+static void
+HitClearCells(WindowHitIndexPtr index)
+{
+    int i;
+
+    for (i = 0; i < HIT_GRID_MAX * HIT_GRID_MAX; i++) {
+        free(index->cells[i].entries);
+        free(index->cells[i].windows);
+        index->cells[i].entries = NULL;
+        index->cells[i].windows = NULL;
+        index->cells[i].count = index->cells[i].size = 0;
+    }
+}
+
+/* Cells covered by the border box of a mapped child, clamped to the grid. */
+static void
+HitCellBox(WindowHitIndexPtr index, WindowHitEntryPtr entry)
+{
+    WindowPtr pWin = entry->pWin;
+    int bw = wBorderWidth(pWin);
+    int x1 = pWin->origin.x - bw;
+    int y1 = pWin->origin.y - bw;
+    int x2 = pWin->origin.x + (int) pWin->drawable.width + bw;
+    int y2 = pWin->origin.y + (int) pWin->drawable.height + bw;
+
+    if (!pWin->mapped || x2 <= 0 || y2 <= 0 ||
+        x1 >= index->width || y1 >= index->height || x1 >= x2 || y1 >= y2) {
+        entry->x1 = entry->y1 = 1;
+        entry->x2 = entry->y2 = 0;
+        return;
+    }
+    entry->x1 = max(x1, 0) / index->cellWidth;
+    entry->y1 = max(y1, 0) / index->cellHeight;
+    entry->x2 = (min(x2, index->width) - 1) / index->cellWidth;
+    entry->y2 = (min(y2, index->height) - 1) / index->cellHeight;
+}
+
+static Bool
+HitCellInsert(WindowHitCellPtr cell, WindowHitEntryPtr entry)
+{
+    int lo = 0, hi = cell->count;
+
+    if (cell->count == cell->size) {
+        int size = cell->size ? cell->size * 2 : 8;
+        WindowHitEntryPtr *entries;
+        WindowPtr *windows;
+
+        entries = reallocarray(cell->entries, size, sizeof(*entries));
+        if (!entries)
+            return FALSE;
+        cell->entries = entries;
+        windows = reallocarray(cell->windows, size, sizeof(*windows));
+        if (!windows)
+            return FALSE;
+        cell->windows = windows;
+        cell->size = size;
+    }
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (cell->entries[mid]->rank < entry->rank)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    memmove(cell->entries + lo + 1, cell->entries + lo,
+            (cell->count - lo) * sizeof(*cell->entries));
+    memmove(cell->windows + lo + 1, cell->windows + lo,
+            (cell->count - lo) * sizeof(*cell->windows));
+    cell->entries[lo] = entry;
+    cell->windows[lo] = entry->pWin;
+    cell->count++;
+    return TRUE;
+}
+
+static void
+HitCellRemove(WindowHitCellPtr cell, WindowHitEntryPtr entry)
+{
+    int lo = 0, hi = cell->count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (cell->entries[mid]->rank < entry->rank)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == cell->count || cell->entries[lo] != entry)
+        return;
+    cell->count--;
+    memmove(cell->entries + lo, cell->entries + lo + 1,
+            (cell->count - lo) * sizeof(*cell->entries));
+    memmove(cell->windows + lo, cell->windows + lo + 1,
+            (cell->count - lo) * sizeof(*cell->windows));
+}
+
+static Bool
+HitPlace(WindowHitIndexPtr index, WindowHitEntryPtr entry)
+{
+    int x, y;
+
+    for (y = entry->y1; y <= entry->y2; y++)
+        for (x = entry->x1; x <= entry->x2; x++)
+            if (!HitCellInsert(&index->cells[y * index->cols + x], entry))
+                return FALSE;
+    return TRUE;
+}
+
+static void
+HitUnplace(WindowHitIndexPtr index, WindowHitEntryPtr entry)
+{
+    int x, y;
+
+    for (y = entry->y1; y <= entry->y2; y++)
+        for (x = entry->x1; x <= entry->x2; x++)
+            HitCellRemove(&index->cells[y * index->cols + x], entry);
+}
+
+/*
+ * (Re)build the index of pParent from its child list.  Children are
+ * placed top to bottom, so every insert lands at the end of its cell.
+ */
+static Bool
+HitRebuild(WindowPtr pParent)
+{
+    WindowHitIndexPtr index = pParent->hitIndex;
+    WindowPtr pChild;
+    int count = 0, size;
+    unsigned rank;
+
+    for (pChild = pParent->firstChild; pChild; pChild = pChild->nextSib)
+        count++;
+    if (count < HIT_INDEX_MIN) {
+        WindowHitIndexFree(pParent);
+        return FALSE;
+    }
+
+    if (!index) {
+        index = calloc(1, sizeof(WindowHitIndexRec));
+        if (!index)
+            return FALSE;
+        pParent->hitIndex = index;
+    }
+    else
+        HitClearCells(index);
+
+    for (size = 64; size < count * 2; size <<= 1);
+    if (size != index->hashSize) {
+        free(index->hash);
+        index->hash = calloc(size, sizeof(WindowHitEntryRec));
+        index->hashSize = index->hash ? size : 0;
+    }
+    else
+        memset(index->hash, 0, size * sizeof(WindowHitEntryRec));
+    if (!index->hash)
+        goto fail;
+
+    index->width = pParent->drawable.width;
+    index->height = pParent->drawable.height;
+    index->cols = min(HIT_GRID_MAX, max(1, index->width / HIT_CELL_MIN));
+    index->rows = min(HIT_GRID_MAX, max(1, index->height / HIT_CELL_MIN));
+    index->cellWidth = (index->width + index->cols - 1) / index->cols;
+    index->cellHeight = (index->height + index->rows - 1) / index->rows;
+    if (!index->cellWidth || !index->cellHeight)
+        goto fail;
+    index->count = count;
+
+    rank = 0;
+    for (pChild = pParent->firstChild; pChild; pChild = pChild->nextSib) {
+        unsigned i = HitHash(pChild, index->hashSize);
+        WindowHitEntryPtr entry;
+
+        while (index->hash[i].pWin)
+            i = (i + 1) & (index->hashSize - 1);
+        entry = &index->hash[i];
+        entry->pWin = pChild;
+        entry->rank = rank++;
+        HitCellBox(index, entry);
+        if (!HitPlace(index, entry))
+            goto fail;
+    }
+    index->stale = FALSE;
+    return TRUE;
+
+ fail:
+    WindowHitIndexFree(pParent);
+    return FALSE;
+}
+
+/**
+ * Index the children of pParent for hit-testing.  Called once a linear
+ * walk over them has been found to be long; does nothing if there are
+ * too few children to be worth it.
+ */
+Bool
+WindowHitIndexBuild(WindowPtr pParent)
+{
+    if (pParent->hitIndex && !pParent->hitIndex->stale)
+        return TRUE;
+    return HitRebuild(pParent);
+}
+
+/**
+ * Return the children of pParent that may contain the screen position
+ * x/y, topmost first, or NULL if pParent has no usable index or the
+ * position lies outside its inside area.  In the latter case the caller
+ * has to walk the child list itself.  Every window returned still has to
+ * be hit-tested; windows not returned certainly do not contain x/y.
+ */
+WindowPtr *
+WindowHitCandidates(WindowPtr pParent, int x, int y, int *count)
+{
+    WindowHitIndexPtr index = pParent->hitIndex;
+    WindowHitCellPtr cell;
+
+    if (!index)
+        return NULL;
+    if (index->stale || index->width != pParent->drawable.width ||
+        index->height != pParent->drawable.height) {
+        if (!HitRebuild(pParent))
+            return NULL;
+        index = pParent->hitIndex;
+    }
+
+    x -= pParent->drawable.x;
+    y -= pParent->drawable.y;
+    if (x < 0 || y < 0 || x >= index->width || y >= index->height)
+        return NULL;
+
+    cell = &index->cells[(y / index->cellHeight) * index->cols +
+                         x / index->cellWidth];
+    *count = cell->count;
+    return cell->windows;
+}
+
+/**
+ * The position, size, border or map state of pWin changed: move it to
+ * the cells it now covers in its parent's index.
+ */
+void
+WindowHitIndexUpdate(WindowPtr pWin)
+{
+    WindowPtr pParent = pWin->parent;
+    WindowHitIndexPtr index;
+    WindowHitEntryRec moved;
+    WindowHitEntryPtr entry;
+
+    if (!pParent || !(index = pParent->hitIndex) || index->stale)
+        return;
+    if (index->width != pParent->drawable.width ||
+        index->height != pParent->drawable.height ||
+        !(entry = HitLookup(index, pWin))) {
+        index->stale = TRUE;
+        return;
+    }
+
+    moved = *entry;
+    HitCellBox(index, &moved);
+    if (moved.x1 == entry->x1 && moved.y1 == entry->y1 &&
+        moved.x2 == entry->x2 && moved.y2 == entry->y2)
+        return;
+
+    HitUnplace(index, entry);
+    *entry = moved;
+    if (!HitPlace(index, entry))
+        index->stale = TRUE;
+}
+
+/**
+ * The children of pParent were restacked, added or removed.  Their ranks
+ * are no longer right, so the index is rebuilt before its next use.
+ */
+void
+WindowHitIndexInvalidate(WindowPtr pParent)
+{
+    if (pParent && pParent->hitIndex)
+        pParent->hitIndex->stale = TRUE;
+}
+
+void
+WindowHitIndexFree(WindowPtr pWin)
+{
+    WindowHitIndexPtr index = pWin->hitIndex;
+
+    if (!index)
+        return;
+    HitClearCells(index);
+    free(index->hash);
+    free(index);
+    pWin->hitIndex = NULL;
+}
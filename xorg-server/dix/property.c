@@ -86,6 +86,220 @@ PrintPropertys(WindowPtr pWin)
 }
 #endif
 
+/*
+ * Windows with many properties (the root window above all) get a hash
+ * index from property name to the first property of that name in the
+ * list, so lookups, changes and deletes no longer walk the list.  The
+ * list itself stays the authoritative, ordered record.
+ */
+
+#define PROPERTY_INDEX_THRESHOLD 16
+
+#define PropertyIndexDeleted ((PropertyPtr) 1)
+
+typedef struct _PropertyIndex {
+    unsigned int mask;
+    unsigned int count;         /* properties in the list */
+    unsigned int used;          /* live and deleted slots */
+    Bool duplicates;            /* some names appear more than once */
+    PropertyPtr *slots;
+} PropertyIndexRec, *PropertyIndexPtr;
+
+static PropertyPtr *
+PropertyIndexSlot(PropertyIndexPtr index, Atom propertyName, Bool insert)
+{
+    unsigned int i = (propertyName * 0x9E3779B1U) >> 7;
+    PropertyPtr *slot, *deleted = NULL;
+
+    for (i &= index->mask;; i = (i + 1) & index->mask) {
+        slot = &index->slots[i];
+        if (*slot == NULL)
+            return (insert && deleted) ? deleted : slot;
+        if (*slot == PropertyIndexDeleted) {
+            if (!deleted)
+                deleted = slot;
+        }
+        else if ((*slot)->propertyName == propertyName)
+            return slot;
+    }
+}
+
+/* Index every property in the list, or just drop the index if that fails. */
+static void
+BuildPropertyIndex(WindowPtr pWin, unsigned int count)
+{
+    PropertyIndexPtr index = pWin->optional->propIndex;
+    unsigned int size = 32;
+    PropertyPtr pProp, *slot;
+
+    while (size < 4 * count)
+        size <<= 1;
+
+    if (!index) {
+        index = calloc(1, sizeof(PropertyIndexRec));
+        if (!index)
+            return;
+    }
+    free(index->slots);
+    index->slots = calloc(size, sizeof(PropertyPtr));
+    if (!index->slots) {
+        free(index);
+        pWin->optional->propIndex = NULL;
+        return;
+    }
+    index->mask = size - 1;
+    index->count = count;
+    index->used = 0;
+    index->duplicates = FALSE;
+
+    for (pProp = pWin->optional->userProps; pProp; pProp = pProp->next) {
+        slot = PropertyIndexSlot(index, pProp->propertyName, TRUE);
+        if (*slot) {
+            index->duplicates = TRUE;
+            continue;
+        }
+        *slot = pProp;
+        index->used++;
+    }
+    pWin->optional->propIndex = index;
+}
+
+static void
+FreePropertyIndex(WindowPtr pWin)
+{
+    if (pWin->optional && pWin->optional->propIndex) {
+        free(pWin->optional->propIndex->slots);
+        free(pWin->optional->propIndex);
+        pWin->optional->propIndex = NULL;
+    }
+}
+
+static PropertyPtr
+FindProperty(WindowPtr pWin, Atom propertyName)
+{
+    PropertyPtr pProp;
+
+    if (pWin->optional && pWin->optional->propIndex) {
+        pProp = *PropertyIndexSlot(pWin->optional->propIndex,
+                                   propertyName, FALSE);
+        return pProp;
+    }
+
+    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
+        if (pProp->propertyName == propertyName)
+            break;
+    return pProp;
+}
+
+/* Add a property to the front of the window's list. */
+static void
+LinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = pWin->optional->propIndex;
+    PropertyPtr *slot;
+    unsigned int count;
+
+    pProp->prev = NULL;
+    pProp->next = pWin->optional->userProps;
+    if (pProp->next)
+        pProp->next->prev = pProp;
+    pWin->optional->userProps = pProp;
+
+    if (!index) {
+        for (count = 0; pProp; pProp = pProp->next)
+            count++;
+        if (count > PROPERTY_INDEX_THRESHOLD)
+            BuildPropertyIndex(pWin, count);
+        return;
+    }
+
+    index->count++;
+    slot = PropertyIndexSlot(index, pProp->propertyName, TRUE);
+    if (*slot == NULL)
+        index->used++;
+    else if (*slot != PropertyIndexDeleted)
+        index->duplicates = TRUE;
+    /* the new property is now the first one with its name */
+    *slot = pProp;
+
+    if (4 * index->used > 3 * (index->mask + 1))
+        BuildPropertyIndex(pWin, index->count);
+}
+
+static void
+UnlinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = pWin->optional->propIndex;
+    PropertyPtr *slot, other;
+
+    if (index) {
+        index->count--;
+        slot = PropertyIndexSlot(index, pProp->propertyName, FALSE);
+        if (*slot == pProp) {
+            other = NULL;
+            if (index->duplicates) {
+                for (other = pProp->next; other; other = other->next)
+                    if (other->propertyName == pProp->propertyName)
+                        break;
+            }
+            *slot = other ? other : PropertyIndexDeleted;
+        }
+    }
+
+    if (pProp->next)
+        pProp->next->prev = pProp->prev;
+    if (pProp->prev)
+        pProp->prev->next = pProp->next;
+    else if (!(pWin->optional->userProps = pProp->next)) {
+        FreePropertyIndex(pWin);
+        CheckWindowOptionalNeed(pWin);
+    }
+}
+
+/*
+ * Property values live in a block that remembers how much room follows
+ * the data.  Appends grow the block geometrically and copy only the new
+ * bytes, so a selection transferred as a long run of PropModeAppend
+ * requests costs linear rather than quadratic time.  The value itself
+ * stays contiguous; everything that reads pProp->data is unaffected.
+ *
+ * GetProperty replies reference the block until they have been written
+ * out, so the block is counted.  Nothing rewrites bytes a reply may
+ * still point at: replacing or prepending allocates a new block and
+ * appending only writes past the old end.
+ */
+
+typedef struct _PropertyData {
+    size_t capacity;            /* bytes available for the value */
+    unsigned int refcnt;
+} PropertyDataRec, *PropertyDataPtr;
+
+#define PropertyDataBlock(data) ((PropertyDataPtr) (data) - 1)
+
+static void *
+AllocPropertyData(size_t size, size_t capacity)
+{
+    PropertyDataPtr block;
+
+    if (capacity < size)
+        capacity = size;
+    if (capacity > SIZE_MAX - sizeof(PropertyDataRec))
+        return NULL;
+    block = malloc(sizeof(PropertyDataRec) + capacity);
+    if (!block)
+        return NULL;
+    block->capacity = capacity;
+    block->refcnt = 1;
+    return block + 1;
+}
+
+static void
+FreePropertyData(void *data)
+{
+    if (data && --PropertyDataBlock(data)->refcnt == 0)
+        free(PropertyDataBlock(data));
+}
+
 int
 dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
                   ClientPtr client, Mask access_mode)
@@ -95,9 +309,7 @@ dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
 
     client->errorValue = propertyName;
 
-    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
-        if (pProp->propertyName == propertyName)
-            break;
+    pProp = FindProperty(pWin, propertyName);
 
     if (pProp)
         rc = XaceHookPropertyAccess(client, pWin, &pProp, access_mode);
@@ -274,8 +486,8 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         pProp = dixAllocateObjectWithPrivates(PropertyRec, PRIVATE_PROPERTY);
         if (!pProp)
             return BadAlloc;
-        data = malloc(totalSize);
-        if (!data && len) {
+        data = AllocPropertyData(totalSize, totalSize);
+        if (!data) {
             dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
             return BadAlloc;
         }
@@ -288,13 +500,12 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         rc = XaceHookPropertyAccess(pClient, pWin, &pProp,
                                     DixCreateAccess | DixWriteAccess);
         if (rc != Success) {
-            free(data);
+            FreePropertyData(data);
             dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
             pClient->errorValue = property;
             return rc;
         }
-        pProp->next = pWin->optional->userProps;
-        pWin->optional->userProps = pProp;
+        LinkProperty(pWin, pProp);
     }
     else if (rc == Success) {
         /* To append or prepend to a property the request format and type
@@ -311,8 +522,8 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         savedProp = *pProp;
 
         if (mode == PropModeReplace) {
-            data = malloc(totalSize);
-            if (!data && len)
+            data = AllocPropertyData(totalSize, totalSize);
+            if (!data)
                 return BadAlloc;
             memcpy(data, value, totalSize);
             pProp->data = data;
@@ -323,17 +534,31 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         else if (len == 0) {
             /* do nothing */
         }
+        else if (len > UINT32_MAX - pProp->size) {
+            return BadAlloc;
+        }
         else if (mode == PropModeAppend) {
-            data = xallocarray(pProp->size + len, sizeInBytes);
-            if (!data)
-                return BadAlloc;
-            memcpy(data, pProp->data, pProp->size * sizeInBytes);
-            memcpy(data + pProp->size * sizeInBytes, value, totalSize);
-            pProp->data = data;
+            size_t used = (size_t) pProp->size * sizeInBytes;
+            size_t needed = used + totalSize;
+
+            if (needed <= PropertyDataBlock(pProp->data)->capacity) {
+                /* Only bytes past the old end are written, so restoring
+                 * savedProp below still undoes the change. */
+                memcpy((char *) pProp->data + used, value, totalSize);
+            }
+            else {
+                data = AllocPropertyData(needed, needed + needed / 2);
+                if (!data)
+                    return BadAlloc;
+                memcpy(data, pProp->data, used);
+                memcpy(data + used, value, totalSize);
+                pProp->data = data;
+            }
             pProp->size += len;
         }
         else if (mode == PropModePrepend) {
-            data = xallocarray(len + pProp->size, sizeInBytes);
+            data = AllocPropertyData((size_t) (len + pProp->size) * sizeInBytes,
+                                     0);
             if (!data)
                 return BadAlloc;
             memcpy(data + totalSize, pProp->data, pProp->size * sizeInBytes);
@@ -347,11 +572,11 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         rc = XaceHookPropertyAccess(pClient, pWin, &pProp, access_mode);
         if (rc == Success) {
             if (savedProp.data != pProp->data)
-                free(savedProp.data);
+                FreePropertyData(savedProp.data);
         }
         else {
             if (savedProp.data != pProp->data)
-                free(pProp->data);
+                FreePropertyData(pProp->data);
             *pProp = savedProp;
             return rc;
         }
@@ -368,7 +593,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
 int
 DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     int rc;
 
     rc = dixLookupProperty(&pProp, pWin, propName, client, DixDestroyAccess);
@@ -376,21 +601,9 @@ DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
         return Success;         /* Succeed if property does not exist */
 
     if (rc == Success) {
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
-
+        UnlinkProperty(pWin, pProp);
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
-        free(pProp->data);
+        FreePropertyData(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
     }
     return rc;
@@ -405,11 +618,12 @@ DeleteAllWindowProperties(WindowPtr pWin)
     while (pProp) {
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
         pNextProp = pProp->next;
-        free(pProp->data);
+        FreePropertyData(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
         pProp = pNextProp;
     }
 
+    FreePropertyIndex(pWin);
     if (pWin->optional)
         pWin->optional->userProps = NULL;
 }
@@ -442,7 +656,7 @@ NullPropertyReply(ClientPtr client, ATOM propertyType, int format)
 int
 ProcGetProperty(ClientPtr client)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     unsigned long n, len, ind;
     int rc;
     WindowPtr pWin;
@@ -526,37 +740,28 @@ ProcGetProperty(ClientPtr client)
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
 
     WriteReplyToClient(client, sizeof(xGenericReply), &reply);
-    if (len) {
+    if (len && client->swapped && reply.format != 8) {
         switch (reply.format) {
         case 32:
             client->pSwapReplyFunc = (ReplySwapPtr) CopySwap32Write;
             break;
-        case 16:
-            client->pSwapReplyFunc = (ReplySwapPtr) CopySwap16Write;
-            break;
         default:
-            client->pSwapReplyFunc = (ReplySwapPtr) WriteToClient;
+            client->pSwapReplyFunc = (ReplySwapPtr) CopySwap16Write;
             break;
         }
         WriteSwappedDataToClient(client, len, (char *) pProp->data + ind);
     }
+    else if (len) {
+        /* the reply may go out after the property has changed or gone */
+        PropertyDataBlock(pProp->data)->refcnt++;
+        WriteToClientBuffer(client, len, (char *) pProp->data + ind,
+                            FreePropertyData, pProp->data);
+    }
 
     if (stuff->delete && (reply.bytesAfter == 0)) {
         /* Delete the Property */
-        if (pWin->optional->userProps == pProp) {
-            /* Takes care of head */
-            if (!(pWin->optional->userProps = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->optional->userProps;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
-
-        free(pProp->data);
+        UnlinkProperty(pWin, pProp);
+        FreePropertyData(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
     }
     return Success;
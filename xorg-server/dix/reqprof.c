@@ -0,0 +1,390 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Per-client request profiling.
+ *
+ * Each client being profiled gets a small open-addressed table keyed by
+ * major and minor opcode.  An entry counts the requests, sums their time
+ * and keeps a log-linear histogram of it, four buckets per power of two,
+ * from which the percentiles are read.  Times are taken from the CPU
+ * time stamp counter where there is one and converted to nanoseconds
+ * against GetTimeInMicros over the whole profiling run.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAVE_TSC
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include <X11/X.h>
+#include "misc.h"
+#include "os.h"
+#include "dixstruct.h"
+#include "client.h"
+#include "registry.h"
+#include "reqprof.h"
+
+Bool RequestProfiling;
+Bool RequestProfileAtStart;
+volatile sig_atomic_t RequestProfileToggle;
+
+#define PROFILE_SUB_BITS 2
+#define PROFILE_SUB (1 << PROFILE_SUB_BITS)
+#define PROFILE_BUCKETS (48 * PROFILE_SUB)
+
+/* opcodes listed per client in the log */
+#define PROFILE_REPORT_MAX 20
+
+typedef struct _RequestProfile {
+    CARD32 key;                 /* major << 16 | minor, 0 if unused */
+    CARD32 hist[PROFILE_BUCKETS];
+    CARD64 count;
+    CARD64 ticks;
+} RequestProfileRec, *RequestProfilePtr;
+
+typedef struct _ClientProfile {
+    int index;
+    Bool gone;                  /* the client has disconnected */
+    char name[64];
+    unsigned int mask;
+    unsigned int used;
+    RequestProfilePtr entries;
+} ClientProfileRec, *ClientProfilePtr;
+
+static ClientProfilePtr profiles[MAXCLIENTS];
+static CARD64 startTicks;
+static CARD64 startMicros;
+
+static inline CARD64
+ReadTicks(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return GetTimeInMicros() * 1000;
+#endif
+}
+
+static double
+NanosecondsPerTick(void)
+{
+#ifdef HAVE_TSC
+    CARD64 ticks = ReadTicks() - startTicks;
+    CARD64 micros = GetTimeInMicros() - startMicros;
+
+    if (!ticks || !micros)
+        return 1.0;
+    return micros * 1000.0 / ticks;
+#else
+    return 1.0;
+#endif
+}
+
+static int
+ProfileBucket(CARD64 ticks)
+{
+    int e, b;
+
+    if (ticks < 2 * PROFILE_SUB)
+        return ticks;
+#if defined(__GNUC__)
+    e = 63 - __builtin_clzll(ticks);
+#else
+    for (e = 0; ticks >> (e + 1); e++);
+#endif
+    b = (e - PROFILE_SUB_BITS + 1) * PROFILE_SUB +
+        ((ticks >> (e - PROFILE_SUB_BITS)) & (PROFILE_SUB - 1));
+    return min(b, PROFILE_BUCKETS - 1);
+}
+
+/* The middle of the range of times counted in bucket b. */
+static double
+ProfileBucketTicks(int b)
+{
+    int e, sub;
+
+    if (b < 2 * PROFILE_SUB)
+        return b;
+    e = b / PROFILE_SUB + PROFILE_SUB_BITS - 1;
+    sub = b % PROFILE_SUB;
+    return (double) ((CARD64) (PROFILE_SUB + sub) << (e - PROFILE_SUB_BITS)) +
+        ((CARD64) 1 << (e - PROFILE_SUB_BITS)) / 2.0;
+}
+
+static double
+ProfilePercentile(const CARD32 *hist, CARD64 count, int percent)
+{
+    CARD64 target = (count * percent + 99) / 100;
+    CARD64 seen = 0;
+    int b;
+
+    for (b = 0; b < PROFILE_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= target && seen)
+            return ProfileBucketTicks(b);
+    }
+    return 0;
+}
+
+static void
+FreeClientProfile(ClientProfilePtr cp)
+{
+    if (!cp)
+        return;
+    profiles[cp->index] = NULL;
+    free(cp->entries);
+    free(cp);
+}
+
+static Bool
+GrowClientProfile(ClientProfilePtr cp)
+{
+    unsigned int size = cp->entries ? 2 * (cp->mask + 1) : 16;
+    RequestProfilePtr entries, old = cp->entries;
+    unsigned int i, j;
+
+    entries = calloc(size, sizeof(RequestProfileRec));
+    if (!entries)
+        return FALSE;
+
+    for (i = 0; old && i <= cp->mask; i++) {
+        if (!old[i].key)
+            continue;
+        for (j = (old[i].key * 0x9E3779B1U) & (size - 1); entries[j].key;
+             j = (j + 1) & (size - 1));
+        entries[j] = old[i];
+    }
+    free(old);
+    cp->entries = entries;
+    cp->mask = size - 1;
+    return TRUE;
+}
+
+static RequestProfilePtr
+FindRequestProfile(ClientProfilePtr cp, CARD32 key)
+{
+    RequestProfilePtr entry;
+    unsigned int i;
+
+    if (4 * (cp->used + 1) > 3 * (cp->mask + 1) && !GrowClientProfile(cp))
+        return NULL;
+
+    for (i = (key * 0x9E3779B1U) & cp->mask;; i = (i + 1) & cp->mask) {
+        entry = &cp->entries[i];
+        if (entry->key == key)
+            return entry;
+        if (!entry->key) {
+            entry->key = key;
+            cp->used++;
+            return entry;
+        }
+    }
+}
+
+static int
+CompareProfileTime(const void *a, const void *b)
+{
+    const RequestProfileRec *pa = *(RequestProfilePtr const *) a;
+    const RequestProfileRec *pb = *(RequestProfilePtr const *) b;
+
+    return (pa->ticks < pb->ticks) - (pa->ticks > pb->ticks);
+}
+
+static void
+ReportClientProfile(ClientProfilePtr cp, double nsPerTick)
+{
+    RequestProfilePtr *sorted;
+    CARD64 count = 0, ticks = 0;
+    unsigned int i, n = 0;
+
+    sorted = calloc(cp->used, sizeof(RequestProfilePtr));
+    if (!sorted)
+        return;
+    for (i = 0; cp->entries && i <= cp->mask; i++) {
+        if (!cp->entries[i].key)
+            continue;
+        sorted[n++] = &cp->entries[i];
+        count += cp->entries[i].count;
+        ticks += cp->entries[i].ticks;
+    }
+    qsort(sorted, n, sizeof(RequestProfilePtr), CompareProfileTime);
+
+    LogMessageVerb(X_INFO, 0,
+                   "Request profile for client %d (%s)%s: %llu requests, "
+                   "%.3f ms\n", cp->index, cp->name,
+                   cp->gone ? ", disconnected" : "",
+                   (unsigned long long) count, ticks * nsPerTick / 1e6);
+
+    if (!cp->gone && clients[cp->index]) {
+        ClientIOStatsRec io;
+
+        GetClientIOStats(clients[cp->index], &io);
+        LogMessageVerb(X_NONE, 0,
+                       "    read %llu bytes in %llu calls, wrote %llu bytes "
+                       "in %llu calls, buffers %d + %d bytes\n",
+                       (unsigned long long) io.bytesRead,
+                       (unsigned long long) io.reads,
+                       (unsigned long long) io.bytesWritten,
+                       (unsigned long long) io.writes,
+                       io.inputBufferSize, io.outputBufferSize);
+    }
+
+    for (i = 0; i < n && i < PROFILE_REPORT_MAX; i++) {
+        RequestProfilePtr entry = sorted[i];
+        int major = entry->key >> 16, minor = entry->key & 0xffff;
+
+        LogMessageVerb(X_NONE, 0,
+                       "    %-36s %3d.%-3d %10llu calls %11.3f ms  "
+                       "p50 %9.1f us  p99 %9.1f us\n",
+                       LookupRequestName(major, minor), major, minor,
+                       (unsigned long long) entry->count,
+                       entry->ticks * nsPerTick / 1e6,
+                       ProfilePercentile(entry->hist, entry->count, 50) *
+                       nsPerTick / 1e3,
+                       ProfilePercentile(entry->hist, entry->count, 99) *
+                       nsPerTick / 1e3);
+    }
+    free(sorted);
+}
+
+static ClientProfilePtr
+NewClientProfile(ClientPtr client)
+{
+    ClientProfilePtr cp;
+    const char *name = GetClientCmdName(client);
+
+    cp = calloc(1, sizeof(ClientProfileRec));
+    if (!cp)
+        return NULL;
+    if (!GrowClientProfile(cp)) {
+        free(cp);
+        return NULL;
+    }
+    cp->index = client->index;
+    snprintf(cp->name, sizeof(cp->name), "%s", name ? name : "unknown");
+    profiles[client->index] = cp;
+    return cp;
+}
+
+static void
+ProfileClientState(CallbackListPtr *list, void *closure, void *data)
+{
+    NewClientInfoRec *clientinfo = (NewClientInfoRec *) data;
+    ClientPtr client = clientinfo->client;
+
+    if (client->clientState == ClientStateGone && profiles[client->index])
+        profiles[client->index]->gone = TRUE;
+}
+
+static void
+StartRequestProfile(void)
+{
+    startTicks = ReadTicks();
+    startMicros = GetTimeInMicros();
+    AddCallback(&ClientStateCallback, ProfileClientState, NULL);
+    RequestProfiling = TRUE;
+    LogMessageVerb(X_INFO, 0, "Request profiling started\n");
+}
+
+static void
+StopRequestProfile(void)
+{
+    double nsPerTick = NanosecondsPerTick();
+    int i;
+
+    RequestProfiling = FALSE;
+    DeleteCallback(&ClientStateCallback, ProfileClientState, NULL);
+    LogMessageVerb(X_INFO, 0, "Request profiling stopped after %.1f s\n",
+                   (GetTimeInMicros() - startMicros) / 1e6);
+    for (i = 0; i < MAXCLIENTS; i++) {
+        if (profiles[i]) {
+            ReportClientProfile(profiles[i], nsPerTick);
+            FreeClientProfile(profiles[i]);
+        }
+    }
+}
+
+void
+InitRequestProfile(void)
+{
+    if (RequestProfileAtStart && !RequestProfiling)
+        StartRequestProfile();
+}
+
+void
+ToggleRequestProfile(void)
+{
+    RequestProfileToggle = FALSE;
+    if (RequestProfiling)
+        StopRequestProfile();
+    else
+        StartRequestProfile();
+}
+
+void
+FinishRequestProfile(void)
+{
+    if (RequestProfiling)
+        StopRequestProfile();
+}
+
+CARD64
+RequestProfileStart(void)
+{
+    return ReadTicks();
+}
+
+void
+RequestProfileDone(ClientPtr client, CARD64 start)
+{
+    CARD64 ticks = ReadTicks() - start;
+    ClientProfilePtr cp = profiles[client->index];
+    RequestProfilePtr entry;
+
+    if (cp && cp->gone && !client->clientGone) {
+        /* the slot has a new client; report the old one now */
+        ReportClientProfile(cp, NanosecondsPerTick());
+        FreeClientProfile(cp);
+        cp = NULL;
+    }
+    if (!cp && !(cp = NewClientProfile(client)))
+        return;
+
+    entry = FindRequestProfile(cp, client->majorOp << 16 | client->minorOp);
+    if (!entry)
+        return;
+    entry->count++;
+    entry->ticks += ticks;
+    entry->hist[ProfileBucket(ticks)]++;
+}
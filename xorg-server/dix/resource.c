@@ -149,31 +149,76 @@ Equipment Corporation.
 #define TypeNameString(t) LookupResourceName(t)
 #endif
 
-static void RebuildTable(int    /*client */
-    );
-
 #define SERVER_MINID 32
 
 #define INITBUCKETS 64
 #define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+
+/*
+ * Each client's resources live in a flat, open-addressed table probed
+ * linearly from the hash of the XID.  The id, type and value are stored
+ * inline, so a lookup touches a single cache line in the common case
+ * instead of chasing a malloc'd node per resource.
+ *
+ * Several resources may share an XID (with different types).  Entries
+ * with the same XID are kept in probe order newest first, which is the
+ * order the old chained buckets returned and freed them in.
+ *
+ * Freed slots become tombstones so that iterators are never disturbed
+ * by deletions.  When the table gets too full a new one is allocated
+ * and entries are migrated over a few at a time on subsequent adds and
+ * frees, so growing never stalls the server on a full rehash.  While
+ * migrating, all entries with a given XID are kept in the same table.
+ */
+
+/* No resource ever uses these ids: the server client starts at SERVER_MINID */
+#define RESOURCE_SLOT_EMPTY     ((XID)0)
+#define RESOURCE_SLOT_DELETED   ((XID)1)
+
+#define SlotInUse(res)  ((res)->id > RESOURCE_SLOT_DELETED)
+
+/* maximum load (live + deleted slots) before the table is resized */
+#define TableFull(t)    ((t)->used * 8 >= (t)->size * 5)
+
+/* minimum number of old slots migrated per add/free while resizing */
+#define MIGRATE_STEP 16
 
 typedef struct _Resource {
-    struct _Resource *next;
     XID id;
     RESTYPE type;
     void *value;
 } ResourceRec, *ResourcePtr;
 
+typedef struct _ResourceTable {
+    ResourcePtr slots;
+    int size;                   /* power of two */
+    int hashsize;               /* log(2)(size) */
+    int used;                   /* live and deleted slots */
+} ResourceTableRec, *ResourceTablePtr;
+
 typedef struct _ClientResource {
-    ResourcePtr *resources;
+    ResourceTableRec table;     /* new resources are added here */
+    ResourceTableRec old;       /* being migrated into table */
+    int migrate;                /* next slot of old to migrate */
+    int migrateStep;
     int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
+    unsigned int generation;    /* bumped whenever a resize starts */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
 
+typedef enum {
+    MatchAnyType,
+    MatchType,
+    MatchClass
+} ResourceMatch;
+
+typedef struct _ResourceIter {
+    ResourceTablePtr table;
+    int index;
+    unsigned int generation;
+} ResourceIterRec;
+
 RESTYPE lastResourceType;
 static RESTYPE lastResourceClass;
 RESTYPE TypeMask;
@@ -623,6 +668,233 @@ ResourceClientBits(void)
     return (ilog2(LimitClients));
 }
 
+static _X_INLINE unsigned int
+ResourceSlot(XID id, int hashsize)
+{
+    /* Fibonacci hashing spreads the mostly sequential client ids */
+    return ((uint32_t) id * 0x9E3779B1U) >> (32 - hashsize);
+}
+
+static _X_INLINE Bool
+MatchResource(ResourcePtr res, ResourceMatch match, RESTYPE type)
+{
+    switch (match) {
+    case MatchType:
+        return res->type == type;
+    case MatchClass:
+        return (res->type & type) != 0;
+    default:
+        return TRUE;
+    }
+}
+
+/* Return the first (newest) matching entry for id in t. */
+static _X_INLINE ResourcePtr
+ProbeTable(ResourceTablePtr t, XID id, ResourceMatch match, RESTYPE type)
+{
+    unsigned int mask = t->size - 1;
+    unsigned int i;
+    ResourcePtr res;
+
+    if (!t->slots)
+        return NULL;
+    for (i = ResourceSlot(id, t->hashsize);; i = (i + 1) & mask) {
+        res = &t->slots[i];
+        if (res->id == id) {
+            if (MatchResource(res, match, type))
+                return res;
+        }
+        else if (res->id == RESOURCE_SLOT_EMPTY)
+            return NULL;
+    }
+}
+
+static _X_INLINE ResourcePtr
+LookupSlot(ClientResourceRec *rrec, XID id, ResourceMatch match, RESTYPE type)
+{
+    ResourcePtr res;
+
+    if (id <= RESOURCE_SLOT_DELETED)
+        return NULL;
+    res = ProbeTable(&rrec->table, id, match, type);
+    if (!res && rrec->old.slots)
+        res = ProbeTable(&rrec->old, id, match, type);
+    return res;
+}
+
+/*
+ * Store a resource in t, in front of any others with the same id unless
+ * append is set.  The caller makes sure there is room.
+ */
+static void
+InsertSlot(ResourceTablePtr t, XID id, RESTYPE type, void *value, Bool append)
+{
+    unsigned int mask = t->size - 1;
+    unsigned int i, first = 0, hole = 0;
+    Bool found = FALSE, haveHole = FALSE;
+    ResourceRec carry, tmp;
+
+    for (i = ResourceSlot(id, t->hashsize);; i = (i + 1) & mask) {
+        ResourcePtr res = &t->slots[i];
+
+        if (!append && res->id == id) {
+            /* the new entry has to go after the last one of these */
+            if (!found)
+                first = i;
+            found = TRUE;
+            haveHole = FALSE;
+        }
+        else if (res->id == RESOURCE_SLOT_DELETED) {
+            if (!haveHole)
+                hole = i;
+            haveHole = TRUE;
+            if (!found)
+                break;
+        }
+        else if (res->id == RESOURCE_SLOT_EMPTY) {
+            if (!haveHole)
+                hole = i;
+            break;
+        }
+    }
+
+    if (t->slots[hole].id == RESOURCE_SLOT_EMPTY)
+        t->used++;
+
+    carry.id = id;
+    carry.type = type;
+    carry.value = value;
+    if (found) {
+        /* rotate the older entries back so the new one comes first */
+        for (i = first; i != hole; i = (i + 1) & mask) {
+            if (t->slots[i].id == id) {
+                tmp = t->slots[i];
+                t->slots[i] = carry;
+                carry = tmp;
+            }
+        }
+    }
+    t->slots[hole] = carry;
+}
+
+static void
+RemoveSlot(ClientResourceRec *rrec, ResourcePtr res)
+{
+    ResourceTablePtr t = &rrec->table;
+    unsigned int mask, i;
+
+    if (res < t->slots || res >= t->slots + t->size)
+        t = &rrec->old;
+    mask = t->size - 1;
+    i = res - t->slots;
+
+    res->id = RESOURCE_SLOT_DELETED;
+    res->type = RT_NONE;
+    res->value = NULL;
+
+    /* a run of deleted slots followed by an empty one can be emptied */
+    if (t->slots[(i + 1) & mask].id != RESOURCE_SLOT_EMPTY)
+        return;
+    while (t->slots[i].id == RESOURCE_SLOT_DELETED) {
+        t->slots[i].id = RESOURCE_SLOT_EMPTY;
+        t->used--;
+        i = (i - 1) & mask;
+    }
+}
+
+/* Move every entry for id from the old table, keeping their order. */
+static void
+MigrateID(ClientResourceRec *rrec, XID id)
+{
+    ResourcePtr res;
+
+    while ((res = ProbeTable(&rrec->old, id, MatchAnyType, RT_NONE))) {
+        InsertSlot(&rrec->table, res->id, res->type, res->value, TRUE);
+        RemoveSlot(rrec, res);
+    }
+}
+
+static void
+MigrateResources(ClientResourceRec *rrec, int count)
+{
+    ResourceTablePtr old = &rrec->old;
+    ResourcePtr res;
+
+    while (old->slots && count-- > 0) {
+        res = &old->slots[rrec->migrate];
+        if (SlotInUse(res))
+            MigrateID(rrec, res->id);
+        if (++rrec->migrate == old->size) {
+            free(old->slots);
+            memset(old, 0, sizeof(*old));
+        }
+    }
+}
+
+static Bool
+StartResize(ClientResourceRec *rrec)
+{
+    ResourceTableRec t;
+    int headroom;
+
+    t.hashsize = INITHASHSIZE;
+    while ((1 << t.hashsize) < 2 * (rrec->elements + 1))
+        t.hashsize++;
+    t.size = 1 << t.hashsize;
+    t.used = 0;
+    t.slots = calloc(t.size, sizeof(ResourceRec));
+    if (!t.slots)
+        return FALSE;
+
+    rrec->old = rrec->table;
+    rrec->table = t;
+    rrec->migrate = 0;
+    /* pace the migration so it is done long before the new table fills */
+    headroom = t.size * 5 / 8 - rrec->elements;
+    rrec->migrateStep = max(MIGRATE_STEP, rrec->old.size / max(headroom / 2, 1));
+    rrec->generation++;
+    return TRUE;
+}
+
+static void
+InitResourceIter(ClientResourceRec *rrec, ResourceIterRec *iter)
+{
+    iter->table = rrec->old.slots ? &rrec->old : &rrec->table;
+    iter->index = 0;
+    iter->generation = rrec->generation;
+}
+
+/*
+ * Return the next live entry, walking the old table before the current
+ * one.  Deletions leave tombstones and migration only moves entries from
+ * the old table to the current one, so nothing is skipped; if a new
+ * resize starts behind our back the walk starts over.
+ */
+static ResourcePtr
+NextResource(ClientResourceRec *rrec, ResourceIterRec *iter)
+{
+    ResourcePtr res;
+
+    for (;;) {
+        if (iter->generation != rrec->generation)
+            InitResourceIter(rrec, iter);
+        else if (iter->table == &rrec->old && !rrec->old.slots) {
+            iter->table = &rrec->table;
+            iter->index = 0;
+        }
+        if (iter->index >= iter->table->size) {
+            if (iter->table == &rrec->table)
+                return NULL;
+            iter->table = &rrec->table;
+            iter->index = 0;
+            continue;
+        }
+        res = &iter->table->slots[iter->index++];
+        if (SlotInUse(res))
+            return res;
+    }
+}
+
 /*****************
  * InitClientResources
  *    When a new client is created, call this to allocate space
@@ -632,7 +904,7 @@ ResourceClientBits(void)
 Bool
 InitClientResources(ClientPtr client)
 {
-    int i, j;
+    ClientResourceRec *rrec;
 
     if (client == serverClient) {
         lastResourceType = RT_LASTPREDEF;
@@ -644,24 +916,23 @@ InitClientResources(ClientPtr client)
             return FALSE;
         memcpy(resourceTypes, predefTypes, sizeof(predefTypes));
     }
-    clientTable[i = client->index].resources =
-        malloc(INITBUCKETS * sizeof(ResourcePtr));
-    if (!clientTable[i].resources)
+    rrec = &clientTable[client->index];
+    rrec->table.slots = calloc(INITBUCKETS, sizeof(ResourceRec));
+    if (!rrec->table.slots)
         return FALSE;
-    clientTable[i].buckets = INITBUCKETS;
-    clientTable[i].elements = 0;
-    clientTable[i].hashsize = INITHASHSIZE;
+    rrec->table.size = INITBUCKETS;
+    rrec->table.hashsize = INITHASHSIZE;
+    rrec->table.used = 0;
+    memset(&rrec->old, 0, sizeof(rrec->old));
+    rrec->elements = 0;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
      * clients, we can start from zero, with SERVER_BIT set.
      */
-    clientTable[i].fakeID = client->clientAsMask |
+    rrec->fakeID = client->clientAsMask |
         (client->index ? SERVER_BIT : SERVER_MINID);
-    clientTable[i].endFakeID = (clientTable[i].fakeID | RESOURCE_ID_MASK) + 1;
-    for (j = 0; j < INITBUCKETS; j++) {
-        clientTable[i].resources[j] = NULL;
-    }
+    rrec->endFakeID = (rrec->fakeID | RESOURCE_ID_MASK) + 1;
     return TRUE;
 }
 
@@ -681,15 +952,10 @@ HashResourceID(XID id, int numBits)
 static XID
 AvailableID(int client, XID id, XID maxid, XID goodid)
 {
-    ResourcePtr res;
-
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
+        if (!LookupSlot(&clientTable[client], id, MatchAnyType, RT_NONE))
             return id;
     }
     return 0;
@@ -699,9 +965,8 @@ void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
     XID id, maxid;
-    ResourcePtr *resp;
+    ResourceIterRec iter;
     ResourcePtr res;
-    int i;
     XID goodid;
 
     id = (Mask) client << CLIENTOFFSET;
@@ -709,18 +974,16 @@ GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
         id |= client ? SERVER_BIT : SERVER_MINID;
     maxid = id | RESOURCE_ID_MASK;
     goodid = 0;
-    for (resp = clientTable[client].resources, i = clientTable[client].buckets;
-         --i >= 0;) {
-        for (res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
-        }
+    InitResourceIter(&clientTable[client], &iter);
+    while ((res = NextResource(&clientTable[client], &iter))) {
+        if ((res->id < id) || (res->id > maxid))
+            continue;
+        if (((res->id - id) >= (maxid - res->id)) ?
+            (goodid = AvailableID(client, id, res->id - 1, goodid)) :
+            !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
+            maxid = res->id - 1;
+        else
+            id = res->id + 1;
     }
     if (id > maxid)
         id = maxid = 0;
@@ -798,77 +1061,45 @@ AddResource(XID id, RESTYPE type, void *value)
 {
     int client;
     ClientResourceRec *rrec;
-    ResourcePtr res, *head;
+    ResourceRec res;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
 #endif
     client = CLIENT_ID(id);
     rrec = &clientTable[client];
-    if (!rrec->buckets) {
+    if (!rrec->table.slots) {
         ErrorF("[dix] AddResource(%lx, %x, %lx), client=%d \n",
                (unsigned long) id, type, (unsigned long)(uintptr_t) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
-        RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
-    res = malloc(sizeof(ResourceRec));
-    if (!res) {
+    if (id <= RESOURCE_SLOT_DELETED) {
+        ErrorF("[dix] AddResource(%lx, %x): invalid resource id\n",
+               (unsigned long) id, type);
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
         return FALSE;
     }
-    res->next = *head;
-    res->id = id;
-    res->type = type;
-    res->value = value;
-    *head = res;
-    rrec->elements++;
-    CallResourceStateCallback(ResourceStateAdding, res);
-    return TRUE;
-}
-
-static void
-RebuildTable(int client)
-{
-    int j;
-    ResourcePtr res, next;
-    ResourcePtr **tails, *resources;
-    ResourcePtr **tptr, *rptr;
-
-    /*
-     * For now, preserve insertion order, since some ddx layers depend
-     * on resources being free in the opposite order they are added.
-     */
-
-    j = 2 * clientTable[client].buckets;
-    tails =  xallocarray(j, sizeof(ResourcePtr *));
-    if (!tails)
-        return;
-    resources =  xallocarray(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
-        return;
-    }
-    for (rptr = resources, tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
-    }
-    clientTable[client].hashsize++;
-    for (j = clientTable[client].buckets,
-         rptr = clientTable[client].resources; --j >= 0; rptr++) {
-        for (res = *rptr; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
+    if (rrec->old.slots)
+        MigrateResources(rrec, rrec->migrateStep);
+    if (TableFull(&rrec->table)) {
+        if (rrec->old.slots)
+            MigrateResources(rrec, rrec->old.size);
+        /* keep going in the current table as long as there is room */
+        if (!StartResize(rrec) && rrec->table.used >= rrec->table.size - 1) {
+            (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
+            return FALSE;
         }
     }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
+    if (rrec->old.slots)
+        MigrateID(rrec, id);
+    InsertSlot(&rrec->table, id, type, value, FALSE);
+    rrec->elements++;
+
+    res.id = id;
+    res.type = type;
+    res.value = value;
+    CallResourceStateCallback(ResourceStateAdding, &res);
+    return TRUE;
 }
 
 static void
@@ -878,42 +1109,33 @@ doFreeResource(ResourcePtr res, Bool skip)
 
     if (!skip)
         resourceTypes[res->type & TypeMask].deleteFunc(res->value, res->id);
-
-    free(res);
 }
 
 void
 FreeResource(XID id, RESTYPE skipDeleteFuncType)
 {
     int cid;
-    ResourcePtr res;
-    ResourcePtr *prev, *head;
-    int *eltptr;
-    int elements;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-        eltptr = &clientTable[cid].elements;
+    ClientResourceRec *rrec;
+    ResourcePtr this;
+    ResourceRec res;
 
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id) {
-                RESTYPE rtype = res->type;
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        rrec = &clientTable[cid];
+        if (rrec->old.slots)
+            MigrateResources(rrec, rrec->migrateStep);
 
+        /* delete functions may free other resources, so probe again
+         * after each one */
+        while ((this = LookupSlot(rrec, id, MatchAnyType, RT_NONE))) {
+            res = *this;
 #ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
+            XSERVER_RESOURCE_FREE(res.id, res.type,
+                                  res.value, TypeNameString(res.type));
 #endif
-                *prev = res->next;
-                elements = --*eltptr;
-
-                doFreeResource(res, rtype == skipDeleteFuncType);
+            RemoveSlot(rrec, this);
+            rrec->elements--;
 
-                if (*eltptr != elements)
-                    prev = head;        /* prev may no longer be valid */
-            }
-            else
-                prev = &res->next;
+            doFreeResource(&res, res.type == skipDeleteFuncType);
         }
     }
 }
@@ -922,28 +1144,23 @@ void
 FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
 {
     int cid;
-    ResourcePtr res;
-    ResourcePtr *prev, *head;
-
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
+    ClientResourceRec *rrec;
+    ResourcePtr this;
+    ResourceRec res;
 
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id && res->type == type) {
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        rrec = &clientTable[cid];
+        this = LookupSlot(rrec, id, MatchType, type);
+        if (this) {
+            res = *this;
 #ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
+            XSERVER_RESOURCE_FREE(res.id, res.type,
+                                  res.value, TypeNameString(res.type));
 #endif
-                *prev = res->next;
-                clientTable[cid].elements--;
+            RemoveSlot(rrec, this);
+            rrec->elements--;
 
-                doFreeResource(res, skipFree);
-
-                break;
-            }
-            else
-                prev = &res->next;
+            doFreeResource(&res, skipFree);
         }
     }
 }
@@ -960,48 +1177,37 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
     int cid;
     ResourcePtr res;
 
-    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if ((res->id == id) && (res->type == rtype)) {
-                res->value = value;
-                return TRUE;
-            }
+    if (((cid = CLIENT_ID(id)) < LimitClients) && clientTable[cid].table.slots) {
+        res = LookupSlot(&clientTable[cid], id, MatchType, rtype);
+        if (res) {
+            res->value = value;
+            return TRUE;
+        }
     }
     return FALSE;
 }
 
 /* Note: if func adds or deletes resources, then func can get called
  * more than once for some resources.  If func adds new resources,
- * func might or might not get called for them.  func cannot both
- * add and delete an equal number of resources!
+ * func might or might not get called for them.
  */
 
 void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
+    ResourcePtr this;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                elements = *eltptr;
-                (*func) (this->value, this->id, cdata);
-                if (*eltptr != elements)
-                    next = resources[i];        /* start over */
-            }
-        }
+    rrec = &clientTable[client->index];
+    InitResourceIter(rrec, &iter);
+    while ((this = NextResource(rrec, &iter))) {
+        if (!type || this->type == type)
+            (*func) (this->value, this->id, cdata);
     }
 }
 
@@ -1017,25 +1223,17 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
-    int i, elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
+    ResourcePtr this;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            elements = *eltptr;
-            (*func) (this->value, this->id, this->type, cdata);
-            if (*eltptr != elements)
-                next = resources[i];    /* start over */
-        }
-    }
+    rrec = &clientTable[client->index];
+    InitResourceIter(rrec, &iter);
+    while ((this = NextResource(rrec, &iter)))
+        (*func) (this->value, this->id, this->type, cdata);
 }
 
 void *
@@ -1043,24 +1241,22 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    ResourcePtr this, next;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
+    ResourcePtr this;
     void *value;
-    int i;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (i = 0; i < clientTable[client->index].buckets; i++) {
-        for (this = resources[i]; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                /* workaround func freeing the type as DRI1 does */
-                value = this->value;
-                if ((*func) (value, this->id, cdata))
-                    return value;
-            }
+    rrec = &clientTable[client->index];
+    InitResourceIter(rrec, &iter);
+    while ((this = NextResource(rrec, &iter))) {
+        if (!type || this->type == type) {
+            /* workaround func freeing the type as DRI1 does */
+            value = this->value;
+            if ((*func) (value, this->id, cdata))
+                return value;
         }
     }
     return NULL;
@@ -1069,38 +1265,33 @@ LookupClientResourceComplex(ClientPtr client,
 void
 FreeClientNeverRetainResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
     ResourcePtr this;
-    ResourcePtr *prev;
-    int j, elements;
-    int *eltptr;
+    ResourceRec res;
+    XID id;
 
     if (!client)
         return;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        prev = &resources[j];
-        while ((this = *prev)) {
-            RESTYPE rtype = this->type;
+    rrec = &clientTable[client->index];
+    InitResourceIter(rrec, &iter);
+    while ((this = NextResource(rrec, &iter))) {
+        if (!(this->type & RC_NEVERRETAIN))
+            continue;
 
-            if (rtype & RC_NEVERRETAIN) {
+        /* free all of them for this id, newest first */
+        id = this->id;
+        while ((this = LookupSlot(rrec, id, MatchClass, RC_NEVERRETAIN))) {
+            res = *this;
 #ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(this->id, this->type,
-                                      this->value, TypeNameString(this->type));
+            XSERVER_RESOURCE_FREE(res.id, res.type,
+                                  res.value, TypeNameString(res.type));
 #endif
-                *prev = this->next;
-                clientTable[client->index].elements--;
-                elements = *eltptr;
-
-                doFreeResource(this, FALSE);
+            RemoveSlot(rrec, this);
+            rrec->elements--;
 
-                if (*eltptr != elements)
-                    prev = &resources[j];       /* prev may no longer be valid */
-            }
-            else
-                prev = &this->next;
+            doFreeResource(&res, FALSE);
         }
     }
 }
@@ -1108,9 +1299,11 @@ FreeClientNeverRetainResources(ClientPtr client)
 void
 FreeClientResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
     ResourcePtr this;
-    int j;
+    ResourceRec res;
+    XID id;
 
     /* This routine shouldn't be called with a null client, but just in
        case ... */
@@ -1120,35 +1313,33 @@ FreeClientResources(ClientPtr client)
 
     HandleSaveSet(client);
 
-    resources = clientTable[client->index].resources;
-    for (j = 0; j < clientTable[client->index].buckets; j++) {
-        /* It may seem silly to update the head of this resource list as
-           we delete the members, since the entire list will be deleted any way,
-           but there are some resource deletion functions "FreeClientPixels" for
-           one which do a LookupID on another resource id (a Colormap id in this
-           case), so the resource list must be kept valid up to the point that
-           it is deleted, so every time we delete a resource, we must update the
-           head, just like in FreeResource. I hope that this doesn't slow down
-           mass deletion appreciably. PRH */
-
-        ResourcePtr *head;
-
-        head = &resources[j];
-
-        for (this = *head; this; this = *head) {
+    rrec = &clientTable[client->index];
+    InitResourceIter(rrec, &iter);
+    while ((this = NextResource(rrec, &iter))) {
+        /* Some resource deletion functions, "FreeClientPixels" for one,
+           do a LookupID on another resource id (a Colormap id in this
+           case), so the table must be kept valid up to the point that
+           it is deleted.  Each entry is removed before it is freed, and
+           all entries sharing an id are freed newest first, just like in
+           FreeResource. */
+
+        id = this->id;
+        while ((this = LookupSlot(rrec, id, MatchAnyType, RT_NONE))) {
+            res = *this;
 #ifdef XSERVER_DTRACE
-            XSERVER_RESOURCE_FREE(this->id, this->type,
-                                  this->value, TypeNameString(this->type));
+            XSERVER_RESOURCE_FREE(res.id, res.type,
+                                  res.value, TypeNameString(res.type));
 #endif
-            *head = this->next;
-            clientTable[client->index].elements--;
+            RemoveSlot(rrec, this);
+            rrec->elements--;
 
-            doFreeResource(this, FALSE);
+            doFreeResource(&res, FALSE);
         }
     }
-    free(clientTable[client->index].resources);
-    clientTable[client->index].resources = NULL;
-    clientTable[client->index].buckets = 0;
+    free(rrec->table.slots);
+    free(rrec->old.slots);
+    memset(&rrec->table, 0, sizeof(rrec->table));
+    memset(&rrec->old, 0, sizeof(rrec->old));
 }
 
 void
@@ -1157,7 +1348,7 @@ FreeAllResources(void)
     int i;
 
     for (i = currentMaxClients; --i >= 0;) {
-        if (clientTable[i].buckets)
+        if (clientTable[i].table.slots)
             FreeClientResources(clients[i]);
     }
 }
@@ -1193,34 +1384,32 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
 {
     int cid = CLIENT_ID(id);
     ResourcePtr res = NULL;
+    void *value;
 
     *result = NULL;
     if ((rtype & TypeMask) > lastResourceType)
         return BadImplementation;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && res->type == rtype)
-                break;
-    }
+    if ((cid < LimitClients) && clientTable[cid].table.slots)
+        res = LookupSlot(&clientTable[cid], id, MatchType, rtype);
     if (client) {
         client->errorValue = id;
     }
     if (!res)
         return resourceTypes[rtype & TypeMask].errorValue;
 
+    /* the slot may move if the access hook adds resources */
+    value = res->value;
     if (client) {
-        cid = XaceHook(XACE_RESOURCE_ACCESS, client, id, res->type,
-                       res->value, RT_NONE, NULL, mode);
+        cid = XaceHook(XACE_RESOURCE_ACCESS, client, id, rtype,
+                       value, RT_NONE, NULL, mode);
         if (cid == BadValue)
             return resourceTypes[rtype & TypeMask].errorValue;
         if (cid != Success)
             return cid;
     }
 
-    *result = res->value;
+    *result = value;
     return Success;
 }
 
@@ -1230,29 +1419,27 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
 {
     int cid = CLIENT_ID(id);
     ResourcePtr res = NULL;
+    void *value;
 
     *result = NULL;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && (res->type & rclass))
-                break;
-    }
+    if ((cid < LimitClients) && clientTable[cid].table.slots)
+        res = LookupSlot(&clientTable[cid], id, MatchClass, rclass);
     if (client) {
         client->errorValue = id;
     }
     if (!res)
         return BadValue;
 
+    /* the slot may move if the access hook adds resources */
+    value = res->value;
     if (client) {
         cid = XaceHook(XACE_RESOURCE_ACCESS, client, id, res->type,
-                       res->value, RT_NONE, NULL, mode);
+                       value, RT_NONE, NULL, mode);
         if (cid != Success)
             return cid;
     }
 
-    *result = res->value;
+    *result = value;
     return Success;
 }
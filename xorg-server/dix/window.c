@@ -481,6 +481,7 @@ SetWindowToDefaults(WindowPtr pWin)
 
     pWin->valdata = NULL;
     pWin->optional = NULL;
+    pWin->hitIndex = NULL;
     pWin->cursorIsNone = TRUE;
 
     pWin->backingStore = NotUseful;
@@ -597,6 +598,7 @@ CreateRootWindow(ScreenPtr pScreen)
     pWin->optional->otherClients = NULL;
     pWin->optional->passiveGrabs = NULL;
     pWin->optional->userProps = NULL;
+    pWin->optional->propIndex = NULL;
     pWin->optional->backingBitPlanes = ~0L;
     pWin->optional->backingPixel = 0;
     pWin->optional->boundingShape = NULL;
@@ -913,6 +915,7 @@ CreateWindow(Window wid, WindowPtr pParent, int x, int y, unsigned w,
             pParent->lastChild = pWin;
         pParent->firstChild = pWin;
     }
+    WindowHitIndexInvalidate(pParent);
 
     SetWinSize(pWin);
     SetBorderSize(pWin);
@@ -999,6 +1002,7 @@ FreeWindowResources(WindowPtr pWin)
     DeleteWindowFromAnySaveSet(pWin);
     DeleteWindowFromAnySelections(pWin);
     DeleteWindowFromAnyEvents(pWin, TRUE);
+    WindowHitIndexFree(pWin);
     RegionUninit(&pWin->clipList);
     RegionUninit(&pWin->winSize);
     RegionUninit(&pWin->borderClip);
@@ -1098,6 +1102,7 @@ DeleteWindow(void *value, XID wid)
             pWin->nextSib->prevSib = pWin->prevSib;
         if (pWin->prevSib)
             pWin->prevSib->nextSib = pWin->nextSib;
+        WindowHitIndexInvalidate(pParent);
     }
     else
         pWin->drawable.pScreen->root = NULL;
@@ -1690,6 +1695,7 @@ MoveWindowInStack(WindowPtr pWin, WindowPtr pNextSib)
                     pFirstChange = pFirstChange->nextSib;
             }
         }
+        WindowHitIndexInvalidate(pParent);
         if (pWin->drawable.pScreen->RestackWindow)
             (*pWin->drawable.pScreen->RestackWindow) (pWin, pOldNextSib);
     }
@@ -1782,6 +1788,7 @@ SetBorderSize(WindowPtr pWin)
     else {
         RegionCopy(&pWin->borderSize, &pWin->winSize);
     }
+    WindowHitIndexUpdate(pWin);
 }
 
 /**
@@ -2544,6 +2551,7 @@ ReparentWindow(WindowPtr pWin, WindowPtr pParent,
         pWin->nextSib->prevSib = pWin->prevSib;
     if (pWin->prevSib)
         pWin->prevSib->nextSib = pWin->nextSib;
+    WindowHitIndexInvalidate(pPrev);
 
     /* insert at begining of pParent */
     pWin->parent = pParent;
@@ -2566,6 +2574,7 @@ ReparentWindow(WindowPtr pWin, WindowPtr pParent,
             pParent->lastChild = pWin;
         pParent->firstChild = pWin;
     }
+    WindowHitIndexInvalidate(pParent);
 
     pWin->origin.x = x + bw;
     pWin->origin.y = y + bw;
@@ -2673,6 +2682,7 @@ MapWindow(WindowPtr pWin, ClientPtr client)
                 return Success;
 
         pWin->mapped = TRUE;
+        WindowHitIndexUpdate(pWin);
         if (SubStrSend(pWin, pParent))
             DeliverMapNotify(pWin);
 
@@ -2741,6 +2751,7 @@ MapSubwindows(WindowPtr pParent, ClientPtr client)
                     continue;
 
             pWin->mapped = TRUE;
+            WindowHitIndexUpdate(pWin);
             if (parentNotify || StrSend(pWin))
                 DeliverMapNotify(pWin);
 
@@ -2857,6 +2868,7 @@ UnmapWindow(WindowPtr pWin, Bool fromConfigure)
         (*pScreen->MarkWindow) (pLayerWin->parent);
     }
     pWin->mapped = FALSE;
+    WindowHitIndexUpdate(pWin);
     if (wasRealized)
         UnrealizeTree(pWin, fromConfigure);
     if (wasViewable) {
@@ -2908,6 +2920,7 @@ UnmapSubwindows(WindowPtr pWin)
                 anyMarked = TRUE;
             }
             pChild->mapped = FALSE;
+            WindowHitIndexUpdate(pChild);
             if (pChild->realized)
                 UnrealizeTree(pChild, FALSE);
         }
@@ -2970,8 +2983,10 @@ HandleSaveSet(ClientPtr client)
                                pParent->drawable.x,
                                pWin->drawable.y - wBorderWidth(pWin) -
                                pParent->drawable.y, client);
-                if (!pWin->realized && pWin->mapped)
+                if (!pWin->realized && pWin->mapped) {
                     pWin->mapped = FALSE;
+                    WindowHitIndexUpdate(pWin);
+                }
             }
             if (SaveSetShouldMap(client->saveSet[j]))
                 MapWindow(pWin, client);
@@ -3406,6 +3421,7 @@ MakeWindowOptional(WindowPtr pWin)
     optional->otherClients = NULL;
     optional->passiveGrabs = NULL;
     optional->userProps = NULL;
+    optional->propIndex = NULL;
     optional->backingBitPlanes = ~0L;
     optional->backingPixel = 0;
     optional->boundingShape = NULL;
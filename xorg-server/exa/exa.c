@@ -770,6 +770,8 @@ exaCloseScreen(ScreenPtr pScreen)
     unwrap(pExaScr, ps, Composite);
     if (pExaScr->SavedGlyphs)
         unwrap(pExaScr, ps, Glyphs);
+    if (pExaScr->SavedUnrealizeGlyph)
+        unwrap(pExaScr, ps, UnrealizeGlyph);
     unwrap(pExaScr, ps, Trapezoids);
     unwrap(pExaScr, ps, Triangles);
     unwrap(pExaScr, ps, AddTraps);
@@ -928,6 +930,7 @@ exaDriverInit(ScreenPtr pScreen, ExaDriverPtr pScreenInfo)
         wrap(pExaScr, ps, Composite, exaComposite);
         if (pScreenInfo->PrepareComposite) {
             wrap(pExaScr, ps, Glyphs, exaGlyphs);
+            wrap(pExaScr, ps, UnrealizeGlyph, exaUnrealizeGlyph);
         }
         else {
             wrap(pExaScr, ps, Glyphs, ExaCheckGlyphs);
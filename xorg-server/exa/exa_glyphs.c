@@ -252,7 +252,7 @@ exaGlyphCacheHashLookup(ExaGlyphCachePtr cache, GlyphPtr pGlyph)
 {
     int slot;
 
-    slot = (*(CARD32 *) pGlyph->sha1) % cache->hashSize;
+    slot = (*(CARD32 *) pGlyph->hash) % cache->hashSize;
 
     while (TRUE) {              /* hash table can never be full */
         int entryPos = cache->hashEntries[slot];
@@ -260,11 +260,10 @@ exaGlyphCacheHashLookup(ExaGlyphCachePtr cache, GlyphPtr pGlyph)
         if (entryPos == -1)
             return -1;
 
-        if (memcmp
-            (pGlyph->sha1, cache->glyphs[entryPos].sha1,
-             sizeof(pGlyph->sha1)) == 0) {
+        /* The hash only picks the slot; equal content always shares one
+         * GlyphRec, so the pointer is what identifies the glyph. */
+        if (cache->glyphs[entryPos].glyph == pGlyph)
             return entryPos;
-        }
 
         slot--;
         if (slot < 0)
@@ -277,9 +276,10 @@ exaGlyphCacheHashInsert(ExaGlyphCachePtr cache, GlyphPtr pGlyph, int pos)
 {
     int slot;
 
-    memcpy(cache->glyphs[pos].sha1, pGlyph->sha1, sizeof(pGlyph->sha1));
+    memcpy(cache->glyphs[pos].hash, pGlyph->hash, sizeof(pGlyph->hash));
+    cache->glyphs[pos].glyph = pGlyph;
 
-    slot = (*(CARD32 *) pGlyph->sha1) % cache->hashSize;
+    slot = (*(CARD32 *) pGlyph->hash) % cache->hashSize;
 
     while (TRUE) {              /* hash table can never be full */
         if (cache->hashEntries[slot] == -1) {
@@ -299,7 +299,7 @@ exaGlyphCacheHashRemove(ExaGlyphCachePtr cache, int pos)
     int slot;
     int emptiedSlot = -1;
 
-    slot = (*(CARD32 *) cache->glyphs[pos].sha1) % cache->hashSize;
+    slot = (*(CARD32 *) cache->glyphs[pos].hash) % cache->hashSize;
 
     while (TRUE) {              /* hash table can never be full */
         int entryPos = cache->hashEntries[slot];
@@ -329,7 +329,7 @@ exaGlyphCacheHashRemove(ExaGlyphCachePtr cache, int pos)
              */
 
             int entrySlot =
-                (*(CARD32 *) cache->glyphs[entryPos].sha1) % cache->hashSize;
+                (*(CARD32 *) cache->glyphs[entryPos].hash) % cache->hashSize;
 
             if (!((entrySlot >= slot && entrySlot < emptiedSlot) ||
                   (emptiedSlot < slot &&
@@ -346,6 +346,34 @@ exaGlyphCacheHashRemove(ExaGlyphCachePtr cache, int pos)
     }
 }
 
+/* Cache entries are matched by glyph pointer, so they must not outlive
+ * the glyph: a new glyph allocated at the same address would hit them. */
+void
+exaUnrealizeGlyph(ScreenPtr pScreen, GlyphPtr pGlyph)
+{
+    PictureScreenPtr ps = GetPictureScreen(pScreen);
+    ExaScreenPriv(pScreen);
+    int i;
+
+    for (i = 0; i < EXA_NUM_GLYPH_CACHES; i++) {
+        ExaGlyphCachePtr cache = &pExaScr->glyphCaches[i];
+        int pos;
+
+        if (!cache->picture)
+            continue;
+
+        pos = exaGlyphCacheHashLookup(cache, pGlyph);
+        if (pos != -1) {
+            exaGlyphCacheHashRemove(cache, pos);
+            cache->glyphs[pos].glyph = NULL;
+        }
+    }
+
+    swap(pExaScr, ps, UnrealizeGlyph);
+    (*ps->UnrealizeGlyph) (pScreen, pGlyph);
+    swap(pExaScr, ps, UnrealizeGlyph);
+}
+
 #define CACHE_X(pos) (((pos) % cache->columns) * cache->glyphWidth)
 #define CACHE_Y(pos) (cache->yOffset + ((pos) / cache->columns) * cache->glyphHeight)
 
@@ -448,7 +476,7 @@ exaGlyphCacheBufferGlyph(ScreenPtr pScreen,
     DBG_GLYPH_CACHE(("(%d,%d,%s): buffering glyph %lx\n",
                      cache->glyphWidth, cache->glyphHeight,
                      cache->format == PICT_a8 ? "A" : "ARGB",
-                     (long) *(CARD32 *) pGlyph->sha1));
+                     (long) *(CARD32 *) pGlyph->hash));
 
     pos = exaGlyphCacheHashLookup(cache, pGlyph);
     if (pos != -1) {
@@ -0,0 +1,448 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Glyph atlas for fbGlyphs.
+ *
+ * Small a8 and a8r8g8b8 glyphs are copied once into large pages of their
+ * format, packed on shelves of similar height.  Drawing a glyph string
+ * then adds each glyph's rows from its page straight into a mask
+ * covering the whole string, and the string goes to the destination in
+ * a single composite.  The general path makes a pixman image per glyph
+ * and a composite call per glyph.
+ *
+ * When every page of a format is full, the page used longest ago is
+ * emptied; glyphs notice through the page generation kept with their
+ * slot.  Pages used by the string being drawn are never emptied.
+ *
+ * Requests the atlas cannot reproduce exactly fall back to fbGlyphs'
+ * general path: other glyph or mask formats, large glyphs, and drawing
+ * without a mask when glyphs overlap or the operator is not Over or Add.
+ * Without a mask each glyph is composited on its own; with no overlap
+ * and an operator that leaves the destination alone where the mask is
+ * zero, one composite through the combined mask gives the same result.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <string.h>
+
+#include "fb.h"
+
+#include "picturestr.h"
+#include "mipict.h"
+#include "fbpict.h"
+
+#define FB_ATLAS_SIZE       1024        /* page width and height */
+#define FB_ATLAS_PAGES      8           /* pages per format */
+#define FB_ATLAS_GLYPH_MAX  128         /* larger glyphs are not packed */
+#define FB_ATLAS_SHELF_STEP 4           /* shelf heights round up to this */
+#define FB_ATLAS_MASK_MAX   (2048 * 1024)       /* mask pixels per string */
+
+typedef struct _FbAtlasShelf {
+    short y, height;
+    short x;                    /* first free column */
+} FbAtlasShelfRec, *FbAtlasShelfPtr;
+
+typedef struct _FbAtlasPage {
+    pixman_image_t *image;      /* NULL until first used */
+    CARD32 generation;          /* bumped whenever the page is emptied */
+    CARD32 lastUsed;
+    int top;                    /* first row not taken by a shelf */
+    int nshelves;
+    FbAtlasShelfRec shelves[FB_ATLAS_SIZE / FB_ATLAS_SHELF_STEP];
+} FbAtlasPageRec, *FbAtlasPagePtr;
+
+typedef struct _FbAtlas {
+    PictFormatShort format;
+    int cpp;
+    FbAtlasPageRec pages[FB_ATLAS_PAGES];
+} FbAtlasRec, *FbAtlasPtr;
+
+/* Where a glyph lives, kept in the glyph's privates. */
+typedef struct _FbAtlasSlot {
+    FbAtlasPagePtr page;
+    CARD32 generation;
+    short x, y;
+} FbAtlasSlotRec, *FbAtlasSlotPtr;
+
+/* A glyph of the string being drawn, relative to the mask. */
+typedef struct _FbAtlasGlyph {
+    FbAtlasSlotPtr slot;
+    int x, y;
+    int width, height;
+} FbAtlasGlyphRec, *FbAtlasGlyphPtr;
+
+static FbAtlasRec atlases[] = {
+    { PICT_a8, 1 },
+    { PICT_a8r8g8b8, 4 },
+};
+
+static CARD32 atlasClock;
+static CARD8 *atlasMask;
+static size_t atlasMaskSize;
+
+static DevPrivateKeyRec fbAtlasSlotKeyRec;
+
+#define fbAtlasSlot(glyph) ((FbAtlasSlotPtr) \
+    dixGetPrivateAddr(&(glyph)->devPrivates, &fbAtlasSlotKeyRec))
+
+Bool
+fbGlyphAtlasInit(ScreenPtr pScreen)
+{
+    return dixRegisterPrivateKey(&fbAtlasSlotKeyRec, PRIVATE_GLYPH,
+                                 sizeof(FbAtlasSlotRec));
+}
+
+void
+fbDestroyGlyphAtlas(void)
+{
+    int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(atlases); i++) {
+        for (j = 0; j < FB_ATLAS_PAGES; j++) {
+            FbAtlasPagePtr page = &atlases[i].pages[j];
+
+            if (page->image) {
+                free(pixman_image_get_data(page->image));
+                pixman_image_unref(page->image);
+                page->image = NULL;
+            }
+            page->generation++;
+            page->top = page->nshelves = 0;
+        }
+    }
+    free(atlasMask);
+    atlasMask = NULL;
+    atlasMaskSize = 0;
+}
+
+void
+fbGlyphAtlasRemove(GlyphPtr glyph)
+{
+    if (fbAtlasSlotKeyRec.initialized)
+        fbAtlasSlot(glyph)->page = NULL;
+}
+
+static FbAtlasPtr
+fbAtlasForFormat(PictFormatShort format)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(atlases); i++)
+        if (atlases[i].format == format)
+            return &atlases[i];
+    return NULL;
+}
+
+/* Find room for a width x height glyph on a shelf of page. */
+static Bool
+fbAtlasPlace(FbAtlasPagePtr page, int width, int height, short *x, short *y)
+{
+    int shelfHeight = (height + FB_ATLAS_SHELF_STEP - 1) &
+        ~(FB_ATLAS_SHELF_STEP - 1);
+    FbAtlasShelfPtr shelf;
+    int i;
+
+    for (i = 0; i < page->nshelves; i++) {
+        shelf = &page->shelves[i];
+        if (shelf->height == shelfHeight &&
+            shelf->x + width <= FB_ATLAS_SIZE)
+            goto found;
+    }
+    if (page->top + shelfHeight > FB_ATLAS_SIZE)
+        return FALSE;
+    shelf = &page->shelves[page->nshelves++];
+    shelf->y = page->top;
+    shelf->height = shelfHeight;
+    shelf->x = 0;
+    page->top += shelfHeight;
+
+ found:
+    *x = shelf->x;
+    *y = shelf->y;
+    shelf->x += width;
+    return TRUE;
+}
+
+static Bool
+fbAtlasAllocPage(FbAtlasPtr atlas, FbAtlasPagePtr page)
+{
+    int stride = FB_ATLAS_SIZE * atlas->cpp;
+    uint32_t *bits = malloc(stride * FB_ATLAS_SIZE);
+
+    if (!bits)
+        return FALSE;
+    page->image = pixman_image_create_bits((pixman_format_code_t) atlas->format,
+                                           FB_ATLAS_SIZE, FB_ATLAS_SIZE,
+                                           bits, stride);
+    if (!page->image) {
+        free(bits);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Put glyph into the atlas, copying it from its picture.  Fails when
+ * every page is full and in use by the current string.
+ */
+static Bool
+fbAtlasInsert(FbAtlasPtr atlas, GlyphPtr glyph, PicturePtr pPicture,
+              FbAtlasSlotPtr slot)
+{
+    int width = glyph->info.width, height = glyph->info.height;
+    FbAtlasPagePtr page, lru = NULL;
+    pixman_image_t *glyphImage;
+    int xoff, yoff;
+    int i;
+
+    for (i = 0; i < FB_ATLAS_PAGES; i++) {
+        page = &atlas->pages[i];
+        if (!page->image) {
+            if (!fbAtlasAllocPage(atlas, page))
+                return FALSE;
+            if (fbAtlasPlace(page, width, height, &slot->x, &slot->y))
+                goto placed;
+            return FALSE;
+        }
+        if (fbAtlasPlace(page, width, height, &slot->x, &slot->y))
+            goto placed;
+        if (page->lastUsed != atlasClock &&
+            (!lru || page->lastUsed < lru->lastUsed))
+            lru = page;
+    }
+    if (!lru)
+        return FALSE;
+
+    page = lru;
+    page->generation++;
+    page->top = page->nshelves = 0;
+    if (!fbAtlasPlace(page, width, height, &slot->x, &slot->y))
+        return FALSE;
+
+ placed:
+    glyphImage = image_from_pict(pPicture, FALSE, &xoff, &yoff);
+    if (!glyphImage)
+        return FALSE;
+    pixman_image_composite32(PIXMAN_OP_SRC, glyphImage, NULL, page->image,
+                             xoff, yoff, 0, 0, slot->x, slot->y,
+                             width, height);
+    free_pixman_pict(pPicture, glyphImage);
+
+    slot->page = page;
+    slot->generation = page->generation;
+    page->lastUsed = atlasClock;
+    return TRUE;
+}
+
+/* Add a glyph's rows from its page into the mask, saturating. */
+static void
+fbAtlasAddGlyph(CARD8 *mask, int maskStride, int cpp, FbAtlasGlyphPtr g)
+{
+    FbAtlasSlotPtr slot = g->slot;
+    int srcStride = pixman_image_get_stride(slot->page->image);
+    CARD8 *src = (CARD8 *) pixman_image_get_data(slot->page->image) +
+        slot->y * srcStride + slot->x * cpp;
+    CARD8 *dst = mask + g->y * maskStride + g->x * cpp;
+    int bytes = g->width * cpp;
+    int x, y;
+
+    for (y = 0; y < g->height; y++) {
+        for (x = 0; x < bytes; x++) {
+            unsigned v = dst[x] + src[x];
+
+            dst[x] = v > 0xff ? 0xff : v;
+        }
+        src += srcStride;
+        dst += maskStride;
+    }
+}
+
+/*
+ * Draw a glyph string through the atlas.  Returns FALSE, having drawn
+ * nothing, when the string has to take the general path.
+ */
+Bool
+fbGlyphAtlasComposite(CARD8 op,
+                      PicturePtr pSrc,
+                      PicturePtr pDst,
+                      PictFormatPtr maskFormat,
+                      INT16 xSrc,
+                      INT16 ySrc, int nlist, GlyphListPtr list,
+                      GlyphPtr *glyphs)
+{
+#define N_STACK_GLYPHS 512
+    ScreenPtr pScreen = pDst->pDrawable->pScreen;
+    FbAtlasGlyphRec stack_glyphs[N_STACK_GLYPHS];
+    FbAtlasGlyphPtr aglyphs = stack_glyphs;
+    FbAtlasPtr atlas = NULL;
+    pixman_image_t *srcImage, *dstImage, *maskImage;
+    int srcXoff, srcYoff, dstXoff, dstYoff;
+    int xDst = list->xOff, yDst = list->yOff;
+    BoxRec extents = { MAXSHORT, MAXSHORT, MINSHORT, MINSHORT };
+    int maxX2 = MINSHORT, maxY2 = MINSHORT;
+    int n_glyphs, width, height, maskStride;
+    Bool ret = FALSE;
+    size_t maskSize;
+    int x, y, i, n;
+
+    if (!fbAtlasSlotKeyRec.initialized)
+        return FALSE;
+    if (maskFormat) {
+        atlas = fbAtlasForFormat(maskFormat->format);
+        if (!atlas)
+            return FALSE;
+    }
+    else if (op != PictOpOver && op != PictOpAdd)
+        return FALSE;
+
+    n_glyphs = 0;
+    for (i = 0; i < nlist; i++)
+        n_glyphs += list[i].len;
+    if (n_glyphs > N_STACK_GLYPHS) {
+        aglyphs = xallocarray(n_glyphs, sizeof(FbAtlasGlyphRec));
+        if (!aglyphs)
+            return FALSE;
+    }
+
+    atlasClock++;
+    n_glyphs = 0;
+    x = y = 0;
+    while (nlist--) {
+        x += list->xOff;
+        y += list->yOff;
+        n = list->len;
+        while (n--) {
+            GlyphPtr glyph = *glyphs++;
+            PicturePtr pPicture = GetGlyphPicture(glyph, pScreen);
+            FbAtlasGlyphPtr g = &aglyphs[n_glyphs];
+
+            if (pPicture) {
+                if (glyph->info.width > FB_ATLAS_GLYPH_MAX ||
+                    glyph->info.height > FB_ATLAS_GLYPH_MAX)
+                    goto out;
+                if (maskFormat) {
+                    if (pPicture->format != maskFormat->format)
+                        goto out;
+                }
+                else if (!atlas) {
+                    atlas = fbAtlasForFormat(pPicture->format);
+                    if (!atlas)
+                        goto out;
+                }
+                else if (pPicture->format != atlas->format)
+                    goto out;
+
+                g->slot = fbAtlasSlot(glyph);
+                g->x = x - glyph->info.x;
+                g->y = y - glyph->info.y;
+                g->width = glyph->info.width;
+                g->height = glyph->info.height;
+
+                /* without a mask, each glyph must stand alone */
+                if (!maskFormat && g->x < maxX2 && g->y < maxY2)
+                    goto out;
+                maxX2 = max(maxX2, g->x + g->width);
+                maxY2 = max(maxY2, g->y + g->height);
+
+                if (!g->slot->page ||
+                    g->slot->generation != g->slot->page->generation) {
+                    if (!fbAtlasInsert(atlas, glyph, pPicture, g->slot))
+                        goto out;
+                }
+                g->slot->page->lastUsed = atlasClock;
+
+                extents.x1 = min(extents.x1, g->x);
+                extents.y1 = min(extents.y1, g->y);
+                extents.x2 = max(extents.x2, g->x + g->width);
+                extents.y2 = max(extents.y2, g->y + g->height);
+                n_glyphs++;
+            }
+            x += glyph->info.xOff;
+            y += glyph->info.yOff;
+        }
+        list++;
+    }
+
+    if (!n_glyphs) {
+        ret = TRUE;
+        goto out;
+    }
+
+    width = extents.x2 - extents.x1;
+    height = extents.y2 - extents.y1;
+    if ((long) width * height > FB_ATLAS_MASK_MAX)
+        goto out;
+
+    maskStride = (width * atlas->cpp + 3) & ~3;
+    maskSize = (size_t) maskStride * height;
+    if (maskSize > atlasMaskSize) {
+        CARD8 *mask = realloc(atlasMask, maskSize);
+
+        if (!mask)
+            goto out;
+        atlasMask = mask;
+        atlasMaskSize = maskSize;
+    }
+    memset(atlasMask, 0, maskSize);
+    for (i = 0; i < n_glyphs; i++) {
+        aglyphs[i].x -= extents.x1;
+        aglyphs[i].y -= extents.y1;
+        fbAtlasAddGlyph(atlasMask, maskStride, atlas->cpp, &aglyphs[i]);
+    }
+
+    maskImage = pixman_image_create_bits((pixman_format_code_t) atlas->format,
+                                         width, height,
+                                         (uint32_t *) atlasMask, maskStride);
+    if (!maskImage)
+        goto out;
+    /* as pixman does for a mask or glyphs with colour channels */
+    if (PICT_FORMAT_RGB(atlas->format))
+        pixman_image_set_component_alpha(maskImage, TRUE);
+
+    if (!(srcImage = image_from_pict(pSrc, FALSE, &srcXoff, &srcYoff)))
+        goto out_free_mask;
+    if (!(dstImage = image_from_pict(pDst, TRUE, &dstXoff, &dstYoff)))
+        goto out_free_src;
+
+    pixman_image_composite32(op, srcImage, maskImage, dstImage,
+                             xSrc + srcXoff + extents.x1 - xDst,
+                             ySrc + srcYoff + extents.y1 - yDst,
+                             0, 0,
+                             extents.x1 + dstXoff, extents.y1 + dstYoff,
+                             width, height);
+    ret = TRUE;
+
+    free_pixman_pict(pDst, dstImage);
+ out_free_src:
+    free_pixman_pict(pSrc, srcImage);
+ out_free_mask:
+    pixman_image_unref(maskImage);
+ out:
+    if (aglyphs != stack_glyphs)
+        free(aglyphs);
+    return ret;
+}
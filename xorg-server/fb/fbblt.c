@@ -27,6 +27,81 @@
 #include <string.h>
 #include "fb.h"
 
+/*
+ * Byte-aligned GXcopy rows are moved by fbCopyRow, which like memmove
+ * copies in whichever direction is safe when source and destination
+ * share the row.  On x86 with gcc or clang an AVX2 version is picked at
+ * run time; MSVC gets it only when building for AVX2.
+ */
+#ifndef FB_ACCESS_WRAPPER
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FB_COPY_AVX2
+#define FB_COPY_AVX2_TARGET __attribute__((target("avx2")))
+#define fbHaveAVX2() __builtin_cpu_supports("avx2")
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#define FB_COPY_AVX2
+#define FB_COPY_AVX2_TARGET
+#define fbHaveAVX2() TRUE
+#endif
+#endif
+
+#ifdef FB_COPY_AVX2
+#include <immintrin.h>
+
+#define FB_COPY_CHUNK   128     /* bytes loaded before any is stored */
+
+/*
+ * Every chunk is loaded completely before it is stored, and chunks go
+ * away from the destination, so no byte is overwritten before it has
+ * been read whatever the overlap.
+ */
+static FB_COPY_AVX2_TARGET void
+fbCopyRowAVX2(CARD8 *dst, const CARD8 *src, size_t n)
+{
+    __m256i a, b, c, d;
+    size_t i;
+
+    if (dst <= src) {
+        for (i = 0; i + FB_COPY_CHUNK <= n; i += FB_COPY_CHUNK) {
+            a = _mm256_loadu_si256((const __m256i *) (src + i));
+            b = _mm256_loadu_si256((const __m256i *) (src + i + 32));
+            c = _mm256_loadu_si256((const __m256i *) (src + i + 64));
+            d = _mm256_loadu_si256((const __m256i *) (src + i + 96));
+            _mm256_storeu_si256((__m256i *) (dst + i), a);
+            _mm256_storeu_si256((__m256i *) (dst + i + 32), b);
+            _mm256_storeu_si256((__m256i *) (dst + i + 64), c);
+            _mm256_storeu_si256((__m256i *) (dst + i + 96), d);
+        }
+        memmove(dst + i, src + i, n - i);
+    }
+    else {
+        for (i = n; i >= FB_COPY_CHUNK; i -= FB_COPY_CHUNK) {
+            a = _mm256_loadu_si256((const __m256i *) (src + i - 32));
+            b = _mm256_loadu_si256((const __m256i *) (src + i - 64));
+            c = _mm256_loadu_si256((const __m256i *) (src + i - 96));
+            d = _mm256_loadu_si256((const __m256i *) (src + i - 128));
+            _mm256_storeu_si256((__m256i *) (dst + i - 32), a);
+            _mm256_storeu_si256((__m256i *) (dst + i - 64), b);
+            _mm256_storeu_si256((__m256i *) (dst + i - 96), c);
+            _mm256_storeu_si256((__m256i *) (dst + i - 128), d);
+        }
+        memmove(dst, src, i);
+    }
+}
+#endif
+
+static inline void
+fbCopyRow(CARD8 *dst, CARD8 *src, size_t n)
+{
+#ifdef FB_COPY_AVX2
+    if (n >= FB_COPY_CHUNK && fbHaveAVX2()) {
+        fbCopyRowAVX2(dst, src, n);
+        return;
+    }
+#endif
+    MEMCPY_WRAPPED(dst, src, n);
+}
+
 #define InitializeShifts(sx,dx,ls,rs) { \
     if (sx != dx) { \
 	if (sx > dx) { \
@@ -68,25 +143,27 @@ fbBlt(FbBits * srcLine,
         FbStride        dst_byte_stride = dstStride << (FB_SHIFT - 3);
         int             width_byte = (width >> 3);
 
-        /* Make sure there's no overlap; we can't use memcpy in that
-         * case as it's not well defined, so fall through to the
-         * general code
+        /* With accessors rows are copied a byte at a time, which is
+         * wrong if they overlap, so fall through to the general code.
+         * Otherwise fbCopyRow copies overlapping rows as memmove does.
          */
+#ifdef FB_ACCESS_WRAPPER
         if (src_byte + width_byte <= dst_byte ||
             dst_byte + width_byte <= src_byte)
+#endif
         {
             int i;
 
             if (!upsidedown)
                 for (i = 0; i < height; i++)
-                    MEMCPY_WRAPPED(dst_byte + i * dst_byte_stride,
-                                   src_byte + i * src_byte_stride,
-                                   width_byte);
+                    fbCopyRow(dst_byte + i * dst_byte_stride,
+                              src_byte + i * src_byte_stride,
+                              width_byte);
             else
                 for (i = height - 1; i >= 0; i--)
-                    MEMCPY_WRAPPED(dst_byte + i * dst_byte_stride,
-                                   src_byte + i * src_byte_stride,
-                                   width_byte);
+                    fbCopyRow(dst_byte + i * dst_byte_stride,
+                              src_byte + i * src_byte_stride,
+                              width_byte);
 
             return;
         }
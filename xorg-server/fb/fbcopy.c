@@ -27,18 +27,16 @@
 #include <stdlib.h>
 
 #include "fb.h"
+#include "threadpool.h"
 
-void
-fbCopyNtoN(DrawablePtr pSrcDrawable,
-           DrawablePtr pDstDrawable,
-           GCPtr pGC,
-           BoxPtr pbox,
-           int nbox,
-           int dx,
-           int dy, Bool reverse, Bool upsidedown, Pixel bitplane, void *closure)
-{
-    CARD8 alu = pGC ? pGC->alu : GXcopy;
-    FbBits pm = pGC ? fbGetGCPrivate(pGC)->pm : FB_ALLONES;
+/* Copies of fewer bytes than this aren't worth waking the workers for */
+#define FB_COPY_PARALLEL_MIN    (512 * 1024)
+/* and each piece should be at least this many rows or bytes wide. */
+#define FB_COPY_BAND_MIN        32
+#define FB_COPY_STRIP_MIN       1024
+#define FB_COPY_PIECES_MAX      32
+
+typedef struct _FbCopyArgs {
     FbBits *src;
     FbStride srcStride;
     int srcBpp;
@@ -47,36 +45,160 @@ fbCopyNtoN(DrawablePtr pSrcDrawable,
     FbStride dstStride;
     int dstBpp;
     int dstXoff, dstYoff;
+    int dx, dy;
+    CARD8 alu;
+    FbBits pm;
+    Bool reverse, upsidedown;
+    /* for the parallel path: the box and where it is cut */
+    BoxRec box;
+    Bool columns;
+    int cuts[FB_COPY_PIECES_MAX + 1];
+} FbCopyArgsRec, *FbCopyArgsPtr;
 
-    fbGetDrawable(pSrcDrawable, src, srcStride, srcBpp, srcXoff, srcYoff);
-    fbGetDrawable(pDstDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
-
-    while (nbox--) {
+static void
+fbCopyBox(FbCopyArgsPtr args, BoxPtr pbox)
+{
 #ifndef FB_ACCESS_WRAPPER       /* pixman_blt() doesn't support accessors yet */
-        if (pm == FB_ALLONES && alu == GXcopy && !reverse && !upsidedown) {
-            if (!pixman_blt
-                ((uint32_t *) src, (uint32_t *) dst, srcStride, dstStride,
-                 srcBpp, dstBpp, (pbox->x1 + dx + srcXoff),
-                 (pbox->y1 + dy + srcYoff), (pbox->x1 + dstXoff),
-                 (pbox->y1 + dstYoff), (pbox->x2 - pbox->x1),
-                 (pbox->y2 - pbox->y1)))
-                goto fallback;
-            else
-                goto next;
-        }
- fallback:
+    if (args->pm == FB_ALLONES && args->alu == GXcopy &&
+        !args->reverse && !args->upsidedown &&
+        pixman_blt((uint32_t *) args->src, (uint32_t *) args->dst,
+                   args->srcStride, args->dstStride,
+                   args->srcBpp, args->dstBpp,
+                   (pbox->x1 + args->dx + args->srcXoff),
+                   (pbox->y1 + args->dy + args->srcYoff),
+                   (pbox->x1 + args->dstXoff), (pbox->y1 + args->dstYoff),
+                   (pbox->x2 - pbox->x1), (pbox->y2 - pbox->y1)))
+        return;
 #endif
-        fbBlt(src + (pbox->y1 + dy + srcYoff) * srcStride,
-              srcStride,
-              (pbox->x1 + dx + srcXoff) * srcBpp,
-              dst + (pbox->y1 + dstYoff) * dstStride,
-              dstStride,
-              (pbox->x1 + dstXoff) * dstBpp,
-              (pbox->x2 - pbox->x1) * dstBpp,
-              (pbox->y2 - pbox->y1), alu, pm, dstBpp, reverse, upsidedown);
+    fbBlt(args->src + (pbox->y1 + args->dy + args->srcYoff) * args->srcStride,
+          args->srcStride,
+          (pbox->x1 + args->dx + args->srcXoff) * args->srcBpp,
+          args->dst + (pbox->y1 + args->dstYoff) * args->dstStride,
+          args->dstStride,
+          (pbox->x1 + args->dstXoff) * args->dstBpp,
+          (pbox->x2 - pbox->x1) * args->dstBpp,
+          (pbox->y2 - pbox->y1), args->alu, args->pm, args->dstBpp,
+          args->reverse, args->upsidedown);
+}
+
 #ifndef FB_ACCESS_WRAPPER
- next:
+
+static void
+fbCopyPiece(void *data, int index)
+{
+    FbCopyArgsPtr args = data;
+    BoxRec box = args->box;
+
+    if (args->columns) {
+        box.x1 = args->cuts[index];
+        box.x2 = args->cuts[index + 1];
+    }
+    else {
+        box.y1 = args->cuts[index];
+        box.y2 = args->cuts[index + 1];
+    }
+    fbCopyBox(args, &box);
+}
+
+/*
+ * Copy a large box in pieces on the worker threads.  No piece may read
+ * what another one writes, so when the copy overlaps itself a vertical
+ * scroll is cut into columns, each still copied in the order the
+ * reverse and upsidedown flags ask for, and a horizontal move into
+ * bands; anything else is left to a single thread.  Column cuts fall on
+ * cache line boundaries in the destination, which also keeps pieces out
+ * of each other's FbBits words.
+ */
+static Bool
+fbCopyParallel(FbCopyArgsPtr args, BoxPtr pbox)
+{
+    int w = pbox->x2 - pbox->x1, h = pbox->y2 - pbox->y1;
+    int sx = pbox->x1 + args->dx + args->srcXoff;
+    int sy = pbox->y1 + args->dy + args->srcYoff;
+    int dx = pbox->x1 + args->dstXoff;
+    int dy = pbox->y1 + args->dstYoff;
+    int pieces, align, i, n;
+    Bool overlap;
+
+    if ((size_t) w * h * args->dstBpp < (size_t) FB_COPY_PARALLEL_MIN * 8)
+        return FALSE;
+    pieces = ThreadPoolThreads();
+    if (pieces < 2)
+        return FALSE;
+    if (pieces > FB_COPY_PIECES_MAX)
+        pieces = FB_COPY_PIECES_MAX;
+
+    overlap = args->src == args->dst && args->srcStride == args->dstStride &&
+        sx < dx + w && dx < sx + w && sy < dy + h && dy < sy + h;
+    if (overlap && sx == dx && sy != dy)
+        args->columns = TRUE;
+    else if (!overlap || sy == dy)
+        args->columns = FALSE;
+    else
+        return FALSE;
+
+    args->box = *pbox;
+    if (args->columns) {
+        /* pixels per 64 bytes, counted from the start of the row */
+        for (align = 1; (align * args->dstBpp) % 512; align++);
+        if (pieces > w * args->dstBpp / 8 / FB_COPY_STRIP_MIN)
+            pieces = w * args->dstBpp / 8 / FB_COPY_STRIP_MIN;
+        args->cuts[0] = pbox->x1;
+        for (i = 1, n = 1; i < pieces; i++) {
+            int x = dx + (int) ((long) w * i / pieces);
+
+            x = (x + align - 1) / align * align - args->dstXoff;
+            if (x > args->cuts[n - 1] && x < pbox->x2)
+                args->cuts[n++] = x;
+        }
+        args->cuts[n] = pbox->x2;
+    }
+    else {
+        if (pieces > h / FB_COPY_BAND_MIN)
+            pieces = h / FB_COPY_BAND_MIN;
+        if (pieces < 2)
+            return FALSE;
+        for (n = 0; n <= pieces; n++)
+            args->cuts[n] = pbox->y1 + (int) ((long) h * n / pieces);
+        n = pieces;
+    }
+    if (n < 2)
+        return FALSE;
+
+    ThreadPoolRun(fbCopyPiece, args, n);
+    return TRUE;
+}
+
+#endif
+
+void
+fbCopyNtoN(DrawablePtr pSrcDrawable,
+           DrawablePtr pDstDrawable,
+           GCPtr pGC,
+           BoxPtr pbox,
+           int nbox,
+           int dx,
+           int dy, Bool reverse, Bool upsidedown, Pixel bitplane, void *closure)
+{
+    FbCopyArgsRec args;
+
+    args.alu = pGC ? pGC->alu : GXcopy;
+    args.pm = pGC ? fbGetGCPrivate(pGC)->pm : FB_ALLONES;
+    args.dx = dx;
+    args.dy = dy;
+    args.reverse = reverse;
+    args.upsidedown = upsidedown;
+
+    fbGetDrawable(pSrcDrawable, args.src, args.srcStride, args.srcBpp,
+                  args.srcXoff, args.srcYoff);
+    fbGetDrawable(pDstDrawable, args.dst, args.dstStride, args.dstBpp,
+                  args.dstXoff, args.dstYoff);
+
+    while (nbox--) {
+#ifndef FB_ACCESS_WRAPPER       /* accessors aren't known to be thread safe */
+        if (!fbCopyParallel(&args, pbox))
 #endif
+            fbCopyBox(&args, pbox);
         pbox++;
     }
     fbFinishAccess(pDstDrawable);
@@ -80,6 +80,7 @@ fbDestroyGlyphCache(void)
 	pixman_glyph_cache_destroy (glyphCache);
 	glyphCache = NULL;
     }
+    fbDestroyGlyphAtlas();
 }
 
 static void
@@ -88,6 +89,7 @@ fbUnrealizeGlyph(ScreenPtr pScreen,
 {
     if (glyphCache)
 	pixman_glyph_cache_remove (glyphCache, pGlyph, NULL);
+    fbGlyphAtlasRemove(pGlyph);
 }
 
 void
@@ -114,6 +116,10 @@ fbGlyphs(CARD8 op,
 
     miCompositeSourceValidate(pSrc);
 
+    if (fbGlyphAtlasComposite(op, pSrc, pDst, maskFormat, xSrc, ySrc,
+                              nlist, list, glyphs))
+        return;
+
     n_glyphs = 0;
     for (i = 0; i < nlist; ++i)
 	n_glyphs += list[i].len;
@@ -492,6 +498,8 @@ fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
 
     if (!miPictureInit(pScreen, formats, nformats))
         return FALSE;
+    if (!fbGlyphAtlasInit(pScreen))
+        return FALSE;
     ps = GetPictureScreen(pScreen);
     ps->Composite = fbComposite;
     ps->Glyphs = fbGlyphs;
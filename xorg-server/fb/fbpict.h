@@ -76,4 +76,26 @@ fbGlyphs(CARD8 op,
 	 GlyphListPtr list,
 	 GlyphPtr *glyphs);
 
+/*
+ * fbatlas.c
+ */
+
+extern _X_EXPORT Bool
+fbGlyphAtlasInit(ScreenPtr pScreen);
+
+extern _X_EXPORT void
+fbDestroyGlyphAtlas(void);
+
+extern _X_EXPORT void
+fbGlyphAtlasRemove(GlyphPtr glyph);
+
+extern _X_EXPORT Bool
+fbGlyphAtlasComposite(CARD8 op,
+                      PicturePtr pSrc,
+                      PicturePtr pDst,
+                      PictFormatPtr maskFormat,
+                      INT16 xSrc,
+                      INT16 ySrc, int nlist, GlyphListPtr list,
+                      GlyphPtr *glyphs);
+
 #endif                          /* _FBPICT_H_ */
@@ -34,6 +34,7 @@
 #define fbCreateGC wfbCreateGC
 #define fbCreatePixmap wfbCreatePixmap
 #define fbCreateWindow wfbCreateWindow
+#define fbDestroyGlyphAtlas wfbDestroyGlyphAtlas
 #define fbDestroyGlyphCache wfbDestroyGlyphCache
 #define fbDestroyPixmap wfbDestroyPixmap
 #define fbDestroyWindow wfbDestroyWindow
@@ -56,6 +57,9 @@
 #define fbGlyph16 wfbGlyph16
 #define fbGlyph32 wfbGlyph32
 #define fbGlyph8 wfbGlyph8
+#define fbGlyphAtlasComposite wfbGlyphAtlasComposite
+#define fbGlyphAtlasInit wfbGlyphAtlasInit
+#define fbGlyphAtlasRemove wfbGlyphAtlasRemove
 #define fbGlyphs wfbGlyphs
 #define fbImageGlyphBlt wfbImageGlyphBlt
 #define fbIn wfbIn
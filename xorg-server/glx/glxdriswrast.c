@@ -42,7 +42,9 @@
 
 #include "scrnintstr.h"
 #include "pixmapstr.h"
+#include "windowstr.h"
 #include "gcstruct.h"
+#include "damage.h"
 #include "os.h"
 
 #include "glxserver.h"
@@ -356,6 +358,73 @@ swrastGetImage(__DRIdrawable * draw,
     }
 }
 
+/*
+ * The storage the driver may render a drawable's front buffer into, and
+ * copy its back buffer into on swaps: a pixmap's own, or the backing pixmap of a redirected window with no
+ * children to draw over.  It has to be plain memory in the driver's
+ * format.
+ */
+static void *
+swrastGetBuffer(__DRIdrawable * draw, int bpp, int width, int height,
+                int *stride, void *loaderPrivate)
+{
+    __GLXDRIdrawable *drawable = loaderPrivate;
+    DrawablePtr pDraw = drawable->base.pDraw;
+    ScreenPtr pScreen = pDraw->pScreen;
+    PixmapPtr pPixmap;
+    int x = 0, y = 0;
+
+#ifdef PANORAMIX
+    if (drawable->base.pAll)
+        return NULL;
+#endif
+    if (pDraw->width != width || pDraw->height != height)
+        return NULL;
+
+    if (pDraw->type == DRAWABLE_WINDOW) {
+#ifdef COMPOSITE
+        WindowPtr pWin = (WindowPtr) pDraw;
+
+        if (pWin->redirectDraw == RedirectDrawNone || pWin->firstChild)
+            return NULL;
+        pPixmap = (*pScreen->GetWindowPixmap) (pWin);
+        x = pDraw->x - pPixmap->screen_x;
+        y = pDraw->y - pPixmap->screen_y;
+#else
+        return NULL;
+#endif
+    }
+    else
+        pPixmap = (PixmapPtr) pDraw;
+
+    if (!pPixmap->devPrivate.ptr || pPixmap->drawable.bitsPerPixel != bpp ||
+        x < 0 || y < 0 || x + width > pPixmap->drawable.width ||
+        y + height > pPixmap->drawable.height)
+        return NULL;
+
+    *stride = pPixmap->devKind;
+    return (char *) pPixmap->devPrivate.ptr + y * pPixmap->devKind +
+        x * (bpp / 8);
+}
+
+static void
+swrastDamage(__DRIdrawable * draw, int x, int y, int w, int h,
+             void *loaderPrivate)
+{
+    __GLXDRIdrawable *drawable = loaderPrivate;
+    DrawablePtr pDraw = drawable->base.pDraw;
+    BoxRec box;
+    RegionRec region;
+
+    box.x1 = pDraw->x + x;
+    box.y1 = pDraw->y + y;
+    box.x2 = box.x1 + w;
+    box.y2 = box.y1 + h;
+    RegionInit(&region, &box, 1);
+    DamageDamageRegion(pDraw, &region);
+    RegionUninit(&region);
+}
+
 static const __DRIswrastLoaderExtension swrastLoaderExtension = {
     {__DRI_SWRAST_LOADER, __DRI_SWRAST_LOADER_VERSION},
     swrastGetDrawableInfo,
@@ -363,8 +432,15 @@ static const __DRIswrastLoaderExtension swrastLoaderExtension = {
     swrastGetImage
 };
 
+static const __DRIswrastDirectExtension swrastDirectExtension = {
+    {__DRI_SWRAST_DIRECT, __DRI_SWRAST_DIRECT_VERSION},
+    swrastGetBuffer,
+    swrastDamage
+};
+
 static const __DRIextension *loader_extensions[] = {
     &swrastLoaderExtension.base,
+    &swrastDirectExtension.base,
     NULL
 };
 
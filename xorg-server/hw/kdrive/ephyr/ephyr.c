@@ -694,6 +694,8 @@ ephyrFinishInitScreen(ScreenPtr pScreen)
      */
     if (!shadowSetup(pScreen))
         return FALSE;
+    /* ephyrWindowLinear hands out plain memory, so bands can go in parallel */
+    shadowSetThreaded(pScreen, TRUE);
 
 #ifdef RANDR
     if (!ephyrRandRInit(pScreen))
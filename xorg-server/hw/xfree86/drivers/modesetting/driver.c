@@ -1378,6 +1378,8 @@ CreateScreenResources(ScreenPtr pScreen)
         if (!shadowAdd(pScreen, rootPixmap, msUpdatePacked, msShadowWindow,
                        0, 0))
             return FALSE;
+        /* the dumb buffer is linear, so bands can be copied in parallel */
+        shadowSetThreaded(pScreen, TRUE);
     }
 
     err = drmModeDirtyFB(ms->fd, ms->drmmode.fb_id, NULL, 0);
@@ -45,6 +45,7 @@
 #define ID_APP_ABOUT		203
 #define ID_APP_MONITOR_PRIMARY	204
 #define ID_APP_GATHER_WINDOWS	205
+#define ID_APP_REQUEST_PROFILE	206
 
 #define ID_ABOUT_WEBSITE	303
 
@@ -36,6 +36,7 @@
 #include "win.h"
 #include <shellapi.h>
 #include "winprefs.h"
+#include "reqprof.h"
 #include "winclipboard/winclipboard.h"
 
 static NOTIFYICONDATA nid;
@@ -204,6 +205,15 @@ winHandleIconMessage(HWND hwnd, UINT message,
             RemoveMenu(hmenuTray, ID_APP_MONITOR_PRIMARY, MF_BYCOMMAND);
         }
 
+        {
+            /* Check 'Profile Requests' while the profiler runs */
+            MENUITEMINFO mii = { 0 };
+            mii.cbSize = sizeof(MENUITEMINFO);
+            mii.fMask = MIIM_STATE;
+            mii.fState = RequestProfiling ? MFS_CHECKED : MFS_UNCHECKED;
+            SetMenuItemInfo(hmenuTray, ID_APP_REQUEST_PROFILE, FALSE, &mii);
+        }
+
         SetupRootMenu(hmenuTray);
 
         /*
@@ -42,6 +42,7 @@
 #include "winmsg.h"
 #include "winmonitors.h"
 #include "inputstr.h"
+#include "reqprof.h"
 #include "winclipboard/winclipboard.h"
 
 #ifndef XKB_IN_SERVER
@@ -1262,6 +1263,11 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             gatherWindows();
             return 0;
 
+        case ID_APP_REQUEST_PROFILE:
+            /* Windows has no SIGUSR2; Dispatch toggles it the same way */
+            RequestProfileToggle = TRUE;
+            return 0;
+
         case ID_APP_ABOUT:
             /* Display the About box */
             winDisplayAboutDialog(s_pScreenPriv);
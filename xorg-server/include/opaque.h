@@ -73,6 +73,7 @@ extern _X_EXPORT long maxBigRequestSize;
 extern _X_EXPORT Bool party_like_its_1989;
 extern _X_EXPORT Bool whiteRoot;
 extern _X_EXPORT Bool bgNoneRoot;
+extern _X_EXPORT Bool CoalesceMotion;
 
 extern _X_EXPORT Bool CoreDump;
 extern _X_EXPORT Bool NoListenAll;
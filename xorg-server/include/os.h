@@ -125,8 +125,30 @@ extern _X_EXPORT void SetCriticalOutputPending(void);
 extern _X_EXPORT int WriteToClient(ClientPtr /*who */ , int /*count */ ,
                                    const void * /*buf */ );
 
+/* Called once the server is done with a buffer given to
+ * WriteToClientBuffer, either because it was written or because the
+ * client went away. */
+typedef void (*WriteDoneProcPtr) (void * /* closure */ );
+
+extern _X_EXPORT int WriteToClientBuffer(ClientPtr /*who */ , int /*count */ ,
+                                         const void * /*buf */ ,
+                                         WriteDoneProcPtr /*done */ ,
+                                         void * /*closure */ );
+
 extern _X_EXPORT void ResetOsBuffers(void);
 
+typedef struct _ClientIOStats {
+    CARD64 bytesRead;
+    CARD64 bytesWritten;
+    CARD64 reads;               /* read system calls */
+    CARD64 writes;              /* write system calls */
+    int inputBufferSize;        /* bytes allocated right now */
+    int outputBufferSize;
+} ClientIOStatsRec, *ClientIOStatsPtr;
+
+extern _X_EXPORT void GetClientIOStats(ClientPtr /*client */ ,
+                                       ClientIOStatsPtr /*stats */ );
+
 extern _X_EXPORT int TransIsListening(char *protocol);
 
 extern _X_EXPORT void NotifyParentProcess(void);
@@ -219,6 +241,8 @@ extern _X_EXPORT void AutoResetServer(int /*sig */ );
 
 extern _X_EXPORT void GiveUp(int /*sig */ );
 
+extern _X_EXPORT void RequestProfileSignal(int /*sig */ );
+
 extern _X_EXPORT void UseMsg(void);
 
 extern _X_EXPORT void ProcessCommandLine(int /*argc */ , char * /*argv */ []);
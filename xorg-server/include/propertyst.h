@@ -55,6 +55,7 @@ SOFTWARE.
 
 typedef struct _Property {
     struct _Property *next;
+    struct _Property *prev;
     ATOM propertyName;
     ATOM type;                  /* ignored by server */
     uint32_t format;            /* format of data for swapping - 8,16,32 */
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef REQPROF_H
+#define REQPROF_H
+
+#include <signal.h>
+
+#include "misc.h"
+#include "dix.h"
+
+/**
+ * Request profiling.  While it runs, Dispatch times every request and
+ * keeps count, total time and a latency histogram per client and per
+ * major/minor opcode.  It is started with -reqprofile or toggled with
+ * SIGUSR2, or on Windows from the tray icon menu; stopping it writes a
+ * report to the log.
+ */
+
+/** Set while requests are being timed. */
+extern Bool RequestProfiling;
+
+/** Start profiling when the server starts (-reqprofile). */
+extern Bool RequestProfileAtStart;
+
+/** Set to ask for a toggle, from the signal handler or the XWin tray menu;
+ * Dispatch toggles profiling when it sees it. */
+extern volatile sig_atomic_t RequestProfileToggle;
+
+extern void InitRequestProfile(void);
+extern void ToggleRequestProfile(void);
+extern void FinishRequestProfile(void);
+
+extern CARD64 RequestProfileStart(void);
+extern void RequestProfileDone(ClientPtr client, CARD64 start);
+
+#endif /* REQPROF_H */
@@ -0,0 +1,52 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "misc.h"
+
+/**
+ * A small pool of worker threads for rendering work that splits into
+ * independent pieces, such as bands of a large copy.  The pool starts on
+ * first use with one worker per extra CPU, or -workers many.
+ */
+
+/** Workers to start, -1 for one per CPU beyond the first (-workers). */
+extern _X_EXPORT int ThreadPoolWorkers;
+
+typedef void (*ThreadPoolProc) (void *data, int index);
+
+/**
+ * Call proc(data, index) for every index in [0, count), spread over the
+ * workers and the calling thread, and return once all calls are done.
+ * Calls made while the pool is busy, including from inside proc, run
+ * serially on the calling thread.
+ */
+extern _X_EXPORT void ThreadPoolRun(ThreadPoolProc proc, void *data,
+                                    int count);
+
+/** How many threads ThreadPoolRun spreads work over, the caller included. */
+extern _X_EXPORT int ThreadPoolThreads(void);
+
+#endif /* THREADPOOL_H */
@@ -220,6 +220,19 @@ extern _X_EXPORT void ResizeChildrenWinSize(WindowPtr /*pWin */ ,
                                             int /*dw */ ,
                                             int /*dh */ );
 
+extern _X_EXPORT Bool WindowHitIndexBuild(WindowPtr /*pParent */ );
+
+extern _X_EXPORT WindowPtr *WindowHitCandidates(WindowPtr /*pParent */ ,
+                                                int /*x */ ,
+                                                int /*y */ ,
+                                                int * /*count */ );
+
+extern _X_EXPORT void WindowHitIndexUpdate(WindowPtr /*pWin */ );
+
+extern _X_EXPORT void WindowHitIndexInvalidate(WindowPtr /*pParent */ );
+
+extern _X_EXPORT void WindowHitIndexFree(WindowPtr /*pWin */ );
+
 extern _X_EXPORT void SendShapeNotify(WindowPtr /* pWin */ ,
                                       int /* which */);
 
@@ -86,6 +86,7 @@ typedef struct _WindowOpt {
     struct _OtherClients *otherClients; /* default: NULL */
     struct _GrabRec *passiveGrabs;      /* default: NULL */
     PropertyPtr userProps;      /* default: NULL */
+    struct _PropertyIndex *propIndex;   /* default: NULL */
     CARD32 backingBitPlanes;    /* default: ~0L */
     CARD32 backingPixel;        /* default: 0 */
     RegionPtr boundingShape;    /* default: NULL */
@@ -145,6 +146,7 @@ typedef struct _Window {
     PixUnion background;
     PixUnion border;
     WindowOptPtr optional;
+    struct _WindowHitIndex *hitIndex;   /* children by position, if many */
     unsigned backgroundState:2; /* None, Relative, Pixel, Pixmap */
     unsigned borderIsPixel:1;
     unsigned cursorIsNone:1;    /* else real cursor (might inherit) */
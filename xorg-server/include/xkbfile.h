@@ -272,5 +272,12 @@ extern _X_EXPORT unsigned XkmReadFile(FILE * /* file */ ,
                                       XkbDescPtr *      /* result */
     );
 
+extern _X_EXPORT unsigned XkmReadBuffer(const void * /* data */ ,
+                                        size_t /* size */ ,
+                                        unsigned /* need */ ,
+                                        unsigned /* want */ ,
+                                        XkbDescPtr *    /* result */
+    );
+
 _XFUNCPROTOEND
 #endif                          /* _XKBFILE_H_ */
@@ -192,6 +192,14 @@ extern _X_EXPORT Bool mieqInit(void
 
 extern _X_EXPORT void mieqFini(void);
 
+typedef struct _MieqStats {
+    unsigned long queued;       /* events queued */
+    unsigned long merged;       /* motion events folded into a later one */
+    unsigned long dropped;      /* events lost to a full queue */
+} MieqStatsRec, *MieqStatsPtr;
+
+extern _X_EXPORT void mieqGetStats(MieqStatsPtr /*stats */ );
+
 extern _X_EXPORT void mieqEnqueue(DeviceIntPtr /*pDev */ ,
                                   InternalEvent *       /*e */
     );
@@ -53,6 +53,7 @@ in this Software without prior written authorization from The Open Group.
 #include   "extinit.h"
 #include   "exglobals.h"
 #include   "eventstr.h"
+#include   "opaque.h"
 
 #ifdef DPMSExtension
 #include "dpmsproc.h"
@@ -61,7 +62,6 @@ in this Software without prior written authorization from The Open Group.
 
 /* Maximum size should be initial size multiplied by a power of 2 */
 #define QUEUE_INITIAL_SIZE                 1024
-#define QUEUE_RESERVED_SIZE                 64
 #define QUEUE_MAXIMUM_SIZE                4096
 #define QUEUE_DROP_BACKTRACE_FREQUENCY     100
 #define QUEUE_DROP_BACKTRACE_MAX            10
@@ -69,92 +69,206 @@ in this Software without prior written authorization from The Open Group.
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
 
+/*
+ * The queue is a chain of single-producer, single-consumer rings.
+ * mieqEnqueue is the producer; its callers are serialized by input_lock,
+ * whether they run on the input thread or the main thread.
+ * mieqProcessInputEvents is the consumer and takes no lock at all, so the
+ * input thread is never held up while the main thread delivers events.
+ *
+ * When a ring fills up the producer starts a new one twice the size and
+ * links it behind the full one; the consumer frees the old ring once it
+ * has drained it.  No ring is ever resized in place, so the consumer can
+ * keep reading while the producer grows the queue.
+ *
+ * Each slot carries a small state word.  The producer may fold a motion
+ * event into one still queued, and it claims the slots involved from
+ * SLOT_READY to SLOT_WRITING to do so; the consumer claims slots from
+ * SLOT_READY to SLOT_TAKEN before reading them.  Whoever loses simply
+ * does something else: the producer queues a new event, the consumer
+ * waits for the few stores it takes to finish the rewrite.
+ */
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+/* volatile accesses are acquire and release with /volatile:ms */
+static inline unsigned int
+AtomicLoad(volatile unsigned int *p)
+{
+    return *p;
+}
+
+static inline void
+AtomicStore(volatile unsigned int *p, unsigned int v)
+{
+    *p = v;
+}
+
+static inline Bool
+AtomicCAS(volatile unsigned int *p, unsigned int old, unsigned int new)
+{
+    return _InterlockedCompareExchange((volatile long *) p, new, old) == old;
+}
+
+static inline unsigned int
+AtomicExchange(volatile unsigned int *p, unsigned int v)
+{
+    return _InterlockedExchange((volatile long *) p, v);
+}
+
+static inline unsigned int
+AtomicIncrement(volatile unsigned int *p)
+{
+    return _InterlockedIncrement((volatile long *) p);
+}
+
+static inline void *
+AtomicLoadPtr(void *volatile *p)
+{
+    return *p;
+}
+
+static inline void
+AtomicStorePtr(void *volatile *p, void *v)
+{
+    *p = v;
+}
+#else
+static inline unsigned int
+AtomicLoad(volatile unsigned int *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+AtomicStore(volatile unsigned int *p, unsigned int v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline Bool
+AtomicCAS(volatile unsigned int *p, unsigned int old, unsigned int new)
+{
+    return __atomic_compare_exchange_n(p, &old, new, FALSE,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline unsigned int
+AtomicExchange(volatile unsigned int *p, unsigned int v)
+{
+    return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST);
+}
+
+static inline unsigned int
+AtomicIncrement(volatile unsigned int *p)
+{
+    return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline void *
+AtomicLoadPtr(void *volatile *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+AtomicStorePtr(void *volatile *p, void *v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+#endif
+
+enum {
+    SLOT_READY,                 /* free, or holding an event to read */
+    SLOT_WRITING,               /* the producer is rewriting it */
+    SLOT_TAKEN,                 /* the consumer is reading it */
+};
+
 typedef struct _Event {
     InternalEvent *events;
     ScreenPtr pScreen;
     DeviceIntPtr pDev;          /* device this event _originated_ from */
+    volatile unsigned int state;
 } EventRec, *EventPtr;
 
+typedef struct _EventRing {
+    void *volatile next;        /* the ring the producer moved on to */
+    volatile unsigned int head; /* next slot to read, consumer owned */
+    volatile unsigned int tail; /* next slot to write, producer owned */
+    unsigned int size;          /* a power of two */
+    InternalEvent *storage;
+    EventRec *events;
+} EventRingRec, *EventRingPtr;
+
 typedef struct _EventQueue {
-    HWEventQueueType head, tail;        /* long for SetInputCheck */
+    HWEventQueueType head, tail;        /* events taken and queued, for SetInputCheck */
     CARD32 lastEventTime;       /* to avoid time running backwards */
     int lastMotion;             /* device ID if last event motion? */
-    EventRec *events;           /* our queue as an array */
-    size_t nevents;             /* the number of buckets in our queue */
-    size_t dropped;             /* counter for number of consecutive dropped events */
+    unsigned int lastMotionPos; /* and where that motion is queued */
+    EventRingPtr producer;      /* ring mieqEnqueue writes to */
+    EventRingPtr consumer;      /* ring mieqProcessInputEvents reads from */
+    volatile unsigned int dropped;      /* consecutive dropped events */
+    unsigned long droppedTotal; /* events dropped since startup */
+    unsigned long queued;       /* events queued since startup */
+    unsigned long merged;       /* motion events folded into a later one */
     mieqHandler handlers[128];  /* custom event handler */
 } EventQueueRec, *EventQueuePtr;
 
 static EventQueueRec miEventQueue;
 
-static size_t
-mieqNumEnqueued(EventQueuePtr eventQueue)
+static void
+mieqFreeRing(EventRingPtr ring)
 {
-    size_t n_enqueued = 0;
-
-    if (eventQueue->nevents) {
-        /* % is not well-defined with negative numbers... sigh */
-        n_enqueued = eventQueue->tail - eventQueue->head + eventQueue->nevents;
-        if (n_enqueued >= eventQueue->nevents)
-            n_enqueued -= eventQueue->nevents;
-    }
-    return n_enqueued;
+    FreeEventList(ring->storage, ring->size);
+    free(ring->events);
+    free(ring);
 }
 
-/* Pre-condition: Called with input_lock held */
-static Bool
-mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
+static EventRingPtr
+mieqAllocRing(unsigned int size)
 {
-    size_t i, n_enqueued, first_hunk;
-    EventRec *new_events;
-
-    if (!eventQueue) {
-        ErrorF("[mi] mieqGrowQueue called with a NULL eventQueue\n");
-        return FALSE;
-    }
-
-    if (new_nevents <= eventQueue->nevents)
-        return FALSE;
+    EventRingPtr ring;
+    unsigned int i;
 
-    new_events = calloc(new_nevents, sizeof(EventRec));
-    if (new_events == NULL) {
-        ErrorF("[mi] mieqGrowQueue memory allocation error.\n");
-        return FALSE;
+    ring = calloc(1, sizeof(EventRingRec));
+    if (!ring)
+        return NULL;
+    ring->size = size;
+    ring->events = calloc(size, sizeof(EventRec));
+    ring->storage = InitEventList(size);
+    if (!ring->events || !ring->storage) {
+        ErrorF("[mi] mieqAllocRing memory allocation error.\n");
+        if (ring->storage)
+            FreeEventList(ring->storage, size);
+        free(ring->events);
+        free(ring);
+        return NULL;
     }
+    for (i = 0; i < size; i++)
+        ring->events[i].events = &ring->storage[i];
+    return ring;
+}
 
-    n_enqueued = mieqNumEnqueued(eventQueue);
-
-    /* First copy the existing events */
-    first_hunk = eventQueue->nevents - eventQueue->head;
-    memcpy(new_events,
-           &eventQueue->events[eventQueue->head],
-           first_hunk * sizeof(EventRec));
-    memcpy(&new_events[first_hunk],
-           eventQueue->events, eventQueue->head * sizeof(EventRec));
-
-    /* Initialize the new portion */
-    for (i = eventQueue->nevents; i < new_nevents; i++) {
-        InternalEvent *evlist = InitEventList(1);
-
-        if (!evlist) {
-            size_t j;
+/* Pre-condition: Called with input_lock held */
+static EventRingPtr
+mieqGrowQueue(EventQueuePtr eventQueue)
+{
+    EventRingPtr ring = eventQueue->producer;
+    EventRingPtr next;
 
-            for (j = 0; j < i; j++)
-                FreeEventList(new_events[j].events, 1);
-            free(new_events);
-            return FALSE;
-        }
-        new_events[i].events = evlist;
-    }
+    if (ring->size >= QUEUE_MAXIMUM_SIZE)
+        return NULL;
 
-    /* And update our record */
-    eventQueue->tail = n_enqueued;
-    eventQueue->head = 0;
-    eventQueue->nevents = new_nevents;
-    free(eventQueue->events);
-    eventQueue->events = new_events;
+    next = mieqAllocRing(ring->size << 1);
+    if (!next)
+        return NULL;
 
-    return TRUE;
+    /* Everything queued in the old ring was published before this */
+    eventQueue->producer = next;
+    eventQueue->lastMotion = 0;
+    AtomicStorePtr(&ring->next, next);
+    return next;
 }
 
 Bool
@@ -164,8 +278,10 @@ mieqInit(void)
     miEventQueue.lastEventTime = GetTimeInMillis();
 
     input_lock();
-    if (!mieqGrowQueue(&miEventQueue, QUEUE_INITIAL_SIZE))
+    miEventQueue.producer = mieqAllocRing(QUEUE_INITIAL_SIZE);
+    if (!miEventQueue.producer)
         FatalError("Could not allocate event queue.\n");
+    miEventQueue.consumer = miEventQueue.producer;
     input_unlock();
 
     SetInputCheck(&miEventQueue.head, &miEventQueue.tail);
@@ -174,16 +290,155 @@ mieqInit(void)
 
 void
 mieqFini(void)
+{
+    EventRingPtr ring, next;
+
+    LogMessageVerb(X_INFO, 3, "[mi] EQ: %lu events queued, %lu motion events "
+                   "merged, %lu dropped\n", miEventQueue.queued,
+                   miEventQueue.merged, miEventQueue.droppedTotal);
+
+    for (ring = miEventQueue.consumer; ring; ring = next) {
+        next = ring->next;
+        mieqFreeRing(ring);
+    }
+    miEventQueue.consumer = miEventQueue.producer = NULL;
+}
+
+static void
+mieqDropped(void)
+{
+    unsigned int dropped = AtomicIncrement(&miEventQueue.dropped);
+
+    miEventQueue.droppedTotal++;
+
+    /* Toss events which come in late.  Usually this means your server's
+     * stuck in an infinite loop in the main thread.
+     */
+    if (dropped == 1) {
+        ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
+                      "discarded until existing events are processed.\n");
+        xorg_backtrace();
+        ErrorFSigSafe("[mi] These backtraces from mieqEnqueue may point to "
+                      "a culprit higher up the stack.\n");
+        ErrorFSigSafe("[mi] mieq is *NOT* the cause.  It is a victim.\n");
+    }
+    else if (dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
+             dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
+             QUEUE_DROP_BACKTRACE_MAX) {
+        ErrorFSigSafe("[mi] EQ overflow continuing.  %u events have been "
+                      "dropped.\n", dropped);
+        if (dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
+            QUEUE_DROP_BACKTRACE_MAX) {
+            ErrorFSigSafe("[mi] No further overflow reports will be "
+                          "reported until the clog is cleared.\n");
+        }
+        xorg_backtrace();
+    }
+}
+
+/*
+ * Whether motion event b may replace motion event a, queued earlier for
+ * the same device.  Nothing the clients see may change between them but
+ * the position and valuator values.
+ */
+static Bool
+mieqCanMergeMotion(const DeviceEvent *a, const DeviceEvent *b)
 {
     int i;
 
-    for (i = 0; i < miEventQueue.nevents; i++) {
-        if (miEventQueue.events[i].events != NULL) {
-            FreeEventList(miEventQueue.events[i].events, 1);
-            miEventQueue.events[i].events = NULL;
+    if (a->flags != b->flags || a->source_type != b->source_type ||
+        a->root != b->root ||
+        memcmp(a->buttons, b->buttons, sizeof(a->buttons)) ||
+        memcmp(&a->mods, &b->mods, sizeof(a->mods)) ||
+        memcmp(&a->group, &b->group, sizeof(a->group)))
+        return FALSE;
+
+    for (i = 0; i < MAX_VALUATORS; i++) {
+        if (BitIsOn(a->valuators.mask, i) && BitIsOn(b->valuators.mask, i) &&
+            BitIsOn(a->valuators.mode, i) != BitIsOn(b->valuators.mode, i))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Folds motion event e into its device's last queued motion, at pos,
+ * which has nothing but that device's raw events queued after it.  The
+ * old motion is taken out, the raw events move down a slot and e goes
+ * last, carrying any axes the old motion set and e does not.  Raw
+ * events thus all arrive, in order, and no valuator change is lost; the
+ * motion history was recorded when the events were generated.
+ *
+ * Fails if the consumer has already reached the old motion.
+ */
+static Bool
+mieqMergeMotion(EventRingPtr ring, unsigned int pos, DeviceIntPtr pDev,
+                const InternalEvent *e)
+{
+    unsigned int mask = ring->size - 1;
+    unsigned int tail = ring->tail;
+    EventPtr slot = &ring->events[pos & mask];
+    InternalEvent *storage = slot->events;
+    DeviceEvent *old = &storage->device_event;
+    uint8_t extra[(MAX_VALUATORS + 7) / 8] = { 0 };
+    uint8_t mode[(MAX_VALUATORS + 7) / 8] = { 0 };
+    double data[MAX_VALUATORS];
+    unsigned int i;
+    int axis;
+
+    if ((int) (pos - AtomicLoad(&ring->head)) < 0 ||
+        slot->pScreen != EnqueueScreen(pDev) ||
+        !mieqCanMergeMotion(old, &e->device_event))
+        return FALSE;
+
+    for (i = pos; i != tail; i++) {
+        if (!AtomicCAS(&ring->events[i & mask].state,
+                       SLOT_READY, SLOT_WRITING))
+            break;
+    }
+    /* As in mieqDequeue, head moves before the slot is let go */
+    if (i != tail || (int) (pos - AtomicLoad(&ring->head)) < 0) {
+        while (i != pos)
+            AtomicStore(&ring->events[--i & mask].state, SLOT_READY);
+        return FALSE;
+    }
+
+    for (axis = 0; axis < MAX_VALUATORS; axis++) {
+        if (BitIsOn(old->valuators.mask, axis) &&
+            !BitIsOn(e->device_event.valuators.mask, axis)) {
+            SetBit(extra, axis);
+            if (BitIsOn(old->valuators.mode, axis))
+                SetBit(mode, axis);
+            data[axis] = old->valuators.data[axis];
         }
     }
-    free(miEventQueue.events);
+
+    for (i = pos; i + 1 != tail; i++) {
+        EventPtr to = &ring->events[i & mask];
+        EventPtr from = &ring->events[(i + 1) & mask];
+
+        to->events = from->events;
+        to->pScreen = from->pScreen;
+        to->pDev = from->pDev;
+    }
+
+    slot = &ring->events[(tail - 1) & mask];
+    slot->events = storage;
+    slot->pScreen = EnqueueScreen(pDev);
+    slot->pDev = pDev;
+    memcpy(storage, e, e->any.length);
+    for (axis = 0; axis < MAX_VALUATORS; axis++) {
+        if (BitIsOn(extra, axis)) {
+            SetBit(storage->device_event.valuators.mask, axis);
+            if (BitIsOn(mode, axis))
+                SetBit(storage->device_event.valuators.mode, axis);
+            storage->device_event.valuators.data[axis] = data[axis];
+        }
+    }
+
+    for (i = pos; i != tail; i++)
+        AtomicStore(&ring->events[i & mask].state, SLOT_READY);
+    return TRUE;
 }
 
 /*
@@ -194,58 +449,38 @@ mieqFini(void)
 void
 mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
 {
-    unsigned int oldtail = miEventQueue.tail;
+    EventRingPtr ring = miEventQueue.producer;
+    EventPtr slot;
     InternalEvent *evt;
     int isMotion = 0;
     int evlen;
     Time time;
-    size_t n_enqueued;
 
     verify_internal_event(e);
 
-    n_enqueued = mieqNumEnqueued(&miEventQueue);
-
     /* avoid merging events from different devices */
     if (e->any.type == ET_Motion)
         isMotion = pDev->id;
 
-    if (isMotion && isMotion == miEventQueue.lastMotion &&
-        oldtail != miEventQueue.head) {
-        oldtail = (oldtail - 1) % miEventQueue.nevents;
+    if (isMotion && isMotion == miEventQueue.lastMotion && CoalesceMotion &&
+        mieqMergeMotion(ring, miEventQueue.lastMotionPos, pDev, e)) {
+        miEventQueue.lastMotionPos = ring->tail - 1;
+        miEventQueue.lastEventTime = e->any.time;
+        miEventQueue.merged++;
+        return;
     }
-    else if (n_enqueued + 1 == miEventQueue.nevents) {
-        if (!mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1)) {
-            /* Toss events which come in late.  Usually this means your server's
-             * stuck in an infinite loop in the main thread.
-             */
-            miEventQueue.dropped++;
-            if (miEventQueue.dropped == 1) {
-                ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
-                              "discarded until existing events are processed.\n");
-                xorg_backtrace();
-                ErrorFSigSafe("[mi] These backtraces from mieqEnqueue may point to "
-                              "a culprit higher up the stack.\n");
-                ErrorFSigSafe("[mi] mieq is *NOT* the cause.  It is a victim.\n");
-            }
-            else if (miEventQueue.dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
-                     miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
-                     QUEUE_DROP_BACKTRACE_MAX) {
-                ErrorFSigSafe("[mi] EQ overflow continuing.  %zu events have been "
-                              "dropped.\n", miEventQueue.dropped);
-                if (miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
-                    QUEUE_DROP_BACKTRACE_MAX) {
-                    ErrorFSigSafe("[mi] No further overflow reports will be "
-                                  "reported until the clog is cleared.\n");
-                }
-                xorg_backtrace();
-            }
+
+    if (ring->tail - AtomicLoad(&ring->head) == ring->size) {
+        ring = mieqGrowQueue(&miEventQueue);
+        if (!ring) {
+            mieqDropped();
             return;
         }
-        oldtail = miEventQueue.tail;
     }
+    slot = &ring->events[ring->tail & (ring->size - 1)];
 
     evlen = e->any.length;
-    evt = miEventQueue.events[oldtail].events;
+    evt = slot->events;
     memcpy(evt, e, evlen);
 
     time = e->any.time;
@@ -256,11 +491,69 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
         e->any.time = miEventQueue.lastEventTime;
 
     miEventQueue.lastEventTime = evt->any.time;
-    miEventQueue.events[oldtail].pScreen = pDev ? EnqueueScreen(pDev) : NULL;
-    miEventQueue.events[oldtail].pDev = pDev;
+    slot->pScreen = pDev ? EnqueueScreen(pDev) : NULL;
+    slot->pDev = pDev;
+
+    /* the device's raw events may sit between two of its motions */
+    if (e->any.type != ET_RawMotion || !pDev ||
+        pDev->id != miEventQueue.lastMotion) {
+        miEventQueue.lastMotion = isMotion;
+        miEventQueue.lastMotionPos = ring->tail;
+    }
 
-    miEventQueue.lastMotion = isMotion;
-    miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+    AtomicStore(&ring->tail, ring->tail + 1);
+    miEventQueue.tail++;
+    miEventQueue.queued++;
+}
+
+/* Reports how many events have been queued, merged and dropped. */
+void
+mieqGetStats(MieqStatsPtr stats)
+{
+    input_lock();
+    stats->queued = miEventQueue.queued;
+    stats->merged = miEventQueue.merged;
+    stats->dropped = miEventQueue.droppedTotal;
+    input_unlock();
+}
+
+/*
+ * Copies the oldest queued event out of the queue.  Called only from
+ * mieqProcessInputEvents, without input_lock.
+ */
+static Bool
+mieqDequeue(InternalEvent *event, DeviceIntPtr *dev, ScreenPtr *screen)
+{
+    EventRingPtr ring = miEventQueue.consumer;
+    EventRingPtr next;
+    unsigned int head = ring->head;
+    EventPtr slot;
+
+    while (head == AtomicLoad(&ring->tail)) {
+        next = AtomicLoadPtr(&ring->next);
+        if (!next)
+            return FALSE;
+        /* the producer may have finished this ring just before leaving */
+        if (head != AtomicLoad(&ring->tail))
+            break;
+        miEventQueue.consumer = next;
+        mieqFreeRing(ring);
+        ring = next;
+        head = ring->head;
+    }
+
+    slot = &ring->events[head & (ring->size - 1)];
+    while (!AtomicCAS(&slot->state, SLOT_READY, SLOT_TAKEN))
+        ;                       /* a motion event is being folded in */
+
+    *event = *slot->events;
+    *dev = slot->pDev;
+    *screen = slot->pScreen;
+
+    AtomicStore(&ring->head, head + 1);
+    AtomicStore(&slot->state, SLOT_READY);
+    miEventQueue.head++;
+    return TRUE;
 }
 
 /**
@@ -501,14 +794,12 @@ mieqProcessDeviceEvent(DeviceIntPtr dev, InternalEvent *event, ScreenPtr screen)
 void
 mieqProcessInputEvents(void)
 {
-    EventRec *e = NULL;
     ScreenPtr screen;
     InternalEvent event;
     DeviceIntPtr dev = NULL, master = NULL;
+    unsigned int dropped;
     static Bool inProcessInputEvents = FALSE;
 
-    input_lock();
-
     /*
      * report an error if mieqProcessInputEvents() is called recursively;
      * this can happen, e.g., if something in the mieqProcessDeviceEvent()
@@ -517,25 +808,15 @@ mieqProcessInputEvents(void)
     BUG_WARN_MSG(inProcessInputEvents, "[mi] mieqProcessInputEvents() called recursively.\n");
     inProcessInputEvents = TRUE;
 
-    if (miEventQueue.dropped) {
-        ErrorF("[mi] EQ processing has resumed after %lu dropped events.\n",
-               (unsigned long) miEventQueue.dropped);
+    dropped = AtomicExchange(&miEventQueue.dropped, 0);
+    if (dropped) {
+        ErrorF("[mi] EQ processing has resumed after %u dropped events "
+               "(%lu since startup).\n", dropped, miEventQueue.droppedTotal);
         ErrorF
             ("[mi] This may be caused by a misbehaving driver monopolizing the server's resources.\n");
-        miEventQueue.dropped = 0;
     }
 
-    while (miEventQueue.head != miEventQueue.tail) {
-        e = &miEventQueue.events[miEventQueue.head];
-
-        event = *e->events;
-        dev = e->pDev;
-        screen = e->pScreen;
-
-        miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
-
-        input_unlock();
-
+    while (mieqDequeue(&event, &dev, &screen)) {
         master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
 
         if (screenIsSaved == SCREEN_SAVER_ON)
@@ -557,11 +838,7 @@ mieqProcessInputEvents(void)
                event.any.type == ET_TouchUpdate) &&
               event.device_event.flags & TOUCH_POINTER_EMULATED)))
             miPointerUpdateSprite(dev);
-
-        input_lock();
     }
 
     inProcessInputEvents = FALSE;
-
-    input_unlock();
 }
@@ -746,46 +746,81 @@ miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure)
     }
 }
 
+/* Children walked before miSpriteTrace asks for an index of them. */
+#define SPRITE_TRACE_INDEX_MIN 32
+
+static Bool
+miSpriteHit(WindowPtr pWin, int x, int y)
+{
+    BoxRec box;
+
+    return (pWin->mapped) &&
+        (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
+        (x < pWin->drawable.x + (int) pWin->drawable.width +
+         wBorderWidth(pWin)) &&
+        (y >= pWin->drawable.y - wBorderWidth(pWin)) &&
+        (y < pWin->drawable.y + (int) pWin->drawable.height +
+         wBorderWidth(pWin))
+        /* When a window is shaped, a further check
+         * is made to see if the point is inside
+         * borderSize
+         */
+        && (!wBoundingShape(pWin) || PointInBorderSize(pWin, x, y))
+        && (!wInputShape(pWin) ||
+            RegionContainsPoint(wInputShape(pWin),
+                                x - pWin->drawable.x,
+                                y - pWin->drawable.y, &box))
+        /* In rootless mode windows may be offscreen, even when
+         * they're in X's stack. (E.g. if the native window system
+         * implements some form of virtual desktop system).
+         */
+        && !pWin->unhittable;
+}
+
 WindowPtr
 miSpriteTrace(SpritePtr pSprite, int x, int y)
 {
-    WindowPtr pWin;
-    BoxRec box;
+    WindowPtr pParent, pWin;
+    WindowPtr *candidates;
+    int i, n, walked;
 
-    pWin = DeepestSpriteWin(pSprite)->firstChild;
-    while (pWin) {
-        if ((pWin->mapped) &&
-            (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
-            (x < pWin->drawable.x + (int) pWin->drawable.width +
-             wBorderWidth(pWin)) &&
-            (y >= pWin->drawable.y - wBorderWidth(pWin)) &&
-            (y < pWin->drawable.y + (int) pWin->drawable.height +
-             wBorderWidth(pWin))
-            /* When a window is shaped, a further check
-             * is made to see if the point is inside
-             * borderSize
-             */
-            && (!wBoundingShape(pWin) || PointInBorderSize(pWin, x, y))
-            && (!wInputShape(pWin) ||
-                RegionContainsPoint(wInputShape(pWin),
-                                    x - pWin->drawable.x,
-                                    y - pWin->drawable.y, &box))
-            /* In rootless mode windows may be offscreen, even when
-             * they're in X's stack. (E.g. if the native window system
-             * implements some form of virtual desktop system).
-             */
-            && !pWin->unhittable) {
-            if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
-                pSprite->spriteTraceSize += 10;
-                pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
-                                                    pSprite->spriteTraceSize,
-                                                    sizeof(WindowPtr));
+    pParent = DeepestSpriteWin(pSprite);
+    while (pParent) {
+        pWin = NullWindow;
+        /*
+         * With many children, only those whose cell in the parent's
+         * hit index contains x/y need testing; they come topmost first,
+         * so the first hit is the same window the sibling walk finds.
+         */
+        candidates = WindowHitCandidates(pParent, x, y, &n);
+        if (candidates) {
+            for (i = 0; i < n; i++)
+                if (miSpriteHit(candidates[i], x, y)) {
+                    pWin = candidates[i];
+                    break;
+                }
+        }
+        else {
+            walked = 0;
+            for (pWin = pParent->firstChild; pWin; pWin = pWin->nextSib) {
+                walked++;
+                if (miSpriteHit(pWin, x, y))
+                    break;
             }
-            pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
-            pWin = pWin->firstChild;
+            if (walked >= SPRITE_TRACE_INDEX_MIN && !pParent->hitIndex)
+                WindowHitIndexBuild(pParent);
         }
-        else
-            pWin = pWin->nextSib;
+        if (!pWin)
+            break;
+
+        if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
+            pSprite->spriteTraceSize += 10;
+            pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
+                                                pSprite->spriteTraceSize,
+                                                sizeof(WindowPtr));
+        }
+        pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+        pParent = pWin;
     }
     return DeepestSpriteWin(pSprite);
 }
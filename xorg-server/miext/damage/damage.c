@@ -121,6 +121,30 @@ getDrawableDamageRef(DrawablePtr pDrawable)
     DamagePtr	*pPrev = (DamagePtr *) \
 	dixLookupPrivateAddr(&(pWindow)->devPrivates, damageWinPrivateKey)
 
+/*
+ * Add pSrc to one of pDamage's regions.  pSrc was already coalesced as
+ * it was appended, so this is a plain union; see damageCoalesceAccumulated.
+ */
+static void
+damageAccumulate(DamagePtr pDamage, RegionPtr pDst, RegionPtr pSrc)
+{
+    RegionUnion(pDst, pDst, pSrc);
+}
+
+/*
+ * Coalesced appends can add up to many boxes again, so the box and waste
+ * policies are reapplied to an accumulated region, but only when it is
+ * handed out rather than on every append.  Tile snapping needs no second
+ * pass.  This is not counted in the stats, which describe appends.
+ */
+static void
+damageCoalesceAccumulated(DamagePtr pDamage, RegionPtr pRegion)
+{
+    if (pDamage->policy.type != DamagePolicyExact &&
+        pDamage->policy.type != DamagePolicyTileGrid)
+        DamageCoalesceRegion(&pDamage->policy, pRegion, NULL, NULL);
+}
+
 #if DAMAGE_DEBUG_ENABLE
 static void
 _damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
@@ -255,17 +279,45 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
         if (draw_x || draw_y)
             RegionTranslate(pDamageRegion, -draw_x, -draw_y);
 
+        /*
+         * Coalesce as the damage object asks, on a private copy
+         */
+        if (pDamage->policy.type != DamagePolicyExact &&
+            RegionNumRects(pDamageRegion) > 1) {
+            DrawablePtr pDamageDrawable = pDamage->pDrawable;
+            BoxRec bounds;
+
+            if (pDamageRegion == pRegion) {
+                pDamageRegion = &clippedRec;
+                RegionCopy(pDamageRegion, pRegion);
+                if (draw_x || draw_y)
+                    RegionTranslate(pRegion, draw_x, draw_y);
+            }
+            bounds.x1 = bounds.y1 = 0;
+            bounds.x2 = pDamageDrawable->width;
+            bounds.y2 = pDamageDrawable->height;
+            if (pDamageDrawable->type == DRAWABLE_WINDOW) {
+                int bw = ((WindowPtr) pDamageDrawable)->borderWidth;
+
+                bounds.x1 -= bw;
+                bounds.y1 -= bw;
+                bounds.x2 += bw;
+                bounds.y2 += bw;
+            }
+            DamageCoalesceRegion(&pDamage->policy, pDamageRegion, &bounds,
+                                 &pDamage->stats);
+        }
+
         /* Store damage region if needed after submission. */
         if (pDamage->reportAfter)
-            RegionUnion(&pDamage->pendingDamage,
-                        &pDamage->pendingDamage, pDamageRegion);
+            damageAccumulate(pDamage, &pDamage->pendingDamage, pDamageRegion);
 
         /* Report damage now, if desired. */
         if (!pDamage->reportAfter) {
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, pDamageRegion);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+                damageAccumulate(pDamage, &pDamage->damage, pDamageRegion);
         }
 
         /*
@@ -289,12 +341,13 @@ damageRegionProcessPending(DrawablePtr pDrawable)
 
     for (; pDamage != NULL; pDamage = pDamage->pNext) {
         if (pDamage->reportAfter) {
+            damageCoalesceAccumulated(pDamage, &pDamage->pendingDamage);
             /* It's possible that there is only interest in postRendering reporting. */
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, &pDamage->pendingDamage);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage,
-                            &pDamage->pendingDamage);
+                damageAccumulate(pDamage, &pDamage->damage,
+                                 &pDamage->pendingDamage);
         }
 
         if (pDamage->reportAfter)
@@ -1760,6 +1813,19 @@ DamageCreate(DamageReportFunc damageReport,
              DamageDestroyFunc damageDestroy,
              DamageReportLevel damageLevel,
              Bool isInternal, ScreenPtr pScreen, void *closure)
+{
+    static const DamagePolicyRec exact = { DamagePolicyExact, 0 };
+
+    return DamageCreateWithPolicy(damageReport, damageDestroy, damageLevel,
+                                  isInternal, pScreen, closure, &exact);
+}
+
+DamagePtr
+DamageCreateWithPolicy(DamageReportFunc damageReport,
+                       DamageDestroyFunc damageDestroy,
+                       DamageReportLevel damageLevel,
+                       Bool isInternal, ScreenPtr pScreen, void *closure,
+                       const DamagePolicyRec *policy)
 {
     damageScrPriv(pScreen);
     DamagePtr pDamage;
@@ -1782,6 +1848,7 @@ DamageCreate(DamageReportFunc damageReport,
     pDamage->damageReport = damageReport;
     pDamage->damageDestroy = damageDestroy;
     pDamage->pScreen = pScreen;
+    pDamage->policy = *policy;
 
     (*pScrPriv->funcs.Create) (pDamage);
 
@@ -1931,6 +1998,7 @@ DamageEmpty(DamagePtr pDamage)
 RegionPtr
 DamageRegion(DamagePtr pDamage)
 {
+    damageCoalesceAccumulated(pDamage, &pDamage->damage);
     return &pDamage->damage;
 }
 
@@ -1940,6 +2008,12 @@ DamagePendingRegion(DamagePtr pDamage)
     return &pDamage->pendingDamage;
 }
 
+void
+DamageGetStats(DamagePtr pDamage, DamageStatsPtr stats)
+{
+    *stats = pDamage->stats;
+}
+
 void
 DamageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion)
 {
@@ -1987,36 +2061,37 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
 
     switch (pDamage->damageLevel) {
     case DamageReportRawRegion:
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, &pDamage->damage, pDamageRegion);
         (*pDamage->damageReport) (pDamage, pDamageRegion, pDamage->closure);
         break;
     case DamageReportDeltaRegion:
         RegionNull(&tmpRegion);
         RegionSubtract(&tmpRegion, pDamageRegion, &pDamage->damage);
         if (RegionNotEmpty(&tmpRegion)) {
-            RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+            damageAccumulate(pDamage, &pDamage->damage, pDamageRegion);
             (*pDamage->damageReport) (pDamage, &tmpRegion, pDamage->closure);
         }
         RegionUninit(&tmpRegion);
         break;
     case DamageReportBoundingBox:
         tmpBox = *RegionExtents(&pDamage->damage);
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, &pDamage->damage, pDamageRegion);
         if (!BOX_SAME(&tmpBox, RegionExtents(&pDamage->damage))) {
+            damageCoalesceAccumulated(pDamage, &pDamage->damage);
             (*pDamage->damageReport) (pDamage, &pDamage->damage,
                                       pDamage->closure);
         }
         break;
     case DamageReportNonEmpty:
         was_empty = !RegionNotEmpty(&pDamage->damage);
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, &pDamage->damage, pDamageRegion);
         if (was_empty && RegionNotEmpty(&pDamage->damage)) {
             (*pDamage->damageReport) (pDamage, &pDamage->damage,
                                       pDamage->closure);
         }
         break;
     case DamageReportNone:
-        RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+        damageAccumulate(pDamage, &pDamage->damage, pDamageRegion);
         break;
     }
 }
@@ -37,6 +37,38 @@ typedef enum _damageReportLevel {
     DamageReportNone
 } DamageReportLevel;
 
+/*
+ * How a damage object coalesces the regions it collects.  Exact keeps
+ * every box; the others trade over-reported pixels for fewer boxes:
+ *
+ *  DamagePolicyBoxLimit   merge neighbouring boxes until at most param
+ *                         remain
+ *  DamagePolicyTileGrid   grow each box out to a grid of param pixel
+ *                         tiles
+ *  DamagePolicyAreaWaste  collapse to the bounding box while that adds
+ *                         no more than param percent of it
+ */
+typedef enum _damagePolicyType {
+    DamagePolicyExact,
+    DamagePolicyBoxLimit,
+    DamagePolicyTileGrid,
+    DamagePolicyAreaWaste
+} DamagePolicyType;
+
+typedef struct _damagePolicy {
+    DamagePolicyType type;
+    int param;
+} DamagePolicyRec, *DamagePolicyPtr;
+
+/* What coalescing has done to a damage object's regions so far. */
+typedef struct _damageStats {
+    CARD64 regions;             /* regions coalesced */
+    CARD64 boxesIn;             /* boxes before coalescing */
+    CARD64 boxesOut;            /* boxes after */
+    CARD64 pixelsIn;            /* pixels before coalescing */
+    CARD64 pixelsOut;           /* pixels after; the excess is over-reported */
+} DamageStatsRec, *DamageStatsPtr;
+
 typedef void (*DamageReportFunc) (DamagePtr pDamage, RegionPtr pRegion,
                                   void *closure);
 typedef void (*DamageDestroyFunc) (DamagePtr pDamage, void *closure);
@@ -67,6 +99,13 @@ DamageCreate(DamageReportFunc damageReport,
              DamageReportLevel damageLevel,
              Bool isInternal, ScreenPtr pScreen, void *closure);
 
+extern _X_EXPORT DamagePtr
+DamageCreateWithPolicy(DamageReportFunc damageReport,
+                       DamageDestroyFunc damageDestroy,
+                       DamageReportLevel damageLevel,
+                       Bool isInternal, ScreenPtr pScreen, void *closure,
+                       const DamagePolicyRec *policy);
+
 extern _X_EXPORT void
  DamageDrawInternal(ScreenPtr pScreen, Bool enable);
 
@@ -112,4 +151,22 @@ extern _X_EXPORT void
 
 extern _X_EXPORT DamageScreenFuncsPtr DamageGetScreenFuncs(ScreenPtr);
 
+extern _X_EXPORT void
+ DamageGetStats(DamagePtr pDamage, DamageStatsPtr stats);
+
+/* Coalesce pRegion in place; boxes are kept inside pBounds, if given. */
+extern _X_EXPORT void
+ DamageCoalesceRegion(const DamagePolicyRec *policy, RegionPtr pRegion,
+                      const BoxRec *pBounds, DamageStatsPtr stats);
+
+/* Parse "exact", "boxes:N", "tile:N" or "waste:N" into policy. */
+extern _X_EXPORT Bool
+ DamageParsePolicy(const char *name, DamagePolicyPtr policy);
+
+/*
+ * Policy for damage objects that forward screen updates: DAMAGE extension
+ * clients and the shadow framebuffer.  Set with -damagepolicy.
+ */
+extern _X_EXPORT DamagePolicyRec DamageDefaultPolicy;
+
 #endif                          /* _DAMAGE_H_ */
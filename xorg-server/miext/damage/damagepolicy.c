@@ -0,0 +1,239 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Damage coalescing policies.
+ *
+ * Every rendering operation appends its exact region to each damage
+ * object watching the drawable, so a busy client leaves consumers with
+ * thousands of tiny boxes.  A policy lets a damage object report a
+ * slightly larger area in fewer boxes instead.  Coalescing only ever
+ * grows a region, so nothing damaged is lost.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "misc.h"
+#include "scrnintstr.h"
+#include "regionstr.h"
+#include "damage.h"
+
+DamagePolicyRec DamageDefaultPolicy = { DamagePolicyExact, 0 };
+
+static CARD64
+damageRegionArea(RegionPtr pRegion)
+{
+    BoxPtr pBox = RegionRects(pRegion);
+    int n = RegionNumRects(pRegion);
+    CARD64 area = 0;
+
+    while (n--) {
+        area += (CARD64) (pBox->x2 - pBox->x1) * (pBox->y2 - pBox->y1);
+        pBox++;
+    }
+    return area;
+}
+
+static CARD64
+damageBoxArea(const BoxRec *pBox)
+{
+    return (CARD64) (pBox->x2 - pBox->x1) * (pBox->y2 - pBox->y1);
+}
+
+/*
+ * Merge runs of consecutive boxes into their bounding boxes.  Region
+ * boxes are sorted into bands, so consecutive boxes are neighbours.
+ * Overlapping merged boxes can split into more bands again, so the runs
+ * double until the result fits; at worst it is the extents.
+ */
+static void
+damageLimitBoxes(RegionPtr pRegion, int limit)
+{
+    int n = RegionNumRects(pRegion);
+    BoxPtr pBox = RegionRects(pRegion);
+    BoxPtr merged;
+    RegionRec result;
+    int run, i, j, m;
+
+    if (limit < 1)
+        limit = 1;
+    if (n <= limit)
+        return;
+    if (limit == 1)
+        goto extents;
+
+    merged = xallocarray(limit, sizeof(BoxRec));
+    if (!merged)
+        goto extents;
+
+    for (run = (n + limit - 1) / limit; run < n; run *= 2) {
+        for (i = 0, m = 0; i < n; i += run, m++) {
+            merged[m] = pBox[i];
+            for (j = i + 1; j < i + run && j < n; j++) {
+                merged[m].x1 = min(merged[m].x1, pBox[j].x1);
+                merged[m].x2 = max(merged[m].x2, pBox[j].x2);
+                merged[m].y2 = max(merged[m].y2, pBox[j].y2);
+            }
+        }
+        if (!RegionInitBoxes(&result, merged, m))
+            break;
+        if (RegionNumRects(&result) <= limit) {
+            RegionCopy(pRegion, &result);
+            RegionUninit(&result);
+            free(merged);
+            return;
+        }
+        RegionUninit(&result);
+    }
+    free(merged);
+
+ extents:
+    RegionReset(pRegion, RegionExtents(pRegion));
+}
+
+/* Round v down to a multiple of tile, also for negative v. */
+static int
+damageTileFloor(int v, int tile)
+{
+    return v - ((v % tile) + tile) % tile;
+}
+
+/* Grow every box out to the tile grid. */
+static void
+damageSnapToTiles(RegionPtr pRegion, int tile, const BoxRec *pBounds)
+{
+    int n = RegionNumRects(pRegion);
+    BoxPtr pBox = RegionRects(pRegion);
+    BoxRec bounds = { MINSHORT, MINSHORT, MAXSHORT, MAXSHORT };
+    BoxPtr snapped;
+    RegionRec result;
+    int i;
+
+    if (tile < 2)
+        return;
+    if (pBounds)
+        bounds = *pBounds;
+
+    snapped = xallocarray(n, sizeof(BoxRec));
+    if (!snapped)
+        return;
+    for (i = 0; i < n; i++) {
+        snapped[i].x1 = max(damageTileFloor(pBox[i].x1, tile), bounds.x1);
+        snapped[i].y1 = max(damageTileFloor(pBox[i].y1, tile), bounds.y1);
+        snapped[i].x2 = min(damageTileFloor(pBox[i].x2 + tile - 1, tile),
+                            bounds.x2);
+        snapped[i].y2 = min(damageTileFloor(pBox[i].y2 + tile - 1, tile),
+                            bounds.y2);
+    }
+    if (RegionInitBoxes(&result, snapped, n)) {
+        RegionCopy(pRegion, &result);
+        RegionUninit(&result);
+    }
+    free(snapped);
+}
+
+static void
+damageLimitWaste(RegionPtr pRegion, int percent)
+{
+    CARD64 extents = damageBoxArea(RegionExtents(pRegion));
+
+    if ((extents - damageRegionArea(pRegion)) * 100 <= extents * percent)
+        RegionReset(pRegion, RegionExtents(pRegion));
+}
+
+void
+DamageCoalesceRegion(const DamagePolicyRec *policy, RegionPtr pRegion,
+                     const BoxRec *pBounds, DamageStatsPtr stats)
+{
+    CARD64 pixelsIn;
+    int boxesIn;
+
+    boxesIn = RegionNumRects(pRegion);
+    if (policy->type == DamagePolicyExact || boxesIn <= 1)
+        return;
+    pixelsIn = damageRegionArea(pRegion);
+
+    switch (policy->type) {
+    case DamagePolicyExact:
+        break;
+    case DamagePolicyBoxLimit:
+        damageLimitBoxes(pRegion, policy->param);
+        break;
+    case DamagePolicyTileGrid:
+        damageSnapToTiles(pRegion, policy->param, pBounds);
+        break;
+    case DamagePolicyAreaWaste:
+        damageLimitWaste(pRegion, policy->param);
+        break;
+    }
+
+    if (stats) {
+        stats->regions++;
+        stats->boxesIn += boxesIn;
+        stats->boxesOut += RegionNumRects(pRegion);
+        stats->pixelsIn += pixelsIn;
+        stats->pixelsOut += damageRegionArea(pRegion);
+    }
+}
+
+Bool
+DamageParsePolicy(const char *name, DamagePolicyPtr policy)
+{
+    static const struct {
+        const char *name;
+        DamagePolicyType type;
+    } policies[] = {
+        { "boxes:", DamagePolicyBoxLimit },
+        { "tile:", DamagePolicyTileGrid },
+        { "waste:", DamagePolicyAreaWaste },
+    };
+    char *end;
+    long param;
+    int i;
+
+    if (strcmp(name, "exact") == 0) {
+        policy->type = DamagePolicyExact;
+        policy->param = 0;
+        return TRUE;
+    }
+    for (i = 0; i < ARRAY_SIZE(policies); i++) {
+        size_t len = strlen(policies[i].name);
+
+        if (strncmp(name, policies[i].name, len) != 0)
+            continue;
+        param = strtol(name + len, &end, 10);
+        if (end == name + len || *end || param < 1 || param > 65535)
+            return FALSE;
+        if (policies[i].type == DamagePolicyAreaWaste && param > 100)
+            return FALSE;
+        policy->type = policies[i].type;
+        policy->param = param;
+        return TRUE;
+    }
+    return FALSE;
+}
@@ -49,6 +49,9 @@ typedef struct _damage {
     Bool reportAfter;
     RegionRec pendingDamage;    /* will be flushed post submission at the latest */
     ScreenPtr pScreen;
+
+    DamagePolicyRec policy;
+    DamageStatsRec stats;
 } DamageRec;
 
 typedef struct _damageScrPriv {
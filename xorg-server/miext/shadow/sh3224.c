@@ -97,10 +97,9 @@ sh24_32BltLine(CARD8 *srcLine,
     }
 }
 
-void
-shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowUpdate32to24Region(ScreenPtr pScreen, shadowBufPtr pBuf, RegionPtr damage)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
     int nbox = RegionNumRects(damage);
     BoxPtr pbox = RegionRects(damage);
@@ -136,3 +135,9 @@ shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }
 }
+
+void
+shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateTiles(pScreen, pBuf, shadowUpdate32to24Region);
+}
@@ -34,8 +34,30 @@
 #include    "regionstr.h"
 #include    "globals.h"
 #include    "gcstruct.h"
+#include    "threadpool.h"
 #include    "shadow.h"
 
+/*
+ * Large updates are split into bands SHADOW_TILE rows high, each
+ * covering only the SHADOW_TILE square tiles the damage touches, and
+ * the bands are run on the worker threads.  Smaller ones are not worth
+ * handing off.
+ */
+#define SHADOW_TILE         64
+#define SHADOW_TILED_MIN    (256 * 256)
+
+typedef struct _shadowTiles {
+    ScreenPtr pScreen;
+    shadowBufPtr pBuf;
+    ShadowRegionUpdateProc update;
+    RegionPtr damage;
+    int width, height;
+    int tilesX;
+    int firstBand;
+    int rowWords;               /* words of dirty bits per band */
+    CARD32 *dirty;
+} shadowTilesRec, *shadowTilesPtr;
+
 static DevPrivateKeyRec shadowScrPrivateKeyRec;
 #define shadowScrPrivateKey (&shadowScrPrivateKeyRec)
 
@@ -125,9 +147,10 @@ shadowSetup(ScreenPtr pScreen)
     pBuf = malloc(sizeof(shadowBufRec));
     if (!pBuf)
         return FALSE;
-    pBuf->pDamage = DamageCreate((DamageReportFunc) NULL,
-                                 (DamageDestroyFunc) NULL,
-                                 DamageReportNone, TRUE, pScreen, pScreen);
+    pBuf->pDamage = DamageCreateWithPolicy((DamageReportFunc) NULL,
+                                           (DamageDestroyFunc) NULL,
+                                           DamageReportNone, TRUE, pScreen,
+                                           pScreen, &DamageDefaultPolicy);
     if (!pBuf->pDamage) {
         free(pBuf);
         return FALSE;
@@ -141,6 +164,7 @@ shadowSetup(ScreenPtr pScreen)
     pBuf->pPixmap = 0;
     pBuf->closure = 0;
     pBuf->randr = 0;
+    pBuf->threaded = FALSE;
 
     dixSetPrivate(&pScreen->devPrivates, shadowScrPrivateKey, pBuf);
     return TRUE;
@@ -193,3 +217,113 @@ shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap)
         pBuf->pPixmap = 0;
     }
 }
+
+void
+shadowSetThreaded(ScreenPtr pScreen, Bool threaded)
+{
+    shadowBuf(pScreen);
+
+    pBuf->threaded = threaded;
+}
+
+#define shadowTileDirty(t,x,y) \
+    ((t)->dirty[(y) * (t)->rowWords + ((x) >> 5)] & (1U << ((x) & 31)))
+
+static void
+shadowUpdateBand(void *data, int index)
+{
+    shadowTilesPtr tiles = data;
+    int band = tiles->firstBand + index;
+    BoxRec whole;
+    BoxPtr boxes;
+    RegionRec region;
+    int x, n = 0;
+
+    whole.x1 = 0;
+    whole.y1 = band * SHADOW_TILE;
+    whole.x2 = tiles->width;
+    whole.y2 = min((band + 1) * SHADOW_TILE, tiles->height);
+
+    /* one box per run of dirty tiles */
+    boxes = xallocarray(tiles->tilesX / 2 + 1, sizeof(BoxRec));
+    for (x = 0; boxes && x < tiles->tilesX; x++) {
+        if (!shadowTileDirty(tiles, x, index))
+            continue;
+        boxes[n].x1 = x * SHADOW_TILE;
+        boxes[n].y1 = whole.y1;
+        while (x < tiles->tilesX && shadowTileDirty(tiles, x, index))
+            x++;
+        boxes[n].x2 = min(x * SHADOW_TILE, tiles->width);
+        boxes[n].y2 = whole.y2;
+        n++;
+    }
+
+    /* out of memory: update all of the band's damage rather than lose it */
+    if (!boxes || (n && !RegionInitBoxes(&region, boxes, n))) {
+        RegionInit(&region, &whole, 1);
+        n = 1;
+    }
+
+    if (n) {
+        RegionIntersect(&region, &region, tiles->damage);
+        if (RegionNotEmpty(&region))
+            (*tiles->update) (tiles->pScreen, tiles->pBuf, &region);
+        RegionUninit(&region);
+    }
+    free(boxes);
+}
+
+void
+shadowUpdateTiles(ScreenPtr pScreen, shadowBufPtr pBuf,
+                  ShadowRegionUpdateProc update)
+{
+    RegionPtr damage = DamageRegion(pBuf->pDamage);
+    BoxPtr extents = RegionExtents(damage);
+    int nbox = RegionNumRects(damage);
+    BoxPtr pbox = RegionRects(damage);
+    shadowTilesRec tiles;
+    int nbands, x, y, x1, x2, y1, y2;
+
+    if (!pBuf->threaded ||
+        (extents->x2 - extents->x1) * (extents->y2 - extents->y1) <
+        SHADOW_TILED_MIN || ThreadPoolThreads() == 1) {
+        (*update) (pScreen, pBuf, damage);
+        return;
+    }
+
+    tiles.pScreen = pScreen;
+    tiles.pBuf = pBuf;
+    tiles.update = update;
+    tiles.damage = damage;
+    tiles.width = pBuf->pPixmap->drawable.width;
+    tiles.height = pBuf->pPixmap->drawable.height;
+    tiles.tilesX = (tiles.width + SHADOW_TILE - 1) / SHADOW_TILE;
+    tiles.rowWords = (tiles.tilesX + 31) / 32;
+    tiles.firstBand = max(extents->y1, 0) / SHADOW_TILE;
+    nbands = (min(extents->y2, tiles.height) + SHADOW_TILE - 1) / SHADOW_TILE -
+        tiles.firstBand;
+    if (nbands <= 0)
+        return;
+
+    tiles.dirty = calloc(nbands * tiles.rowWords, sizeof(CARD32));
+    if (!tiles.dirty) {
+        (*update) (pScreen, pBuf, damage);
+        return;
+    }
+
+    for (; nbox--; pbox++) {
+        x1 = max(pbox->x1, 0);
+        y1 = max(pbox->y1, 0);
+        x2 = min(pbox->x2, tiles.width);
+        y2 = min(pbox->y2, tiles.height);
+        if (x1 >= x2 || y1 >= y2)
+            continue;
+        for (y = y1 / SHADOW_TILE; y <= (y2 - 1) / SHADOW_TILE; y++)
+            for (x = x1 / SHADOW_TILE; x <= (x2 - 1) / SHADOW_TILE; x++)
+                tiles.dirty[(y - tiles.firstBand) * tiles.rowWords +
+                            (x >> 5)] |= 1U << (x & 31);
+    }
+
+    ThreadPoolRun(shadowUpdateBand, &tiles, nbands);
+    free(tiles.dirty);
+}
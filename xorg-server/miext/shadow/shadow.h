@@ -34,6 +34,10 @@ typedef struct _shadowBuf *shadowBufPtr;
 
 typedef void (*ShadowUpdateProc) (ScreenPtr pScreen, shadowBufPtr pBuf);
 
+/* Update the part of the screen covered by damage. */
+typedef void (*ShadowRegionUpdateProc) (ScreenPtr pScreen, shadowBufPtr pBuf,
+                                        RegionPtr damage);
+
 #define SHADOW_WINDOW_RELOCATE 1
 #define SHADOW_WINDOW_READ 2
 #define SHADOW_WINDOW_WRITE 4
@@ -50,6 +54,7 @@ typedef struct _shadowBuf {
     PixmapPtr pPixmap;
     void *closure;
     int randr;
+    Bool threaded;
 
     /* screen wrappers */
     GetImageProcPtr GetImage;
@@ -81,6 +86,23 @@ shadowAdd(ScreenPtr pScreen,
 extern _X_EXPORT void
  shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap);
 
+/*
+ * Let the packed and rotated updates below split large damage into bands
+ * and run them on worker threads.  Only for a window proc that can be
+ * called from several threads at once, as for a linear frame buffer.
+ */
+extern _X_EXPORT void
+ shadowSetThreaded(ScreenPtr pScreen, Bool threaded);
+
+/*
+ * Run update over the damage, in bands of dirty tiles on worker threads
+ * when the screen allows it and the damage is large enough, otherwise
+ * directly.
+ */
+extern _X_EXPORT void
+ shadowUpdateTiles(ScreenPtr pScreen, shadowBufPtr pBuf,
+                   ShadowRegionUpdateProc update);
+
 extern _X_EXPORT void
  shadowUpdateAfb4(ScreenPtr pScreen, shadowBufPtr pBuf);
 
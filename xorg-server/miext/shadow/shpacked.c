@@ -40,10 +40,9 @@
 #include    "shadow.h"
 #include    "fb.h"
 
-void
-shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowUpdatePackedRegion(ScreenPtr pScreen, shadowBufPtr pBuf, RegionPtr damage)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
     int nbox = RegionNumRects(damage);
     BoxPtr pbox = RegionRects(damage);
@@ -107,3 +106,9 @@ shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }
 }
+
+void
+shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateTiles(pScreen, pBuf, shadowUpdatePackedRegion);
+}
@@ -48,10 +48,9 @@
 #define TOP_TO_BOTTOM	2
 #define BOTTOM_TO_TOP	-2
 
-void
-shadowUpdateRotatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+static void
+shadowUpdateRotatePackedRegion(ScreenPtr pScreen, shadowBufPtr pBuf, RegionPtr damage)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
     int nbox = RegionNumRects(damage);
     BoxPtr pbox = RegionRects(damage);
@@ -296,3 +295,9 @@ shadowUpdateRotatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
         }
     }
 }
+
+void
+shadowUpdateRotatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateTiles(pScreen, pBuf, shadowUpdateRotatePackedRegion);
+}
@@ -53,10 +53,13 @@
 #define PREFETCH
 #endif
 
-void
-FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
+#define PASTE(a,b)          a##b
+#define REGION_NAME(f)      PASTE(f, Region)
+#define REGIONFUNC          REGION_NAME(FUNC)
+
+static void
+REGIONFUNC(ScreenPtr pScreen, shadowBufPtr pBuf, RegionPtr damage)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
     PixmapPtr pShadow = pBuf->pPixmap;
     int nbox = RegionNumRects(damage);
     BoxPtr pbox = RegionRects(damage);
@@ -150,3 +153,9 @@ FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
         pbox++;
     }                           /*  nbox */
 }
+
+void
+FUNC(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    shadowUpdateTiles(pScreen, pBuf, REGIONFUNC);
+}
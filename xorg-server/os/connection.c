@@ -317,6 +317,7 @@ CreateWellKnownSockets(void)
 #if !defined(WIN32)
     OsSignal(SIGPIPE, SIG_IGN);
     OsSignal(SIGHUP, AutoResetServer);
+    OsSignal(SIGUSR2, RequestProfileSignal);
 #endif
     OsSignal(SIGINT, GiveUp);
     OsSignal(SIGTERM, GiveUp);
@@ -648,6 +649,7 @@ AllocNewConnection(XtransConnInfo trans_conn, int fd, CARD32 conn_time)
     oc->auth_id = None;
     oc->conn_time = conn_time;
     oc->flags = 0;
+    InitOsBuffers(oc);
     if (!(client = NextAvailableClient((void *) oc))) {
         free(oc);
         return NullClient;
@@ -859,6 +861,13 @@ CloseDownConnection(ClientPtr client)
 #endif
     if (oc->output)
         FlushClient(client, oc, (char *) NULL, 0);
+    LogMessageVerb(X_INFO, 3, "client %d disconnected: read %llu bytes in "
+                   "%llu calls, wrote %llu bytes in %llu calls\n",
+                   client->index,
+                   (unsigned long long) oc->stats.bytesRead,
+                   (unsigned long long) oc->stats.reads,
+                   (unsigned long long) oc->stats.bytesWritten,
+                   (unsigned long long) oc->stats.writes);
     CloseDownFileDescriptor(oc);
     FreeOsBuffers(oc);
     free(client->osPrivate);
@@ -89,22 +89,50 @@ typedef struct _connectionInput {
     int lenLastReq;
     int size;
     unsigned int ignoreBytes;   /* bytes to ignore before the next request */
+    int scanned;                /* requests before this offset are complete */
 } ConnectionInput;
 
+/*
+ * Output that could not be written at once waits in buf.  Large buffers
+ * handed over through WriteToClientBuffer are not copied there; they are
+ * queued by reference as segments behind buf and written straight from
+ * the caller's memory with writev.  Once any segment is queued, later
+ * output goes behind it as well, into segments that carry their own
+ * copy of the data.
+ */
+typedef struct _outputSegment {
+    struct _outputSegment *next;
+    const char *data;           /* first byte not yet written */
+    int count;                  /* bytes not yet written */
+    int room;                   /* space after them, copied segments only */
+    WriteDoneProcPtr done;      /* NULL if the data follows the segment */
+    void *closure;
+} OutputSegment, *OutputSegmentPtr;
+
 typedef struct _connectionOutput {
     struct _connectionOutput *next;
     unsigned char *buf;
     int size;
     int count;
+    OutputSegmentPtr segments;  /* queued in order after buf */
+    OutputSegmentPtr *lastSegment;
 } ConnectionOutput;
 
-static ConnectionInputPtr AllocateInputBuffer(void);
-static ConnectionOutputPtr AllocateOutputBuffer(void);
+static ConnectionInputPtr GetInputBuffer(void);
+static void PutInputBuffer(ConnectionInputPtr oci);
+static ConnectionOutputPtr GetOutputBuffer(void);
+static void PutOutputBuffer(ConnectionOutputPtr oco);
+static void ScheduleBufferTrim(void);
+static int FlushOutput(ClientPtr who, OsCommPtr oc, const char *extraBuf,
+                       int extraCount, WriteDoneProcPtr done, void *closure);
 
 static Bool CriticalOutputPending;
 static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
 static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
+static int numFreeInputs, numFreeOutputs;
+static OsTimerPtr BufferTrimTimer;
+static Bool BufferTrimPending;
 static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 
 #define get_req_len(req,cli) ((cli)->swapped ? \
@@ -116,8 +144,24 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 				  bswap_32(((xBigReq *)(req))->length) : \
 				  ((xBigReq *)(req))->length)
 
+/*
+ * Every connection starts out with BUFSIZE buffers.  A client whose reads
+ * keep filling its input buffer, or whose output keeps backing up, gets a
+ * larger preferred size, up to BUFMAX; the preference halves again after
+ * BUFSHRINKRUN uses of less than a quarter of it, and falls back to
+ * BUFSIZE once the client has been quiet for BUFIDLETIME.  Only BUFSIZE
+ * buffers are shared through the free lists, at most BUFFREEMAX each.
+ */
 #define BUFSIZE 16384
-#define BUFWATERMARK 32768
+#define BUFMAX (4 * 1024 * 1024)
+#define BUFSHRINKRUN 16
+#define BUFIDLETIME 10000
+#define BUFFREEMAX 8
+
+/* smaller buffers are cheaper to copy than to queue by reference */
+#define OUTPUT_REF_MIN 4096
+/* iovecs passed to a single writev */
+#define OUTPUT_IOV_MAX 64
 
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
@@ -147,8 +191,36 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
  *  needed = the length of the request that we're trying to
  *  read.  Watch out: needed sometimes counts bytes and sometimes
  *  counts CARD32's.
+ *
+ *  After every read, ScanRequests walks the complete requests that
+ *  arrived and records where they end in scanned.  Requests before that
+ *  offset are handed out without looking at the buffer state again, so
+ *  a batch that came in with one read is dispatched back to back.
+ *  scanned is reset to 0 whenever data in the buffer moves.
  */
 
+static void
+ScanRequests(ClientPtr client, ConnectionInputPtr oci)
+{
+    char *p = oci->buffer + oci->scanned;
+    char *end = oci->buffer + oci->bufcnt;
+    unsigned int len;
+
+    if (oci->ignoreBytes)
+        return;
+    if (p < oci->bufptr)
+        p = oci->bufptr;
+
+    while (end - p >= sizeof(xReq)) {
+        len = get_req_len((xReq *) p, client) << 2;
+        /* leave big and short requests to the slow path */
+        if (len < sizeof(xReq) || len > end - p)
+            break;
+        p += len;
+    }
+    oci->scanned = p - oci->buffer;
+}
+
 /*****************************************************************
  * ReadRequestFromClient
  *    Returns one request in client->requestBuffer.  The request
@@ -200,7 +272,7 @@ YieldControlDeath(void)
 /* If an input buffer was empty, either free it if it is too big or link it
  * into our list of free input buffers.  This means that different clients can
  * share the same input buffer (at different times).  This was done to save
- * memory.
+ * memory.  A client that currently prefers a larger buffer keeps its own.
  */
 static void
 NextAvailableInput(OsCommPtr oc)
@@ -209,20 +281,38 @@ NextAvailableInput(OsCommPtr oc)
         if (AvailableInput != oc) {
             ConnectionInputPtr aci = AvailableInput->input;
 
-            if (aci->size > BUFWATERMARK) {
-                free(aci->buffer);
-                free(aci);
-            }
-            else {
-                aci->next = FreeInputs;
-                FreeInputs = aci;
+            if (aci->size <= BUFSIZE ||
+                aci->size > AvailableInput->input_size) {
+                PutInputBuffer(aci);
+                AvailableInput->input = NULL;
             }
-            AvailableInput->input = NULL;
         }
         AvailableInput = NULL;
     }
 }
 
+/*
+ * Move a client's preferred buffer size towards what it uses: double it
+ * when the buffer ran full, halve it after a run of light use.
+ */
+static void
+AdaptBufferSize(int *size, int *run, int capacity, int used)
+{
+    if (used >= capacity) {
+        *size = min(max(*size, capacity), BUFMAX / 2) * 2;
+        *run = 0;
+        ScheduleBufferTrim();
+    }
+    else if (*size > BUFSIZE && used < *size / 4) {
+        if (++*run >= BUFSHRINKRUN) {
+            *size = max(*size / 2, BUFSIZE);
+            *run = 0;
+        }
+    }
+    else
+        *run = 0;
+}
+
 int
 ReadRequestFromClient(ClientPtr client)
 {
@@ -239,10 +329,7 @@ ReadRequestFromClient(ClientPtr client)
     /* make sure we have an input buffer */
 
     if (!oci) {
-        if ((oci = FreeInputs)) {
-            FreeInputs = oci->next;
-        }
-        else if (!(oci = AllocateInputBuffer())) {
+        if (!(oci = GetInputBuffer())) {
             YieldControlDeath();
             return -1;
         }
@@ -261,6 +348,18 @@ ReadRequestFromClient(ClientPtr client)
 
     oci->bufptr += oci->lenLastReq;
 
+    if (oci->bufptr < oci->buffer + oci->scanned) {
+        /* complete, and its length was checked when it was read */
+        request = (xReq *) oci->bufptr;
+        client->req_len = get_req_len(request, client);
+        needed = client->req_len << 2;
+        oci->lenLastReq = needed;
+        if (oci->bufptr + needed == oci->buffer + oci->bufcnt)
+            AvailableInput = oc;
+        client->requestBuffer = (void *) oci->bufptr;
+        return needed;
+    }
+
     need_header = FALSE;
     move_header = FALSE;
     gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
@@ -316,26 +415,32 @@ ReadRequestFromClient(ClientPtr client)
             oci->lenLastReq = gotnow;
             return needed;
         }
-        if ((gotnow == 0) || ((oci->bufptr - oci->buffer + needed) > oci->size)) {
-            /* no data, or the request is too big to fit in the buffer */
+        if ((gotnow == 0) || ((oci->bufptr - oci->buffer + needed) > oci->size) ||
+            (oci->bufptr != oci->buffer &&
+             oci->size - oci->bufcnt < oci->size / 4)) {
+            /* no data, the request is too big to fit in the buffer, or
+             * so little room is left that the read would come up short */
+
+            unsigned int want = max(needed, oc->input_size);
 
             if ((gotnow > 0) && (oci->bufptr != oci->buffer))
                 /* save the data we've already read */
                 memmove(oci->buffer, oci->bufptr, gotnow);
-            if (needed > oci->size) {
-                /* make buffer bigger to accomodate request */
+            if (want > oci->size || oci->size > 2 * want) {
+                /* make the buffer fit the request, and the client */
                 char *ibuf;
 
-                ibuf = (char *) realloc(oci->buffer, needed);
+                ibuf = (char *) realloc(oci->buffer, want);
                 if (!ibuf) {
                     YieldControlDeath();
                     return -1;
                 }
-                oci->size = needed;
+                oci->size = want;
                 oci->buffer = ibuf;
             }
             oci->bufptr = oci->buffer;
             oci->bufcnt = gotnow;
+            oci->scanned = 0;
         }
         /*  XXX this is a workaround.  This function is sometimes called
          *  after the trans_conn has been freed.  In this case trans_conn
@@ -349,6 +454,7 @@ ReadRequestFromClient(ClientPtr client)
             YieldControlDeath();
             return -1;
         }
+        oc->stats.reads++;
         result = _XSERVTransRead(oc->trans_conn, oci->buffer + oci->bufcnt,
                                  oci->size - oci->bufcnt);
         if (result <= 0) {
@@ -367,18 +473,10 @@ ReadRequestFromClient(ClientPtr client)
         }
         oci->bufcnt += result;
         gotnow += result;
-        /* free up some space after huge requests */
-        if ((oci->size > BUFWATERMARK) &&
-            (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE)) {
-            char *ibuf;
-
-            ibuf = (char *) realloc(oci->buffer, BUFSIZE);
-            if (ibuf) {
-                oci->size = BUFSIZE;
-                oci->buffer = ibuf;
-                oci->bufptr = ibuf + oci->bufcnt - gotnow;
-            }
-        }
+        oc->stats.bytesRead += result;
+        AdaptBufferSize(&oc->input_size, &oc->input_run,
+                        oci->size, oci->bufcnt);
+        ScanRequests(client, oci);
         if (need_header && gotnow >= needed) {
             /* We wanted an xReq, now we've gotten it. */
             request = (xReq *) oci->bufptr;
@@ -510,14 +608,13 @@ InsertFakeRequest(ClientPtr client, char *data, int count)
     NextAvailableInput(oc);
 
     if (!oci) {
-        if ((oci = FreeInputs))
-            FreeInputs = oci->next;
-        else if (!(oci = AllocateInputBuffer()))
+        if (!(oci = GetInputBuffer()))
             return FALSE;
         oc->input = oci;
     }
     oci->bufptr += oci->lenLastReq;
     oci->lenLastReq = 0;
+    oci->scanned = 0;
     gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
     if ((gotnow + count) > oci->size) {
         char *ibuf;
@@ -564,6 +661,8 @@ ResetCurrentRequest(ClientPtr client)
     if (AvailableInput == oc)
         AvailableInput = (OsCommPtr) NULL;
     oci->lenLastReq = 0;
+    /* the handler may have rewritten the request, swapping it in place */
+    oci->scanned = 0;
     gotnow = oci->bufcnt + oci->buffer - oci->bufptr;
     if (gotnow < sizeof(xReq)) {
         YieldControlNoInput(client);
@@ -661,6 +760,126 @@ AbortClient(ClientPtr client)
     }
 }
 
+static void
+ReleaseOutputBuffer(WriteDoneProcPtr done, void *closure)
+{
+    if (done)
+        (*done) (closure);
+}
+
+static void
+ReleaseOutputSegments(ConnectionOutputPtr oco)
+{
+    OutputSegmentPtr seg;
+
+    while ((seg = oco->segments)) {
+        oco->segments = seg->next;
+        ReleaseOutputBuffer(seg->done, seg->closure);
+        free(seg);
+    }
+    oco->lastSegment = &oco->segments;
+}
+
+static OutputSegmentPtr
+AppendOutputSegment(ConnectionOutputPtr oco, int size)
+{
+    OutputSegmentPtr seg;
+
+    seg = malloc(sizeof(OutputSegment) + size);
+    if (!seg)
+        return NULL;
+    seg->next = NULL;
+    seg->data = (const char *) (seg + 1);
+    seg->count = 0;
+    seg->room = size;
+    seg->done = NULL;
+    seg->closure = NULL;
+    *oco->lastSegment = seg;
+    oco->lastSegment = &seg->next;
+    return seg;
+}
+
+/* Copy data to the end of the output queue. */
+static Bool
+QueueOutputCopy(ConnectionOutputPtr oco, const char *data, int count)
+{
+    OutputSegmentPtr seg;
+    int n;
+
+    if (!oco->segments) {
+        if (oco->count + count > oco->size) {
+            unsigned char *obuf = NULL;
+
+            int size = oco->count + count + BUFSIZE;
+
+            if (count <= INT_MAX - BUFSIZE - oco->count) {
+                /* grow geometrically while the client falls behind */
+                if (size < oco->size && oco->size <= INT_MAX / 2)
+                    size = oco->size * 2;
+                obuf = realloc(oco->buf, size);
+            }
+            if (!obuf)
+                return FALSE;
+            oco->size = size;
+            oco->buf = obuf;
+        }
+        memmove(oco->buf + oco->count, data, count);
+        oco->count += count;
+        return TRUE;
+    }
+
+    seg = (OutputSegmentPtr) ((char *) oco->lastSegment -
+                              offsetof(OutputSegment, next));
+    while (count) {
+        if (seg->done || !seg->room) {
+            seg = AppendOutputSegment(oco, max(count, BUFSIZE));
+            if (!seg)
+                return FALSE;
+        }
+        n = min(count, seg->room);
+        memmove((char *) seg->data + seg->count, data, n);
+        seg->count += n;
+        seg->room -= n;
+        data += n;
+        count -= n;
+    }
+    return TRUE;
+}
+
+/*
+ * Queue count bytes of buf plus padding at the end of the output.  If
+ * done is set, the queue takes over the buffer and calls done once it
+ * no longer needs it, which may be right away.
+ */
+static Bool
+QueueOutput(ConnectionOutputPtr oco, const char *buf, int count, int padBytes,
+            WriteDoneProcPtr done, void *closure)
+{
+    static const char padBuffer[3];
+    OutputSegmentPtr seg;
+    Bool ok = TRUE;
+
+    if (done && count >= OUTPUT_REF_MIN) {
+        seg = AppendOutputSegment(oco, 0);
+        if (!seg) {
+            ReleaseOutputBuffer(done, closure);
+            return FALSE;
+        }
+        seg->data = buf;
+        seg->count = count;
+        seg->done = done;
+        seg->closure = closure;
+    }
+    else {
+        ok = QueueOutputCopy(oco, buf, count);
+        ReleaseOutputBuffer(done, closure);
+    }
+
+    if (ok && padBytes)
+        ok = QueueOutputCopy(oco, padBuffer, padBytes);
+    return ok;
+}
+
 /*****************
  * WriteToClient
  *    Copies buf into ClientPtr.buf if it fits (with padding), else
@@ -674,6 +893,21 @@ AbortClient(ClientPtr client)
 
 int
 WriteToClient(ClientPtr who, int count, const void *__buf)
+{
+    return WriteToClientBuffer(who, count, __buf, NULL, NULL);
+}
+
+/*****************
+ * WriteToClientBuffer
+ *    As WriteToClient, but if done is set the caller hands buf over
+ *    until done(closure) is called.  Data the client is not ready for
+ *    is then queued by reference instead of being copied.  done is
+ *    called exactly once, possibly before this returns.
+ *****************/
+
+int
+WriteToClientBuffer(ClientPtr who, int count, const void *__buf,
+                    WriteDoneProcPtr done, void *closure)
 {
     OsCommPtr oc;
     ConnectionOutputPtr oco;
@@ -686,8 +920,10 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 #ifdef DEBUG_COMMUNICATION
     Bool multicount = FALSE;
 #endif
-    if (!count || !who || who == serverClient || who->clientGone)
+    if (!count || !who || who == serverClient || who->clientGone) {
+        ReleaseOutputBuffer(done, closure);
         return 0;
+    }
     oc = who->osPrivate;
     oco = oc->output;
 #ifdef DEBUG_COMMUNICATION
@@ -732,10 +968,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 #endif
 
     if (!oco) {
-        if ((oco = FreeOutputs)) {
-            FreeOutputs = oco->next;
-        }
-        else if (!(oco = AllocateOutputBuffer())) {
+        if (!(oco = GetOutputBuffer())) {
+            ReleaseOutputBuffer(done, closure);
             AbortClient(who);
             MarkClientException(who);
             return -1;
@@ -785,6 +1019,19 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
     }
 #endif
+    if (oco->segments) {
+        /* The client is already behind; wait for it to drain the queue
+         * rather than trying another write now. */
+        NewOutputPending = TRUE;
+        output_pending_mark(who);
+        if (!QueueOutput(oco, buf, count, padBytes, done, closure)) {
+            AbortClient(who);
+            MarkClientException(who);
+            return -1;
+        }
+        return count;
+    }
+
     if (oco->count == 0 || oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
@@ -792,7 +1039,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
             NewOutputPending = FALSE;
         }
 
-        return FlushClient(who, oc, buf, count);
+        return FlushOutput(who, oc, buf, count, done, closure);
     }
 
     NewOutputPending = TRUE;
@@ -803,6 +1050,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         memset(oco->buf + oco->count, '\0', padBytes);
         oco->count += padBytes;
     }
+    ReleaseOutputBuffer(done, closure);
     return count;
 }
 
@@ -818,160 +1066,179 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 
 int
 FlushClient(ClientPtr who, OsCommPtr oc, const void *__extraBuf, int extraCount)
+{
+    return FlushOutput(who, oc, __extraBuf, extraCount, NULL, NULL);
+}
+
+/* Drop the first len bytes of the queue, then of the extra data. */
+static void
+ConsumeOutput(ConnectionOutputPtr oco, long len,
+              const char **extraBuf, int *extraCount, long *padsize)
+{
+    OutputSegmentPtr seg;
+    long n;
+
+    if (oco->count) {
+        n = min(len, oco->count);
+        oco->count -= n;
+        memmove(oco->buf, oco->buf + n, oco->count);
+        len -= n;
+    }
+    while (len && (seg = oco->segments)) {
+        n = min(len, seg->count);
+        seg->data += n;
+        seg->count -= n;
+        len -= n;
+        if (!seg->count) {
+            if (!(oco->segments = seg->next))
+                oco->lastSegment = &oco->segments;
+            ReleaseOutputBuffer(seg->done, seg->closure);
+            free(seg);
+        }
+    }
+    n = min(len, *extraCount);
+    *extraBuf += n;
+    *extraCount -= n;
+    *padsize -= len - n;
+}
+
+static int
+FlushOutput(ClientPtr who, OsCommPtr oc, const char *extraBuf, int extraCount,
+            WriteDoneProcPtr done, void *closure)
 {
     ConnectionOutputPtr oco = oc->output;
     XtransConnInfo trans_conn = oc->trans_conn;
-    struct iovec iov[3];
+    struct iovec iov[OUTPUT_IOV_MAX];
     static char padBuffer[3];
-    const char *extraBuf = __extraBuf;
-    long written;
+    OutputSegmentPtr seg;
+    int requested = extraCount;
     long padsize;
-    long notWritten;
     long todo;
+    long total;
+    long len;
+    int i;
 
-    if (!oco)
-	return 0;
-    written = 0;
+    if (!oco) {
+        ReleaseOutputBuffer(done, closure);
+        return 0;
+    }
     padsize = padding_for_int32(extraCount);
-    notWritten = oco->count + extraCount + padsize;
-    if (!notWritten)
+    if (!oco->count && !oco->segments && !extraCount) {
+        ReleaseOutputBuffer(done, closure);
         return 0;
+    }
 
     if (FlushCallback)
         CallCallbacks(&FlushCallback, who);
 
-    todo = notWritten;
-    while (notWritten) {
-        long before = written;  /* amount of whole thing written */
-        long remain = todo;     /* amount to try this time, <= notWritten */
-        int i = 0;
-        long len;
-
-        /* You could be very general here and have "in" and "out" iovecs
-         * and write a loop without using a macro, but what the heck.  This
-         * translates to:
-         *
-         *     how much of this piece is new?
-         *     if more new then we are trying this time, clamp
-         *     if nothing new
-         *         then bump down amount already written, for next piece
-         *         else put new stuff in iovec, will need all of next piece
-         *
-         * Note that todo had better be at least 1 or else we'll end up
-         * writing 0 iovecs.
-         */
+    todo = LONG_MAX;
+    for (;;) {
+        /* Gather as much as fits in one writev, clamped to todo */
+        i = 0;
+        total = 0;
 #define InsertIOV(pointer, length) \
-	len = (length) - before; \
-	if (len > remain) \
-	    len = remain; \
-	if (len <= 0) { \
-	    before = (-len); \
-	} else { \
-	    iov[i].iov_len = len; \
-	    iov[i].iov_base = (pointer) + before;	\
-	    i++; \
-	    remain -= len; \
-	    before = 0; \
-	}
-
-        InsertIOV((char *) oco->buf, oco->count)
-            InsertIOV((char *) extraBuf, extraCount)
+        if ((length) > 0 && total < todo) { \
+            iov[i].iov_base = (char *) (pointer); \
+            iov[i].iov_len = min((long) (length), todo - total); \
+            total += iov[i].iov_len; \
+            i++; \
+        }
+
+        InsertIOV(oco->buf, oco->count)
+        for (seg = oco->segments; seg && i < OUTPUT_IOV_MAX - 2;
+             seg = seg->next) {
+            InsertIOV(seg->data, seg->count)
+        }
+        if (!seg) {
+            InsertIOV(extraBuf, extraCount)
             InsertIOV(padBuffer, padsize)
+        }
+#undef InsertIOV
+
+        if (!total)
+            break;              /* everything was flushed out */
 
-            errno = 0;
+        errno = 0;
+        if (trans_conn)
+            oc->stats.writes++;
         if (trans_conn && (len = _XSERVTransWritev(trans_conn, iov, i)) >= 0) {
-            written += len;
-            notWritten -= len;
-            todo = notWritten;
+            oc->stats.bytesWritten += len;
+            ConsumeOutput(oco, len, &extraBuf, &extraCount, &padsize);
+            todo = LONG_MAX;
         }
         else if (ETEST(errno)
 #ifdef SUNSYSV                  /* check for another brain-damaged OS bug */
                  || (errno == 0)
 #endif
 #ifdef EMSGSIZE                 /* check for another brain-damaged OS bug */
-                 || ((errno == EMSGSIZE) && (todo == 1))
+                 || ((errno == EMSGSIZE) && (total == 1))
 #endif
             ) {
             /* If we've arrived here, then the client is stuffed to the gills
-               and not ready to accept more.  Make a note of it and buffer
+               and not ready to accept more.  Make a note of it and queue
                the rest. */
             output_pending_mark(who);
 
-            if (written < oco->count) {
-                if (written > 0) {
-                    oco->count -= written;
-                    memmove((char *) oco->buf,
-                            (char *) oco->buf + written, oco->count);
-                    written = 0;
-                }
+            if (!extraCount) {
+                ReleaseOutputBuffer(done, closure);
+                done = NULL;
             }
-            else {
-                written -= oco->count;
+            if (!QueueOutput(oco, extraBuf, extraCount, padsize,
+                             done, closure)) {
+                AbortClient(who);
+                MarkClientException(who);
                 oco->count = 0;
+                ReleaseOutputSegments(oco);
+                return -1;
             }
+            AdaptBufferSize(&oc->output_size, &oc->output_run,
+                            oco->size, oco->size);
 
-            if (notWritten > oco->size) {
-                unsigned char *obuf = NULL;
-
-                if (notWritten + BUFSIZE <= INT_MAX) {
-                    obuf = realloc(oco->buf, notWritten + BUFSIZE);
-                }
-                if (!obuf) {
-                    AbortClient(who);
-                    MarkClientException(who);
-                    oco->count = 0;
-                    return -1;
-                }
-                oco->size = notWritten + BUFSIZE;
-                oco->buf = obuf;
-            }
-
-            /* If the amount written extended into the padBuffer, then the
-               difference "extraCount - written" may be less than 0 */
-            if ((len = extraCount - written) > 0)
-                memmove((char *) oco->buf + oco->count,
-                        extraBuf + written, len);
-
-            oco->count = notWritten;    /* this will include the pad */
             ospoll_listen(server_poll, oc->fd, X_NOTIFY_WRITE);
 
             /* return only the amount explicitly requested */
-            return extraCount;
+            return requested;
         }
 #ifdef EMSGSIZE                 /* check for another brain-damaged OS bug */
         else if (errno == EMSGSIZE) {
-            todo >>= 1;
+            todo = total >> 1;
         }
 #endif
         else {
             AbortClient(who);
             MarkClientException(who);
             oco->count = 0;
+            ReleaseOutputSegments(oco);
+            ReleaseOutputBuffer(done, closure);
             return -1;
         }
     }
 
     /* everything was flushed out */
-    oco->count = 0;
+    ReleaseOutputSegments(oco);
+    ReleaseOutputBuffer(done, closure);
     output_pending_clear(who);
+    AdaptBufferSize(&oc->output_size, &oc->output_run, oco->size, 0);
 
-    if (oco->size > BUFWATERMARK) {
-        free(oco->buf);
-        free(oco);
-    }
-    else {
-        oco->next = FreeOutputs;
-        FreeOutputs = oco;
+    /* keep the buffer if it is one the client is expected to need again */
+    if (oco->size <= BUFSIZE || oco->size > oc->output_size) {
+        PutOutputBuffer(oco);
+        oc->output = (ConnectionOutputPtr) NULL;
     }
-    oc->output = (ConnectionOutputPtr) NULL;
-    return extraCount;          /* return only the amount explicitly requested */
+    return requested;           /* return only the amount explicitly requested */
 }
 
 static ConnectionInputPtr
-AllocateInputBuffer(void)
+GetInputBuffer(void)
 {
     ConnectionInputPtr oci;
 
+    if ((oci = FreeInputs)) {
+        FreeInputs = oci->next;
+        numFreeInputs--;
+        return oci;
+    }
+
     oci = malloc(sizeof(ConnectionInput));
     if (!oci)
         return NULL;
@@ -985,14 +1252,39 @@ AllocateInputBuffer(void)
     oci->bufcnt = 0;
     oci->lenLastReq = 0;
     oci->ignoreBytes = 0;
+    oci->scanned = 0;
     return oci;
 }
 
+static void
+PutInputBuffer(ConnectionInputPtr oci)
+{
+    if (oci->size != BUFSIZE || numFreeInputs >= BUFFREEMAX) {
+        free(oci->buffer);
+        free(oci);
+        return;
+    }
+    oci->next = FreeInputs;
+    oci->bufptr = oci->buffer;
+    oci->bufcnt = 0;
+    oci->lenLastReq = 0;
+    oci->ignoreBytes = 0;
+    oci->scanned = 0;
+    FreeInputs = oci;
+    numFreeInputs++;
+}
+
 static ConnectionOutputPtr
-AllocateOutputBuffer(void)
+GetOutputBuffer(void)
 {
     ConnectionOutputPtr oco;
 
+    if ((oco = FreeOutputs)) {
+        FreeOutputs = oco->next;
+        numFreeOutputs--;
+        return oco;
+    }
+
     oco = malloc(sizeof(ConnectionOutput));
     if (!oco)
         return NULL;
@@ -1003,41 +1295,124 @@ AllocateOutputBuffer(void)
     }
     oco->size = BUFSIZE;
     oco->count = 0;
+    oco->segments = NULL;
+    oco->lastSegment = &oco->segments;
     return oco;
 }
 
+static void
+PutOutputBuffer(ConnectionOutputPtr oco)
+{
+    ReleaseOutputSegments(oco);
+    if (oco->size != BUFSIZE || numFreeOutputs >= BUFFREEMAX) {
+        free(oco->buf);
+        free(oco);
+        return;
+    }
+    oco->next = FreeOutputs;
+    oco->count = 0;
+    FreeOutputs = oco;
+    numFreeOutputs++;
+}
+
+/*
+ * Runs every BUFIDLETIME while some client prefers larger buffers.  A
+ * client with no reads or writes since the last run goes back to the
+ * default size and gives up any oversized buffer it no longer needs.
+ */
+static CARD32
+TrimClientBuffers(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    Bool again = FALSE;
+    int i;
+
+    for (i = 1; i < currentMaxClients; i++) {
+        ClientPtr client = clients[i];
+        OsCommPtr oc;
+        ConnectionInputPtr oci;
+        ConnectionOutputPtr oco;
+        CARD64 activity;
+
+        if (!client || client->clientGone || !(oc = client->osPrivate))
+            continue;
+
+        activity = oc->stats.reads + oc->stats.writes;
+        if (activity == oc->idle_mark && !(oc->flags & OS_COMM_IGNORED)) {
+            oc->input_size = oc->output_size = BUFSIZE;
+            oc->input_run = oc->output_run = 0;
+
+            oci = oc->input;
+            if (oci && oci->size > BUFSIZE && !oci->ignoreBytes &&
+                oci->bufptr + oci->lenLastReq == oci->buffer + oci->bufcnt) {
+                if (AvailableInput == oc)
+                    AvailableInput = NULL;
+                PutInputBuffer(oci);
+                oc->input = NULL;
+            }
+            oco = oc->output;
+            if (oco && oco->size > BUFSIZE && !oco->count && !oco->segments) {
+                PutOutputBuffer(oco);
+                oc->output = NULL;
+            }
+        }
+        oc->idle_mark = activity;
+
+        if (oc->input_size > BUFSIZE || oc->output_size > BUFSIZE ||
+            (oc->input && oc->input->size > BUFSIZE) ||
+            (oc->output && oc->output->size > BUFSIZE))
+            again = TRUE;
+    }
+
+    BufferTrimPending = again;
+    return again ? BUFIDLETIME : 0;
+}
+
+static void
+ScheduleBufferTrim(void)
+{
+    if (BufferTrimPending)
+        return;
+    BufferTrimTimer = TimerSet(BufferTrimTimer, 0, BUFIDLETIME,
+                               TrimClientBuffers, NULL);
+    BufferTrimPending = BufferTrimTimer != NULL;
+}
+
 void
-FreeOsBuffers(OsCommPtr oc)
+GetClientIOStats(ClientPtr client, ClientIOStatsPtr stats)
 {
-    ConnectionInputPtr oci;
-    ConnectionOutputPtr oco;
+    OsCommPtr oc = client->osPrivate;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!oc || client == serverClient)
+        return;
+    *stats = oc->stats;
+    if (oc->input)
+        stats->inputBufferSize = oc->input->size;
+    if (oc->output)
+        stats->outputBufferSize = oc->output->size;
+}
+
+void
+InitOsBuffers(OsCommPtr oc)
+{
+    oc->input_size = oc->output_size = BUFSIZE;
+    oc->input_run = oc->output_run = 0;
+    oc->idle_mark = 0;
+    memset(&oc->stats, 0, sizeof(oc->stats));
+}
 
+void
+FreeOsBuffers(OsCommPtr oc)
+{
     if (AvailableInput == oc)
         AvailableInput = (OsCommPtr) NULL;
-    if ((oci = oc->input)) {
-        if (FreeInputs) {
-            free(oci->buffer);
-            free(oci);
-        }
-        else {
-            FreeInputs = oci;
-            oci->next = (ConnectionInputPtr) NULL;
-            oci->bufptr = oci->buffer;
-            oci->bufcnt = 0;
-            oci->lenLastReq = 0;
-            oci->ignoreBytes = 0;
-        }
+    if (oc->input) {
+        PutInputBuffer(oc->input);
+        oc->input = NULL;
     }
-    if ((oco = oc->output)) {
-        if (FreeOutputs) {
-            free(oco->buf);
-            free(oco);
-        }
-        else {
-            FreeOutputs = oco;
-            oco->next = (ConnectionOutputPtr) NULL;
-            oco->count = 0;
-        }
+    if (oc->output) {
+        PutOutputBuffer(oc->output);
+        oc->output = NULL;
     }
 }
 
@@ -1057,4 +1432,9 @@ ResetOsBuffers(void)
         free(oco->buf);
         free(oco);
     }
+    numFreeInputs = numFreeOutputs = 0;
+
+    TimerFree(BufferTrimTimer);
+    BufferTrimTimer = NULL;
+    BufferTrimPending = FALSE;
 }
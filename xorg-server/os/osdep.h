@@ -119,6 +119,12 @@ typedef struct _osComm {
     CARD32 conn_time;           /* timestamp if not established, else 0  */
     struct _XtransConnInfo *trans_conn; /* transport connection object */
     int flags;
+    int input_size;             /* preferred buffer sizes, see io.c */
+    int output_size;
+    int input_run;              /* light uses since the last change */
+    int output_run;
+    CARD64 idle_mark;           /* reads + writes at the last idle check */
+    ClientIOStatsRec stats;
 } OsCommRec, *OsCommPtr;
 
 #define OS_COMM_GRAB_IMPERVIOUS 1
@@ -130,6 +136,9 @@ extern int FlushClient(ClientPtr /*who */ ,
                        int      /*extraCount */
     );
 
+extern void InitOsBuffers(OsCommPtr     /*oc */
+    );
+
 extern void FreeOsBuffers(OsCommPtr     /*oc */
     );
 
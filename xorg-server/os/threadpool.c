@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Worker thread pool.
+ *
+ * There is one job at a time: a function and a count of indices to call
+ * it with.  The caller publishes the job under the pool lock and bumps
+ * the generation; workers wake, and they and the caller take indices
+ * until none are left.  The caller then waits for the last call to
+ * finish.  Pieces are expected to be coarse, so taking the lock per
+ * index costs nothing that matters.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#endif
+
+#include "misc.h"
+#include "os.h"
+#include "threadpool.h"
+
+#define THREAD_POOL_MAX 16
+
+int ThreadPoolWorkers = -1;
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t poolDone = PTHREAD_COND_INITIALIZER;
+
+static Bool poolStarted;
+static Bool poolBusy;
+static int poolThreads;         /* workers running */
+
+static struct {
+    ThreadPoolProc proc;
+    void *data;
+    int count;
+    int next;                   /* next index to hand out */
+    int pending;                /* calls not yet finished */
+    unsigned int generation;
+} job;
+
+/* Take indices of the current job until there are none left. */
+static void
+ThreadPoolDrain(void)
+{
+    while (job.next < job.count) {
+        int index = job.next++;
+
+        pthread_mutex_unlock(&poolLock);
+        (*job.proc) (job.data, index);
+        pthread_mutex_lock(&poolLock);
+        if (--job.pending == 0)
+            pthread_cond_signal(&poolDone);
+    }
+}
+
+static void *
+ThreadPoolWorker(void *arg)
+{
+    unsigned int seen = 0;
+
+#ifndef WIN32
+    sigset_t set;
+
+    /* signals belong to the main thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+    pthread_mutex_lock(&poolLock);
+    for (;;) {
+        while (job.generation == seen)
+            pthread_cond_wait(&poolWork, &poolLock);
+        seen = job.generation;
+        ThreadPoolDrain();
+    }
+    return NULL;
+}
+
+static int
+ThreadPoolCpus(void)
+{
+#ifdef WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? n : 1;
+#else
+    return 1;
+#endif
+}
+
+static void
+ThreadPoolStart(void)
+{
+    int workers = ThreadPoolWorkers;
+    pthread_t thread;
+
+    poolStarted = TRUE;
+    if (workers < 0)
+        workers = ThreadPoolCpus() - 1;
+    if (workers > THREAD_POOL_MAX)
+        workers = THREAD_POOL_MAX;
+
+    for (poolThreads = 0; poolThreads < workers; poolThreads++) {
+        if (pthread_create(&thread, NULL, ThreadPoolWorker, NULL) != 0) {
+            LogMessage(X_WARNING, "Started only %d of %d worker threads\n",
+                       poolThreads, workers);
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+int
+ThreadPoolThreads(void)
+{
+    if (!poolStarted) {
+        pthread_mutex_lock(&poolLock);
+        if (!poolStarted)
+            ThreadPoolStart();
+        pthread_mutex_unlock(&poolLock);
+    }
+    return poolThreads + 1;
+}
+
+void
+ThreadPoolRun(ThreadPoolProc proc, void *data, int count)
+{
+    int i;
+
+    if (count <= 0)
+        return;
+    if (count == 1 || ThreadPoolThreads() == 1)
+        goto serial;
+
+    pthread_mutex_lock(&poolLock);
+    if (poolBusy) {
+        pthread_mutex_unlock(&poolLock);
+        goto serial;
+    }
+    poolBusy = TRUE;
+    job.proc = proc;
+    job.data = data;
+    job.count = count;
+    job.next = 0;
+    job.pending = count;
+    job.generation++;
+    pthread_cond_broadcast(&poolWork);
+
+    ThreadPoolDrain();
+    while (job.pending)
+        pthread_cond_wait(&poolDone, &poolLock);
+    poolBusy = FALSE;
+    pthread_mutex_unlock(&poolLock);
+    return;
+
+ serial:
+    for (i = 0; i < count; i++)
+        (*proc) (data, i);
+}
@@ -109,10 +109,16 @@ __stdcall unsigned long GetTickCount(void);
 
 #include "dixstruct.h"
 
+#include "reqprof.h"
+
+#include "threadpool.h"
+
 #include "xkbsrv.h"
 
 #include "picture.h"
 
+#include "damage.h"
+
 Bool noTestExtensions;
 
 #ifdef COMPOSITE
@@ -440,6 +446,18 @@ GiveUp(int sig)
     errno = olderrno;
 }
 
+/* Start or stop request profiling on SIGUSR2 */
+
+void
+RequestProfileSignal(int sig)
+{
+    int olderrno = errno;
+
+    RequestProfileToggle = TRUE;
+    isItTimeToYield = TRUE;
+    errno = olderrno;
+}
+
 #ifdef MONOTONIC_CLOCK
 void
 ForceClockId(clockid_t forced_clockid)
@@ -539,6 +557,8 @@ UseMsg(void)
     ErrorF("-cc int                default color visual class\n");
     ErrorF("-nocursor              disable the cursor\n");
     ErrorF("-core                  generate core dump on fatal error\n");
+    ErrorF("-damagepolicy exact|boxes:n|tile:n|waste:n\n"
+           "                       coalesce damage reported to clients\n");
     ErrorF("-displayfd fd          file descriptor to write display number to when ready to connect\n");
 #ifdef _MSC_VER
     ErrorF("-dpi [auto|int]        screen resolution set to native or this dpi\n");
@@ -573,6 +593,7 @@ UseMsg(void)
     ErrorF("-maxclients n          set maximum number of clients (power of two)\n");
     ErrorF("-nolisten string       don't listen on protocol\n");
     ErrorF("-listen string         listen on protocol\n");
+    ErrorF("-nomotioncoalesce      deliver every queued pointer motion\n");
     ErrorF("-noreset               don't reset after last client exists\n");
     ErrorF("-background [none]     create root window with no background\n");
     ErrorF("-reset                 reset after last client exists\n");
@@ -581,12 +602,14 @@ UseMsg(void)
     ErrorF("-r                     turns off auto-repeat\n");
     ErrorF("r                      turns on auto-repeat \n");
     ErrorF("-render [default|mono|gray|color] set render color alloc policy\n");
+    ErrorF("-reqprofile            profile requests per client from startup\n");
     ErrorF("-retro                 start with classic stipple\n");
     ErrorF("-seat string           seat to run on\n");
     ErrorF("-t #                   default pointer threshold (pixels/t)\n");
     ErrorF("-terminate             terminate at server reset\n");
     ErrorF("-to #                  connection time out\n");
     ErrorF("-tst                   disable testing extensions\n");
+    ErrorF("-workers n             worker threads for rendering, 0 for none\n");
     ErrorF("-wr                    create root window with white background\n");
 #ifdef PANORAMIX
     ErrorF("+xinerama              Enable XINERAMA extension\n");
@@ -752,6 +775,14 @@ ProcessCommandLine(int argc, char *argv[])
         else if (strcmp(argv[i], "-nocursor") == 0) {
             EnableCursor = FALSE;
         }
+        else if (strcmp(argv[i], "-damagepolicy") == 0) {
+            if (++i < argc) {
+                if (!DamageParsePolicy(argv[i], &DamageDefaultPolicy))
+                    UseMsg();
+            }
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-dpi") == 0) {
             if (++i < argc)
 #ifdef _MSC_VER
@@ -908,6 +939,9 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-nomotioncoalesce") == 0) {
+            CoalesceMotion = FALSE;
+        }
         else if (strcmp(argv[i], "-noreset") == 0) {
             dispatchExceptionAtReset = 0;
         }
@@ -932,6 +966,8 @@ ProcessCommandLine(int argc, char *argv[])
             defaultKeyboardControl.autoRepeat = TRUE;
         else if (strcmp(argv[i], "-r") == 0)
             defaultKeyboardControl.autoRepeat = FALSE;
+        else if (strcmp(argv[i], "-reqprofile") == 0)
+            RequestProfileAtStart = TRUE;
         else if (strcmp(argv[i], "-retro") == 0)
             party_like_its_1989 = TRUE;
         else if (strcmp(argv[i], "-s") == 0) {
@@ -965,6 +1001,12 @@ ProcessCommandLine(int argc, char *argv[])
         else if (strcmp(argv[i], "-tst") == 0) {
             noTestExtensions = TRUE;
         }
+        else if (strcmp(argv[i], "-workers") == 0) {
+            if (++i < argc && isdigit(*argv[i]))
+                ThreadPoolWorkers = atoi(argv[i]);
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-wr") == 0)
             whiteRoot = TRUE;
         else if (strcmp(argv[i], "-background") == 0) {
@@ -0,0 +1,224 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * A 128-bit hash in the style of XXH3: the input is consumed in 64-byte
+ * stripes by eight 64-bit accumulators, each taking a 32x32->64 multiply
+ * of the data mixed with a key, and the accumulators are scrambled every
+ * block of 16 stripes.  The stripe loop maps directly onto SSE2, which is
+ * used where available; the plain C version computes the same result.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <string.h>
+
+#include "xhash.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XHASH_SSE2
+#include <emmintrin.h>
+#endif
+
+#define XHASH_LANES             8
+#define XHASH_STRIPE            (XHASH_LANES * 8)       /* bytes */
+#define XHASH_BLOCK             16                      /* stripes */
+
+#define PRIME32_1   0x9E3779B1U
+#define PRIME32_2   0x85EBCA77U
+#define PRIME32_3   0xC2B2AE3DU
+#define PRIME64_1   0x9E3779B185EBCA87ULL
+#define PRIME64_2   0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3   0x165667B19E3779F9ULL
+#define PRIME64_4   0x85EBCA77C2B2AE63ULL
+#define PRIME64_5   0x27D4EB2F165667C5ULL
+
+static const uint64_t x_hash_key[XHASH_LANES * 2] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL,
+    0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL,
+    0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+    0xcb00c391bb52283cULL, 0xa32e531b8b65d088ULL,
+    0x4ef90da297486471ULL, 0xd8acdea946ef1938ULL,
+    0x3f349ce33f76faa8ULL, 0x1d4f0bc7c7bbdcf9ULL,
+    0x3159b4cd4be0518aULL, 0x647378d9c97e9fc8ULL,
+};
+
+static inline uint64_t
+read64(const unsigned char *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void
+write64(unsigned char *p, uint64_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+/* Fold the 128-bit product of a and b into 64 bits. */
+static inline uint64_t
+mul_fold(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t product = (__uint128_t) a * b;
+
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+#else
+    uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+    uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+    uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xffffffff);
+
+    return lower ^ upper;
+#endif
+}
+
+static inline uint64_t
+avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+#ifdef XHASH_SSE2
+
+static void
+accumulate(uint64_t acc64[XHASH_LANES], const unsigned char *p,
+           size_t stripes, const uint64_t *key)
+{
+    __m128i acc[XHASH_LANES / 2], k[XHASH_LANES / 2];
+    const __m128i prime = _mm_set1_epi32((int) PRIME32_1);
+    size_t s;
+    int i;
+
+    for (i = 0; i < XHASH_LANES / 2; i++) {
+        acc[i] = _mm_loadu_si128((const __m128i *) (acc64 + 2 * i));
+        k[i] = _mm_loadu_si128((const __m128i *) (key + 2 * i));
+    }
+
+    for (s = 0; s < stripes; s++, p += XHASH_STRIPE) {
+        for (i = 0; i < XHASH_LANES / 2; i++) {
+            __m128i d = _mm_loadu_si128((const __m128i *) p + i);
+            __m128i dk = _mm_xor_si128(d, k[i]);
+            __m128i product = _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32));
+
+            acc[i] = _mm_add_epi64(acc[i],
+                                   _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0,
+                                                                    3, 2)));
+            acc[i] = _mm_add_epi64(acc[i], product);
+        }
+        if (s % XHASH_BLOCK == XHASH_BLOCK - 1) {
+            for (i = 0; i < XHASH_LANES / 2; i++) {
+                __m128i a = acc[i];
+
+                a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+                a = _mm_xor_si128(a, k[i]);
+                acc[i] = _mm_add_epi64(_mm_mul_epu32(a, prime),
+                                       _mm_slli_epi64(_mm_mul_epu32
+                                                      (_mm_srli_epi64(a, 32),
+                                                       prime), 32));
+            }
+        }
+    }
+
+    for (i = 0; i < XHASH_LANES / 2; i++)
+        _mm_storeu_si128((__m128i *) (acc64 + 2 * i), acc[i]);
+}
+
+#else
+
+static void
+accumulate(uint64_t acc[XHASH_LANES], const unsigned char *p,
+           size_t stripes, const uint64_t *key)
+{
+    size_t s;
+    int i;
+
+    for (s = 0; s < stripes; s++, p += XHASH_STRIPE) {
+        for (i = 0; i < XHASH_LANES; i++) {
+            uint64_t d = read64(p + 8 * i);
+            uint64_t dk = d ^ key[i];
+
+            acc[i ^ 1] += d;
+            acc[i] += (dk & 0xffffffff) * (dk >> 32);
+        }
+        if (s % XHASH_BLOCK == XHASH_BLOCK - 1) {
+            for (i = 0; i < XHASH_LANES; i++) {
+                acc[i] ^= acc[i] >> 47;
+                acc[i] ^= key[i];
+                acc[i] *= PRIME32_1;
+            }
+        }
+    }
+}
+
+#endif
+
+void
+x_hash128(const void *data, size_t size, uint64_t seed,
+          unsigned char result[16])
+{
+    uint64_t acc[XHASH_LANES] = {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+        PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+    };
+    uint64_t key[XHASH_LANES * 2];
+    unsigned char tail[XHASH_STRIPE];
+    const unsigned char *p = data;
+    size_t stripes = size / XHASH_STRIPE;
+    uint64_t lo, hi;
+    int i;
+
+    for (i = 0; i < XHASH_LANES * 2; i++)
+        key[i] = (i & 1) ? x_hash_key[i] - seed : x_hash_key[i] + seed;
+
+    accumulate(acc, p, stripes, key);
+    if (size % XHASH_STRIPE) {
+        memset(tail, 0, sizeof(tail));
+        memcpy(tail, p + stripes * XHASH_STRIPE, size % XHASH_STRIPE);
+        accumulate(acc, tail, 1, key);
+    }
+
+    lo = (uint64_t) size * PRIME64_1;
+    hi = ~((uint64_t) size * PRIME64_2);
+    for (i = 0; i < XHASH_LANES; i += 2) {
+        lo += mul_fold(acc[i] ^ key[XHASH_LANES + i],
+                       acc[i + 1] ^ key[XHASH_LANES + i + 1]);
+        hi += mul_fold(acc[i] ^ key[XHASH_LANES * 2 - 1 - i],
+                       acc[i + 1] ^ key[XHASH_LANES * 2 - 2 - i]);
+    }
+    write64(result, avalanche(lo));
+    write64(result + 8, avalanche(hi));
+}
@@ -26,6 +26,7 @@
 #include <dix-config.h>
 #endif
 
+#include "xhash.h"
 #include "xsha1.h"
 
 #include "misc.h"
@@ -82,6 +83,22 @@ static GlyphHashSetRec glyphHashSets[] = {
 
 static GlyphHashRec globalGlyphs[GlyphFormatNum];
 
+static const int glyphDepths[GlyphFormatNum] = { 1, 4, 8, 16, 32 };
+
+/*
+ * What a lookup in the global table is after: either an existing glyph,
+ * or the header and bits of one that is being added.
+ */
+typedef struct _GlyphKey {
+    unsigned char *hash;
+    GlyphPtr glyph;
+    xGlyphInfo *gi;
+    CARD8 *bits;
+    int depth;
+    Bool hasSha1;
+    unsigned char sha1[20];
+} GlyphKeyRec, *GlyphKeyPtr;
+
 void
 GlyphUninit(ScreenPtr pScreen)
 {
@@ -117,9 +134,122 @@ FindGlyphHashSet(CARD32 filled)
     return 0;
 }
 
+/*
+ * SHA-1 over the header and the visible part of each row of the bits,
+ * leaving out the padding at the end of the rows, which the client may
+ * fill with anything.
+ */
+static Bool
+Sha1GlyphBits(xGlyphInfo * gi, CARD8 *bits, int stride, int depth,
+              unsigned char sha1[20])
+{
+    int rowBits = gi->width * depth;
+    int full = rowBits >> 3, rem = rowBits & 7;
+    CARD8 mask, last;
+    void *ctx = x_sha1_init();
+    int y;
+
+    if (!ctx)
+        return FALSE;
+#if BITMAP_BIT_ORDER == LSBFirst
+    mask = (1 << rem) - 1;
+#else
+    mask = 0xff << (8 - rem);
+#endif
+
+    if (!x_sha1_update(ctx, gi, sizeof(xGlyphInfo)))
+        return FALSE;
+    for (y = 0; y < gi->height; y++, bits += stride) {
+        if (full && !x_sha1_update(ctx, bits, full))
+            return FALSE;
+        if (rem) {
+            last = bits[full] & mask;
+            if (!x_sha1_update(ctx, &last, 1))
+                return FALSE;
+        }
+    }
+    return x_sha1_final(ctx, sha1);
+}
+
+/*
+ * Work out the SHA-1 of a glyph already in the table.  Its bits only
+ * live in the glyph pictures by now, so they are read back from the
+ * first screen's.  This only happens when another glyph has the same
+ * fast hash, and the result is kept.
+ */
+static Bool
+Sha1Glyph(GlyphPtr glyph, int depth)
+{
+    ScreenPtr pScreen = screenInfo.screens[0];
+    PicturePtr pPicture;
+    int width = glyph->info.width, height = glyph->info.height;
+    int stride;
+    CARD8 *bits;
+
+    if (glyph->hasSha1)
+        return TRUE;
+
+    if (!width || !height) {
+        glyph->hasSha1 = Sha1GlyphBits(&glyph->info, NULL, 0, depth,
+                                       glyph->sha1);
+        return glyph->hasSha1;
+    }
+
+    pPicture = GetGlyphPicture(glyph, pScreen);
+    if (!pPicture || !pPicture->pDrawable)
+        return FALSE;
+    stride = PixmapBytePad(width, depth);
+    bits = xallocarray(height, stride);
+    if (!bits)
+        return FALSE;
+    (*pScreen->GetImage) (pPicture->pDrawable, 0, 0, width, height,
+                          ZPixmap, ~0, (char *) bits);
+    glyph->hasSha1 = Sha1GlyphBits(&glyph->info, bits, stride, depth,
+                                   glyph->sha1);
+    free(bits);
+    return glyph->hasSha1;
+}
+
+/*
+ * Whether glyph has the content key describes.  Equal fast hashes are
+ * confirmed with SHA-1, so a collision, accidental or crafted, can
+ * never merge two different glyphs; when the SHA-1 cannot be had, the
+ * glyphs are taken to be different, which only costs sharing.
+ */
+static Bool
+GlyphMatchesKey(GlyphPtr glyph, GlyphKeyPtr key)
+{
+    if (glyph == key->glyph)
+        return TRUE;
+    if (memcmp(glyph->hash, key->hash, sizeof(glyph->hash)) != 0 ||
+        memcmp(&glyph->info, key->gi, sizeof(xGlyphInfo)) != 0)
+        return FALSE;
+
+    if (!key->hasSha1) {
+        if (key->glyph) {
+            if (!Sha1Glyph(key->glyph, key->depth))
+                return FALSE;
+            memcpy(key->sha1, key->glyph->sha1, sizeof(key->sha1));
+        }
+        else if (!Sha1GlyphBits(key->gi, key->bits,
+                                PixmapBytePad(key->gi->width, key->depth),
+                                key->depth, key->sha1))
+            return FALSE;
+        key->hasSha1 = TRUE;
+    }
+    if (!Sha1Glyph(glyph, key->depth))
+        return FALSE;
+    return memcmp(glyph->sha1, key->sha1, sizeof(key->sha1)) == 0;
+}
+
+/*
+ * Find the slot for signature.  In the global table, match picks out one
+ * glyph by pointer, and key one by content; with neither, as for the
+ * glyph ids of a glyph set, the signature alone decides.
+ */
 static GlyphRefPtr
 FindGlyphRef(GlyphHashPtr hash,
-             CARD32 signature, Bool match, unsigned char sha1[20])
+             CARD32 signature, GlyphPtr match, GlyphKeyPtr key)
 {
     CARD32 elt, step, s;
     GlyphPtr glyph;
@@ -146,7 +276,8 @@ FindGlyphRef(GlyphHashPtr hash,
                 break;
         }
         else if (s == signature &&
-                 (!match || memcmp(glyph->sha1, sha1, 20) == 0)) {
+                 (match ? glyph == match :
+                  !key || GlyphMatchesKey(glyph, key))) {
             break;
         }
         if (!step) {
@@ -161,38 +292,40 @@ FindGlyphRef(GlyphHashPtr hash,
     return gr;
 }
 
+/*
+ * The fast hash that keys the global glyph table.  It is not meant to
+ * tell glyphs apart on its own: FindGlyphByHash and AddGlyph confirm
+ * any match with SHA-1.
+ */
 int
 HashGlyph(xGlyphInfo * gi,
-          CARD8 *bits, unsigned long size, unsigned char sha1[20])
+          CARD8 *bits, unsigned long size, unsigned char hash[16])
 {
-    void *ctx = x_sha1_init();
-    int success;
+    unsigned char data[sizeof(xGlyphInfo) + 16];
 
-    if (!ctx)
-        return BadAlloc;
-
-    success = x_sha1_update(ctx, gi, sizeof(xGlyphInfo));
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_update(ctx, bits, size);
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_final(ctx, sha1);
-    if (!success)
-        return BadAlloc;
+    x_hash128(bits, size, 0, data + sizeof(xGlyphInfo));
+    memcpy(data, gi, sizeof(xGlyphInfo));
+    x_hash128(data, sizeof(data), size, hash);
     return Success;
 }
 
 GlyphPtr
-FindGlyphByHash(unsigned char sha1[20], int format)
+FindGlyphByHash(unsigned char hash[16], xGlyphInfo * gi, CARD8 *bits,
+                int format)
 {
     GlyphRefPtr gr;
-    CARD32 signature = *(CARD32 *) sha1;
+    CARD32 signature = *(CARD32 *) hash;
+    GlyphKeyRec key = {
+        .hash = hash,
+        .gi = gi,
+        .bits = bits,
+        .depth = glyphDepths[format],
+    };
 
     if (!globalGlyphs[format].hashSet)
         return NULL;
 
-    gr = FindGlyphRef(&globalGlyphs[format], signature, TRUE, sha1);
+    gr = FindGlyphRef(&globalGlyphs[format], signature, NULL, &key);
 
     if (gr->glyph && gr->glyph != DeletedGlyph)
         return gr->glyph;
@@ -263,8 +396,8 @@ FreeGlyph(GlyphPtr glyph, int format)
                 first = i;
             }
 
-        signature = *(CARD32 *) glyph->sha1;
-        gr = FindGlyphRef(&globalGlyphs[format], signature, TRUE, glyph->sha1);
+        signature = *(CARD32 *) glyph->hash;
+        gr = FindGlyphRef(&globalGlyphs[format], signature, glyph, NULL);
         if (gr - globalGlyphs[format].table != first)
             DuplicateRef(glyph, "Found wrong one");
         if (gr->glyph && gr->glyph != DeletedGlyph) {
@@ -283,12 +416,18 @@ AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
 {
     GlyphRefPtr gr;
     CARD32 signature;
+    GlyphKeyRec key = {
+        .hash = glyph->hash,
+        .glyph = glyph,
+        .gi = &glyph->info,
+        .depth = glyphDepths[glyphSet->fdepth],
+    };
 
     CheckDuplicates(&globalGlyphs[glyphSet->fdepth], "AddGlyph top global");
     /* Locate existing matching glyph */
-    signature = *(CARD32 *) glyph->sha1;
+    signature = *(CARD32 *) glyph->hash;
     gr = FindGlyphRef(&globalGlyphs[glyphSet->fdepth], signature,
-                      TRUE, glyph->sha1);
+                      NULL, &key);
     if (gr->glyph && gr->glyph != DeletedGlyph && gr->glyph != glyph) {
         FreeGlyphPicture(glyph);
         dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
@@ -301,7 +440,7 @@ AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
     }
 
     /* Insert/replace glyphset value */
-    gr = FindGlyphRef(&glyphSet->hash, id, FALSE, 0);
+    gr = FindGlyphRef(&glyphSet->hash, id, NULL, NULL);
     ++glyph->refcnt;
     if (gr->glyph && gr->glyph != DeletedGlyph)
         FreeGlyph(gr->glyph, glyphSet->fdepth);
@@ -318,7 +457,7 @@ DeleteGlyph(GlyphSetPtr glyphSet, Glyph id)
     GlyphRefPtr gr;
     GlyphPtr glyph;
 
-    gr = FindGlyphRef(&glyphSet->hash, id, FALSE, 0);
+    gr = FindGlyphRef(&glyphSet->hash, id, NULL, NULL);
     glyph = gr->glyph;
     if (glyph && glyph != DeletedGlyph) {
         gr->glyph = DeletedGlyph;
@@ -334,7 +473,7 @@ FindGlyph(GlyphSetPtr glyphSet, Glyph id)
 {
     GlyphPtr glyph;
 
-    glyph = FindGlyphRef(&glyphSet->hash, id, FALSE, 0)->glyph;
+    glyph = FindGlyphRef(&glyphSet->hash, id, NULL, NULL)->glyph;
     if (glyph == DeletedGlyph)
         glyph = 0;
     return glyph;
@@ -355,6 +494,7 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
     if (!glyph)
         return 0;
     glyph->refcnt = 0;
+    glyph->hasSha1 = FALSE;
     glyph->size = size + sizeof(xGlyphInfo);
     glyph->info = *gi;
     dixInitPrivates(glyph, (char *) glyph + head_size, PRIVATE_GLYPH);
@@ -420,7 +560,7 @@ ResizeGlyphHash(GlyphHashPtr hash, CARD32 change, Bool global)
             glyph = hash->table[i].glyph;
             if (glyph && glyph != DeletedGlyph) {
                 s = hash->table[i].signature;
-                gr = FindGlyphRef(&newHash, s, global, glyph->sha1);
+                gr = FindGlyphRef(&newHash, s, global ? glyph : NULL, NULL);
 
                 gr->signature = s;
                 gr->glyph = glyph;
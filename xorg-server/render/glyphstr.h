@@ -42,7 +42,9 @@
 typedef struct _Glyph {
     CARD32 refcnt;
     PrivateRec *devPrivates;
-    unsigned char sha1[20];
+    unsigned char hash[16];     /* fast content hash, keys the global table */
+    unsigned char sha1[20];     /* content SHA-1, once hasSha1 is set */
+    Bool hasSha1;
     CARD32 size;                /* info + bitmap */
     xGlyphInfo info;
     /* per-screen pixmaps follow */
@@ -93,11 +95,12 @@ typedef struct _GlyphList {
 extern void
  GlyphUninit(ScreenPtr pScreen);
 
-extern GlyphPtr FindGlyphByHash(unsigned char sha1[20], int format);
+extern GlyphPtr FindGlyphByHash(unsigned char hash[16],
+                                xGlyphInfo * gi, CARD8 *bits, int format);
 
 extern int
 HashGlyph(xGlyphInfo * gi,
-          CARD8 *bits, unsigned long size, unsigned char sha1[20]);
+          CARD8 *bits, unsigned long size, unsigned char hash[16]);
 
 extern void
  AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id);
@@ -985,7 +985,7 @@ typedef struct _GlyphNew {
     Glyph id;
     GlyphPtr glyph;
     Bool found;
-    unsigned char sha1[20];
+    unsigned char hash[16];
 } GlyphNewRec, *GlyphNewPtr;
 
 #define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
@@ -1068,11 +1068,12 @@ ProcRenderAddGlyphs(ClientPtr client)
         if (remain < size)
             break;
 
-        err = HashGlyph(&gi[i], bits, size, glyph_new->sha1);
+        err = HashGlyph(&gi[i], bits, size, glyph_new->hash);
         if (err)
             goto bail;
 
-        glyph_new->glyph = FindGlyphByHash(glyph_new->sha1, glyphSet->fdepth);
+        glyph_new->glyph = FindGlyphByHash(glyph_new->hash, &gi[i], bits,
+                                           glyphSet->fdepth);
 
         if (glyph_new->glyph && glyph_new->glyph != DeletedGlyph) {
             glyph_new->found = TRUE;
@@ -1150,7 +1151,7 @@ ProcRenderAddGlyphs(ClientPtr client)
                 pSrcPix = NULL;
             }
 
-            memcpy(glyph_new->glyph->sha1, glyph_new->sha1, 20);
+            memcpy(glyph_new->glyph->hash, glyph_new->hash, 16);
         }
 
         glyph_new->id = gids[i];
@@ -0,0 +1,256 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Atom table benchmark: interns roughly the 1500 atoms a GTK plus KDE
+ * session ends up with, then measures InternAtom (only-if-exists) and
+ * GetAtomName, both pipelined and as individual round trips.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "bench.h"
+
+#define MAX_ATOMS 2048
+
+static const char *session_atoms[] = {
+    "UTF8_STRING", "COMPOUND_TEXT", "TEXT", "TARGETS", "MULTIPLE",
+    "TIMESTAMP", "CLIPBOARD", "CLIPBOARD_MANAGER", "SAVE_TARGETS", "INCR",
+    "DELETE", "ATOM_PAIR", "WM_PROTOCOLS", "WM_DELETE_WINDOW",
+    "WM_TAKE_FOCUS", "WM_STATE", "WM_CHANGE_STATE", "WM_CLIENT_LEADER",
+    "WM_WINDOW_ROLE", "WM_LOCALE_NAME", "WM_COLORMAP_WINDOWS",
+    "SM_CLIENT_ID", "MANAGER", "RESOURCE_MANAGER", "SCREEN_RESOURCES",
+    "_XSETTINGS_SETTINGS", "_XKB_RULES_NAMES", "_XEMBED", "_XEMBED_INFO",
+    "_MOTIF_WM_HINTS", "_MOTIF_DRAG_AND_DROP_MESSAGE", "XdndAware",
+    "XdndEnter", "XdndLeave", "XdndPosition", "XdndStatus", "XdndDrop",
+    "XdndFinished", "XdndSelection", "XdndTypeList", "XdndActionCopy",
+    "XdndActionMove", "XdndActionLink", "XdndActionAsk",
+    "XdndActionPrivate", "XdndActionList", "XdndActionDescription",
+    "XdndProxy", "_NET_SUPPORTED", "_NET_CLIENT_LIST",
+    "_NET_CLIENT_LIST_STACKING", "_NET_NUMBER_OF_DESKTOPS",
+    "_NET_DESKTOP_GEOMETRY", "_NET_DESKTOP_VIEWPORT",
+    "_NET_CURRENT_DESKTOP", "_NET_DESKTOP_NAMES", "_NET_ACTIVE_WINDOW",
+    "_NET_WORKAREA", "_NET_SUPPORTING_WM_CHECK", "_NET_VIRTUAL_ROOTS",
+    "_NET_DESKTOP_LAYOUT", "_NET_SHOWING_DESKTOP", "_NET_CLOSE_WINDOW",
+    "_NET_MOVERESIZE_WINDOW", "_NET_WM_MOVERESIZE", "_NET_RESTACK_WINDOW",
+    "_NET_REQUEST_FRAME_EXTENTS", "_NET_WM_NAME", "_NET_WM_VISIBLE_NAME",
+    "_NET_WM_ICON_NAME", "_NET_WM_VISIBLE_ICON_NAME", "_NET_WM_DESKTOP",
+    "_NET_WM_WINDOW_TYPE", "_NET_WM_STATE", "_NET_WM_ALLOWED_ACTIONS",
+    "_NET_WM_STRUT", "_NET_WM_STRUT_PARTIAL", "_NET_WM_ICON_GEOMETRY",
+    "_NET_WM_ICON", "_NET_WM_PID", "_NET_WM_HANDLED_ICONS",
+    "_NET_WM_USER_TIME", "_NET_WM_USER_TIME_WINDOW", "_NET_FRAME_EXTENTS",
+    "_NET_WM_OPAQUE_REGION", "_NET_WM_BYPASS_COMPOSITOR", "_NET_WM_PING",
+    "_NET_WM_SYNC_REQUEST", "_NET_WM_SYNC_REQUEST_COUNTER",
+    "_NET_WM_FULLSCREEN_MONITORS", "_NET_WM_FULL_PLACEMENT",
+    "_NET_WM_WINDOW_OPACITY", "_NET_STARTUP_ID", "_NET_STARTUP_INFO",
+    "_NET_STARTUP_INFO_BEGIN", "_NET_SYSTEM_TRAY_OPCODE",
+    "_NET_SYSTEM_TRAY_MESSAGE_DATA", "_NET_SYSTEM_TRAY_ORIENTATION",
+    "_NET_SYSTEM_TRAY_VISUAL", "_NET_SYSTEM_TRAY_COLORS",
+    "_GTK_FRAME_EXTENTS", "_GTK_THEME_VARIANT", "_GTK_SHOW_WINDOW_MENU",
+    "_GTK_EDGE_CONSTRAINTS", "_GTK_WORKAREAS", "_GTK_HIDE_TITLEBAR_WHEN_MAXIMIZED",
+    "_GTK_APPLICATION_ID", "_GTK_UNIQUE_BUS_NAME", "_GTK_MENUBAR_OBJECT_PATH",
+    "_GTK_APPLICATION_OBJECT_PATH", "_GTK_WINDOW_OBJECT_PATH",
+    "_GTK_APP_MENU_OBJECT_PATH", "_GTK_LOAD_ICONTHEMES",
+    "_KDE_NET_WM_FRAME_STRUT", "_KDE_NET_WM_WINDOW_TYPE_OVERRIDE",
+    "_KDE_NET_WM_BLUR_BEHIND_REGION", "_KDE_NET_WM_SHADOW",
+    "_KDE_NET_WM_ACTIVITIES", "_KDE_NET_WM_USER_CREATION_TIME",
+    "_KDE_NET_WM_TEMPORARY_RULES", "_KDE_NET_WM_BACKGROUND_CONTRAST_REGION",
+    "_KDE_NET_WM_APPMENU_SERVICE_NAME", "_KDE_NET_WM_APPMENU_OBJECT_PATH",
+    "_KDE_SLIDE", "_KDE_WM_CHANGE_STATE", "_KDE_OSD",
+    "_KDE_SPLASH_PROGRESS", "_KDE_FIRST_IN_WINDOWLIST",
+    "_QT_SELECTION", "_QT_CLIPBOARD_SENTINEL", "_QT_SELECTION_SENTINEL",
+    "_QT_SCROLL_DONE", "_QT_INPUT_ENCODING", "_QT_CLOSE_CONCEAL",
+    "_QT_GET_TIMESTAMP", "_XSETTINGS_S0", "_NET_WM_CM_S0", "WM_S0",
+    "_NET_SYSTEM_TRAY_S0", "_NET_DESKTOP_MANAGER_S0",
+    "_ICC_PROFILE", "_ICC_PROFILE_IN_X_VERSION", "_XROOTPMAP_ID",
+    "ESETROOT_PMAP_ID", "AT_SPI_BUS", "_DBUS_SESSION_BUS_SELECTION",
+    "FOUNDRY", "FAMILY_NAME", "WEIGHT_NAME", "SLANT", "SETWIDTH_NAME",
+    "ADD_STYLE_NAME", "PIXEL_SIZE", "POINT_SIZE", "RESOLUTION_X",
+    "RESOLUTION_Y", "SPACING", "AVERAGE_WIDTH", "CHARSET_REGISTRY",
+    "CHARSET_ENCODING", "FONT", "FACE_NAME", "COPYRIGHT", "RAW_ASCENT",
+    "RAW_DESCENT", "Backlight", "EDID", "scaling mode", "Axis Labels",
+    "Button Labels", "Device Enabled", "Coordinate Transformation Matrix",
+    "Device Node", "Device Product ID", "libinput Tapping Enabled",
+    "libinput Natural Scrolling Enabled", "libinput Accel Speed",
+    "Rel X", "Rel Y", "Rel Horiz Wheel", "Rel Vert Wheel", "Abs X", "Abs Y",
+    "Abs Pressure", "Abs Tilt X", "Abs Tilt Y", "Button Left",
+    "Button Middle", "Button Right", "Button Wheel Up", "Button Wheel Down",
+    "Button Horiz Wheel Left", "Button Horiz Wheel Right",
+};
+
+static const char *net_wm_window_types[] = {
+    "DESKTOP", "DOCK", "TOOLBAR", "MENU", "UTILITY", "SPLASH", "DIALOG",
+    "DROPDOWN_MENU", "POPUP_MENU", "TOOLTIP", "NOTIFICATION", "COMBO",
+    "DND", "NORMAL",
+};
+
+static const char *net_wm_states[] = {
+    "MODAL", "STICKY", "MAXIMIZED_VERT", "MAXIMIZED_HORZ", "SHADED",
+    "SKIP_TASKBAR", "SKIP_PAGER", "HIDDEN", "FULLSCREEN", "ABOVE", "BELOW",
+    "DEMANDS_ATTENTION", "FOCUSED",
+};
+
+static const char *net_wm_actions[] = {
+    "MOVE", "RESIZE", "MINIMIZE", "SHADE", "STICK", "MAXIMIZE_HORZ",
+    "MAXIMIZE_VERT", "FULLSCREEN", "CHANGE_DESKTOP", "CLOSE", "ABOVE",
+    "BELOW",
+};
+
+static const char *mime_types[] = {
+    "text/plain", "text/plain;charset=utf-8", "text/html", "text/uri-list",
+    "text/x-moz-url", "text/x-moz-url-priv", "text/rtf", "text/richtext",
+    "image/png", "image/jpeg", "image/bmp", "image/gif", "image/tiff",
+    "image/x-icon", "image/svg+xml", "application/x-qt-image",
+    "application/x-kde-cutselection", "application/x-kde-suggestedfilename",
+    "application/x-color", "application/x-gtk-text-buffer-rich-text",
+    "application/x-rootwindow-drop", "application/vnd.oasis.opendocument.text",
+    "application/pdf", "application/octet-stream", "chromium/x-web-custom-data",
+    "chromium/x-renderer-taint", "x-special/gnome-copied-files",
+    "x-special/nautilus-clipboard", "STRING", "TEXT/PLAIN",
+};
+
+static char names[MAX_ATOMS][64];
+static int num_names;
+
+static void
+add_name(const char *fmt, const char *a, int b)
+{
+    if (num_names < MAX_ATOMS)
+        snprintf(names[num_names++], sizeof(names[0]), fmt, a, b);
+}
+
+/* Builds the session's atom names: the fixed list above plus the per
+ * screen, per type and per application variants real sessions create. */
+static void
+build_names(void)
+{
+    int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(session_atoms); i++)
+        add_name("%s", session_atoms[i], 0);
+    for (i = 0; i < ARRAY_SIZE(net_wm_window_types); i++) {
+        add_name("_NET_WM_WINDOW_TYPE_%s", net_wm_window_types[i], 0);
+        add_name("_KDE_NET_WM_WINDOW_TYPE_%s", net_wm_window_types[i], 0);
+    }
+    for (i = 0; i < ARRAY_SIZE(net_wm_states); i++) {
+        add_name("_NET_WM_STATE_%s", net_wm_states[i], 0);
+        add_name("_KDE_NET_WM_STATE_%s", net_wm_states[i], 0);
+    }
+    for (i = 0; i < ARRAY_SIZE(net_wm_actions); i++)
+        add_name("_NET_WM_ACTION_%s", net_wm_actions[i], 0);
+    for (i = 0; i < ARRAY_SIZE(mime_types); i++)
+        add_name("%s", mime_types[i], 0);
+    for (i = 1; i < 16; i++) {
+        add_name("%s%d", "_NET_WM_CM_S", i);
+        add_name("%s%d", "WM_S", i);
+        add_name("%s%d", "_NET_SYSTEM_TRAY_S", i);
+        add_name("%s%d", "_XSETTINGS_S", i);
+        add_name("%s%d", "_NET_DESKTOP_MANAGER_S", i);
+        add_name("%s%d", "_ICC_PROFILE_", i);
+    }
+    /* toolkits intern private per-instance selection and property names */
+    for (i = 0; num_names < 1500; i++) {
+        add_name("_GDK_SELECTION_%s_%d", "CLIPBOARD", i);
+        add_name("_QT_SELECTION_%s_%d", "XdndSelection", i);
+        for (j = 0; j < 4 && num_names < 1500; j++)
+            add_name("_KDE_STARTUP_NOTIFY_%s%d", j & 1 ? "END_" : "", i * 4 + j);
+    }
+}
+
+static void
+intern_all(xcb_connection_t *c, xcb_atom_t *atoms, uint8_t only_if_exists)
+{
+    xcb_intern_atom_cookie_t cookies[MAX_ATOMS];
+    xcb_intern_atom_reply_t *reply;
+    int i;
+
+    for (i = 0; i < num_names; i++)
+        cookies[i] = xcb_intern_atom(c, only_if_exists, strlen(names[i]),
+                                     names[i]);
+    for (i = 0; i < num_names; i++) {
+        reply = xcb_intern_atom_reply(c, cookies[i], NULL);
+        atoms[i] = reply ? reply->atom : XCB_ATOM_NONE;
+        free(reply);
+    }
+}
+
+static void
+name_all(xcb_connection_t *c, const xcb_atom_t *atoms)
+{
+    xcb_get_atom_name_cookie_t cookies[MAX_ATOMS];
+    int i;
+
+    for (i = 0; i < num_names; i++)
+        cookies[i] = xcb_get_atom_name(c, atoms[i]);
+    for (i = 0; i < num_names; i++)
+        free(xcb_get_atom_name_reply(c, cookies[i], NULL));
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_atom_t atoms[MAX_ATOMS], check[MAX_ATOMS];
+    const int rounds = 100;
+    double t0, t1;
+    int i, r;
+
+    build_names();
+
+    t0 = bench_now();
+    intern_all(c, atoms, 0);
+    t1 = bench_now();
+    bench_report("InternAtom create", num_names, num_names, t1 - t0);
+
+    t0 = bench_now();
+    for (r = 0; r < rounds; r++)
+        intern_all(c, check, 1);
+    t1 = bench_now();
+    bench_report("InternAtom lookup", num_names, rounds * num_names, t1 - t0);
+
+    for (i = 0; i < num_names; i++) {
+        if (check[i] != atoms[i]) {
+            fprintf(stderr, "%s: got atom %u, expected %u\n", names[i],
+                    check[i], atoms[i]);
+            return 1;
+        }
+    }
+
+    t0 = bench_now();
+    for (r = 0; r < rounds; r++)
+        name_all(c, atoms);
+    t1 = bench_now();
+    bench_report("GetAtomName", num_names, rounds * num_names, t1 - t0);
+
+    /* one request at a time, so this is latency rather than throughput */
+    t0 = bench_now();
+    for (i = 0; i < num_names; i++)
+        free(xcb_intern_atom_reply(c, xcb_intern_atom(c, 1, strlen(names[i]),
+                                                      names[i]), NULL));
+    t1 = bench_now();
+    bench_report("InternAtom round trip", num_names, num_names, t1 - t0);
+
+    return bench_finish(c);
+}
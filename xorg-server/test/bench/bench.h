@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Shared helpers for the client-side benchmarks.  Each benchmark is a
+ * plain xcb client run against Xvfb through simple-xinit; they print
+ * one line per measurement and exit 0 unless the connection breaks.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+static inline double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void
+bench_report(const char *name, long n, long ops, double seconds)
+{
+    printf("%-24s n=%-8ld %12.1f ns/op %14.0f ops/s\n", name, n,
+           seconds * 1e9 / ops, ops / seconds);
+}
+
+/** Round-trips to the server so all queued requests have been handled. */
+static inline void
+bench_sync(xcb_connection_t *c)
+{
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static inline xcb_connection_t *
+bench_connect(xcb_screen_t **screen)
+{
+    int screen_num;
+    xcb_connection_t *c = xcb_connect(NULL, &screen_num);
+    xcb_screen_iterator_t it;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect to the server\n");
+        exit(1);
+    }
+    it = xcb_setup_roots_iterator(xcb_get_setup(c));
+    while (screen_num-- > 0)
+        xcb_screen_next(&it);
+    *screen = it.data;
+    return c;
+}
+
+static inline int
+bench_finish(xcb_connection_t *c)
+{
+    int err = xcb_connection_has_error(c);
+
+    xcb_disconnect(c);
+    if (err) {
+        fprintf(stderr, "Connection error %d\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* BENCH_H */
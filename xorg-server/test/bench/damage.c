@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Damage coalescing: replays damage traces shaped like the ones a
+ * terminal, a scrolling browser page and a busy animated desktop
+ * produce, frame by frame, into a pixmap watched by a DAMAGE object.
+ * After each frame the damage is fetched the way a compositor would, and
+ * its box count and area are compared with the exact area drawn.  Run it
+ * once per -damagepolicy to compare policies.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <xcb/damage.h>
+#include <xcb/xfixes.h>
+#include "bench.h"
+
+#define WIDTH 1024
+#define HEIGHT 768
+#define FRAMES 2000
+
+#define CELL_W 9
+#define CELL_H 18
+#define COLS (WIDTH / CELL_W)
+#define ROWS (HEIGHT / CELL_H)
+
+typedef enum { TRACE_TERMINAL, TRACE_SCROLL, TRACE_SPARKLE } trace_t;
+
+static const struct {
+    const char *name;
+    trace_t trace;
+} runs[] = {
+    { "damage terminal", TRACE_TERMINAL },
+    { "damage scroll", TRACE_SCROLL },
+    { "damage sparkle", TRACE_SPARKLE },
+};
+
+static uint8_t drawn[WIDTH * HEIGHT];
+static uint32_t seed;
+
+static uint32_t
+next_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void
+fill(xcb_connection_t *c, xcb_drawable_t d, xcb_gcontext_t gc,
+     int x, int y, int w, int h)
+{
+    xcb_rectangle_t r = { x, y, w, h };
+    int i;
+
+    if (x < 0 || y < 0 || x + w > WIDTH || y + h > HEIGHT)
+        return;
+    xcb_poly_fill_rectangle(c, d, gc, 1, &r);
+    for (i = 0; i < h; i++)
+        memset(drawn + (y + i) * WIDTH + x, 1, w);
+}
+
+/* A line of text: one cell per glyph, spaces left alone. */
+static void
+text(xcb_connection_t *c, xcb_drawable_t d, xcb_gcontext_t gc,
+     int row, int col, int len)
+{
+    for (; len-- && col < COLS; col++)
+        if (next_random() % 6)
+            fill(c, d, gc, col * CELL_W, row * CELL_H, CELL_W, CELL_H);
+}
+
+static void
+frame(xcb_connection_t *c, xcb_drawable_t d, xcb_gcontext_t gc,
+      trace_t trace)
+{
+    int i, n;
+
+    switch (trace) {
+    case TRACE_TERMINAL:
+        /* a few lines of output and the cursor */
+        n = 1 + next_random() % 4;
+        for (i = 0; i < n; i++)
+            text(c, d, gc, next_random() % ROWS, 0, next_random() % COLS);
+        fill(c, d, gc, (next_random() % COLS) * CELL_W,
+             (next_random() % ROWS) * CELL_H, CELL_W, CELL_H);
+        break;
+    case TRACE_SCROLL:
+        /* the page moves up a line, a new line comes in at the bottom */
+        xcb_copy_area(c, d, d, gc, 0, CELL_H, 0, 0, WIDTH, HEIGHT - CELL_H);
+        memset(drawn, 1, WIDTH * (HEIGHT - CELL_H));
+        text(c, d, gc, ROWS - 1, 0, COLS);
+        /* and a sidebar widget updates */
+        n = next_random() % 8;
+        for (i = 0; i < n; i++)
+            fill(c, d, gc, WIDTH - 200 + next_random() % 180,
+                 next_random() % HEIGHT, 16, 16);
+        break;
+    case TRACE_SPARKLE:
+        /* spinners, blinking icons and progress bars all over */
+        n = 50 + next_random() % 150;
+        for (i = 0; i < n; i++)
+            fill(c, d, gc, next_random() % WIDTH, next_random() % HEIGHT,
+                 2 + next_random() % 7, 2 + next_random() % 7);
+        break;
+    }
+}
+
+static long
+count_drawn(void)
+{
+    long n = 0;
+    int i;
+
+    for (i = 0; i < WIDTH * HEIGHT; i++)
+        n += drawn[i];
+    return n;
+}
+
+static void
+run(xcb_connection_t *c, xcb_screen_t *screen, const char *name,
+    trace_t trace)
+{
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    xcb_damage_damage_t damage = xcb_generate_id(c);
+    xcb_xfixes_region_t region = xcb_generate_id(c);
+    xcb_xfixes_fetch_region_reply_t *reply;
+    xcb_rectangle_t *rects;
+    long boxes = 0, exact = 0, reported = 0;
+    double start;
+    int i, j, n;
+
+    xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root,
+                      WIDTH, HEIGHT);
+    xcb_create_gc(c, gc, pixmap, 0, NULL);
+    xcb_xfixes_create_region(c, region, 0, NULL);
+    xcb_damage_create(c, damage, pixmap,
+                      XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+
+    seed = 1;
+    start = bench_now();
+    for (i = 0; i < FRAMES; i++) {
+        memset(drawn, 0, sizeof(drawn));
+        frame(c, pixmap, gc, trace);
+        exact += count_drawn();
+
+        xcb_damage_subtract(c, damage, XCB_NONE, region);
+        reply = xcb_xfixes_fetch_region_reply(c,
+                                              xcb_xfixes_fetch_region(c,
+                                                                      region),
+                                              NULL);
+        if (!reply)
+            break;
+        rects = xcb_xfixes_fetch_region_rectangles(reply);
+        n = xcb_xfixes_fetch_region_rectangles_length(reply);
+        boxes += n;
+        for (j = 0; j < n; j++)
+            reported += (long) rects[j].width * rects[j].height;
+        free(reply);
+    }
+    bench_report(name, FRAMES, FRAMES, bench_now() - start);
+    printf("%-24s %.1f boxes/frame, %.1f%% pixels over-reported\n", "",
+           (double) boxes / FRAMES,
+           exact ? 100.0 * (reported - exact) / exact : 0.0);
+
+    xcb_damage_destroy(c, damage);
+    xcb_xfixes_destroy_region(c, region);
+    xcb_free_gc(c, gc);
+    xcb_free_pixmap(c, pixmap);
+    bench_sync(c);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_damage_query_version_reply_t *damage;
+    xcb_xfixes_query_version_reply_t *xfixes;
+    int i;
+
+    xfixes = xcb_xfixes_query_version_reply(c,
+                                            xcb_xfixes_query_version(c, 2, 0),
+                                            NULL);
+    damage = xcb_damage_query_version_reply(c,
+                                            xcb_damage_query_version(c, 1, 1),
+                                            NULL);
+    if (!xfixes || !damage) {
+        fprintf(stderr, "DAMAGE or XFIXES is not available\n");
+        free(xfixes);
+        free(damage);
+        return bench_finish(c);
+    }
+    free(xfixes);
+    free(damage);
+
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+        run(c, screen, runs[i].name, runs[i].trace);
+
+    return bench_finish(c);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * GetImage throughput: reads a pixmap back at a few sizes, one request
+ * at a time and with several requests in flight, so that replies back
+ * up in the server's output queue the way they do for a client busy
+ * elsewhere.
+ */
+
+#include <stdint.h>
+#include "bench.h"
+
+#define PIPELINE 8
+
+static const struct {
+    uint16_t width, height;
+    int rounds;
+} sizes[] = {
+    { 64, 64, 2000 },
+    { 512, 512, 200 },
+    { 1920, 1080, 40 },
+    { 3840, 2160, 10 },
+};
+
+static void
+report(const char *name, int width, int height, long ops, long bytes,
+       double seconds)
+{
+    char label[32];
+
+    snprintf(label, sizeof(label), "%s %dx%d", name, width, height);
+    bench_report(label, (long) width * height, ops, seconds);
+    printf("%-24s %.1f MB/s\n", "", bytes / seconds / 1e6);
+}
+
+static long
+get_image(xcb_connection_t *c, xcb_pixmap_t pixmap, int width, int height,
+          int count)
+{
+    xcb_get_image_cookie_t cookies[PIPELINE];
+    xcb_get_image_reply_t *reply;
+    long bytes = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+        cookies[i] = xcb_get_image(c, XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap,
+                                   0, 0, width, height, ~0);
+    for (i = 0; i < count; i++) {
+        reply = xcb_get_image_reply(c, cookies[i], NULL);
+        if (reply) {
+            bytes += xcb_get_image_data_length(reply);
+            free(reply);
+        }
+    }
+    return bytes;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_pixmap_t pixmap;
+    xcb_gcontext_t gc;
+    xcb_rectangle_t rect;
+    uint32_t value;
+    long bytes;
+    double t0, t1;
+    int i, r;
+
+    for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+        const int width = sizes[i].width, height = sizes[i].height;
+        const int rounds = sizes[i].rounds;
+
+        pixmap = xcb_generate_id(c);
+        xcb_create_pixmap(c, screen->root_depth, pixmap, screen->root,
+                          width, height);
+        gc = xcb_generate_id(c);
+        value = 0x336699;
+        xcb_create_gc(c, gc, pixmap, XCB_GC_FOREGROUND, &value);
+        rect.x = rect.y = 0;
+        rect.width = width;
+        rect.height = height;
+        xcb_poly_fill_rectangle(c, pixmap, gc, 1, &rect);
+        bench_sync(c);
+
+        bytes = 0;
+        t0 = bench_now();
+        for (r = 0; r < rounds; r++)
+            bytes += get_image(c, pixmap, width, height, 1);
+        t1 = bench_now();
+        report("GetImage", width, height, rounds, bytes, t1 - t0);
+
+        bytes = 0;
+        t0 = bench_now();
+        for (r = 0; r < rounds; r += PIPELINE)
+            bytes += get_image(c, pixmap, width, height, PIPELINE);
+        t1 = bench_now();
+        report("GetImage pipelined", width, height,
+               (rounds + PIPELINE - 1) / PIPELINE * PIPELINE, bytes, t1 - t0);
+
+        xcb_free_gc(c, gc);
+        xcb_free_pixmap(c, pixmap);
+    }
+
+    return bench_finish(c);
+}
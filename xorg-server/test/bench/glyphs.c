@@ -0,0 +1,186 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * RenderAddGlyphs throughput, the way a terminal or browser fills a
+ * glyph set at startup: batches of distinct glyphs, then the same glyphs
+ * again into a second glyph set, which the server shares with the first
+ * instead of storing twice.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <xcb/render.h>
+#include "bench.h"
+
+#define GLYPHS 20000
+#define BATCH 32
+
+static const struct {
+    const char *name;
+    int depth;
+    uint16_t width, height;
+} runs[] = {
+    { "addglyphs a8 12x16", 8, 12, 16 },
+    { "addglyphs a8 24x32", 8, 24, 32 },
+    { "addglyphs argb 24x32", 32, 24, 32 },
+};
+
+static xcb_render_pictformat_t
+find_format(xcb_connection_t *c, int depth)
+{
+    xcb_render_query_pict_formats_reply_t *reply;
+    xcb_render_pictforminfo_iterator_t it;
+    xcb_render_pictformat_t format = XCB_NONE;
+
+    reply = xcb_render_query_pict_formats_reply(c,
+                                                xcb_render_query_pict_formats
+                                                (c), NULL);
+    if (!reply)
+        return XCB_NONE;
+    for (it = xcb_render_query_pict_formats_formats_iterator(reply);
+         it.rem; xcb_render_pictforminfo_next(&it)) {
+        xcb_render_pictforminfo_t *info = it.data;
+
+        if (info->type == XCB_RENDER_PICT_TYPE_DIRECT &&
+            info->depth == depth && info->direct.alpha_mask == 0xff &&
+            (depth == 8 || info->direct.red_mask == 0xff)) {
+            format = info->id;
+            break;
+        }
+    }
+    free(reply);
+    return format;
+}
+
+/* Glyph n: a pattern no other n produces. */
+static void
+fill_glyph(uint8_t *bits, int stride, int width, int height, int bpp,
+           uint32_t n)
+{
+    uint32_t v = n * 2654435761u + 1;
+    int x, y, i;
+
+    for (y = 0; y < height; y++) {
+        memset(bits + y * stride, 0, stride);
+        for (x = 0; x < width * bpp; x++) {
+            v ^= v << 13;
+            v ^= v >> 17;
+            v ^= v << 5;
+            bits[y * stride + x] = v;
+        }
+    }
+    /* make sure distinct n never collide on content */
+    for (i = 0; i < 4 && i < width * bpp; i++)
+        bits[i] = n >> (8 * i);
+}
+
+static double
+add_glyphs(xcb_connection_t *c, xcb_render_glyphset_t glyphset,
+           int width, int height, int bpp)
+{
+    int stride = (width * bpp + 3) & ~3;
+    int size = stride * height;
+    uint32_t ids[BATCH];
+    xcb_render_glyphinfo_t info[BATCH];
+    uint8_t *data = malloc(BATCH * size);
+    double start;
+    int i, j;
+
+    if (!data)
+        exit(1);
+    start = bench_now();
+    for (i = 0; i < GLYPHS; i += BATCH) {
+        for (j = 0; j < BATCH; j++) {
+            ids[j] = i + j;
+            info[j].width = width;
+            info[j].height = height;
+            info[j].x = 0;
+            info[j].y = height;
+            info[j].x_off = width;
+            info[j].y_off = 0;
+            fill_glyph(data + j * size, stride, width, height, bpp, i + j);
+        }
+        xcb_render_add_glyphs(c, glyphset, BATCH, ids, info,
+                              BATCH * size, data);
+    }
+    bench_sync(c);
+    free(data);
+    return bench_now() - start;
+}
+
+static void
+run(xcb_connection_t *c, const char *name, int depth, int width, int height)
+{
+    xcb_render_pictformat_t format = find_format(c, depth);
+    xcb_render_glyphset_t first, second;
+    char label[64];
+    double seconds;
+
+    if (format == XCB_NONE) {
+        printf("%-24s no depth %d format\n", name, depth);
+        return;
+    }
+
+    first = xcb_generate_id(c);
+    second = xcb_generate_id(c);
+    xcb_render_create_glyph_set(c, first, format);
+    xcb_render_create_glyph_set(c, second, format);
+
+    seconds = add_glyphs(c, first, width, height, depth / 8);
+    snprintf(label, sizeof(label), "%s new", name);
+    bench_report(label, GLYPHS, GLYPHS, seconds);
+
+    seconds = add_glyphs(c, second, width, height, depth / 8);
+    snprintf(label, sizeof(label), "%s shared", name);
+    bench_report(label, GLYPHS, GLYPHS, seconds);
+
+    xcb_render_free_glyph_set(c, first);
+    xcb_render_free_glyph_set(c, second);
+    bench_sync(c);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_render_query_version_reply_t *version;
+    int i;
+
+    version = xcb_render_query_version_reply(c,
+                                             xcb_render_query_version(c, 0,
+                                                                      11),
+                                             NULL);
+    if (!version) {
+        fprintf(stderr, "RENDER is not available\n");
+        return bench_finish(c);
+    }
+    free(version);
+
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+        run(c, runs[i].name, runs[i].depth, runs[i].width, runs[i].height);
+
+    return bench_finish(c);
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Pointer hit-testing: builds a tree of 2,000 windows, either all
+ * top-levels or top-levels with deeply nested children, and replays a
+ * recorded-style motion trace over it with XTest.  Every so often the
+ * pointer is queried and the top-level under it checked against a
+ * client-side model of the stack, so a wrong hit fails the run.  One run
+ * raises a random window now and then to exercise the restack path.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <xcb/xtest.h>
+#include "bench.h"
+
+#define WINDOWS 2000
+#define TRACE 200000
+#define CHECK_EVERY 64
+
+typedef struct {
+    xcb_window_t id;
+    int x, y, w, h, bw;         /* root coordinates, outside the border */
+} bench_window_t;
+
+static const struct {
+    const char *name;
+    int depth;                  /* windows in each top-level's chain */
+    int raise_every;            /* motions between raises, 0 for none */
+} runs[] = {
+    { "hittest flat", 1, 0 },
+    { "hittest nested 8", 8, 0 },
+    { "hittest flat restack", 1, 256 },
+};
+
+static bench_window_t tops[WINDOWS];
+static int order[WINDOWS];      /* indices into tops, topmost first */
+static int ntops;
+static int16_t trace_x[TRACE], trace_y[TRACE];
+
+static uint32_t seed;
+
+static uint32_t
+next_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/*
+ * A pointer trace: mostly short steps like a hand moving a mouse, with
+ * the odd jump across the screen.
+ */
+static void
+make_trace(int width, int height)
+{
+    int x = width / 2, y = height / 2, i;
+
+    for (i = 0; i < TRACE; i++) {
+        if (next_random() % 500 == 0) {
+            x = next_random() % width;
+            y = next_random() % height;
+        }
+        else {
+            x += (int) (next_random() % 17) - 8;
+            y += (int) (next_random() % 17) - 8;
+            x = x < 0 ? 0 : x >= width ? width - 1 : x;
+            y = y < 0 ? 0 : y >= height ? height - 1 : y;
+        }
+        trace_x[i] = x;
+        trace_y[i] = y;
+    }
+}
+
+static xcb_window_t
+create_window(xcb_connection_t *c, xcb_window_t parent,
+              int x, int y, int w, int h, int bw)
+{
+    uint32_t values[] = { XCB_BACK_PIXMAP_NONE, 1 };
+    xcb_window_t id = xcb_generate_id(c);
+
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, id, parent, x, y, w, h, bw,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_BACK_PIXMAP | XCB_CW_OVERRIDE_REDIRECT, values);
+    xcb_map_window(c, id);
+    return id;
+}
+
+/*
+ * WINDOWS windows in chains of depth: each top-level holds one child
+ * inset from it, which holds the next, and so on.  Top-levels are
+ * created bottom first, so the last one is on top.
+ */
+static int
+build_tree(xcb_connection_t *c, xcb_screen_t *screen, int depth)
+{
+    int width = screen->width_in_pixels, height = screen->height_in_pixels;
+    int i, j, count = 0;
+
+    ntops = WINDOWS / depth;
+    for (i = 0; i < ntops; i++) {
+        bench_window_t *t = &tops[i];
+        xcb_window_t parent;
+        int w, h;
+
+        t->w = 20 + next_random() % (width / 4);
+        t->h = 20 + next_random() % (height / 4);
+        t->x = (int) (next_random() % (width + 40)) - 40;
+        t->y = (int) (next_random() % (height + 40)) - 40;
+        t->bw = next_random() % 3;
+        t->id = create_window(c, screen->root, t->x, t->y,
+                              t->w, t->h, t->bw);
+
+        parent = t->id;
+        w = t->w;
+        h = t->h;
+        for (j = 1; j < depth && w > 4 && h > 4; j++) {
+            w -= 4;
+            h -= 4;
+            parent = create_window(c, parent, 1, 1, w, h, 0);
+        }
+        count += j;
+        order[ntops - 1 - i] = i;
+    }
+    bench_sync(c);
+    return count;
+}
+
+static void
+destroy_tree(xcb_connection_t *c)
+{
+    int i;
+
+    for (i = 0; i < ntops; i++)
+        xcb_destroy_window(c, tops[i].id);
+    bench_sync(c);
+}
+
+/* The top-level the model says is under x/y, or XCB_NONE. */
+static xcb_window_t
+model_hit(int x, int y)
+{
+    int i;
+
+    for (i = 0; i < ntops; i++) {
+        bench_window_t *t = &tops[order[i]];
+
+        if (x >= t->x && x < t->x + t->w + 2 * t->bw &&
+            y >= t->y && y < t->y + t->h + 2 * t->bw)
+            return t->id;
+    }
+    return XCB_NONE;
+}
+
+static void
+raise_random(xcb_connection_t *c)
+{
+    uint32_t above = XCB_STACK_MODE_ABOVE;
+    int i = next_random() % ntops, top = order[i];
+
+    memmove(order + 1, order, i * sizeof(*order));
+    order[0] = top;
+    xcb_configure_window(c, tops[top].id, XCB_CONFIG_WINDOW_STACK_MODE,
+                         &above);
+}
+
+static long
+run(xcb_connection_t *c, xcb_screen_t *screen, const char *name,
+    int depth, int raise_every)
+{
+    long i, checks = 0, wrong = 0;
+    int windows;
+    xcb_query_pointer_cookie_t cookie;
+    xcb_query_pointer_reply_t *reply;
+    double start;
+
+    seed = 1;
+    windows = build_tree(c, screen, depth);
+    make_trace(screen->width_in_pixels, screen->height_in_pixels);
+
+    start = bench_now();
+    for (i = 0; i < TRACE; i++) {
+        if (raise_every && i % raise_every == 0)
+            raise_random(c);
+        xcb_test_fake_input(c, XCB_MOTION_NOTIFY, 0, XCB_CURRENT_TIME,
+                            screen->root, trace_x[i], trace_y[i], 0);
+        if (i % CHECK_EVERY == CHECK_EVERY - 1) {
+            cookie = xcb_query_pointer(c, screen->root);
+            reply = xcb_query_pointer_reply(c, cookie, NULL);
+            if (!reply)
+                break;
+            if (reply->child != model_hit(trace_x[i], trace_y[i]))
+                wrong++;
+            checks++;
+            free(reply);
+        }
+    }
+    bench_sync(c);
+    bench_report(name, TRACE, TRACE, bench_now() - start);
+    printf("%-24s %d windows, %ld checks, %ld wrong\n", "",
+           windows, checks, wrong);
+
+    destroy_tree(c);
+    return wrong;
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_test_get_version_reply_t *version;
+    long wrong = 0;
+    int i;
+
+    version = xcb_test_get_version_reply(c, xcb_test_get_version(c, 2, 2),
+                                         NULL);
+    if (!version) {
+        fprintf(stderr, "XTEST is not available\n");
+        return bench_finish(c);
+    }
+    free(version);
+
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+        wrong += run(c, screen, runs[i].name, runs[i].depth,
+                     runs[i].raise_every);
+
+    if (bench_finish(c))
+        return 1;
+    return wrong != 0;
+}
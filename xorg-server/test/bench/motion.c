@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Pointer motion through the event queue: pushes absolute XTest
+ * motions, a million per batched run, each to a distinct position, and
+ * times how long each one takes to come back as a MotionNotify on the
+ * root window.  Motions the server folded into a later one are counted
+ * as merged and take the later one's delivery time.
+ */
+
+#include <stdint.h>
+#include <xcb/xtest.h>
+#include "bench.h"
+
+#define MOTIONS 1000000
+
+static const struct {
+    const char *name;
+    long count;
+    int burst;                  /* motions sent per flush */
+    int window;                 /* motions allowed in flight */
+} runs[] = {
+    { "motion serial", 100000, 1, 1 },
+    { "motion burst 16", MOTIONS, 16, 64 },
+    { "motion burst 256", MOTIONS, 256, 1024 },
+};
+
+static double *sent;
+static double *latency;
+
+static int
+compare_double(const void *a, const void *b)
+{
+    double da = *(const double *) a, db = *(const double *) b;
+
+    return (da > db) - (da < db);
+}
+
+/* Position of motion i, on a grid inside the root window. */
+static void
+position(long i, int width, int height, int16_t *x, int16_t *y)
+{
+    i %= (long) width * height;
+    *x = 1 + i % width;
+    *y = 1 + i / width;
+}
+
+/* Index of the motion that ended at (x, y), the first one after base. */
+static long
+motion_index(long base, int x, int y, int width, int height)
+{
+    long grid = (long) width * height;
+    long code = (long) (y - 1) * width + (x - 1);
+
+    return base + (code - base % grid + grid) % grid;
+}
+
+static void
+run(xcb_connection_t *c, xcb_screen_t *screen, const char *name,
+    long count, int burst, int window)
+{
+    int width = screen->width_in_pixels - 2;
+    int height = screen->height_in_pixels - 2;
+    long next = 0, delivered = 0, events = 0, n = 0;
+    double start, now;
+    xcb_generic_event_t *ev;
+    int16_t x, y;
+    int i;
+
+    /* start off the grid so the first motion moves */
+    xcb_test_fake_input(c, XCB_MOTION_NOTIFY, 0, XCB_CURRENT_TIME,
+                        screen->root, 0, 0, 0);
+    bench_sync(c);
+    while ((ev = xcb_poll_for_event(c)))
+        free(ev);
+
+    start = bench_now();
+    while (delivered < count) {
+        while (next < count && next - delivered < window) {
+            for (i = 0; i < burst && next < count; i++, next++) {
+                position(next, width, height, &x, &y);
+                sent[next] = bench_now();
+                xcb_test_fake_input(c, XCB_MOTION_NOTIFY, 0,
+                                    XCB_CURRENT_TIME, screen->root, x, y, 0);
+            }
+            xcb_flush(c);
+        }
+
+        ev = xcb_wait_for_event(c);
+        if (!ev)
+            break;
+        if ((ev->response_type & 0x7f) == XCB_MOTION_NOTIFY) {
+            xcb_motion_notify_event_t *motion = (void *) ev;
+            long last = motion_index(delivered, motion->root_x,
+                                     motion->root_y, width, height);
+
+            now = bench_now();
+            if (last < next) {
+                latency[n++] = now - sent[last];
+                delivered = last + 1;
+                events++;
+            }
+        }
+        free(ev);
+    }
+    now = bench_now();
+
+    bench_report(name, count, delivered, now - start);
+    if (n) {
+        qsort(latency, n, sizeof(double), compare_double);
+        printf("%-24s latency p50 %.1f us p99 %.1f us max %.1f us\n", "",
+               latency[n / 2] * 1e6, latency[n * 99 / 100] * 1e6,
+               latency[n - 1] * 1e6);
+    }
+    printf("%-24s %ld events delivered, %ld merged\n", "", events,
+           delivered - events);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    uint32_t mask = XCB_EVENT_MASK_POINTER_MOTION;
+    xcb_test_get_version_reply_t *version;
+    int i;
+
+    version = xcb_test_get_version_reply(c, xcb_test_get_version(c, 2, 2),
+                                         NULL);
+    if (!version) {
+        fprintf(stderr, "XTEST is not available\n");
+        return bench_finish(c);
+    }
+    free(version);
+
+    sent = calloc(MOTIONS, sizeof(double));
+    latency = calloc(MOTIONS, sizeof(double));
+    if (!sent || !latency)
+        return 1;
+
+    xcb_change_window_attributes(c, screen->root, XCB_CW_EVENT_MASK, &mask);
+    bench_sync(c);
+
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+        run(c, screen, runs[i].name, runs[i].count, runs[i].burst,
+            runs[i].window);
+
+    free(sent);
+    free(latency);
+    return bench_finish(c);
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Property churn on the root window: fills root with a few hundred
+ * properties, as a desktop session does, and then times GetProperty,
+ * ChangeProperty (replace and append), DeleteProperty and
+ * RotateProperties on names picked across the whole set.  A last pass
+ * builds one large value from many appends and reads it back in
+ * pieces, the way INCR selection transfers move clipboard data.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "bench.h"
+
+#define NUM_PROPS 500
+#define ROUNDS 20
+#define INCR_CHUNK (64 * 1024)
+#define INCR_TOTAL (64 * 1024 * 1024)
+
+static xcb_atom_t props[NUM_PROPS];
+
+static void
+intern_props(xcb_connection_t *c)
+{
+    xcb_intern_atom_cookie_t cookies[NUM_PROPS];
+    xcb_intern_atom_reply_t *reply;
+    char name[32];
+    int i;
+
+    for (i = 0; i < NUM_PROPS; i++) {
+        snprintf(name, sizeof(name), "_BENCH_PROPERTY_%d", i);
+        cookies[i] = xcb_intern_atom(c, 0, strlen(name), name);
+    }
+    for (i = 0; i < NUM_PROPS; i++) {
+        reply = xcb_intern_atom_reply(c, cookies[i], NULL);
+        props[i] = reply ? reply->atom : XCB_ATOM_NONE;
+        free(reply);
+    }
+}
+
+static xcb_atom_t
+pick(int i)
+{
+    /* spread consecutive operations over the whole set of names */
+    return props[(i * 37) % NUM_PROPS];
+}
+
+static void
+set_all(xcb_connection_t *c, xcb_window_t root)
+{
+    uint32_t value = 0;
+    int i;
+
+    for (i = 0; i < NUM_PROPS; i++)
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, root, props[i],
+                            XCB_ATOM_CARDINAL, 32, 1, &value);
+}
+
+static void
+incr_transfer(xcb_connection_t *c, xcb_window_t root)
+{
+    static char chunk[INCR_CHUNK];
+    const long chunks = INCR_TOTAL / INCR_CHUNK;
+    xcb_get_property_reply_t *reply;
+    uint32_t offset;
+    double t0, t1;
+    long i;
+
+    memset(chunk, 'x', sizeof(chunk));
+    xcb_delete_property(c, root, props[0]);
+
+    t0 = bench_now();
+    for (i = 0; i < chunks; i++)
+        xcb_change_property(c, XCB_PROP_MODE_APPEND, root, props[0],
+                            XCB_ATOM_STRING, 8, sizeof(chunk), chunk);
+    bench_sync(c);
+    t1 = bench_now();
+    bench_report("ChangeProperty INCR", INCR_TOTAL, chunks, t1 - t0);
+
+    t0 = bench_now();
+    for (offset = 0; offset < INCR_TOTAL / 4; offset += INCR_CHUNK / 4) {
+        reply = xcb_get_property_reply(c,
+                    xcb_get_property(c, 0, root, props[0], XCB_ATOM_STRING,
+                                     offset, INCR_CHUNK / 4), NULL);
+        free(reply);
+    }
+    t1 = bench_now();
+    bench_report("GetProperty INCR", INCR_TOTAL, chunks, t1 - t0);
+
+    xcb_delete_property(c, root, props[0]);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_window_t root = screen->root;
+    xcb_get_property_cookie_t cookies[NUM_PROPS];
+    uint32_t value = 0;
+    const long ops = (long) ROUNDS * NUM_PROPS;
+    double t0, t1;
+    int i, r;
+
+    intern_props(c);
+    set_all(c, root);
+    bench_sync(c);
+
+    t0 = bench_now();
+    for (r = 0; r < ROUNDS; r++) {
+        for (i = 0; i < NUM_PROPS; i++)
+            cookies[i] = xcb_get_property(c, 0, root, pick(i),
+                                          XCB_GET_PROPERTY_TYPE_ANY, 0, 1);
+        for (i = 0; i < NUM_PROPS; i++)
+            free(xcb_get_property_reply(c, cookies[i], NULL));
+    }
+    t1 = bench_now();
+    bench_report("GetProperty", NUM_PROPS, ops, t1 - t0);
+
+    t0 = bench_now();
+    for (r = 0; r < ROUNDS; r++)
+        for (i = 0; i < NUM_PROPS; i++)
+            xcb_change_property(c, XCB_PROP_MODE_REPLACE, root, pick(i),
+                                XCB_ATOM_CARDINAL, 32, 1, &value);
+    bench_sync(c);
+    t1 = bench_now();
+    bench_report("ChangeProperty replace", NUM_PROPS, ops, t1 - t0);
+
+    t0 = bench_now();
+    for (r = 0; r < ROUNDS; r++)
+        for (i = 0; i < NUM_PROPS; i++)
+            xcb_change_property(c, XCB_PROP_MODE_APPEND, root, pick(i),
+                                XCB_ATOM_CARDINAL, 32, 1, &value);
+    bench_sync(c);
+    t1 = bench_now();
+    bench_report("ChangeProperty append", NUM_PROPS, ops, t1 - t0);
+
+    t0 = bench_now();
+    for (r = 0; r < ROUNDS; r++) {
+        for (i = 0; i < NUM_PROPS; i++)
+            xcb_delete_property(c, root, pick(i));
+        /* put them back so every round deletes the full set */
+        set_all(c, root);
+    }
+    bench_sync(c);
+    t1 = bench_now();
+    bench_report("DeleteProperty+Change", NUM_PROPS, 2 * ops, t1 - t0);
+
+    t0 = bench_now();
+    for (r = 0; r < ROUNDS * 10; r++)
+        xcb_rotate_properties(c, root, 8, 1, &props[(r * 8) % (NUM_PROPS - 8)]);
+    bench_sync(c);
+    t1 = bench_now();
+    bench_report("RotateProperties (8)", NUM_PROPS, ROUNDS * 10, t1 - t0);
+
+    incr_transfer(c, root);
+
+    for (i = 0; i < NUM_PROPS; i++)
+        xcb_delete_property(c, root, props[i]);
+
+    return bench_finish(c);
+}
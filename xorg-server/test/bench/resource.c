@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Resource table throughput: creates n 1x1 pixmaps, looks each of them
+ * up (GetGeometry, pipelined) in a scattered order and frees them again,
+ * for n from 1k to 1M.  Pass a smaller maximum as argv[1] if memory is
+ * tight.
+ */
+
+#include <stdint.h>
+#include "bench.h"
+
+#define LOOKUP_BATCH 4096
+
+static void
+lookup_pixmaps(xcb_connection_t *c, const xcb_pixmap_t *ids, long n)
+{
+    xcb_get_geometry_cookie_t cookies[LOOKUP_BATCH];
+    long i, j, done;
+
+    for (done = 0; done < n; done += j) {
+        for (j = 0; j < LOOKUP_BATCH && done + j < n; j++) {
+            /* step through the ids with a large odd stride */
+            i = ((done + j) * 7919) % n;
+            cookies[j] = xcb_get_geometry(c, ids[i]);
+        }
+        for (i = 0; i < j; i++)
+            free(xcb_get_geometry_reply(c, cookies[i], NULL));
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    long max = argc > 1 ? atol(argv[1]) : 1000000;
+    xcb_pixmap_t *ids;
+    double t0, t1;
+    long n, i;
+
+    ids = calloc(max, sizeof(*ids));
+    if (!ids)
+        return 1;
+
+    for (n = 1000; n <= max; n *= 10) {
+        for (i = 0; i < n; i++)
+            ids[i] = xcb_generate_id(c);
+
+        t0 = bench_now();
+        for (i = 0; i < n; i++)
+            xcb_create_pixmap(c, 1, ids[i], screen->root, 1, 1);
+        bench_sync(c);
+        t1 = bench_now();
+        bench_report("AddResource", n, n, t1 - t0);
+
+        t0 = bench_now();
+        lookup_pixmaps(c, ids, n);
+        t1 = bench_now();
+        bench_report("LookupResource", n, n, t1 - t0);
+
+        t0 = bench_now();
+        for (i = 0; i < n; i++)
+            xcb_free_pixmap(c, ids[i]);
+        bench_sync(c);
+        t1 = bench_now();
+        bench_report("FreeResource", n, n, t1 - t0);
+    }
+
+    free(ids);
+    return bench_finish(c);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Large copies in the style of x11perf's -scroll and -move tests, at
+ * the size of the screen: a full-window scroll by a text line each way,
+ * a sideways move, a pixmap copied onto the window and a big top-level
+ * dragged about.  Run it on a large screen, with and without -workers 0,
+ * to see what splitting copies across threads buys.
+ */
+
+#include <stdint.h>
+#include "bench.h"
+
+#define LINE 18
+#define ROUNDS 300
+
+typedef enum {
+    SCROLL_UP, SCROLL_DOWN, MOVE_LEFT, MOVE_RIGHT, COPY_PIXMAP, MOVE_WINDOW
+} op_t;
+
+static const struct {
+    const char *name;
+    op_t op;
+} runs[] = {
+    { "scroll up", SCROLL_UP },
+    { "scroll down", SCROLL_DOWN },
+    { "move left", MOVE_LEFT },
+    { "move right", MOVE_RIGHT },
+    { "copy pixmap", COPY_PIXMAP },
+    { "move window", MOVE_WINDOW },
+};
+
+static xcb_window_t
+create_window(xcb_connection_t *c, xcb_screen_t *screen, int w, int h)
+{
+    uint32_t values[] = { screen->black_pixel, 1 };
+    xcb_window_t id = xcb_generate_id(c);
+
+    xcb_create_window(c, XCB_COPY_FROM_PARENT, id, screen->root, 0, 0, w, h,
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+    xcb_map_window(c, id);
+    return id;
+}
+
+static void
+run(xcb_connection_t *c, xcb_screen_t *screen, const char *name, op_t op)
+{
+    int w = screen->width_in_pixels, h = screen->height_in_pixels;
+    xcb_window_t window;
+    xcb_pixmap_t pixmap = xcb_generate_id(c);
+    xcb_gcontext_t gc = xcb_generate_id(c);
+    uint32_t values[] = { screen->white_pixel, 0 };
+    xcb_rectangle_t rect = { 0, 0, w, h };
+    uint32_t pos[2];
+    double start, seconds;
+    long bytes;
+    int i;
+
+    /* the moved window leaves room to move in */
+    if (op == MOVE_WINDOW)
+        window = create_window(c, screen, w - 4 * LINE, h - 4 * LINE);
+    else
+        window = create_window(c, screen, w, h);
+    xcb_create_pixmap(c, screen->root_depth, pixmap, window, w, h);
+    xcb_create_gc(c, gc, window,
+                  XCB_GC_FOREGROUND | XCB_GC_GRAPHICS_EXPOSURES, values);
+    xcb_poly_fill_rectangle(c, pixmap, gc, 1, &rect);
+    xcb_copy_area(c, pixmap, window, gc, 0, 0, 0, 0, w, h);
+    bench_sync(c);
+
+    start = bench_now();
+    for (i = 0; i < ROUNDS; i++) {
+        switch (op) {
+        case SCROLL_UP:
+            xcb_copy_area(c, window, window, gc, 0, LINE, 0, 0, w, h - LINE);
+            break;
+        case SCROLL_DOWN:
+            xcb_copy_area(c, window, window, gc, 0, 0, 0, LINE, w, h - LINE);
+            break;
+        case MOVE_LEFT:
+            xcb_copy_area(c, window, window, gc, LINE, 0, 0, 0, w - LINE, h);
+            break;
+        case MOVE_RIGHT:
+            xcb_copy_area(c, window, window, gc, 0, 0, LINE, 0, w - LINE, h);
+            break;
+        case COPY_PIXMAP:
+            xcb_copy_area(c, pixmap, window, gc, 0, 0, 0, 0, w, h);
+            break;
+        case MOVE_WINDOW:
+            pos[0] = (i & 3) * LINE;
+            pos[1] = ((i >> 2) & 3) * LINE;
+            xcb_configure_window(c, window,
+                                 XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y,
+                                 pos);
+            break;
+        }
+    }
+    bench_sync(c);
+    seconds = bench_now() - start;
+    bytes = (long) w * h * (screen->root_depth > 16 ? 4 : 2);
+    bench_report(name, (long) w * h, ROUNDS, seconds);
+    printf("%-24s %.1f MB/s\n", "", (double) bytes * ROUNDS / seconds / 1e6);
+
+    xcb_free_gc(c, gc);
+    xcb_free_pixmap(c, pixmap);
+    xcb_destroy_window(c, window);
+    bench_sync(c);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+        run(c, screen, runs[i].name, runs[i].op);
+
+    return bench_finish(c);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * MIT-SHM frame throughput at 4K: a client writes each frame into a
+ * memfd passed with ShmAttachFd, then pushes it with ShmPutImage, or
+ * reads one back with ShmGetImage, the way a video player and a screen
+ * scraper do.  Each is run against an ordinary pixmap, which costs a
+ * copy per frame, and against a shm pixmap over the same memory, which
+ * should cost none.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <xcb/shm.h>
+#include "bench.h"
+
+#define WIDTH 3840
+#define HEIGHT 2160
+#define FRAMES 120
+
+typedef enum { SHM_PUT, SHM_GET } op_t;
+
+static void
+report(const char *name, long bytes, double seconds)
+{
+    bench_report(name, (long) WIDTH * HEIGHT, FRAMES, seconds);
+    printf("%-24s %.1f frames/s, %.1f MB/s\n", "", FRAMES / seconds,
+           bytes / seconds / 1e6);
+}
+
+static void
+run(xcb_connection_t *c, xcb_screen_t *screen, const char *name,
+    xcb_pixmap_t pixmap, xcb_gcontext_t gc, xcb_shm_seg_t seg,
+    uint8_t *frame, size_t size, op_t op)
+{
+    xcb_shm_get_image_reply_t *reply;
+    long bytes = 0;
+    double start;
+    int i;
+
+    start = bench_now();
+    for (i = 0; i < FRAMES; i++) {
+        switch (op) {
+        case SHM_PUT:
+            /* the decoder touches every line of the frame */
+            memset(frame, i, size);
+            xcb_shm_put_image(c, pixmap, gc, WIDTH, HEIGHT, 0, 0,
+                              WIDTH, HEIGHT, 0, 0, screen->root_depth,
+                              XCB_IMAGE_FORMAT_Z_PIXMAP, 0, seg, 0);
+            bench_sync(c);
+            bytes += size;
+            break;
+        case SHM_GET:
+            reply = xcb_shm_get_image_reply(c,
+                                            xcb_shm_get_image(c, pixmap, 0, 0,
+                                                              WIDTH, HEIGHT,
+                                                              ~0,
+                                                              XCB_IMAGE_FORMAT_Z_PIXMAP,
+                                                              seg, 0),
+                                            NULL);
+            if (reply) {
+                bytes += reply->size;
+                free(reply);
+            }
+            break;
+        }
+    }
+    report(name, bytes, bench_now() - start);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_shm_query_version_reply_t *version;
+    xcb_shm_seg_t seg;
+    xcb_pixmap_t plain, aliased;
+    xcb_gcontext_t gc;
+    size_t size = (size_t) WIDTH * HEIGHT * 4;
+    uint8_t *frame;
+    int fd;
+
+    version = xcb_shm_query_version_reply(c, xcb_shm_query_version(c), NULL);
+    if (!version || !version->shared_pixmaps ||
+        (version->major_version == 1 && version->minor_version < 2)) {
+        fprintf(stderr, "MIT-SHM 1.2 with shared pixmaps is not available\n");
+        free(version);
+        return bench_finish(c);
+    }
+    free(version);
+    if (screen->root_depth != 24) {
+        fprintf(stderr, "Needs a depth 24 screen\n");
+        return bench_finish(c);
+    }
+
+    fd = memfd_create("shm-bench", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, size) < 0) {
+        perror("memfd");
+        return bench_finish(c);
+    }
+    frame = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (frame == MAP_FAILED) {
+        perror("mmap");
+        return bench_finish(c);
+    }
+
+    seg = xcb_generate_id(c);
+    xcb_shm_attach_fd(c, seg, fd, 0);
+    plain = xcb_generate_id(c);
+    xcb_create_pixmap(c, screen->root_depth, plain, screen->root,
+                      WIDTH, HEIGHT);
+    aliased = xcb_generate_id(c);
+    xcb_shm_create_pixmap(c, aliased, screen->root, WIDTH, HEIGHT,
+                          screen->root_depth, seg, 0);
+    gc = xcb_generate_id(c);
+    xcb_create_gc(c, gc, plain, 0, NULL);
+    bench_sync(c);
+
+    run(c, screen, "ShmPutImage copy", plain, gc, seg, frame, size,
+        SHM_PUT);
+    run(c, screen, "ShmPutImage aliased", aliased, gc, seg, frame, size,
+        SHM_PUT);
+    run(c, screen, "ShmGetImage copy", plain, gc, seg, frame, size,
+        SHM_GET);
+    run(c, screen, "ShmGetImage aliased", aliased, gc, seg, frame, size,
+        SHM_GET);
+
+    xcb_free_gc(c, gc);
+    xcb_free_pixmap(c, aliased);
+    xcb_free_pixmap(c, plain);
+    xcb_shm_detach(c, seg);
+    munmap(frame, size);
+    return bench_finish(c);
+}
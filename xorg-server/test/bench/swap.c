@@ -0,0 +1,295 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file
+ *
+ * Indirect GLX frame rate, glxgears style: every frame clears the window,
+ * draws a ring of spinning triangles through GLX render requests and
+ * either swaps or, drawing to the front buffer, flushes.  Rendering
+ * happens in the server's swrast driver.  Unless the window is
+ * redirected, a swap hands the frame over with a PutImage and front
+ * buffer rendering reads the window back and writes it out again.  When
+ * it is, the driver copies the frame straight into the window's backing
+ * pixmap on a swap, or renders into it in the first place, and only
+ * reports the damage.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <xcb/glx.h>
+#include <xcb/composite.h>
+#include "bench.h"
+
+/* GLX render opcodes and GL tokens used below */
+#define X_GLrop_Begin 4
+#define X_GLrop_Color3fv 8
+#define X_GLrop_End 23
+#define X_GLrop_Vertex2fv 66
+#define X_GLrop_DrawBuffer 126
+#define X_GLrop_Clear 127
+#define X_GLrop_LoadIdentity 176
+#define X_GLrop_Rotatef 186
+#define GL_TRIANGLES 0x0004
+#define GL_FRONT 0x0404
+#define GL_COLOR_BUFFER_BIT 0x4000
+
+#define FRAMES 1000
+#define TEETH 20
+
+/* cos and sin of pi / TEETH, the step between ring points */
+#define STEP_COS 0.98768834f
+#define STEP_SIN 0.15643447f
+
+static const struct {
+    const char *name;
+    int width, height;
+    int redirect;
+    int front;                  /* draw to the front buffer, don't swap */
+} runs[] = {
+    { "swap 300x300", 300, 300, 0, 0 },
+    { "swap 300x300 redirected", 300, 300, 1, 0 },
+    { "swap 1024x768", 1024, 768, 0, 0 },
+    { "swap 1024x768 redirected", 1024, 768, 1, 0 },
+    { "front 300x300", 300, 300, 0, 1 },
+    { "front 300x300 redirected", 300, 300, 1, 1 },
+    { "front 1024x768", 1024, 768, 0, 1 },
+    { "front 1024x768 redirected", 1024, 768, 1, 1 },
+};
+
+static float ring[2 * TEETH + 1][2];
+
+/* A GLX render request under construction. */
+static uint8_t cmds[4096];
+static int ncmds;
+
+static void
+rop(int opcode, const void *data, int len)
+{
+    uint16_t header[2] = { 4 + len, opcode };
+
+    memcpy(cmds + ncmds, header, sizeof(header));
+    memcpy(cmds + ncmds + 4, data, len);
+    ncmds += 4 + len;
+}
+
+static void
+rop_floats(int opcode, float a, float b, float c, float d, int n)
+{
+    float v[4] = { a, b, c, d };
+
+    rop(opcode, v, n * sizeof(float));
+}
+
+static void
+rop_enum(int opcode, uint32_t value)
+{
+    rop(opcode, &value, sizeof(value));
+}
+
+static void
+init_ring(void)
+{
+    int i;
+
+    ring[0][0] = 0.9f;
+    ring[0][1] = 0;
+    for (i = 1; i <= 2 * TEETH; i++) {
+        ring[i][0] = ring[i - 1][0] * STEP_COS - ring[i - 1][1] * STEP_SIN;
+        ring[i][1] = ring[i - 1][0] * STEP_SIN + ring[i - 1][1] * STEP_COS;
+    }
+}
+
+static void
+frame(xcb_connection_t *c, xcb_glx_context_tag_t tag, int i)
+{
+    int t;
+
+    ncmds = 0;
+    rop_enum(X_GLrop_Clear, GL_COLOR_BUFFER_BIT);
+    rop(X_GLrop_LoadIdentity, NULL, 0);
+    rop_floats(X_GLrop_Rotatef, i * 2.0f, 0, 0, 1, 4);
+    rop_enum(X_GLrop_Begin, GL_TRIANGLES);
+    for (t = 0; t < TEETH; t++) {
+        rop_floats(X_GLrop_Color3fv, t & 1, 0.5f, (t & 2) >> 1, 0, 3);
+        rop_floats(X_GLrop_Vertex2fv, 0, 0, 0, 0, 2);
+        rop_floats(X_GLrop_Vertex2fv, ring[2 * t][0], ring[2 * t][1],
+                   0, 0, 2);
+        rop_floats(X_GLrop_Vertex2fv, ring[2 * t + 1][0], ring[2 * t + 1][1],
+                   0, 0, 2);
+    }
+    rop(X_GLrop_End, NULL, 0);
+    xcb_glx_render(c, tag, ncmds, cmds);
+}
+
+/* A double-buffered RGBA visual, from the core GLX visual configs. */
+static xcb_visualid_t
+find_visual(xcb_connection_t *c, xcb_screen_t *screen, int screen_num,
+            uint8_t *depth)
+{
+    xcb_glx_get_visual_configs_reply_t *reply;
+    xcb_depth_iterator_t d;
+    xcb_visualid_t visual = 0;
+    uint32_t *props;
+    unsigned i;
+
+    reply = xcb_glx_get_visual_configs_reply(c,
+                                             xcb_glx_get_visual_configs(c,
+                                                                        screen_num),
+                                             NULL);
+    if (!reply)
+        return 0;
+    props = xcb_glx_get_visual_configs_property_list(reply);
+    /* visual, class, rgba, r, g, b, a, 4 x accum, double buffer, ... */
+    for (i = 0; i < reply->num_visuals && !visual; i++) {
+        uint32_t *v = props + i * reply->num_properties;
+
+        if (v[2] && v[11])
+            visual = v[0];
+    }
+    free(reply);
+
+    for (d = xcb_screen_allowed_depths_iterator(screen); d.rem;
+         xcb_depth_next(&d)) {
+        xcb_visualtype_iterator_t v = xcb_depth_visuals_iterator(d.data);
+
+        for (; v.rem; xcb_visualtype_next(&v))
+            if (v.data->visual_id == visual)
+                *depth = d.data->depth;
+    }
+    return visual;
+}
+
+/* Show a frame: swap, or make sure front buffer drawing is done. */
+static void
+show(xcb_connection_t *c, xcb_glx_context_tag_t tag, xcb_window_t window,
+     int front)
+{
+    if (front)
+        xcb_glx_flush(c, tag);
+    else
+        xcb_glx_swap_buffers(c, tag, window);
+}
+
+static void
+run(xcb_connection_t *c, xcb_screen_t *screen, int screen_num,
+    xcb_visualid_t visual, uint8_t depth, const char *name, int w, int h,
+    int redirect, int front)
+{
+    xcb_window_t window = xcb_generate_id(c);
+    xcb_colormap_t colormap = xcb_generate_id(c);
+    xcb_glx_context_t context = xcb_generate_id(c);
+    xcb_glx_make_current_reply_t *current;
+    uint32_t values[] = { 0, colormap };
+    double start;
+    int i;
+
+    xcb_create_colormap(c, XCB_COLORMAP_ALLOC_NONE, colormap, screen->root,
+                        visual);
+    xcb_create_window(c, depth, window, screen->root, 0, 0, w, h, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, visual,
+                      XCB_CW_BORDER_PIXEL | XCB_CW_COLORMAP, values);
+    if (redirect)
+        xcb_composite_redirect_window(c, window,
+                                      XCB_COMPOSITE_REDIRECT_AUTOMATIC);
+    xcb_map_window(c, window);
+
+    xcb_glx_create_context(c, context, visual, screen_num, 0, 0);
+    current = xcb_glx_make_current_reply(c,
+                                         xcb_glx_make_current(c, window,
+                                                              context, 0),
+                                         NULL);
+    if (!current) {
+        fprintf(stderr, "%s: cannot make an indirect context current\n",
+                name);
+        goto out;
+    }
+
+    if (front) {
+        ncmds = 0;
+        rop_enum(X_GLrop_DrawBuffer, GL_FRONT);
+        xcb_glx_render(c, current->context_tag, ncmds, cmds);
+    }
+    frame(c, current->context_tag, 0);
+    show(c, current->context_tag, window, front);
+    bench_sync(c);
+
+    start = bench_now();
+    for (i = 1; i <= FRAMES; i++) {
+        frame(c, current->context_tag, i);
+        show(c, current->context_tag, window, front);
+    }
+    bench_sync(c);
+    bench_report(name, (long) w * h, FRAMES, bench_now() - start);
+
+    free(xcb_glx_make_current_reply(c,
+                                    xcb_glx_make_current(c, 0, 0,
+                                                         current->context_tag),
+                                    NULL));
+    free(current);
+ out:
+    xcb_glx_destroy_context(c, context);
+    xcb_destroy_window(c, window);
+    xcb_free_colormap(c, colormap);
+    bench_sync(c);
+}
+
+int
+main(int argc, char **argv)
+{
+    xcb_screen_t *screen;
+    xcb_connection_t *c = bench_connect(&screen);
+    xcb_glx_query_version_reply_t *glx;
+    xcb_composite_query_version_reply_t *composite;
+    xcb_visualid_t visual;
+    uint8_t depth = 0;
+    int i;
+
+    glx = xcb_glx_query_version_reply(c, xcb_glx_query_version(c, 1, 4),
+                                      NULL);
+    composite = xcb_composite_query_version_reply(c,
+                                                  xcb_composite_query_version(c,
+                                                                              0,
+                                                                              4),
+                                                  NULL);
+    if (!glx || !composite) {
+        fprintf(stderr, "GLX or Composite is not available\n");
+        free(glx);
+        free(composite);
+        return bench_finish(c);
+    }
+    free(glx);
+    free(composite);
+
+    visual = find_visual(c, screen, 0, &depth);
+    if (!visual || !depth) {
+        fprintf(stderr, "No double-buffered GLX visual\n");
+        return bench_finish(c);
+    }
+
+    init_ring();
+    for (i = 0; i < ARRAY_SIZE(runs); i++)
+        run(c, screen, 0, visual, depth, runs[i].name, runs[i].width,
+            runs[i].height, runs[i].redirect, runs[i].front);
+
+    return bench_finish(c);
+}
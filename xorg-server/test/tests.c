@@ -16,6 +16,7 @@ main(int argc, char **argv)
     run_test(touch_test);
     run_test(xfree86_test);
     run_test(xkb_test);
+    run_test(xkbcomp_test);
     run_test(xtest_test);
 
 #ifdef RES_TESTS
@@ -11,6 +11,7 @@ int string_test(void);
 int touch_test(void);
 int xfree86_test(void);
 int xkb_test(void);
+int xkbcomp_test(void);
 int xtest_test(void);
 
 int protocol_xchangedevicecontrol_test(void);
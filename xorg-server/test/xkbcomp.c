@@ -0,0 +1,251 @@
+/*
+ * Copyright © 2026 The XLaunch Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <xkb-config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/keysym.h>
+#include "misc.h"
+#include "inputstr.h"
+#define	XKBSRV_NEED_FILE_FUNCS
+#include <xkbsrv.h>
+#include <X11/extensions/XKMformat.h>
+#include "xkbfile.h"
+#include <assert.h>
+#ifdef HAVE_DLFCN_H
+#include <dlfcn.h>
+#endif
+
+#include "tests-common.h"
+
+/*
+ * The xkbcomp module as xkb/ddxLoad.c uses it: keymap text in, .xkm out.
+ * Without the module, or without the XKB data to compile, there is
+ * nothing to test.
+ */
+#if defined(RTLD_DEEPBIND) && defined(XKBCOMP_MODULE_DIRECTORY)
+
+typedef int (*xkbcomp_compile_proc)(const char *src, size_t len,
+                                    const char *root, int warning_level,
+                                    char **xkm_rtrn, size_t *xkm_len_rtrn);
+typedef void (*xkbcomp_free_proc)(void *data);
+
+static xkbcomp_compile_proc xkbcomp_compile;
+static xkbcomp_free_proc xkbcomp_free;
+
+static Bool
+load_xkbcomp(void)
+{
+    void *module;
+
+    module = dlopen(XKBCOMP_MODULE_DIRECTORY "/libxkbcomp.so",
+                    RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+    if (!module)
+        return FALSE;
+    xkbcomp_compile = (xkbcomp_compile_proc) dlsym(module, "xkbcomp_compile");
+    xkbcomp_free = (xkbcomp_free_proc) dlsym(module, "xkbcomp_free");
+    assert(xkbcomp_compile);
+    assert(xkbcomp_free);
+    return TRUE;
+}
+
+/* The keymap source the server would feed xkbcomp for an RMLVO set. */
+static char *
+keymap_source(const char *rules, XkbRF_VarDefsPtr mlvo, size_t *len)
+{
+    XkbComponentNamesRec kccgst = { 0 };
+    FILE *file;
+    char *src;
+    long size;
+
+    if (!XkbDDXNamesFromRules(NULL, rules, mlvo, &kccgst))
+        return NULL;
+
+    file = tmpfile();
+    assert(file);
+    assert(XkbWriteXKBKeymapForNames(file, &kccgst, NULL,
+                                     XkmAllIndicesMask, XkmKeymapRequired));
+    XkbFreeComponentNames(&kccgst, FALSE);
+
+    size = ftell(file);
+    assert(size > 0);
+    src = malloc(size);
+    assert(src);
+    rewind(file);
+    assert(fread(src, 1, size, file) == size);
+    fclose(file);
+    *len = size;
+    return src;
+}
+
+/* Read a compiled keymap back the way the server loads it. */
+static XkbDescPtr
+read_xkm(const char *xkm, size_t len)
+{
+    XkbDescPtr xkb = NULL;
+    FILE *file;
+    unsigned missing;
+
+    file = tmpfile();
+    assert(file);
+    assert(fwrite(xkm, 1, len, file) == len);
+    rewind(file);
+    missing = XkmReadFile(file, XkmKeymapRequired, XkmKeymapLegal, &xkb);
+    fclose(file);
+    assert(missing == 0);
+    assert(xkb);
+    return xkb;
+}
+
+static KeyCode
+find_key(XkbDescPtr xkb, const char *name)
+{
+    int kc;
+
+    for (kc = xkb->min_key_code; kc <= xkb->max_key_code; kc++) {
+        if (strncmp(xkb->names->keys[kc].name, name, XkbKeyNameLength) == 0)
+            return kc;
+    }
+    return 0;
+}
+
+/**
+ * Compile the us layout through xkbcomp_compile, twice, and read the
+ * result with XkmReadFile.
+ *
+ * Result: the keymap has key names, the required types and the us
+ * symbols, and the second compile, which must not see anything the
+ * first one left behind, gives the same .xkm.
+ */
+static void
+xkbcomp_compile_rmlvo_test(void)
+{
+    XkbRF_VarDefsRec mlvo = { 0 };
+    XkbDescPtr xkb;
+    char *src, *xkm, *xkm2;
+    size_t len, xkmLen, xkmLen2;
+    KeyCode ac01, tab;
+
+    mlvo.model = "pc105";
+    mlvo.layout = "us";
+    mlvo.variant = "";
+    mlvo.options = "";
+    src = keymap_source("evdev", &mlvo, &len);
+    if (!src)
+        return;
+
+    assert(xkbcomp_compile(src, len, XkbBaseDirectory, 0, &xkm, &xkmLen));
+    assert(xkm && xkmLen > 0);
+    assert(xkbcomp_compile(src, len, XkbBaseDirectory, 0, &xkm2, &xkmLen2));
+    assert(xkmLen2 == xkmLen && memcmp(xkm, xkm2, xkmLen) == 0);
+    xkbcomp_free(xkm2);
+    free(src);
+
+    xkb = read_xkm(xkm, xkmLen);
+    xkbcomp_free(xkm);
+
+    assert(xkb->min_key_code >= XkbMinLegalKeyCode);
+    assert(xkb->max_key_code >= xkb->min_key_code);
+    assert(xkb->names && xkb->names->keys);
+    assert(xkb->map && xkb->map->num_types >= XkbNumRequiredTypes);
+
+    ac01 = find_key(xkb, "AC01");
+    assert(ac01);
+    assert(XkbKeyNumSyms(xkb, ac01) >= 2);
+    assert(XkbKeySymsPtr(xkb, ac01)[0] == XK_a);
+    assert(XkbKeySymsPtr(xkb, ac01)[1] == XK_A);
+
+    tab = find_key(xkb, "TAB");
+    assert(tab);
+    assert(XkbKeySymsPtr(xkb, tab)[0] == XK_Tab);
+
+    XkbFreeKeyboard(xkb, XkbAllComponentsMask, TRUE);
+}
+
+/**
+ * Compile a keymap that includes a file that does not exist, and one
+ * that does not parse.
+ *
+ * Result: both fail, and a good keymap still compiles afterwards.
+ */
+static void
+xkbcomp_compile_error_test(void)
+{
+    static const char missing[] =
+        "xkb_keymap { xkb_keycodes { include \"no-such-file\" }; };\n";
+    static const char garbage[] = "xkb_keymap { xkb_keycodes {\n";
+    static const char good[] =
+        "xkb_keymap {\n"
+        "    xkb_keycodes { <ESC> = 9; };\n"
+        "    xkb_types { };\n"
+        "    xkb_compat { };\n"
+        "    xkb_symbols { key <ESC> { [ Escape ] }; };\n"
+        "};\n";
+    XkbDescPtr xkb;
+    char *xkm;
+    size_t xkmLen;
+
+    assert(!xkbcomp_compile(missing, strlen(missing), XkbBaseDirectory, 0,
+                            &xkm, &xkmLen));
+    assert(!xkm);
+    assert(!xkbcomp_compile(garbage, strlen(garbage), XkbBaseDirectory, 0,
+                            &xkm, &xkmLen));
+    assert(!xkm);
+
+    assert(xkbcomp_compile(good, strlen(good), XkbBaseDirectory, 0,
+                           &xkm, &xkmLen));
+    xkb = read_xkm(xkm, xkmLen);
+    xkbcomp_free(xkm);
+    assert(find_key(xkb, "ESC") == 9);
+    assert(XkbKeySymsPtr(xkb, 9)[0] == XK_Escape);
+    XkbFreeKeyboard(xkb, XkbAllComponentsMask, TRUE);
+}
+
+int
+xkbcomp_test(void)
+{
+    if (!load_xkbcomp())
+        return 0;
+
+    xkbcomp_compile_rmlvo_test();
+    xkbcomp_compile_error_test();
+
+    return 0;
+}
+
+#else
+
+int
+xkbcomp_test(void)
+{
+    return 0;
+}
+
+#endif
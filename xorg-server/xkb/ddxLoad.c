@@ -32,6 +32,9 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include <stdio.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <X11/X.h>
 #include <X11/Xos.h>
 #include <X11/Xproto.h>
@@ -44,6 +47,18 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <xkbsrv.h>
 #include <X11/extensions/XI.h>
 #include "xkb.h"
+#include "xhash.h"
+
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <utime.h>
+#ifdef HAVE_DLFCN_H
+#include <dlfcn.h>
+#endif
+#endif
 
 #define	PRE_ERROR_MSG "\"The XKEYBOARD keymap compiler (xkbcomp) reports:\""
 #define	ERROR_PREFIX	"\"> \""
@@ -56,8 +71,20 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define PATHSEPARATOR "/"
 #endif
 
+#define XKM_CACHE_PREFIX "xkbcache-"
+#define XKM_CACHE_MAX_ENTRIES 32
+#define XKM_CACHE_MAX_AGE (30L * 24 * 60 * 60)  /* seconds since last use */
+
+/* Where RunXkbComp left a compiled keymap. */
+typedef struct {
+    Bool keep;                  /* the .xkm is a cache entry, leave it */
+    char *xkm;                  /* compiled in process, the .xkm in memory */
+    size_t xkmLen;
+} XkbCompiledRec, *XkbCompiledPtr;
+
 static unsigned
-LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn);
+LoadXKM(unsigned want, unsigned need, const char *keymap,
+        XkbCompiledPtr compiled, XkbDescPtr *xkbRtrn);
 
 static void
 OutputDirectory(char *outdir, size_t size)
@@ -86,15 +113,597 @@ OutputDirectory(char *outdir, size_t size)
  */
 typedef void (*xkbcomp_buffer_callback)(FILE *out, void *userdata);
 
+/*
+ * Compiled keymaps are kept in the xkm output directory, named after a
+ * hash of a key: the text xkbcomp is fed plus everything else its
+ * output depends on.  The key itself is stored next to each entry in a
+ * .xkb file and compared on a hit, so a hash collision can only cost a
+ * compile.  Which data files xkbcomp reads depends on the includes it
+ * follows, so the key covers the size and modification time of every
+ * file in the component directories; editing, adding or removing any
+ * of them makes stale entries simply stop being found.  The directories
+ * are only walked once per server generation, data files changed while
+ * the server runs are picked up at the next reset.
+ *
+ * An entry's .xkm is touched whenever it is used.  After each new entry
+ * is stored, entries unused for XKM_CACHE_MAX_AGE are removed, and so
+ * are the least recently used ones beyond XKM_CACHE_MAX_ENTRIES.
+ */
+
+static void
+XkbCachePath(char *path, size_t size, const char *outdir, const char *name,
+             const char *ext)
+{
+    if (snprintf(path, size, "%s%s%s", outdir, name, ext) >= size)
+        path[0] = '\0';
+}
+
+/* Only trust entries nobody else could have planted or changed. */
+static Bool
+XkbCacheTrusted(FILE *file)
+{
+#ifndef WIN32
+    struct stat st;
+
+    return fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) &&
+        st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+#else
+    return TRUE;
+#endif
+}
+
+/* Fold one data file into stamp; xor keeps the result independent of
+ * the order directories are listed in. */
+static void
+XkbCacheStampFile(const char *path, long long size, long long mtime,
+                  unsigned char stamp[16], int *count)
+{
+    char line[PATH_MAX + 64];
+    unsigned char hash[16];
+    int i, n;
+
+    n = snprintf(line, sizeof(line), "%s %lld %lld", path, size, mtime);
+    if (n < 0 || n >= sizeof(line))
+        return;
+    x_hash128(line, n, 0, hash);
+    for (i = 0; i < sizeof(hash); i++)
+        stamp[i] ^= hash[i];
+    (*count)++;
+}
+
+static void
+XkbCacheStampDir(const char *dir, int depth, unsigned char stamp[16],
+                 int *count)
+{
+    char path[PATH_MAX];
+#ifndef WIN32
+    struct dirent *ent;
+    struct stat st;
+    DIR *d;
+
+    if (depth > 8 || !(d = opendir(dir)))
+        return;
+    while ((ent = readdir(d))) {
+        if (ent->d_name[0] == '.')
+            continue;
+        if (snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name) >=
+            sizeof(path) || stat(path, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            XkbCacheStampDir(path, depth + 1, stamp, count);
+        else
+            XkbCacheStampFile(path, (long long) st.st_size,
+                              (long long) st.st_mtime, stamp, count);
+    }
+    closedir(d);
+#else
+    WIN32_FIND_DATAA data;
+    HANDLE find;
+
+    if (depth > 8 ||
+        snprintf(path, sizeof(path), "%s\\*", dir) >= sizeof(path))
+        return;
+    find = FindFirstFileA(path, &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        if (data.cFileName[0] == '.')
+            continue;
+        if (snprintf(path, sizeof(path), "%s\\%s", dir, data.cFileName) >=
+            sizeof(path))
+            continue;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            XkbCacheStampDir(path, depth + 1, stamp, count);
+        else
+            XkbCacheStampFile(path,
+                              ((long long) data.nFileSizeHigh << 32) |
+                              data.nFileSizeLow,
+                              ((long long) data.ftLastWriteTime.
+                               dwHighDateTime << 32) |
+                              data.ftLastWriteTime.dwLowDateTime,
+                              stamp, count);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#endif
+}
+
+static char *
+XkbCacheKey(const char *input, size_t len, size_t *keyLen)
+{
+    static const char *const dirs[] = {
+        "keycodes", "types", "compat", "symbols", "geometry", "rules"
+    };
+    static unsigned long generation;
+    static char hex[2 * 16 + 1];
+    static int count;
+    unsigned char stamp[16] = { 0 };
+    char path[PATH_MAX];
+    char *key, *tmp;
+    int i, n;
+
+    if (generation != serverGeneration) {
+        count = 0;
+        for (i = 0; i < ARRAY_SIZE(dirs); i++) {
+            snprintf(path, sizeof(path), "%s" PATHSEPARATOR "%s",
+                     XkbBaseDirectory ? XkbBaseDirectory : "", dirs[i]);
+            XkbCacheStampDir(path, 0, stamp, &count);
+        }
+        for (i = 0; i < sizeof(stamp); i++)
+            sprintf(hex + 2 * i, "%02x", stamp[i]);
+        generation = serverGeneration;
+    }
+
+    n = asprintf(&key, "xkm %d dir %s bin %s files %d %s\n",
+                 XkmFileVersion, XkbBaseDirectory ? XkbBaseDirectory : "",
+                 XkbBinDirectory ? XkbBinDirectory : "", count, hex);
+    if (n < 0)
+        return NULL;
+    tmp = realloc(key, n + len);
+    if (!tmp) {
+        free(key);
+        return NULL;
+    }
+    key = tmp;
+    memcpy(key + n, input, len);
+    *keyLen = n + len;
+    return key;
+}
+
+/* Whether name.xkb holds exactly key and name.xkm is there to go with it. */
+static Bool
+XkbCacheLookup(const char *outdir, const char *name,
+               const char *key, size_t keyLen)
+{
+    char path[PATH_MAX], *stored;
+    FILE *file;
+    Bool hit = FALSE;
+
+    XkbCachePath(path, sizeof(path), outdir, name, ".xkb");
+    if (!path[0] || !(file = fopen(path, "rb")))
+        return FALSE;
+    stored = malloc(keyLen + 1);
+    if (stored && XkbCacheTrusted(file))
+        hit = fread(stored, 1, keyLen + 1, file) == keyLen &&
+            memcmp(stored, key, keyLen) == 0;
+    free(stored);
+    fclose(file);
+    if (!hit)
+        return FALSE;
+
+    XkbCachePath(path, sizeof(path), outdir, name, ".xkm");
+    if (!path[0] || !(file = fopen(path, "rb")))
+        return FALSE;
+    hit = XkbCacheTrusted(file);
+    fclose(file);
+    /* the modification time tells XkbCachePrune when it was last used */
+    if (hit)
+        (void) utime(path, NULL);
+    return hit;
+}
+
+/*
+ * Write data to outdir/name+ext.  It goes to a new file with a random
+ * name first, created exclusively and private to us, and is renamed into
+ * place once complete.  The output directory may be /tmp, where a fixed
+ * name could be a link planted by another user, and another server must
+ * never read half a file.
+ */
+static Bool
+XkbCacheWrite(const char *outdir, const char *name, const char *ext,
+              const void *data, size_t len)
+{
+    char tmp[PATH_MAX], path[PATH_MAX];
+    FILE *file;
+    Bool ok;
+    int fd;
+
+    XkbCachePath(path, sizeof(path), outdir, name, ext);
+    XkbCachePath(tmp, sizeof(tmp), outdir, "xkbtmp-", "XXXXXX");
+    if (!path[0] || !tmp[0])
+        return FALSE;
+#ifndef WIN32
+    fd = mkstemp(tmp);
+#else
+    fd = mktemp(tmp) ?
+        open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0600) : -1;
+#endif
+    if (fd < 0)
+        return FALSE;
+    file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+        (void) unlink(tmp);
+        return FALSE;
+    }
+    ok = fwrite(data, 1, len, file) == len;
+    if (fclose(file) != 0 || !ok) {
+        (void) unlink(tmp);
+        return FALSE;
+    }
+#ifdef WIN32
+    (void) unlink(path);
+#endif
+    if (rename(tmp, path) != 0) {
+        (void) unlink(tmp);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+typedef struct {
+    char name[sizeof(XKM_CACHE_PREFIX) + 32];
+    time_t used;
+} XkbCacheEntryRec, *XkbCacheEntryPtr;
+
+/* Most recently used first. */
+static int
+XkbCacheEntryCompare(const void *a, const void *b)
+{
+    time_t ua = ((const XkbCacheEntryRec *) a)->used;
+    time_t ub = ((const XkbCacheEntryRec *) b)->used;
+
+    return (ua < ub) ? 1 : (ua > ub) ? -1 : 0;
+}
+
+/* Add file to entries if it is the .xkm of a cache entry. */
+static void
+XkbCacheAddEntry(XkbCacheEntryPtr *entries, int *count, int *size,
+                 const char *file, time_t used)
+{
+    size_t len = sizeof(XKM_CACHE_PREFIX) - 1 + 32;
+    XkbCacheEntryPtr tmp;
+
+    if (strlen(file) != len + 4 ||
+        strncmp(file, XKM_CACHE_PREFIX, sizeof(XKM_CACHE_PREFIX) - 1) != 0 ||
+        strcmp(file + len, ".xkm") != 0)
+        return;
+    if (*count == *size) {
+        tmp = reallocarray(*entries, *size ? *size * 2 : 64, sizeof(**entries));
+        if (!tmp)
+            return;
+        *entries = tmp;
+        *size = *size ? *size * 2 : 64;
+    }
+    memcpy((*entries)[*count].name, file, len);
+    (*entries)[*count].name[len] = '\0';
+    (*entries)[*count].used = used;
+    (*count)++;
+}
+
+/*
+ * Remove the entries in outdir that have not been used for
+ * XKM_CACHE_MAX_AGE, and the least recently used ones beyond
+ * XKM_CACHE_MAX_ENTRIES.  Only our own files are considered, the output
+ * directory may be shared.
+ */
+static void
+XkbCachePrune(const char *outdir)
+{
+    XkbCacheEntryPtr entries = NULL;
+    char path[PATH_MAX];
+    time_t now = time(NULL);
+    int i, count = 0, size = 0;
+#ifndef WIN32
+    struct dirent *ent;
+    struct stat st;
+    DIR *d;
+
+    if (!(d = opendir(outdir)))
+        return;
+    while ((ent = readdir(d))) {
+        if (strncmp(ent->d_name, XKM_CACHE_PREFIX,
+                    sizeof(XKM_CACHE_PREFIX) - 1) != 0)
+            continue;
+        XkbCachePath(path, sizeof(path), outdir, ent->d_name, "");
+        if (path[0] && lstat(path, &st) == 0 && S_ISREG(st.st_mode) &&
+            st.st_uid == geteuid())
+            XkbCacheAddEntry(&entries, &count, &size, ent->d_name,
+                             st.st_mtime);
+    }
+    closedir(d);
+#else
+    WIN32_FIND_DATAA data;
+    ULARGE_INTEGER t;
+    HANDLE find;
+
+    XkbCachePath(path, sizeof(path), outdir, XKM_CACHE_PREFIX, "*.xkm");
+    if (!path[0])
+        return;
+    find = FindFirstFileA(path, &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        /* 100ns ticks since 1601 to seconds since 1970 */
+        t.LowPart = data.ftLastWriteTime.dwLowDateTime;
+        t.HighPart = data.ftLastWriteTime.dwHighDateTime;
+        XkbCacheAddEntry(&entries, &count, &size, data.cFileName,
+                         (time_t) ((t.QuadPart - 116444736000000000ULL) /
+                                   10000000));
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#endif
+
+    qsort(entries, count, sizeof(*entries), XkbCacheEntryCompare);
+    for (i = 0; i < count; i++) {
+        if (i < XKM_CACHE_MAX_ENTRIES &&
+            now - entries[i].used < XKM_CACHE_MAX_AGE)
+            continue;
+        DebugF("[xkb] removing cached keymap %s\n", entries[i].name);
+        XkbCachePath(path, sizeof(path), outdir, entries[i].name, ".xkm");
+        if (path[0])
+            (void) unlink(path);
+        XkbCachePath(path, sizeof(path), outdir, entries[i].name, ".xkb");
+        if (path[0])
+            (void) unlink(path);
+    }
+    free(entries);
+}
+
+/*
+ * Move a freshly compiled keymap into the cache under name.  The .xkm is
+ * renamed into place, so another server never reads half a file.
+ */
+static Bool
+XkbCacheStore(const char *outdir, const char *keymap, const char *name,
+              const char *key, size_t keyLen)
+{
+    char from[PATH_MAX], to[PATH_MAX];
+
+    /* an old entry under this name must not pair up with the new key */
+    XkbCachePath(to, sizeof(to), outdir, name, ".xkm");
+    if (!to[0])
+        return FALSE;
+    (void) unlink(to);
+
+    if (!XkbCacheWrite(outdir, name, ".xkb", key, keyLen))
+        return FALSE;
+
+    XkbCachePath(from, sizeof(from), outdir, keymap, ".xkm");
+    if (!from[0] || rename(from, to) != 0) {
+        XkbCachePath(to, sizeof(to), outdir, name, ".xkb");
+        (void) unlink(to);
+        return FALSE;
+    }
+    XkbCachePrune(outdir);
+    return TRUE;
+}
+
+#ifndef HAVE_OPEN_MEMSTREAM
+/* Read back everything the callback wrote to file. */
+static char *
+XkbReadInput(FILE *file, size_t *len)
+{
+    char *input = NULL, *tmp;
+    size_t size = 0, n;
+
+    *len = 0;
+    if (fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0)
+        return NULL;
+    do {
+        if (*len == size) {
+            size = size ? size * 2 : 4096;
+            tmp = realloc(input, size);
+            if (!tmp) {
+                free(input);
+                return NULL;
+            }
+            input = tmp;
+        }
+        n = fread(input + *len, 1, size - *len, file);
+        *len += n;
+    } while (n > 0);
+    if (ferror(file)) {
+        free(input);
+        return NULL;
+    }
+    return input;
+}
+#endif
+
+/*
+ * Collect what the callback writes, the text xkbcomp is to compile, in
+ * memory.  Without open_memstream it goes through a temporary file.
+ */
+static char *
+XkbCollectInput(xkbcomp_buffer_callback callback, void *userdata,
+                size_t *len)
+{
+    char *input = NULL;
+    FILE *file;
+#ifdef HAVE_OPEN_MEMSTREAM
+    file = open_memstream(&input, len);
+    if (!file)
+        return NULL;
+    (*callback)(file, userdata);
+    if (fclose(file) != 0) {
+        free(input);
+        return NULL;
+    }
+#else
+#ifdef WIN32
+    char tmpname[PATH_MAX];
+
+    snprintf(tmpname, sizeof(tmpname), "%s\\xkb_XXXXXX", Win32TempDir());
+    file = mktemp(tmpname) ? fopen(tmpname, "w+") : NULL;
+#else
+    file = tmpfile();
+#endif
+    if (!file)
+        return NULL;
+    (*callback)(file, userdata);
+    input = XkbReadInput(file, len);
+    fclose(file);
+#ifdef WIN32
+    unlink(tmpname);
+#endif
+#endif
+    return input;
+}
+
+/*
+ * xkbcomp is also built as a module, libxkbcomp, which compiles keymaps
+ * in process and saves starting a program for each one.  It is loaded
+ * on first use, on Windows from next to xkbcomp.exe and elsewhere from
+ * its own directory, XKBCOMP_MODULE_DIRECTORY; if it is missing or
+ * fails on a keymap, xkbcomp is run as before.  The module carries its
+ * own copies of the client-side XKB functions, which share names with
+ * the server's, so with dlopen it needs RTLD_DEEPBIND to bind to them.
+ * The interface must match xkbcomp/xkbcomplib.h.
+ */
+#if defined(WIN32) || \
+    (defined(RTLD_DEEPBIND) && defined(XKBCOMP_MODULE_DIRECTORY))
+#define XKBCOMP_MODULE 1
+#endif
+
+#ifdef XKBCOMP_MODULE
+
+#ifdef WIN32
+#define XKBCOMP_MODULE_NAME "libxkbcomp.dll"
+#else
+#define XKBCOMP_MODULE_NAME "libxkbcomp.so"
+#endif
+
+typedef int (*xkbcomp_compile_proc)(const char *src, size_t len,
+                                    const char *root, int warning_level,
+                                    char **xkm_rtrn, size_t *xkm_len_rtrn);
+typedef void (*xkbcomp_free_proc)(void *data);
+
+static xkbcomp_compile_proc xkbcompCompile;
+static xkbcomp_free_proc xkbcompFree;
+
+static Bool
+XkbLoadCompiler(void)
+{
+    static Bool tried;
+    char *path;
+    const char *sep = "";
+#ifdef WIN32
+    const char *dir = XkbBinDirectory ? XkbBinDirectory : "";
+    HMODULE module;
+#else
+    const char *dir = XKBCOMP_MODULE_DIRECTORY;
+    void *module;
+#endif
+
+    if (tried)
+        return xkbcompCompile != NULL;
+    tried = TRUE;
+
+    if (dir[0] && dir[strlen(dir) - 1] != PATHSEPARATOR[0])
+        sep = PATHSEPARATOR;
+    if (asprintf(&path, "%s%s%s", dir, sep, XKBCOMP_MODULE_NAME) == -1)
+        return FALSE;
+#ifdef WIN32
+    module = LoadLibrary(path);
+    if (module) {
+        xkbcompCompile =
+            (xkbcomp_compile_proc) GetProcAddress(module, "xkbcomp_compile");
+        xkbcompFree =
+            (xkbcomp_free_proc) GetProcAddress(module, "xkbcomp_free");
+    }
+#else
+    module = dlopen(path, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+    if (module) {
+        xkbcompCompile = (xkbcomp_compile_proc) dlsym(module,
+                                                      "xkbcomp_compile");
+        xkbcompFree = (xkbcomp_free_proc) dlsym(module, "xkbcomp_free");
+    }
+#endif
+    if (!module)
+        DebugF("[xkb] %s not loaded, running xkbcomp\n", path);
+    else if (!xkbcompCompile || !xkbcompFree) {
+        LogMessage(X_WARNING, "XKB: %s is not an xkbcomp module\n", path);
+        xkbcompCompile = NULL;
+    }
+    free(path);
+    return xkbcompCompile != NULL;
+}
+
+/* Compile input to a .xkm in memory, if the module is there. */
+static Bool
+XkbCompileInProcess(const char *input, size_t len, XkbCompiledPtr compiled)
+{
+    char *xkm;
+    size_t xkmLen;
+
+    if (!XkbLoadCompiler())
+        return FALSE;
+    if (!(*xkbcompCompile) (input, len, XkbBaseDirectory,
+                            ((xkbDebugFlags < 2) ? 1 :
+                             ((xkbDebugFlags > 10) ? 10 :
+                              (int) xkbDebugFlags)), &xkm, &xkmLen))
+        return FALSE;
+    /* the module may not share our heap */
+    compiled->xkm = malloc(xkmLen);
+    if (compiled->xkm) {
+        memcpy(compiled->xkm, xkm, xkmLen);
+        compiled->xkmLen = xkmLen;
+    }
+    (*xkbcompFree) (xkm);
+    return compiled->xkm != NULL;
+}
+
+#else
+
+static Bool
+XkbCompileInProcess(const char *input, size_t len, XkbCompiledPtr compiled)
+{
+    return FALSE;
+}
+
+#endif /* XKBCOMP_MODULE */
+
+/* Write a keymap compiled in memory where xkbcomp would have put it. */
+static Bool
+XkbWriteCompiled(const char *outdir, const char *keymap,
+                 XkbCompiledPtr compiled)
+{
+    return XkbCacheWrite(outdir, keymap, ".xkm", compiled->xkm,
+                         compiled->xkmLen);
+}
+
 /**
- * Start xkbcomp, let the callback write into xkbcomp's stdin. When done,
- * return a strdup'd copy of the file name we've written to.
+ * Compile what the callback writes, in process or by starting xkbcomp and
+ * feeding it to xkbcomp's stdin.  When done, return a strdup'd copy of
+ * the file name we've written to.  If the same
+ * keymap has been compiled before, return the cached copy without
+ * running xkbcomp at all.  compiled->keep is set if the file is a cache
+ * entry, which must not be removed after loading.  If the keymap was
+ * compiled in process, compiled->xkm holds it as well.
  */
 static char *
-RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
+RunXkbComp(xkbcomp_buffer_callback callback, void *userdata,
+           XkbCompiledPtr compiled)
 {
     FILE *out;
     char *buf = NULL, keymap[PATH_MAX], xkm_output_dir[PATH_MAX];
+    char cachename[sizeof(XKM_CACHE_PREFIX) + 32];
+    char *input = NULL, *key = NULL;
+    size_t inputLen = 0, keyLen = 0;
+    unsigned char hash[16];
+    int i;
 
     const char *emptystring = "";
     char *xkbbasedirflag = NULL;
@@ -110,6 +719,9 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     const char *xkmfile = "-";
 #endif
 
+    compiled->keep = FALSE;
+    compiled->xkm = NULL;
+    compiled->xkmLen = 0;
     snprintf(keymap, sizeof(keymap), "server-%s", display);
 
     OutputDirectory(xkm_output_dir, sizeof(xkm_output_dir));
@@ -120,6 +732,49 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     (void) mktemp(tmpname);
 #endif
 
+    /* Collect what xkbcomp would be given first, the cache is keyed on it */
+    input = XkbCollectInput(callback, userdata, &inputLen);
+    if (input == NULL) {
+        LogMessage(X_ERROR, "XKB: Could not collect the keymap to compile\n");
+        return NULL;
+    }
+    key = XkbCacheKey(input, inputLen, &keyLen);
+
+    cachename[0] = '\0';
+    if (key) {
+        x_hash128(key, keyLen, 0, hash);
+        strcpy(cachename, XKM_CACHE_PREFIX);
+        for (i = 0; i < sizeof(hash); i++)
+            sprintf(cachename + strlen(XKM_CACHE_PREFIX) + 2 * i, "%02x",
+                    hash[i]);
+        if (XkbCacheLookup(xkm_output_dir, cachename, key, keyLen)) {
+            DebugF("[xkb] using cached keymap %s\n", cachename);
+            free(input);
+            free(key);
+            compiled->keep = TRUE;
+            return xnfstrdup(cachename);
+        }
+    }
+
+    if (XkbCompileInProcess(input, inputLen, compiled)) {
+        char path[PATH_MAX];
+
+        DebugF("[xkb] compiled keymap %s in process\n", keymap);
+        free(input);
+        if (key && XkbWriteCompiled(xkm_output_dir, keymap, compiled) &&
+            XkbCacheStore(xkm_output_dir, keymap, cachename, key, keyLen)) {
+            free(key);
+            compiled->keep = TRUE;
+            return xnfstrdup(cachename);
+        }
+        free(key);
+        /* not cached, and nothing to remove once it is loaded */
+        XkbCachePath(path, sizeof(path), xkm_output_dir, keymap, ".xkm");
+        if (path[0])
+            (void) unlink(path);
+        return xnfstrdup(keymap);
+    }
+
     if (XkbBaseDirectory != NULL) {
         if (asprintf(&xkbbasedirflag, "\"-R%s\"", XkbBaseDirectory) == -1)
             xkbbasedirflag = NULL;
@@ -152,6 +807,8 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
     if (!buf) {
         LogMessage(X_ERROR,
                    "XKB: Could not invoke xkbcomp: not enough memory\n");
+        free(input);
+        free(key);
         return NULL;
     }
 
@@ -162,8 +819,8 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 #endif
 
     if (out != NULL) {
-        /* Now write to xkbcomp */
-        (*callback)(out, userdata);
+        /* Now hand the keymap to xkbcomp */
+        fwrite(input, 1, inputLen, out);
 
 #ifndef WIN32
         if (Pclose(out) == 0)
@@ -174,9 +831,17 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
             if (xkbDebugFlags)
                 DebugF("[xkb] xkb executes: %s\n", buf);
             free(buf);
+            free(input);
 #ifdef WIN32
             unlink(tmpname);
 #endif
+            if (key && XkbCacheStore(xkm_output_dir, keymap, cachename,
+                                     key, keyLen)) {
+                free(key);
+                compiled->keep = TRUE;
+                return xnfstrdup(cachename);
+            }
+            free(key);
             return xnfstrdup(keymap);
         }
         else {
@@ -196,6 +861,8 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 #endif
     }
     free(buf);
+    free(input);
+    free(key);
     return NULL;
 }
 
@@ -223,7 +890,8 @@ static Bool
 XkbDDXCompileKeymapByNames(XkbDescPtr xkb,
                            XkbComponentNamesPtr names,
                            unsigned want,
-                           unsigned need, char *nameRtrn, int nameRtrnLen)
+                           unsigned need, char *nameRtrn, int nameRtrnLen,
+                           XkbCompiledPtr compiled)
 {
     char *keymap;
     Bool rc = FALSE;
@@ -234,7 +902,7 @@ XkbDDXCompileKeymapByNames(XkbDescPtr xkb,
         .need = need
     };
 
-    keymap = RunXkbComp(xkb_write_keymap_for_names_cb, &ctx);
+    keymap = RunXkbComp(xkb_write_keymap_for_names_cb, &ctx, compiled);
 
     if (keymap) {
         if(nameRtrn)
@@ -269,6 +937,7 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
 {
     unsigned int have;
     char *map_name;
+    XkbCompiledRec compiled;
     XkbKeymapString map = {
         .keymap = keymap,
         .len = keymap_length
@@ -276,13 +945,13 @@ XkbDDXLoadKeymapFromString(DeviceIntPtr keybd,
 
     *xkbRtrn = NULL;
 
-    map_name = RunXkbComp(xkb_write_keymap_string_cb, &map);
+    map_name = RunXkbComp(xkb_write_keymap_string_cb, &map, &compiled);
     if (!map_name) {
         LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
         return 0;
     }
 
-    have = LoadXKM(want, need, map_name, xkbRtrn);
+    have = LoadXKM(want, need, map_name, &compiled, xkbRtrn);
     free(map_name);
 
     return have;
@@ -324,13 +993,32 @@ XkbDDXOpenConfigFile(const char *mapName, char *fileNameRtrn, int fileNameRtrnLe
     return file;
 }
 
+/*
+ * Load a compiled keymap, and remove it unless it is to be kept.  One
+ * compiled in process is read from memory instead.
+ */
 static unsigned
-LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
+LoadXKM(unsigned want, unsigned need, const char *keymap,
+        XkbCompiledPtr compiled, XkbDescPtr *xkbRtrn)
 {
     FILE *file;
     char fileName[PATH_MAX];
     unsigned missing;
 
+    if (compiled->xkm) {
+        missing = XkmReadBuffer(compiled->xkm, compiled->xkmLen,
+                                need, want, xkbRtrn);
+        free(compiled->xkm);
+        compiled->xkm = NULL;
+        if (*xkbRtrn == NULL) {
+            LogMessage(X_ERROR, "Error loading keymap %s\n", keymap);
+            return 0;
+        }
+        DebugF("Loaded XKB keymap %s, defined=0x%x\n", keymap,
+               (*xkbRtrn)->defined);
+        return (need | want) & (~missing);
+    }
+
     file = XkbDDXOpenConfigFile(keymap, fileName, PATH_MAX);
     if (file == NULL) {
         LogMessage(X_ERROR, "Couldn't open compiled keymap file %s\n",
@@ -349,7 +1037,8 @@ LoadXKM(unsigned want, unsigned need, const char *keymap, XkbDescPtr *xkbRtrn)
                (*xkbRtrn)->defined);
     }
     fclose(file);
-    (void) unlink(fileName);
+    if (!compiled->keep)
+        (void) unlink(fileName);
     return (need | want) & (~missing);
 }
 
@@ -361,6 +1050,7 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
                         XkbDescPtr *xkbRtrn, char *nameRtrn, int nameRtrnLen)
 {
     XkbDescPtr xkb;
+    XkbCompiledRec compiled;
 
     *xkbRtrn = NULL;
     if ((keybd == NULL) || (keybd->key == NULL) ||
@@ -376,12 +1066,12 @@ XkbDDXLoadKeymapByNames(DeviceIntPtr keybd,
         return 0;
     }
     else if (!XkbDDXCompileKeymapByNames(xkb, names, want, need,
-                                         nameRtrn, nameRtrnLen)) {
+                                         nameRtrn, nameRtrnLen, &compiled)) {
         LogMessage(X_ERROR, "XKB: Couldn't compile keymap\n");
         return 0;
     }
 
-    return LoadXKM(want, need, nameRtrn, xkbRtrn);
+    return LoadXKM(want, need, nameRtrn, &compiled, xkbRtrn);
 }
 
 Bool
@@ -29,6 +29,7 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #include <X11/Xos.h>
 #include <X11/Xfuncs.h>
@@ -80,51 +81,95 @@ XkmInsureSize(void *oldPtr, int oldCount, int *newCountRtrn, int elemSize)
 
 #define	XkmInsureTypedSize(p,o,n,t) ((p)=((t *)XkmInsureSize((char *)(p),(o),(n),sizeof(t))))
 
+/*
+ * Compiled keymaps are read either from a file or straight from memory;
+ * the readers below see both through an XkmInput.
+ */
+typedef struct _XkmInput {
+    FILE *file;
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+} XkmInput, *XkmInputPtr;
+
+static int
+XkmGetc(XkmInputPtr in)
+{
+    if (in->file)
+        return getc(in->file);
+    if (in->pos >= in->size)
+        return EOF;
+    return in->data[in->pos++];
+}
+
+static size_t
+XkmRead(void *ptr, size_t size, size_t count, XkmInputPtr in)
+{
+    if (in->file)
+        return fread(ptr, size, count, in->file);
+    if (count > (in->size - in->pos) / size)
+        count = (in->size - in->pos) / size;
+    memcpy(ptr, in->data + in->pos, size * count);
+    in->pos += size * count;
+    return count;
+}
+
+static int
+XkmSeek(XkmInputPtr in, unsigned offset)
+{
+    if (in->file)
+        return fseek(in->file, offset, SEEK_SET);
+    if (offset > in->size)
+        return -1;
+    in->pos = offset;
+    return 0;
+}
+
 static CARD8
-XkmGetCARD8(FILE * file, int *pNRead)
+XkmGetCARD8(XkmInputPtr file, int *pNRead)
 {
     int tmp;
 
-    tmp = getc(file);
+    tmp = XkmGetc(file);
     if (pNRead && (tmp != EOF))
         (*pNRead) += 1;
     return tmp;
 }
 
 static CARD16
-XkmGetCARD16(FILE * file, int *pNRead)
+XkmGetCARD16(XkmInputPtr file, int *pNRead)
 {
     CARD16 val;
 
-    if ((fread(&val, 2, 1, file) == 1) && (pNRead))
+    if ((XkmRead(&val, 2, 1, file) == 1) && (pNRead))
         (*pNRead) += 2;
     return val;
 }
 
 static CARD32
-XkmGetCARD32(FILE * file, int *pNRead)
+XkmGetCARD32(XkmInputPtr file, int *pNRead)
 {
     CARD32 val;
 
-    if ((fread(&val, 4, 1, file) == 1) && (pNRead))
+    if ((XkmRead(&val, 4, 1, file) == 1) && (pNRead))
         (*pNRead) += 4;
     return val;
 }
 
 static int
-XkmSkipPadding(FILE * file, unsigned pad)
+XkmSkipPadding(XkmInputPtr file, unsigned pad)
 {
     register int i, nRead = 0;
 
     for (i = 0; i < pad; i++) {
-        if (getc(file) != EOF)
+        if (XkmGetc(file) != EOF)
             nRead++;
     }
     return nRead;
 }
 
 static int
-XkmGetCountedString(FILE * file, char *str, int max_len)
+XkmGetCountedString(XkmInputPtr file, char *str, int max_len)
 {
     int count, nRead = 0;
 
@@ -133,16 +178,16 @@ XkmGetCountedString(FILE * file, char *str, int max_len)
         int tmp;
 
         if (count > max_len) {
-            tmp = fread(str, 1, max_len, file);
+            tmp = XkmRead(str, 1, max_len, file);
             while (tmp < count) {
-                if ((getc(file)) != EOF)
+                if ((XkmGetc(file)) != EOF)
                     tmp++;
                 else
                     break;
             }
         }
         else {
-            tmp = fread(str, 1, count, file);
+            tmp = XkmRead(str, 1, count, file);
         }
         nRead += tmp;
     }
@@ -159,7 +204,7 @@ XkmGetCountedString(FILE * file, char *str, int max_len)
 /***====================================================================***/
 
 static int
-ReadXkmVirtualMods(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
+ReadXkmVirtualMods(XkmInputPtr file, XkbDescPtr xkb, XkbChangesPtr changes)
 {
     register unsigned int i, bit;
     unsigned int bound, named, tmp;
@@ -202,7 +247,7 @@ ReadXkmVirtualMods(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
 /***====================================================================***/
 
 static int
-ReadXkmKeycodes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
+ReadXkmKeycodes(XkmInputPtr file, XkbDescPtr xkb, XkbChangesPtr changes)
 {
     register int i;
     unsigned minKC, maxKC, nAl;
@@ -239,7 +284,7 @@ ReadXkmKeycodes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
     }
 
     for (pN = &xkb->names->keys[minKC], i = minKC; i <= (int) maxKC; i++, pN++) {
-        if (fread(pN, 1, XkbKeyNameLength, file) != XkbKeyNameLength) {
+        if (XkmRead(pN, 1, XkbKeyNameLength, file) != XkbKeyNameLength) {
             _XkbLibError(_XkbErrBadLength, "ReadXkmKeycodes", 0);
             return -1;
         }
@@ -251,7 +296,7 @@ ReadXkmKeycodes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
         for (pAl = xkb->names->key_aliases, i = 0; i < nAl; i++, pAl++) {
             int tmp;
 
-            tmp = fread(pAl, 1, 2 * XkbKeyNameLength, file);
+            tmp = XkmRead(pAl, 1, 2 * XkbKeyNameLength, file);
             if (tmp != 2 * XkbKeyNameLength) {
                 _XkbLibError(_XkbErrBadLength, "ReadXkmKeycodes", 0);
                 return -1;
@@ -269,7 +314,7 @@ ReadXkmKeycodes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
 /***====================================================================***/
 
 static int
-ReadXkmKeyTypes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
+ReadXkmKeyTypes(XkmInputPtr file, XkbDescPtr xkb, XkbChangesPtr changes)
 {
     register unsigned i, n;
     unsigned num_types;
@@ -308,7 +353,7 @@ ReadXkmKeyTypes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
     }
     type = xkb->map->types;
     for (i = 0; i < num_types; i++, type++) {
-        if ((int) fread(&wire, SIZEOF(xkmKeyTypeDesc), 1, file) < 1) {
+        if ((int) XkmRead(&wire, SIZEOF(xkmKeyTypeDesc), 1, file) < 1) {
             _XkbLibError(_XkbErrBadLength, "ReadXkmKeyTypes", 0);
             return -1;
         }
@@ -326,7 +371,7 @@ ReadXkmKeyTypes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
             return -1;
         }
         for (n = 0, entry = type->map; n < wire.nMapEntries; n++, entry++) {
-            if (fread(&wire_entry, SIZEOF(xkmKTMapEntryDesc), 1, file) <
+            if (XkmRead(&wire_entry, SIZEOF(xkmKTMapEntryDesc), 1, file) <
                 (int) 1) {
                 _XkbLibError(_XkbErrBadLength, "ReadXkmKeyTypes", 0);
                 return -1;
@@ -363,7 +408,7 @@ ReadXkmKeyTypes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
                 return -1;
             }
             for (n = 0, pre = type->preserve; n < wire.nMapEntries; n++, pre++) {
-                if (fread(&p_entry, SIZEOF(xkmModsDesc), 1, file) < 1) {
+                if (XkmRead(&p_entry, SIZEOF(xkmModsDesc), 1, file) < 1) {
                     _XkbLibError(_XkbErrBadLength, "ReadXkmKeycodes", 0);
                     return -1;
                 }
@@ -411,7 +456,7 @@ ReadXkmKeyTypes(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
 /***====================================================================***/
 
 static int
-ReadXkmCompatMap(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
+ReadXkmCompatMap(XkmInputPtr file, XkbDescPtr xkb, XkbChangesPtr changes)
 {
     register int i;
     unsigned num_si, groups;
@@ -444,7 +489,7 @@ ReadXkmCompatMap(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
     compat->num_si = 0;
     interp = compat->sym_interpret;
     for (i = 0; i < num_si; i++) {
-        tmp = fread(&wire, SIZEOF(xkmSymInterpretDesc), 1, file);
+        tmp = XkmRead(&wire, SIZEOF(xkmSymInterpretDesc), 1, file);
         nRead += tmp * SIZEOF(xkmSymInterpretDesc);
         interp->sym = wire.sym;
         interp->mods = wire.mods;
@@ -584,7 +629,7 @@ ReadXkmCompatMap(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
             xkmModsDesc md;
 
             if (groups & bit) {
-                tmp = fread(&md, SIZEOF(xkmModsDesc), 1, file);
+                tmp = XkmRead(&md, SIZEOF(xkmModsDesc), 1, file);
                 nRead += tmp * SIZEOF(xkmModsDesc);
                 xkb->compat->groups[i].real_mods = md.realMods;
                 xkb->compat->groups[i].vmods = md.virtualMods;
@@ -605,7 +650,7 @@ ReadXkmCompatMap(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
 }
 
 static int
-ReadXkmIndicators(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
+ReadXkmIndicators(XkmInputPtr file, XkbDescPtr xkb, XkbChangesPtr changes)
 {
     register unsigned nLEDs;
     xkmIndicatorMapDesc wire;
@@ -637,7 +682,7 @@ ReadXkmIndicators(FILE * file, XkbDescPtr xkb, XkbChangesPtr changes)
             name = XkbInternAtom(buf, FALSE);
         else
             name = None;
-        if ((tmp = fread(&wire, SIZEOF(xkmIndicatorMapDesc), 1, file)) < 1) {
+        if ((tmp = XkmRead(&wire, SIZEOF(xkmIndicatorMapDesc), 1, file)) < 1) {
             _XkbLibError(_XkbErrBadLength, "ReadXkmIndicators", 0);
             return -1;
         }
@@ -689,7 +734,7 @@ FindTypeForKey(XkbDescPtr xkb, Atom name, unsigned width, KeySym * syms)
 }
 
 static int
-ReadXkmSymbols(FILE * file, XkbDescPtr xkb)
+ReadXkmSymbols(XkmInputPtr file, XkbDescPtr xkb)
 {
     register int i, g, s, totalVModMaps;
     xkmKeySymMapDesc wireMap;
@@ -764,7 +809,7 @@ ReadXkmSymbols(FILE * file, XkbDescPtr xkb)
         Atom typeName[XkbNumKbdGroups];
         XkbKeyTypePtr type[XkbNumKbdGroups];
 
-        if ((tmp = fread(&wireMap, SIZEOF(xkmKeySymMapDesc), 1, file)) < 1) {
+        if ((tmp = XkmRead(&wireMap, SIZEOF(xkmKeySymMapDesc), 1, file)) < 1) {
             _XkbLibError(_XkbErrBadLength, "ReadXkmSymbols", 0);
             return -1;
         }
@@ -814,7 +859,7 @@ ReadXkmSymbols(FILE * file, XkbDescPtr xkb)
 
                 act = XkbResizeKeyActions(xkb, i, nSyms);
                 for (s = 0; s < nSyms; s++, act++) {
-                    tmp = fread(act, SIZEOF(xkmActionDesc), 1, file);
+                    tmp = XkmRead(act, SIZEOF(xkmActionDesc), 1, file);
                     nRead += tmp * SIZEOF(xkmActionDesc);
                 }
                 xkb->server->explicit[i] |= XkbExplicitInterpretMask;
@@ -836,7 +881,7 @@ ReadXkmSymbols(FILE * file, XkbDescPtr xkb)
         if (wireMap.flags & XkmKeyHasBehavior) {
             xkmBehaviorDesc b;
 
-            tmp = fread(&b, SIZEOF(xkmBehaviorDesc), 1, file);
+            tmp = XkmRead(&b, SIZEOF(xkmBehaviorDesc), 1, file);
             nRead += tmp * SIZEOF(xkmBehaviorDesc);
             xkb->server->behaviors[i].type = b.type;
             xkb->server->behaviors[i].data = b.data;
@@ -847,7 +892,7 @@ ReadXkmSymbols(FILE * file, XkbDescPtr xkb)
         xkmVModMapDesc v;
 
         for (i = 0; i < totalVModMaps; i++) {
-            tmp = fread(&v, SIZEOF(xkmVModMapDesc), 1, file);
+            tmp = XkmRead(&v, SIZEOF(xkmVModMapDesc), 1, file);
             nRead += tmp * SIZEOF(xkmVModMapDesc);
             if (tmp > 0)
                 xkb->server->vmodmap[v.key] = v.vmods;
@@ -857,7 +902,7 @@ ReadXkmSymbols(FILE * file, XkbDescPtr xkb)
 }
 
 static int
-ReadXkmGeomDoodad(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
+ReadXkmGeomDoodad(XkmInputPtr file, XkbGeometryPtr geom, XkbSectionPtr section)
 {
     XkbDoodadPtr doodad;
     xkmDoodadDesc doodadWire;
@@ -866,7 +911,7 @@ ReadXkmGeomDoodad(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
     int nRead = 0;
 
     nRead += XkmGetCountedString(file, buf, 100);
-    tmp = fread(&doodadWire, SIZEOF(xkmDoodadDesc), 1, file);
+    tmp = XkmRead(&doodadWire, SIZEOF(xkmDoodadDesc), 1, file);
     nRead += SIZEOF(xkmDoodadDesc) * tmp;
     doodad = XkbAddGeomDoodad(geom, section, XkbInternAtom(buf, FALSE));
     if (!doodad)
@@ -912,7 +957,7 @@ ReadXkmGeomDoodad(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
 }
 
 static int
-ReadXkmGeomOverlay(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
+ReadXkmGeomOverlay(XkmInputPtr file, XkbGeometryPtr geom, XkbSectionPtr section)
 {
     char buf[100];
     unsigned tmp;
@@ -924,7 +969,7 @@ ReadXkmGeomOverlay(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
     register int r;
 
     nRead += XkmGetCountedString(file, buf, 100);
-    tmp = fread(&olWire, SIZEOF(xkmOverlayDesc), 1, file);
+    tmp = XkmRead(&olWire, SIZEOF(xkmOverlayDesc), 1, file);
     nRead += tmp * SIZEOF(xkmOverlayDesc);
     ol = XkbAddGeomOverlay(section, XkbInternAtom(buf, FALSE), olWire.num_rows);
     if (!ol)
@@ -933,7 +978,7 @@ ReadXkmGeomOverlay(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
         int k;
         xkmOverlayKeyDesc keyWire;
 
-        tmp = fread(&rowWire, SIZEOF(xkmOverlayRowDesc), 1, file);
+        tmp = XkmRead(&rowWire, SIZEOF(xkmOverlayRowDesc), 1, file);
         nRead += tmp * SIZEOF(xkmOverlayRowDesc);
         row = XkbAddGeomOverlayRow(ol, rowWire.row_under, rowWire.num_keys);
         if (!row) {
@@ -941,7 +986,7 @@ ReadXkmGeomOverlay(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
             return nRead;
         }
         for (k = 0; k < rowWire.num_keys; k++) {
-            tmp = fread(&keyWire, SIZEOF(xkmOverlayKeyDesc), 1, file);
+            tmp = XkmRead(&keyWire, SIZEOF(xkmOverlayKeyDesc), 1, file);
             nRead += tmp * SIZEOF(xkmOverlayKeyDesc);
             memcpy(row->keys[k].over.name, keyWire.over, XkbKeyNameLength);
             memcpy(row->keys[k].under.name, keyWire.under, XkbKeyNameLength);
@@ -952,7 +997,7 @@ ReadXkmGeomOverlay(FILE * file, XkbGeometryPtr geom, XkbSectionPtr section)
 }
 
 static int
-ReadXkmGeomSection(FILE * file, XkbGeometryPtr geom)
+ReadXkmGeomSection(XkmInputPtr file, XkbGeometryPtr geom)
 {
     register int i;
     XkbSectionPtr section;
@@ -964,7 +1009,7 @@ ReadXkmGeomSection(FILE * file, XkbGeometryPtr geom)
 
     nRead += XkmGetCountedString(file, buf, 100);
     nameAtom = XkbInternAtom(buf, FALSE);
-    tmp = fread(&sectionWire, SIZEOF(xkmSectionDesc), 1, file);
+    tmp = XkmRead(&sectionWire, SIZEOF(xkmSectionDesc), 1, file);
     nRead += SIZEOF(xkmSectionDesc) * tmp;
     section = XkbAddGeomSection(geom, nameAtom, sectionWire.num_rows,
                                 sectionWire.num_doodads,
@@ -987,7 +1032,7 @@ ReadXkmGeomSection(FILE * file, XkbGeometryPtr geom)
         xkmKeyDesc keyWire;
 
         for (i = 0; i < sectionWire.num_rows; i++) {
-            tmp = fread(&rowWire, SIZEOF(xkmRowDesc), 1, file);
+            tmp = XkmRead(&rowWire, SIZEOF(xkmRowDesc), 1, file);
             nRead += SIZEOF(xkmRowDesc) * tmp;
             row = XkbAddGeomRow(section, rowWire.num_keys);
             if (!row) {
@@ -998,7 +1043,7 @@ ReadXkmGeomSection(FILE * file, XkbGeometryPtr geom)
             row->left = rowWire.left;
             row->vertical = rowWire.vertical;
             for (k = 0; k < rowWire.num_keys; k++) {
-                tmp = fread(&keyWire, SIZEOF(xkmKeyDesc), 1, file);
+                tmp = XkmRead(&keyWire, SIZEOF(xkmKeyDesc), 1, file);
                 nRead += SIZEOF(xkmKeyDesc) * tmp;
                 key = XkbAddGeomKey(row);
                 if (!key) {
@@ -1032,7 +1077,7 @@ ReadXkmGeomSection(FILE * file, XkbGeometryPtr geom)
 }
 
 static int
-ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
+ReadXkmGeometry(XkmInputPtr file, XkbDescPtr xkb)
 {
     register int i;
     char buf[100];
@@ -1043,7 +1088,7 @@ ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
     XkbGeometrySizesRec sizes;
 
     nRead += XkmGetCountedString(file, buf, 100);
-    tmp = fread(&wireGeom, SIZEOF(xkmGeometryDesc), 1, file);
+    tmp = XkmRead(&wireGeom, SIZEOF(xkmGeometryDesc), 1, file);
     nRead += tmp * SIZEOF(xkmGeometryDesc);
     sizes.which = XkbGeomAllMask;
     sizes.num_properties = wireGeom.num_properties;
@@ -1097,7 +1142,7 @@ ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
 
             nRead += XkmGetCountedString(file, buf, 100);
             nameAtom = XkbInternAtom(buf, FALSE);
-            tmp = fread(&shapeWire, SIZEOF(xkmShapeDesc), 1, file);
+            tmp = XkmRead(&shapeWire, SIZEOF(xkmShapeDesc), 1, file);
             nRead += tmp * SIZEOF(xkmShapeDesc);
             shape = XkbAddGeomShape(geom, nameAtom, shapeWire.num_outlines);
             if (!shape) {
@@ -1108,7 +1153,7 @@ ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
                 register int p;
                 xkmPointDesc ptWire;
 
-                tmp = fread(&olWire, SIZEOF(xkmOutlineDesc), 1, file);
+                tmp = XkmRead(&olWire, SIZEOF(xkmOutlineDesc), 1, file);
                 nRead += tmp * SIZEOF(xkmOutlineDesc);
                 ol = XkbAddGeomOutline(shape, olWire.num_points);
                 if (!ol) {
@@ -1118,7 +1163,7 @@ ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
                 ol->num_points = olWire.num_points;
                 ol->corner_radius = olWire.corner_radius;
                 for (p = 0; p < olWire.num_points; p++) {
-                    tmp = fread(&ptWire, SIZEOF(xkmPointDesc), 1, file);
+                    tmp = XkmRead(&ptWire, SIZEOF(xkmPointDesc), 1, file);
                     nRead += tmp * SIZEOF(xkmPointDesc);
                     ol->points[p].x = ptWire.x;
                     ol->points[p].y = ptWire.y;
@@ -1158,7 +1203,7 @@ ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
         int sz = XkbKeyNameLength * 2;
         int num = wireGeom.num_key_aliases;
 
-        if (fread(geom->key_aliases, sz, num, file) != num) {
+        if (XkmRead(geom->key_aliases, sz, num, file) != num) {
             _XkbLibError(_XkbErrBadLength, "ReadXkmGeometry", 0);
             return -1;
         }
@@ -1169,8 +1214,9 @@ ReadXkmGeometry(FILE * file, XkbDescPtr xkb)
 }
 
 Bool
-XkmProbe(FILE * file)
+XkmProbe(FILE * fp)
 {
+    XkmInput input = { .file = fp }, *file = &input;
     unsigned hdr, tmp;
     int nRead = 0;
 
@@ -1186,7 +1232,7 @@ XkmProbe(FILE * file)
 }
 
 static Bool
-XkmReadTOC(FILE * file, xkmFileInfo * file_info, int max_toc,
+XkmReadTOC(XkmInputPtr file, xkmFileInfo * file_info, int max_toc,
            xkmSectionInfo * toc)
 {
     unsigned hdr, tmp;
@@ -1204,7 +1250,7 @@ XkmReadTOC(FILE * file, xkmFileInfo * file_info, int max_toc,
         }
         return 0;
     }
-    if (fread(file_info, SIZEOF(xkmFileInfo), 1, file) != 1)
+    if (XkmRead(file_info, SIZEOF(xkmFileInfo), 1, file) != 1)
         return 0;
     size_toc = file_info->num_toc;
     if (size_toc > max_toc) {
@@ -1213,7 +1259,7 @@ XkmReadTOC(FILE * file, xkmFileInfo * file_info, int max_toc,
         size_toc = max_toc;
     }
     for (i = 0; i < size_toc; i++) {
-        if (fread(&toc[i], SIZEOF(xkmSectionInfo), 1, file) != 1)
+        if (XkmRead(&toc[i], SIZEOF(xkmSectionInfo), 1, file) != 1)
             return 0;
     }
     return 1;
@@ -1222,8 +1268,8 @@ XkmReadTOC(FILE * file, xkmFileInfo * file_info, int max_toc,
 /***====================================================================***/
 
 #define	MAX_TOC	16
-unsigned
-XkmReadFile(FILE * file, unsigned need, unsigned want, XkbDescPtr *xkb)
+static unsigned
+XkmReadInput(XkmInputPtr file, unsigned need, unsigned want, XkbDescPtr *xkb)
 {
     register unsigned i;
     xkmSectionInfo toc[MAX_TOC], tmpTOC;
@@ -1241,8 +1287,9 @@ XkmReadFile(FILE * file, unsigned need, unsigned want, XkbDescPtr *xkb)
     if (*xkb == NULL)
         *xkb = XkbAllocKeyboard();
     for (i = 0; i < fileInfo.num_toc; i++) {
-        fseek(file, toc[i].offset, SEEK_SET);
-        tmp = fread(&tmpTOC, SIZEOF(xkmSectionInfo), 1, file);
+        if (XkmSeek(file, toc[i].offset) != 0)
+            return which;
+        tmp = XkmRead(&tmpTOC, SIZEOF(xkmSectionInfo), 1, file);
         nRead = tmp * SIZEOF(xkmSectionInfo);
         if ((tmpTOC.type != toc[i].type) || (tmpTOC.format != toc[i].format) ||
             (tmpTOC.size != toc[i].size) || (tmpTOC.offset != toc[i].offset)) {
@@ -1292,3 +1339,21 @@ XkmReadFile(FILE * file, unsigned need, unsigned want, XkbDescPtr *xkb)
     }
     return which;
 }
+
+unsigned
+XkmReadFile(FILE * file, unsigned need, unsigned want, XkbDescPtr *xkb)
+{
+    XkmInput input = { .file = file };
+
+    return XkmReadInput(&input, need, want, xkb);
+}
+
+/* Like XkmReadFile, for a compiled keymap that is already in memory. */
+unsigned
+XkmReadBuffer(const void *data, size_t size, unsigned need, unsigned want,
+              XkbDescPtr *xkb)
+{
+    XkmInput input = { .data = data, .size = size };
+
+    return XkmReadInput(&input, need, want, xkb);
+}